@@ -6,10 +6,13 @@
  * \ingroup bke
  */
 
+#include "BKE_customdata.h"
 #include "BKE_mesh_types.h"
 #include "BLI_compiler_attrs.h"
 #include "BLI_utildefines.h"
 
+#include "DNA_mesh_types.h"
+
 struct BLI_Stack;
 struct BMesh;
 struct BMeshCreateParams;
@@ -658,6 +661,44 @@ void BKE_mesh_normals_loop_split(const struct MVert *mverts,
                                  MLoopNorSpaceArray *r_lnors_spacearr,
                                  short (*clnors_data)[2],
                                  int *r_loop_to_poly);
+/**
+ * Same as #BKE_mesh_normals_loop_split, with an optional precomputed face corner topology
+ * (see #BKE_mesh_corner_topology_ensure), to avoid building it for every call.
+ */
+void BKE_mesh_normals_loop_split_ex(const struct MVert *mverts,
+                                    const float (*vert_normals)[3],
+                                    int numVerts,
+                                    struct MEdge *medges,
+                                    int numEdges,
+                                    struct MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    int numLoops,
+                                    struct MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    int numPolys,
+                                    bool use_split_normals,
+                                    float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    const int (*edge_to_loops_topology)[2],
+                                    const int *loop_to_poly_topology);
+
+/**
+ * The face corner topology used to find the smooth fans around vertices when computing split
+ * normals, cached in the mesh runtime data until its geometry is cleared:
+ * - `r_edge_to_loops`: The first two face corners using each edge. The second one is -1 when
+ *   the edge isn't used by exactly two faces, both are -1 for loose edges.
+ * - `r_loop_to_poly`: The face of each face corner.
+ *
+ * \note This function only fills a cache, and therefore the mesh argument can
+ * be considered logically const. Concurrent access is protected by a mutex.
+ * \note #BKE_mesh_calc_normals_split only uses the cache for evaluated meshes, since original
+ * meshes can be edited in place without clearing it.
+ */
+void BKE_mesh_corner_topology_ensure(const struct Mesh *mesh,
+                                     const int (**r_edge_to_loops)[2],
+                                     const int **r_loop_to_poly);
 
 void BKE_mesh_normals_loop_custom_set(const struct MVert *mverts,
                                       const float (*vert_normals)[3],
@@ -1085,6 +1126,111 @@ BLI_INLINE int BKE_mesh_origindex_mface_mpoly(const int *index_mf_to_mpoly,
   return (j != -1) ? (index_mp_to_orig ? index_mp_to_orig[j] : j) : -1;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Mesh Domain Data Access
+ *
+ * Access to the vertex, edge, face and face corner arrays that doesn't depend on the cached
+ * pointers in #Mesh, so the way these are stored in custom data can change without touching the
+ * code using them. The `_for_write` versions make sure the layer isn't shared with another mesh
+ * (see #CD_REFERENCE) before it is modified.
+ *
+ * TODO: The data is still stored as the interleaved #MVert, #MEdge, #MPoly and #MLoop layers.
+ * Storing positions, flags, bevel weights and edge vertex pairs as separate attributes, and moving
+ * the code reading and writing them over, is still to be done.
+ * \{ */
+
+BLI_INLINE const struct MVert *BKE_mesh_verts(const struct Mesh *mesh)
+{
+  return (const struct MVert *)CustomData_get_layer(&mesh->vdata, CD_MVERT);
+}
+BLI_INLINE struct MVert *BKE_mesh_verts_for_write(struct Mesh *mesh)
+{
+  mesh->mvert = (struct MVert *)CustomData_duplicate_referenced_layer(
+      &mesh->vdata, CD_MVERT, mesh->totvert);
+  return mesh->mvert;
+}
+
+BLI_INLINE const struct MEdge *BKE_mesh_edges(const struct Mesh *mesh)
+{
+  return (const struct MEdge *)CustomData_get_layer(&mesh->edata, CD_MEDGE);
+}
+BLI_INLINE struct MEdge *BKE_mesh_edges_for_write(struct Mesh *mesh)
+{
+  mesh->medge = (struct MEdge *)CustomData_duplicate_referenced_layer(
+      &mesh->edata, CD_MEDGE, mesh->totedge);
+  return mesh->medge;
+}
+
+BLI_INLINE const struct MPoly *BKE_mesh_polys(const struct Mesh *mesh)
+{
+  return (const struct MPoly *)CustomData_get_layer(&mesh->pdata, CD_MPOLY);
+}
+BLI_INLINE struct MPoly *BKE_mesh_polys_for_write(struct Mesh *mesh)
+{
+  mesh->mpoly = (struct MPoly *)CustomData_duplicate_referenced_layer(
+      &mesh->pdata, CD_MPOLY, mesh->totpoly);
+  return mesh->mpoly;
+}
+
+BLI_INLINE const struct MLoop *BKE_mesh_loops(const struct Mesh *mesh)
+{
+  return (const struct MLoop *)CustomData_get_layer(&mesh->ldata, CD_MLOOP);
+}
+BLI_INLINE struct MLoop *BKE_mesh_loops_for_write(struct Mesh *mesh)
+{
+  mesh->mloop = (struct MLoop *)CustomData_duplicate_referenced_layer(
+      &mesh->ldata, CD_MLOOP, mesh->totloop);
+  return mesh->mloop;
+}
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
 #ifdef __cplusplus
+
+#  include "BLI_span.hh"
+
+namespace blender::bke {
+
+inline Span<MVert> mesh_verts(const Mesh &mesh)
+{
+  return {BKE_mesh_verts(&mesh), mesh.totvert};
+}
+inline MutableSpan<MVert> mesh_verts_for_write(Mesh &mesh)
+{
+  return {BKE_mesh_verts_for_write(&mesh), mesh.totvert};
+}
+
+inline Span<MEdge> mesh_edges(const Mesh &mesh)
+{
+  return {BKE_mesh_edges(&mesh), mesh.totedge};
+}
+inline MutableSpan<MEdge> mesh_edges_for_write(Mesh &mesh)
+{
+  return {BKE_mesh_edges_for_write(&mesh), mesh.totedge};
+}
+
+inline Span<MPoly> mesh_polys(const Mesh &mesh)
+{
+  return {BKE_mesh_polys(&mesh), mesh.totpoly};
+}
+inline MutableSpan<MPoly> mesh_polys_for_write(Mesh &mesh)
+{
+  return {BKE_mesh_polys_for_write(&mesh), mesh.totpoly};
+}
+
+inline Span<MLoop> mesh_loops(const Mesh &mesh)
+{
+  return {BKE_mesh_loops(&mesh), mesh.totloop};
 }
+inline MutableSpan<MLoop> mesh_loops_for_write(Mesh &mesh)
+{
+  return {BKE_mesh_loops_for_write(&mesh), mesh.totloop};
+}
+
+}  // namespace blender::bke
+
 #endif
@@ -20,6 +20,7 @@ struct Depsgraph;
 struct KeyBlock;
 struct MLoop;
 struct MLoopTri;
+struct MeshElemMap;
 struct MVertTri;
 struct Mesh;
 struct Object;
@@ -49,6 +50,21 @@ void BKE_mesh_runtime_looptri_recalc(struct Mesh *mesh);
  * \note This is a ported copy of dm_getLoopTriArray(dm).
  */
 const struct MLoopTri *BKE_mesh_runtime_looptri_ensure(const struct Mesh *mesh);
+
+/**
+ * Topology maps cached on the mesh until its geometry is cleared (see
+ * #BKE_mesh_runtime_clear_geometry), so that all users of a mesh share the same maps. The maps
+ * are the same as the ones created by #BKE_mesh_vert_poly_map_create,
+ * #BKE_mesh_vert_edge_map_create and #BKE_mesh_edge_poly_map_create.
+ *
+ * \note These functions only fill a cache, and therefore the mesh argument can
+ * be considered logically const. Concurrent access is protected by a mutex.
+ * \return The map, or null when the mesh has no elements in the map's domain.
+ */
+const struct MeshElemMap *BKE_mesh_runtime_vert_poly_map_ensure(const struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_vert_edge_map_ensure(const struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_edge_poly_map_ensure(const struct Mesh *mesh);
+
 bool BKE_mesh_runtime_ensure_edit_data(struct Mesh *mesh);
 bool BKE_mesh_runtime_clear_edit_data(struct Mesh *mesh);
 bool BKE_mesh_runtime_reset_edit_data(struct Mesh *mesh);
@@ -1656,15 +1656,12 @@ bool BKE_mesh_minmax(const Mesh *me, float r_min[3], float r_max[3])
 void BKE_mesh_transform(Mesh *me, const float mat[4][4], bool do_keys)
 {
   int i;
-  MVert *mvert = (MVert *)CustomData_duplicate_referenced_layer(&me->vdata, CD_MVERT, me->totvert);
+  blender::MutableSpan<MVert> verts = blender::bke::mesh_verts_for_write(*me);
   float(*lnors)[3] = (float(*)[3])CustomData_duplicate_referenced_layer(
       &me->ldata, CD_NORMAL, me->totloop);
 
-  /* If the referenced layer has been re-allocated need to update pointers stored in the mesh. */
-  BKE_mesh_update_customdata_pointers(me, false);
-
-  for (i = 0; i < me->totvert; i++, mvert++) {
-    mul_m4_v3(mat, mvert->co);
+  for (MVert &vert : verts) {
+    mul_m4_v3(mat, vert.co);
   }
 
   if (do_keys && me->key) {
@@ -1692,19 +1689,14 @@ void BKE_mesh_transform(Mesh *me, const float mat[4][4], bool do_keys)
 
 void BKE_mesh_translate(Mesh *me, const float offset[3], const bool do_keys)
 {
-  CustomData_duplicate_referenced_layer(&me->vdata, CD_MVERT, me->totvert);
-  /* If the referenced layer has been re-allocated need to update pointers stored in the mesh. */
-  BKE_mesh_update_customdata_pointers(me, false);
-
-  int i = me->totvert;
-  for (MVert *mvert = me->mvert; i--; mvert++) {
-    add_v3_v3(mvert->co, offset);
+  for (MVert &vert : blender::bke::mesh_verts_for_write(*me)) {
+    add_v3_v3(vert.co, offset);
   }
 
   if (do_keys && me->key) {
     LISTBASE_FOREACH (KeyBlock *, kb, &me->key->block) {
       float *fp = (float *)kb->data;
-      for (i = kb->totelem; i--; fp += 3) {
+      for (int i = kb->totelem; i--; fp += 3) {
         add_v3_v3(fp, offset);
       }
     }
@@ -1957,22 +1949,33 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
   /* may be nullptr */
   clnors = (short(*)[2])CustomData_get_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL);
 
-  BKE_mesh_normals_loop_split(mesh->mvert,
-                              BKE_mesh_vertex_normals_ensure(mesh),
-                              mesh->totvert,
-                              mesh->medge,
-                              mesh->totedge,
-                              mesh->mloop,
-                              r_loopnors,
-                              mesh->totloop,
-                              mesh->mpoly,
-                              BKE_mesh_poly_normals_ensure(mesh),
-                              mesh->totpoly,
-                              use_split_normals,
-                              split_angle,
-                              r_lnors_spacearr,
-                              clnors,
-                              nullptr);
+  /* The topology is only needed for split normals, avoid caching it otherwise. Original meshes
+   * can have their loops and edges written in place (e.g. from Python) without the cache being
+   * cleared, so it is only cached on evaluated meshes, and computed for each call otherwise. */
+  const int(*edge_to_loops)[2] = nullptr;
+  const int *loop_to_poly = nullptr;
+  if (use_split_normals && DEG_is_evaluated_id(&mesh->id)) {
+    BKE_mesh_corner_topology_ensure(mesh, &edge_to_loops, &loop_to_poly);
+  }
+
+  BKE_mesh_normals_loop_split_ex(mesh->mvert,
+                                 BKE_mesh_vertex_normals_ensure(mesh),
+                                 mesh->totvert,
+                                 mesh->medge,
+                                 mesh->totedge,
+                                 mesh->mloop,
+                                 r_loopnors,
+                                 mesh->totloop,
+                                 mesh->mpoly,
+                                 BKE_mesh_poly_normals_ensure(mesh),
+                                 mesh->totpoly,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors,
+                                 nullptr,
+                                 edge_to_loops,
+                                 loop_to_poly);
 
   BKE_mesh_assert_normals_dirty_or_calculated(mesh);
 }
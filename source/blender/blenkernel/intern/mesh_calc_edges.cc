@@ -15,6 +15,7 @@
 
 #include "BKE_customdata.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 
 namespace blender::bke::calc_edges {
 
@@ -244,6 +245,9 @@ void BKE_mesh_calc_edges(Mesh *mesh, bool keep_existing_edges, const bool select
   mesh->totedge = new_totedge;
   mesh->medge = new_edges.data();
 
+  /* The edge indices of face corners changed, cached topology is invalid. */
+  BKE_mesh_runtime_clear_geometry(mesh);
+
   /* Explicitly clear edge maps, because that way it can be parallelized. */
   clear_hash_tables(edge_maps);
 }
@@ -29,6 +29,7 @@
 #include "BLI_task.h"
 #include "BLI_task.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "BKE_customdata.h"
 #include "BKE_editmesh_cache.h"
@@ -372,12 +373,12 @@ const float (*BKE_mesh_vertex_normals_ensure(const Mesh *mesh))[3]
     vert_normals = BKE_mesh_vertex_normals_for_write(&mesh_mutable);
     poly_normals = BKE_mesh_poly_normals_for_write(&mesh_mutable);
 
-    BKE_mesh_calc_normals_poly_and_vertex(mesh_mutable.mvert,
-                                          mesh_mutable.totvert,
-                                          mesh_mutable.mloop,
-                                          mesh_mutable.totloop,
-                                          mesh_mutable.mpoly,
-                                          mesh_mutable.totpoly,
+    BKE_mesh_calc_normals_poly_and_vertex(BKE_mesh_verts(mesh),
+                                          mesh->totvert,
+                                          BKE_mesh_loops(mesh),
+                                          mesh->totloop,
+                                          BKE_mesh_polys(mesh),
+                                          mesh->totpoly,
                                           poly_normals,
                                           vert_normals);
 
@@ -416,12 +417,12 @@ const float (*BKE_mesh_poly_normals_ensure(const Mesh *mesh))[3]
 
     poly_normals = BKE_mesh_poly_normals_for_write(&mesh_mutable);
 
-    BKE_mesh_calc_normals_poly(mesh_mutable.mvert,
-                               mesh_mutable.totvert,
-                               mesh_mutable.mloop,
-                               mesh_mutable.totloop,
-                               mesh_mutable.mpoly,
-                               mesh_mutable.totpoly,
+    BKE_mesh_calc_normals_poly(BKE_mesh_verts(mesh),
+                               mesh->totvert,
+                               BKE_mesh_loops(mesh),
+                               mesh->totloop,
+                               BKE_mesh_polys(mesh),
+                               mesh->totpoly,
                                poly_normals);
 
     BKE_mesh_poly_normals_clear_dirty(&mesh_mutable);
@@ -781,25 +782,16 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space,
 
 #define LOOP_SPLIT_TASK_BLOCK_SIZE 1024
 
+/**
+ * A face corner to compute the normal of: either a corner with sharp edges on both sides, which
+ * just uses its face normal, or the first corner of a smooth fan around its vertex.
+ */
 struct LoopSplitTaskData {
-  /* Specific to each instance (each task). */
-
   /** We have to create those outside of tasks, since #MemArena is not thread-safe. */
   MLoopNorSpace *lnor_space;
-  float (*lnor)[3];
-  const MLoop *ml_curr;
-  const MLoop *ml_prev;
   int ml_curr_index;
   int ml_prev_index;
-  /** Also used a flag to switch between single or fan process! */
-  const int *e2l_prev;
   int mp_index;
-
-  /** This one is special, it's owned and managed by worker tasks,
-   * avoid to have to create it for each fan! */
-  BLI_Stack *edge_vectors;
-
-  char pad_c;
 };
 
 struct LoopSplitTaskDataCommon {
@@ -815,8 +807,8 @@ struct LoopSplitTaskDataCommon {
   const MEdge *medges;
   const MLoop *mloops;
   const MPoly *mpolys;
-  int (*edge_to_loops)[2];
-  int *loop_to_poly;
+  const int (*edge_to_loops)[2];
+  const int *loop_to_poly;
   const float (*polynors)[3];
   const float (*vert_normals)[3];
 
@@ -830,110 +822,157 @@ struct LoopSplitTaskDataCommon {
 /* See comment about edge_to_loops below. */
 #define IS_EDGE_SHARP(_e2l) (ELEM((_e2l)[1], INDEX_UNSET, INDEX_INVALID))
 
-static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
-                                 const bool check_angle,
-                                 const float split_angle,
-                                 const bool do_sharp_edges_tag)
+/**
+ * Fill the face corner topology described in #BKE_mesh_corner_topology_ensure.
+ */
+static void mesh_corner_topology_calc(const MLoop *mloops,
+                                      const MPoly *mpolys,
+                                      const int numEdges,
+                                      const int numPolys,
+                                      int (*r_edge_to_loops)[2],
+                                      int *r_loop_to_poly)
 {
-  const MEdge *medges = data->medges;
-  const MLoop *mloops = data->mloops;
+  using namespace blender;
 
-  const MPoly *mpolys = data->mpolys;
+  threading::parallel_for(IndexRange(numPolys), 1024, [&](const IndexRange range) {
+    for (const int mp_index : range) {
+      const MPoly &mp = mpolys[mp_index];
+      for (const int ml_index : IndexRange(mp.loopstart, mp.totloop)) {
+        r_loop_to_poly[ml_index] = mp_index;
+      }
+    }
+  });
 
-  const int numEdges = data->numEdges;
-  const int numPolys = data->numPolys;
+  threading::parallel_for(IndexRange(numEdges), 4096, [&](const IndexRange range) {
+    for (const int me_index : range) {
+      r_edge_to_loops[me_index][0] = INDEX_UNSET;
+      r_edge_to_loops[me_index][1] = INDEX_UNSET;
+    }
+  });
 
-  float(*loopnors)[3] = data->loopnors; /* NOTE: loopnors may be nullptr here. */
-  const float(*polynors)[3] = data->polynors;
+  for (int mp_index = 0; mp_index < numPolys; mp_index++) {
+    const MPoly &mp = mpolys[mp_index];
+    for (const int ml_index : IndexRange(mp.loopstart, mp.totloop)) {
+      int *e2l = r_edge_to_loops[mloops[ml_index].e];
+      if (e2l[0] == INDEX_UNSET) {
+        e2l[0] = ml_index;
+      }
+      else if (e2l[1] == INDEX_UNSET) {
+        e2l[1] = ml_index;
+      }
+      else {
+        /* More than two loops using this edge. */
+        e2l[1] = INDEX_INVALID;
+      }
+    }
+  }
 
-  int(*edge_to_loops)[2] = data->edge_to_loops;
-  int *loop_to_poly = data->loop_to_poly;
+  threading::parallel_for(IndexRange(numEdges), 4096, [&](const IndexRange range) {
+    for (const int me_index : range) {
+      int *e2l = r_edge_to_loops[me_index];
+      if (e2l[0] == INDEX_UNSET) {
+        e2l[0] = INDEX_INVALID;
+      }
+      if (e2l[1] == INDEX_UNSET) {
+        e2l[1] = INDEX_INVALID;
+      }
+    }
+  });
+}
 
-  BLI_bitmap *sharp_edges = do_sharp_edges_tag ? BLI_BITMAP_NEW(numEdges, __func__) : nullptr;
+/**
+ * Find which edges are smooth, based on the face corner topology \a edge_to_loops_topology:
+ * \a r_edge_to_loops gets the same corners, with the second one set to #INDEX_INVALID for sharp
+ * edges. Both arrays may be the same.
+ *
+ * An edge is sharp if it is tagged as such, or one of its faces is not smooth, or both faces have
+ * opposed (flipped) normals, i.e. both loops on the same edge share the same vertex, or the angle
+ * between both faces normals is above \a split_angle. Edges that don't have exactly two faces are
+ * always sharp.
+ *
+ * If \a r_medges_sharp is given, edges that are sharp because of the angle get #ME_SHARP.
+ * The first face of an edge is the first one in face order. Edges used by more than two faces
+ * are tagged based on their first two faces.
+ */
+static void mesh_edges_sharp_tag(const LoopSplitTaskDataCommon *data,
+                                 const int (*edge_to_loops_topology)[2],
+                                 const bool check_angle,
+                                 const float split_angle,
+                                 int (*r_edge_to_loops)[2],
+                                 MEdge *r_medges_sharp)
+{
+  using namespace blender;
 
-  const MPoly *mp;
-  int mp_index;
+  const MEdge *medges = data->medges;
+  const MLoop *mloops = data->mloops;
+  const MPoly *mpolys = data->mpolys;
+  const int *loop_to_poly = data->loop_to_poly;
+  const float(*polynors)[3] = data->polynors;
 
   const float split_angle_cos = check_angle ? cosf(split_angle) : -1.0f;
 
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    const MLoop *ml_curr;
-    int *e2l;
-    int ml_curr_index = mp->loopstart;
-    const int ml_last_index = (ml_curr_index + mp->totloop) - 1;
-
-    ml_curr = &mloops[ml_curr_index];
-
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
-      e2l = edge_to_loops[ml_curr->e];
-
-      loop_to_poly[ml_curr_index] = mp_index;
-
-      /* Pre-populate all loop normals as if their verts were all-smooth,
-       * this way we don't have to compute those later!
-       */
-      if (loopnors) {
-        copy_v3_v3(loopnors[ml_curr_index], data->vert_normals[ml_curr->v]);
-      }
-
-      /* Check whether current edge might be smooth or sharp */
-      if ((e2l[0] | e2l[1]) == 0) {
-        /* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
-        e2l[0] = ml_curr_index;
-        /* We have to check this here too, else we might miss some flat faces!!! */
-        e2l[1] = (mp->flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
-      }
-      else if (e2l[1] == INDEX_UNSET) {
-        const bool is_angle_sharp = (check_angle &&
-                                     dot_v3v3(polynors[loop_to_poly[e2l[0]]], polynors[mp_index]) <
-                                         split_angle_cos);
-
-        /* Second loop using this edge, time to test its sharpness.
-         * An edge is sharp if it is tagged as such, or its face is not smooth,
-         * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the
-         * same vertex, or angle between both its polys' normals is above split_angle value.
-         */
-        if (!(mp->flag & ME_SMOOTH) || (medges[ml_curr->e].flag & ME_SHARP) ||
-            ml_curr->v == mloops[e2l[0]].v || is_angle_sharp) {
-          /* NOTE: we are sure that loop != 0 here ;). */
-          e2l[1] = INDEX_INVALID;
-
-          /* We want to avoid tagging edges as sharp when it is already defined as such by
-           * other causes than angle threshold. */
-          if (do_sharp_edges_tag && is_angle_sharp) {
-            BLI_BITMAP_SET(sharp_edges, ml_curr->e, true);
-          }
+  auto edge_is_sharp = [&](const int me_index,
+                           const int ml_index_a,
+                           const int ml_index_b,
+                           bool *r_is_angle_sharp) {
+    const int mp_index_a = loop_to_poly[ml_index_a];
+    const int mp_index_b = loop_to_poly[ml_index_b];
+    *r_is_angle_sharp = (check_angle &&
+                         dot_v3v3(polynors[mp_index_a], polynors[mp_index_b]) < split_angle_cos);
+    return !(mpolys[mp_index_a].flag & ME_SMOOTH) || !(mpolys[mp_index_b].flag & ME_SMOOTH) ||
+           (medges[me_index].flag & ME_SHARP) || mloops[ml_index_a].v == mloops[ml_index_b].v ||
+           *r_is_angle_sharp;
+  };
+
+  if (r_medges_sharp && check_angle) {
+    /* The topology doesn't store the second corner of edges used by more than two faces, find it
+     * in face order. This runs before the main loop, which may overwrite the topology. */
+    BLI_bitmap *edges_done = BLI_BITMAP_NEW((size_t)data->numEdges, __func__);
+    for (const int mp_index : IndexRange(data->numPolys)) {
+      const MPoly &mp = mpolys[mp_index];
+      for (const int ml_index : IndexRange(mp.loopstart, mp.totloop)) {
+        const int me_index = mloops[ml_index].e;
+        const int ml_index_a = edge_to_loops_topology[me_index][0];
+        if (edge_to_loops_topology[me_index][1] != INDEX_INVALID || ml_index_a == ml_index ||
+            BLI_BITMAP_TEST(edges_done, me_index)) {
+          continue;
         }
-        else {
-          e2l[1] = ml_curr_index;
+        BLI_BITMAP_ENABLE(edges_done, me_index);
+        bool is_angle_sharp;
+        edge_is_sharp(me_index, ml_index_a, ml_index, &is_angle_sharp);
+        if (is_angle_sharp && (mpolys[loop_to_poly[ml_index_a]].flag & ME_SMOOTH)) {
+          r_medges_sharp[me_index].flag |= ME_SHARP;
         }
       }
-      else if (!IS_EDGE_SHARP(e2l)) {
-        /* More than two loops using this edge, tag as sharp if not yet done. */
-        e2l[1] = INDEX_INVALID;
-
-        /* We want to avoid tagging edges as sharp when it is already defined as such by
-         * other causes than angle threshold. */
-        if (do_sharp_edges_tag) {
-          BLI_BITMAP_SET(sharp_edges, ml_curr->e, false);
-        }
-      }
-      /* Else, edge is already 'disqualified' (i.e. sharp)! */
     }
+    MEM_freeN(edges_done);
   }
 
-  /* If requested, do actual tagging of edges as sharp in another loop. */
-  if (do_sharp_edges_tag) {
-    MEdge *me;
-    int me_index;
-    for (me = (MEdge *)medges, me_index = 0; me_index < numEdges; me++, me_index++) {
-      if (BLI_BITMAP_TEST(sharp_edges, me_index)) {
-        me->flag |= ME_SHARP;
+  threading::parallel_for(IndexRange(data->numEdges), 4096, [&](const IndexRange range) {
+    for (const int me_index : range) {
+      const int ml_index_a = edge_to_loops_topology[me_index][0];
+      const int ml_index_b = edge_to_loops_topology[me_index][1];
+      r_edge_to_loops[me_index][0] = ml_index_a;
+      if (ml_index_b == INDEX_INVALID) {
+        r_edge_to_loops[me_index][1] = INDEX_INVALID;
+        continue;
       }
-    }
 
-    MEM_freeN(sharp_edges);
-  }
+      bool is_angle_sharp;
+      if (edge_is_sharp(me_index, ml_index_a, ml_index_b, &is_angle_sharp)) {
+        r_edge_to_loops[me_index][1] = INDEX_INVALID;
+
+        /* Only tag edges that wouldn't be sharp because of their first face already. */
+        if (r_medges_sharp && is_angle_sharp &&
+            (mpolys[loop_to_poly[ml_index_a]].flag & ME_SMOOTH)) {
+          r_medges_sharp[me_index].flag |= ME_SHARP;
+        }
+      }
+      else {
+        r_edge_to_loops[me_index][1] = ml_index_b;
+      }
+    }
+  });
 }
 
 void BKE_edges_sharp_from_angle_set(const struct MVert *mverts,
@@ -953,24 +992,25 @@ void BKE_edges_sharp_from_angle_set(const struct MVert *mverts,
   }
 
   /* Mapping edge -> loops. See BKE_mesh_normals_loop_split() for details. */
-  int(*edge_to_loops)[2] = (int(*)[2])MEM_calloc_arrayN(
+  int(*edge_to_loops)[2] = (int(*)[2])MEM_malloc_arrayN(
       (size_t)numEdges, sizeof(*edge_to_loops), __func__);
 
   /* Simple mapping from a loop to its polygon index. */
   int *loop_to_poly = (int *)MEM_malloc_arrayN((size_t)numLoops, sizeof(*loop_to_poly), __func__);
 
+  mesh_corner_topology_calc(mloops, mpolys, numEdges, numPolys, edge_to_loops, loop_to_poly);
+
   LoopSplitTaskDataCommon common_data = {};
   common_data.mverts = mverts;
   common_data.medges = medges;
   common_data.mloops = mloops;
   common_data.mpolys = mpolys;
-  common_data.edge_to_loops = edge_to_loops;
   common_data.loop_to_poly = loop_to_poly;
   common_data.polynors = polynors;
   common_data.numEdges = numEdges;
   common_data.numPolys = numPolys;
 
-  mesh_edges_sharp_tag(&common_data, true, split_angle, true);
+  mesh_edges_sharp_tag(&common_data, edge_to_loops, true, split_angle, edge_to_loops, medges);
 
   MEM_freeN(edge_to_loops);
   MEM_freeN(loop_to_poly);
@@ -1023,24 +1063,22 @@ void BKE_mesh_loop_manifold_fan_around_vert_next(const MLoop *mloops,
   /* And now we are back in sync, mlfan_curr_index is the index of `mlfan_curr`! Pff! */
 }
 
-static void split_loop_nor_single_do(LoopSplitTaskDataCommon *common_data, LoopSplitTaskData *data)
+static void split_loop_nor_single_do(LoopSplitTaskDataCommon *common_data,
+                                     const LoopSplitTaskData *data)
 {
   MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
   const short(*clnors_data)[2] = common_data->clnors_data;
 
   const MVert *mverts = common_data->mverts;
   const MEdge *medges = common_data->medges;
+  const MLoop *mloops = common_data->mloops;
   const float(*polynors)[3] = common_data->polynors;
 
   MLoopNorSpace *lnor_space = data->lnor_space;
-  float(*lnor)[3] = data->lnor;
-  const MLoop *ml_curr = data->ml_curr;
-  const MLoop *ml_prev = data->ml_prev;
   const int ml_curr_index = data->ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-  const int ml_prev_index = data->ml_prev_index;
-  const int *e2l_prev = data->e2l_prev;
-#endif
+  float(*lnor)[3] = &common_data->loopnors[ml_curr_index];
+  const MLoop *ml_curr = &mloops[ml_curr_index];
+  const MLoop *ml_prev = &mloops[data->ml_prev_index];
   const int mp_index = data->mp_index;
 
   /* Simple case (both edges around that vertex are sharp in current polygon),
@@ -1084,7 +1122,9 @@ static void split_loop_nor_single_do(LoopSplitTaskDataCommon *common_data, LoopS
   }
 }
 
-static void split_loop_nor_fan_do(LoopSplitTaskDataCommon *common_data, LoopSplitTaskData *data)
+static void split_loop_nor_fan_do(LoopSplitTaskDataCommon *common_data,
+                                  const LoopSplitTaskData *data,
+                                  BLI_Stack *edge_vectors)
 {
   MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
   float(*loopnors)[3] = common_data->loopnors;
@@ -1099,17 +1139,14 @@ static void split_loop_nor_fan_do(LoopSplitTaskDataCommon *common_data, LoopSpli
   const float(*polynors)[3] = common_data->polynors;
 
   MLoopNorSpace *lnor_space = data->lnor_space;
-#if 0 /* Not needed for 'fan' loops. */
-  float(*lnor)[3] = data->lnor;
-#endif
-  const MLoop *ml_curr = data->ml_curr;
-  const MLoop *ml_prev = data->ml_prev;
   const int ml_curr_index = data->ml_curr_index;
   const int ml_prev_index = data->ml_prev_index;
+  const MLoop *ml_curr = &mloops[ml_curr_index];
+  const MLoop *ml_prev = &mloops[ml_prev_index];
   const int mp_index = data->mp_index;
-  const int *e2l_prev = data->e2l_prev;
+  const int *e2l_prev = edge_to_loops[ml_prev->e];
 
-  BLI_Stack *edge_vectors = data->edge_vectors;
+  BLI_assert((edge_vectors == nullptr) || BLI_stack_is_empty(edge_vectors));
 
   /* Sigh! we have to fan around current vertex, until we find the other non-smooth edge,
    * and accumulate face normals into the vertex!
@@ -1296,54 +1333,6 @@ static void split_loop_nor_fan_do(LoopSplitTaskDataCommon *common_data, LoopSpli
   }
 }
 
-static void loop_split_worker_do(LoopSplitTaskDataCommon *common_data,
-                                 LoopSplitTaskData *data,
-                                 BLI_Stack *edge_vectors)
-{
-  BLI_assert(data->ml_curr);
-  if (data->e2l_prev) {
-    BLI_assert((edge_vectors == nullptr) || BLI_stack_is_empty(edge_vectors));
-    data->edge_vectors = edge_vectors;
-    split_loop_nor_fan_do(common_data, data);
-  }
-  else {
-    /* No need for edge_vectors for 'single' case! */
-    split_loop_nor_single_do(common_data, data);
-  }
-}
-
-static void loop_split_worker(TaskPool *__restrict pool, void *taskdata)
-{
-  LoopSplitTaskDataCommon *common_data = (LoopSplitTaskDataCommon *)BLI_task_pool_user_data(pool);
-  LoopSplitTaskData *data = (LoopSplitTaskData *)taskdata;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr. */
-  BLI_Stack *edge_vectors = common_data->lnors_spacearr ?
-                                BLI_stack_new(sizeof(float[3]), __func__) :
-                                nullptr;
-
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
-
-  for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-    /* A nullptr ml_curr is used to tag ended data! */
-    if (data->ml_curr == nullptr) {
-      break;
-    }
-
-    loop_split_worker_do(common_data, data, edge_vectors);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
-}
-
 /**
  * Check whether given loop is part of an unknown-so-far cyclic smooth fan, or not.
  * Needed because cyclic smooth fans have no obvious 'entry point',
@@ -1420,10 +1409,11 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   }
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+static void loop_split_generator(LoopSplitTaskDataCommon *common_data,
+                                 blender::Vector<LoopSplitTaskData> &r_single_tasks,
+                                 blender::Vector<LoopSplitTaskData> &r_fan_tasks)
 {
   MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-  float(*loopnors)[3] = common_data->loopnors;
 
   const MLoop *mloops = common_data->mloops;
   const MPoly *mpolys = common_data->mpolys;
@@ -1442,37 +1432,22 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 
   BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
 
-  LoopSplitTaskData *data_buff = nullptr;
-  int data_idx = 0;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr
-   * (and we are not multi-threading). */
-  BLI_Stack *edge_vectors = nullptr;
-
 #ifdef DEBUG_TIME
   TIMEIT_START_AVERAGED(loop_split_generator);
 #endif
 
-  if (!pool) {
-    if (lnors_spacearr) {
-      edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
-    }
-  }
-
   /* We now know edges that can be smoothed (with their vector, and their two loops),
    * and edges that will be hard! Now, time to generate the normals.
    */
   for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    float(*lnors)[3];
     const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
     ml_curr_index = mp->loopstart;
     ml_prev_index = ml_last_index;
 
     ml_curr = &mloops[ml_curr_index];
     ml_prev = &mloops[ml_prev_index];
-    lnors = &loopnors[ml_curr_index];
 
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
+    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
       const int *e2l_curr = edge_to_loops[ml_curr->e];
       const int *e2l_prev = edge_to_loops[ml_prev->e];
 
@@ -1510,35 +1485,16 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
         // printf("SKIPPING!\n");
       }
       else {
-        LoopSplitTaskData *data, data_local;
+        LoopSplitTaskData data;
+        data.lnor_space = lnors_spacearr ? BKE_lnor_space_create(lnors_spacearr) : nullptr;
+        data.ml_curr_index = ml_curr_index;
+        data.ml_prev_index = ml_prev_index;
+        data.mp_index = mp_index;
 
         // printf("PROCESSING!\n");
 
-        if (pool) {
-          if (data_idx == 0) {
-            data_buff = (LoopSplitTaskData *)MEM_calloc_arrayN(
-                LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-          }
-          data = &data_buff[data_idx];
-        }
-        else {
-          data = &data_local;
-          memset(data, 0, sizeof(*data));
-        }
-
         if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-          data->lnor = lnors;
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = nullptr; /* Tag as 'single' task. */
-#endif
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
+          r_single_tasks.append(data);
         }
         /* We *do not need* to check/tag loops as already computed!
          * Due to the fact a loop only links to one of its two edges,
@@ -1550,29 +1506,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
          * All this due/thanks to link between normals and loop ordering (i.e. winding).
          */
         else {
-#if 0 /* Not needed for 'fan' loops. */
-          data->lnor = lnors;
-#endif
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
-
-        if (pool) {
-          data_idx++;
-          if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-            BLI_task_pool_push(pool, loop_split_worker, data_buff, true, nullptr);
-            data_idx = 0;
-          }
-        }
-        else {
-          loop_split_worker_do(common_data, data, edge_vectors);
+          r_fan_tasks.append(data);
         }
       }
 
@@ -1581,15 +1515,6 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
     }
   }
 
-  /* Last block of data. Since it is calloc'ed and we use first nullptr item as stopper,
-   * everything is fine. */
-  if (pool && data_idx) {
-    BLI_task_pool_push(pool, loop_split_worker, data_buff, true, nullptr);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
   MEM_freeN(skip_loops);
 
 #ifdef DEBUG_TIME
@@ -1597,26 +1522,31 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 #endif
 }
 
-void BKE_mesh_normals_loop_split(const MVert *mverts,
-                                 const float (*vert_normals)[3],
-                                 const int UNUSED(numVerts),
-                                 MEdge *medges,
-                                 const int numEdges,
-                                 MLoop *mloops,
-                                 float (*r_loopnors)[3],
-                                 const int numLoops,
-                                 MPoly *mpolys,
-                                 const float (*polynors)[3],
-                                 const int numPolys,
-                                 const bool use_split_normals,
-                                 const float split_angle,
-                                 MLoopNorSpaceArray *r_lnors_spacearr,
-                                 short (*clnors_data)[2],
-                                 int *r_loop_to_poly)
+void BKE_mesh_normals_loop_split_ex(const MVert *mverts,
+                                    const float (*vert_normals)[3],
+                                    const int UNUSED(numVerts),
+                                    MEdge *medges,
+                                    const int numEdges,
+                                    MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    const int (*edge_to_loops_topology)[2],
+                                    const int *loop_to_poly_topology)
 {
+  using namespace blender;
+
   /* For now this is not supported.
    * If we do not use split normals, we do not generate anything fancy! */
   BLI_assert(use_split_normals || !(r_lnors_spacearr));
+  BLI_assert((edge_to_loops_topology == nullptr) == (loop_to_poly_topology == nullptr));
 
   if (!use_split_normals) {
     /* In this case, we simply fill lnors with vnors (or fnors for flat faces), quite simple!
@@ -1625,26 +1555,24 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
      * (see e.g. mesh mapping code).
      * As usual, we could handle that on case-by-case basis,
      * but simpler to keep it well confined here. */
-    int mp_index;
-
-    for (mp_index = 0; mp_index < numPolys; mp_index++) {
-      MPoly *mp = &mpolys[mp_index];
-      int ml_index = mp->loopstart;
-      const int ml_index_end = ml_index + mp->totloop;
-      const bool is_poly_flat = ((mp->flag & ME_SMOOTH) == 0);
-
-      for (; ml_index < ml_index_end; ml_index++) {
-        if (r_loop_to_poly) {
-          r_loop_to_poly[ml_index] = mp_index;
-        }
-        if (is_poly_flat) {
-          copy_v3_v3(r_loopnors[ml_index], polynors[mp_index]);
-        }
-        else {
-          copy_v3_v3(r_loopnors[ml_index], vert_normals[mloops[ml_index].v]);
+    threading::parallel_for(IndexRange(numPolys), 1024, [&](const IndexRange range) {
+      for (const int mp_index : range) {
+        const MPoly *mp = &mpolys[mp_index];
+        const bool is_poly_flat = ((mp->flag & ME_SMOOTH) == 0);
+
+        for (const int ml_index : IndexRange(mp->loopstart, mp->totloop)) {
+          if (r_loop_to_poly) {
+            r_loop_to_poly[ml_index] = mp_index;
+          }
+          if (is_poly_flat) {
+            copy_v3_v3(r_loopnors[ml_index], polynors[mp_index]);
+          }
+          else {
+            copy_v3_v3(r_loopnors[ml_index], vert_normals[mloops[ml_index].v]);
+          }
         }
       }
-    }
+    });
     return;
   }
 
@@ -1661,14 +1589,31 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
    * Note that currently we only have two values for second loop of sharp edges.
    * However, if needed, we can store the negated value of loop index instead of INDEX_INVALID
    * to retrieve the real value later in code).
-   * Note also that loose edges always have both values set to 0! */
-  int(*edge_to_loops)[2] = (int(*)[2])MEM_calloc_arrayN(
+   * Note also that loose edges always have both values set to INDEX_INVALID! */
+  int(*edge_to_loops)[2] = (int(*)[2])MEM_malloc_arrayN(
       (size_t)numEdges, sizeof(*edge_to_loops), __func__);
 
   /* Simple mapping from a loop to its polygon index. */
-  int *loop_to_poly = r_loop_to_poly ? r_loop_to_poly :
-                                       (int *)MEM_malloc_arrayN(
-                                           (size_t)numLoops, sizeof(*loop_to_poly), __func__);
+  const int *loop_to_poly;
+  int *loop_to_poly_alloc = nullptr;
+  if (loop_to_poly_topology) {
+    loop_to_poly = loop_to_poly_topology;
+    if (r_loop_to_poly) {
+      memcpy(r_loop_to_poly, loop_to_poly_topology, sizeof(*r_loop_to_poly) * (size_t)numLoops);
+    }
+  }
+  else {
+    int *loop_to_poly_calc = r_loop_to_poly;
+    if (loop_to_poly_calc == nullptr) {
+      loop_to_poly_calc = loop_to_poly_alloc = (int *)MEM_malloc_arrayN(
+          (size_t)numLoops, sizeof(*loop_to_poly_alloc), __func__);
+    }
+    /* Compute the topology in place, #mesh_edges_sharp_tag then only updates it. */
+    mesh_corner_topology_calc(
+        mloops, mpolys, numEdges, numPolys, edge_to_loops, loop_to_poly_calc);
+    edge_to_loops_topology = edge_to_loops;
+    loop_to_poly = loop_to_poly_calc;
+  }
 
   /* When using custom loop normals, disable the angle feature! */
   const bool check_angle = (split_angle < (float)M_PI) && (clnors_data == nullptr);
@@ -1704,27 +1649,45 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   common_data.numLoops = numLoops;
   common_data.numPolys = numPolys;
 
-  /* This first loop check which edges are actually smooth, and compute edge vectors. */
-  mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
-
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead. */
-    loop_split_generator(nullptr, &common_data);
-  }
-  else {
-    TaskPool *task_pool = BLI_task_pool_create(&common_data, TASK_PRIORITY_HIGH);
+  /* This first loop check which edges are actually smooth. */
+  mesh_edges_sharp_tag(
+      &common_data, edge_to_loops_topology, check_angle, split_angle, edge_to_loops, nullptr);
 
-    loop_split_generator(task_pool, &common_data);
+  /* Pre-populate all loop normals as if their verts were all-smooth,
+   * this way we don't have to compute those later! */
+  threading::parallel_for(IndexRange(numLoops), 4096, [&](const IndexRange range) {
+    for (const int ml_index : range) {
+      copy_v3_v3(r_loopnors[ml_index], vert_normals[mloops[ml_index].v]);
+    }
+  });
 
-    BLI_task_pool_work_and_wait(task_pool);
+  /* Finding the fans is sequential, computing their normals is not. */
+  Vector<LoopSplitTaskData> single_tasks;
+  Vector<LoopSplitTaskData> fan_tasks;
+  loop_split_generator(&common_data, single_tasks, fan_tasks);
 
-    BLI_task_pool_free(task_pool);
-  }
+  threading::parallel_for(
+      single_tasks.index_range(), LOOP_SPLIT_TASK_BLOCK_SIZE, [&](const IndexRange range) {
+        for (const int i : range) {
+          split_loop_nor_single_do(&common_data, &single_tasks[i]);
+        }
+      });
+
+  threading::parallel_for(
+      fan_tasks.index_range(), LOOP_SPLIT_TASK_BLOCK_SIZE, [&](const IndexRange range) {
+        /* Temp edge vectors stack, only used when computing lnor spacearr. */
+        BLI_Stack *edge_vectors = r_lnors_spacearr ? BLI_stack_new(sizeof(float[3]), __func__) :
+                                                     nullptr;
+        for (const int i : range) {
+          split_loop_nor_fan_do(&common_data, &fan_tasks[i], edge_vectors);
+        }
+        if (edge_vectors) {
+          BLI_stack_free(edge_vectors);
+        }
+      });
 
   MEM_freeN(edge_to_loops);
-  if (!r_loop_to_poly) {
-    MEM_freeN(loop_to_poly);
-  }
+  MEM_SAFE_FREE(loop_to_poly_alloc);
 
   if (r_lnors_spacearr) {
     if (r_lnors_spacearr == &_lnors_spacearr) {
@@ -1737,6 +1700,78 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
 #endif
 }
 
+void BKE_mesh_normals_loop_split(const MVert *mverts,
+                                 const float (*vert_normals)[3],
+                                 const int numVerts,
+                                 MEdge *medges,
+                                 const int numEdges,
+                                 MLoop *mloops,
+                                 float (*r_loopnors)[3],
+                                 const int numLoops,
+                                 MPoly *mpolys,
+                                 const float (*polynors)[3],
+                                 const int numPolys,
+                                 const bool use_split_normals,
+                                 const float split_angle,
+                                 MLoopNorSpaceArray *r_lnors_spacearr,
+                                 short (*clnors_data)[2],
+                                 int *r_loop_to_poly)
+{
+  BKE_mesh_normals_loop_split_ex(mverts,
+                                 vert_normals,
+                                 numVerts,
+                                 medges,
+                                 numEdges,
+                                 mloops,
+                                 r_loopnors,
+                                 numLoops,
+                                 mpolys,
+                                 polynors,
+                                 numPolys,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors_data,
+                                 r_loop_to_poly,
+                                 nullptr,
+                                 nullptr);
+}
+
+void BKE_mesh_corner_topology_ensure(const Mesh *mesh,
+                                     const int (**r_edge_to_loops)[2],
+                                     const int **r_loop_to_poly)
+{
+  if (mesh->runtime.edge_to_loops == nullptr && mesh->totedge > 0) {
+    ThreadMutex *topology_mutex = (ThreadMutex *)mesh->runtime.topology_mutex;
+    BLI_mutex_lock(topology_mutex);
+    if (mesh->runtime.edge_to_loops == nullptr) {
+      /* Isolate task because a mutex is locked and computing the topology is multi-threaded. */
+      blender::threading::isolate_task([&]() {
+        Mesh &mesh_mutable = *const_cast<Mesh *>(mesh);
+        int(*edge_to_loops)[2] = (int(*)[2])MEM_malloc_arrayN(
+            (size_t)mesh->totedge, sizeof(*edge_to_loops), __func__);
+        int *loop_to_poly = (int *)MEM_malloc_arrayN(
+            (size_t)mesh->totloop, sizeof(*loop_to_poly), __func__);
+
+        mesh_corner_topology_calc(BKE_mesh_loops(mesh),
+                                  BKE_mesh_polys(mesh),
+                                  mesh->totedge,
+                                  mesh->totpoly,
+                                  edge_to_loops,
+                                  loop_to_poly);
+
+        /* The edge map is set last, it is used to check whether the cache exists. */
+        mesh_mutable.runtime.loop_to_poly = loop_to_poly;
+        mesh_mutable.runtime.edge_to_loops = edge_to_loops;
+      });
+    }
+    BLI_mutex_unlock(topology_mutex);
+  }
+
+  *r_edge_to_loops = mesh->runtime.edge_to_loops;
+  *r_loop_to_poly = mesh->runtime.loop_to_poly;
+}
+
 #undef INDEX_UNSET
 #undef INDEX_INVALID
 #undef IS_EDGE_SHARP
@@ -0,0 +1,155 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+#include "testing/testing.h"
+
+#include "BLI_index_range.hh"
+#include "BLI_math_rotation.h"
+#include "BLI_math_vector.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "DNA_ID.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+namespace blender::bke::tests {
+
+/**
+ * Three triangles sharing their first edge (vertices 0 and 1), the face normals are given
+ * directly rather than computed from the vertex positions.
+ */
+struct NonManifoldEdgeTestMesh {
+  MVert verts[5] = {};
+  MEdge edges[7] = {
+      {0, 1}, {1, 2}, {2, 0}, {0, 3}, {3, 1}, {1, 4}, {4, 0}};
+  MLoop loops[9] = {
+      {0, 0}, {1, 1}, {2, 2}, {1, 0}, {0, 3}, {3, 4}, {0, 0}, {1, 5}, {4, 6}};
+  MPoly polys[3] = {};
+
+  NonManifoldEdgeTestMesh()
+  {
+    for (const int i : IndexRange(3)) {
+      polys[i].loopstart = i * 3;
+      polys[i].totloop = 3;
+      polys[i].flag = ME_SMOOTH;
+    }
+  }
+
+  void edges_sharp_from_angle_set(const float (*polynors)[3], const float split_angle)
+  {
+    BKE_edges_sharp_from_angle_set(
+        verts, 5, edges, 7, loops, 9, polys, polynors, 3, split_angle);
+  }
+};
+
+TEST(mesh_normals, edges_sharp_from_angle_non_manifold)
+{
+  NonManifoldEdgeTestMesh mesh;
+  const float polynors[3][3] = {{0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+  mesh.edges_sharp_from_angle_set(polynors, DEG2RADF(30.0f));
+
+  /* The first two faces of the shared edge are at a right angle. */
+  EXPECT_TRUE(mesh.edges[0].flag & ME_SHARP);
+  for (const int i : IndexRange(1, 6)) {
+    EXPECT_FALSE(mesh.edges[i].flag & ME_SHARP);
+  }
+}
+
+TEST(mesh_normals, edges_sharp_from_angle_non_manifold_first_faces_flat)
+{
+  NonManifoldEdgeTestMesh mesh;
+  const float polynors[3][3] = {{0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}};
+  mesh.edges_sharp_from_angle_set(polynors, DEG2RADF(30.0f));
+
+  /* Only the first two faces are taken into account. */
+  EXPECT_FALSE(mesh.edges[0].flag & ME_SHARP);
+}
+
+TEST(mesh_normals, edges_sharp_from_angle_non_manifold_first_face_flat_shaded)
+{
+  NonManifoldEdgeTestMesh mesh;
+  mesh.polys[0].flag &= ~ME_SMOOTH;
+  const float polynors[3][3] = {{0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+  mesh.edges_sharp_from_angle_set(polynors, DEG2RADF(30.0f));
+
+  /* The edge is sharp because of its first face already. */
+  EXPECT_FALSE(mesh.edges[0].flag & ME_SHARP);
+}
+
+/**
+ * Two smooth triangles sharing an edge, with auto smooth enabled. The loops of the second one
+ * start at \a second_face_start.
+ */
+static Mesh *two_triangles_mesh_create(const int second_face_start)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(4, 5, 0, 6, 2);
+  const float positions[4][3] = {
+      {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.5f, 1.0f, 0.0f}, {0.5f, -1.0f, 0.2f}};
+  for (const int i : IndexRange(4)) {
+    copy_v3_v3(mesh->mvert[i].co, positions[i]);
+  }
+  const MEdge edges[5] = {{0, 1}, {1, 2}, {2, 0}, {0, 3}, {3, 1}};
+  for (const int i : IndexRange(5)) {
+    mesh->medge[i] = edges[i];
+  }
+  const MLoop loops[6] = {{0, 0}, {1, 1}, {2, 2}, {1, 0}, {0, 3}, {3, 4}};
+  for (const int i : IndexRange(3)) {
+    mesh->mloop[i] = loops[i];
+    mesh->mloop[3 + i] = loops[3 + (second_face_start + i) % 3];
+  }
+  for (const int i : IndexRange(2)) {
+    mesh->mpoly[i].loopstart = i * 3;
+    mesh->mpoly[i].totloop = 3;
+    mesh->mpoly[i].flag = ME_SMOOTH;
+  }
+  mesh->flag |= ME_AUTOSMOOTH;
+  mesh->smoothresh = DEG2RADF(30.0f);
+  return mesh;
+}
+
+static const float (*mesh_loop_normals_calc(Mesh *mesh))[3]
+{
+  BKE_mesh_calc_normals_split(mesh);
+  return static_cast<const float(*)[3]>(CustomData_get_layer(&mesh->ldata, CD_NORMAL));
+}
+
+TEST(mesh_normals, calc_normals_split_loops_changed_in_place)
+{
+  BKE_idtype_init();
+  Mesh *mesh = two_triangles_mesh_create(0);
+  mesh_loop_normals_calc(mesh);
+
+  /* Rotate the loops of the second face in place, like the Python API can, without clearing
+   * the mesh caches. */
+  Mesh *mesh_expected = two_triangles_mesh_create(1);
+  for (const int i : IndexRange(3, 3)) {
+    mesh->mloop[i] = mesh_expected->mloop[i];
+  }
+  BKE_mesh_normals_tag_dirty(mesh);
+
+  const float(*loop_normals)[3] = mesh_loop_normals_calc(mesh);
+  const float(*loop_normals_expected)[3] = mesh_loop_normals_calc(mesh_expected);
+  for (const int i : IndexRange(6)) {
+    EXPECT_V3_NEAR(loop_normals[i], loop_normals_expected[i], 1e-6f);
+  }
+  /* The topology isn't cached for original meshes. */
+  EXPECT_EQ(mesh->runtime.edge_to_loops, nullptr);
+
+  BKE_id_free(nullptr, mesh);
+  BKE_id_free(nullptr, mesh_expected);
+}
+
+TEST(mesh_normals, calc_normals_split_evaluated_topology_cached)
+{
+  BKE_idtype_init();
+  Mesh *mesh = two_triangles_mesh_create(0);
+  mesh->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+  mesh_loop_normals_calc(mesh);
+  EXPECT_NE(mesh->runtime.edge_to_loops, nullptr);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
@@ -20,6 +20,7 @@
 #include "BKE_bvhutils.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_mesh_runtime.h"
 #include "BKE_shrinkwrap.h"
 #include "BKE_subdiv_ccg.h"
@@ -41,6 +42,8 @@ static void mesh_runtime_init_mutexes(Mesh *mesh)
   BLI_mutex_init(mesh->runtime.normals_mutex);
   mesh->runtime.render_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime render_mutex");
   BLI_mutex_init(mesh->runtime.render_mutex);
+  mesh->runtime.topology_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime topology_mutex");
+  BLI_mutex_init(mesh->runtime.topology_mutex);
 }
 
 /**
@@ -63,6 +66,11 @@ static void mesh_runtime_free_mutexes(Mesh *mesh)
     MEM_freeN(mesh->runtime.render_mutex);
     mesh->runtime.render_mutex = NULL;
   }
+  if (mesh->runtime.topology_mutex != NULL) {
+    BLI_mutex_end(mesh->runtime.topology_mutex);
+    MEM_freeN(mesh->runtime.topology_mutex);
+    mesh->runtime.topology_mutex = NULL;
+  }
 }
 
 void BKE_mesh_runtime_init_data(Mesh *mesh)
@@ -92,6 +100,14 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
   runtime->poly_normals_dirty = true;
   runtime->vert_normals = NULL;
   runtime->poly_normals = NULL;
+  runtime->edge_to_loops = NULL;
+  runtime->loop_to_poly = NULL;
+  runtime->vert_poly_map = NULL;
+  runtime->vert_poly_map_mem = NULL;
+  runtime->vert_edge_map = NULL;
+  runtime->vert_edge_map_mem = NULL;
+  runtime->edge_poly_map = NULL;
+  runtime->edge_poly_map_mem = NULL;
 
   mesh_runtime_init_mutexes(mesh);
 }
@@ -254,6 +270,14 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     mesh->runtime.bvh_cache = NULL;
   }
   MEM_SAFE_FREE(mesh->runtime.looptris.array);
+  MEM_SAFE_FREE(mesh->runtime.edge_to_loops);
+  MEM_SAFE_FREE(mesh->runtime.loop_to_poly);
+  MEM_SAFE_FREE(mesh->runtime.vert_poly_map);
+  MEM_SAFE_FREE(mesh->runtime.vert_poly_map_mem);
+  MEM_SAFE_FREE(mesh->runtime.vert_edge_map);
+  MEM_SAFE_FREE(mesh->runtime.vert_edge_map_mem);
+  MEM_SAFE_FREE(mesh->runtime.edge_poly_map);
+  MEM_SAFE_FREE(mesh->runtime.edge_poly_map_mem);
   /* TODO(sergey): Does this really belong here? */
   if (mesh->runtime.subdiv_ccg != NULL) {
     BKE_subdiv_ccg_destroy(mesh->runtime.subdiv_ccg);
@@ -264,6 +288,94 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Mesh Topology Maps
+ * \{ */
+
+typedef void (*MeshTopologyMapCreateFn)(const Mesh *mesh, MeshElemMap **r_map, int **r_mem);
+
+static void mesh_vert_poly_map_create(const Mesh *mesh, MeshElemMap **r_map, int **r_mem)
+{
+  BKE_mesh_vert_poly_map_create(
+      r_map, r_mem, mesh->mpoly, mesh->mloop, mesh->totvert, mesh->totpoly, mesh->totloop);
+}
+
+static void mesh_vert_edge_map_create(const Mesh *mesh, MeshElemMap **r_map, int **r_mem)
+{
+  BKE_mesh_vert_edge_map_create(r_map, r_mem, mesh->medge, mesh->totvert, mesh->totedge);
+}
+
+static void mesh_edge_poly_map_create(const Mesh *mesh, MeshElemMap **r_map, int **r_mem)
+{
+  BKE_mesh_edge_poly_map_create(r_map,
+                                r_mem,
+                                mesh->medge,
+                                mesh->totedge,
+                                mesh->mpoly,
+                                mesh->totpoly,
+                                mesh->mloop,
+                                mesh->totloop);
+}
+
+static const MeshElemMap *mesh_runtime_topology_map_ensure(const Mesh *mesh,
+                                                           MeshElemMap **map_p,
+                                                           int **mem_p,
+                                                           const int map_len,
+                                                           MeshTopologyMapCreateFn create_fn)
+{
+  if (map_len == 0) {
+    return NULL;
+  }
+  if (*map_p != NULL) {
+    return *map_p;
+  }
+
+  ThreadMutex *topology_mutex = mesh->runtime.topology_mutex;
+  BLI_mutex_lock(topology_mutex);
+  if (*map_p == NULL) {
+    MeshElemMap *map;
+    int *mem;
+    create_fn(mesh, &map, &mem);
+    /* The map is set last, it is used to check whether the cache exists. */
+    *mem_p = mem;
+    *map_p = map;
+  }
+  BLI_mutex_unlock(topology_mutex);
+  return *map_p;
+}
+
+const MeshElemMap *BKE_mesh_runtime_vert_poly_map_ensure(const Mesh *mesh)
+{
+  Mesh_Runtime *runtime = (Mesh_Runtime *)&mesh->runtime;
+  return mesh_runtime_topology_map_ensure(mesh,
+                                          &runtime->vert_poly_map,
+                                          &runtime->vert_poly_map_mem,
+                                          mesh->totvert,
+                                          mesh_vert_poly_map_create);
+}
+
+const MeshElemMap *BKE_mesh_runtime_vert_edge_map_ensure(const Mesh *mesh)
+{
+  Mesh_Runtime *runtime = (Mesh_Runtime *)&mesh->runtime;
+  return mesh_runtime_topology_map_ensure(mesh,
+                                          &runtime->vert_edge_map,
+                                          &runtime->vert_edge_map_mem,
+                                          mesh->totvert,
+                                          mesh_vert_edge_map_create);
+}
+
+const MeshElemMap *BKE_mesh_runtime_edge_poly_map_ensure(const Mesh *mesh)
+{
+  Mesh_Runtime *runtime = (Mesh_Runtime *)&mesh->runtime;
+  return mesh_runtime_topology_map_ensure(mesh,
+                                          &runtime->edge_poly_map,
+                                          &runtime->edge_poly_map_mem,
+                                          mesh->totedge,
+                                          mesh_edge_poly_map_create);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Mesh Batch Cache Callbacks
  * \{ */
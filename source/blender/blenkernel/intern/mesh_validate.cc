@@ -27,6 +27,7 @@
 #include "BKE_customdata.h"
 #include "BKE_deform.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 
 #include "DEG_depsgraph.h"
 
@@ -1085,6 +1086,7 @@ bool BKE_mesh_validate(Mesh *me, const bool do_verbose, const bool cddata_check_
                            &changed);
 
   if (changed) {
+    BKE_mesh_runtime_clear_geometry(me);
     DEG_id_tag_update(&me->id, ID_RECALC_GEOMETRY_ALL_MODES);
     return true;
   }
@@ -72,6 +72,10 @@ typedef struct BVHTreeRayHit {
   float dist;
 } BVHTreeRayHit;
 
+enum {
+  /* Build the tree with the surface area heuristic, slower to build but faster to query. */
+  BVH_BUILD_SAH = (1 << 0),
+};
 enum {
   /* Use a priority queue to process nodes in the optimal order (for slow callbacks) */
   BVH_OVERLAP_USE_THREADING = (1 << 0),
@@ -147,6 +151,11 @@ typedef bool (*BVHTree_WalkOrderCallback)(const BVHTreeAxisRange *bounds,
  * \note many callers don't check for `NULL` return.
  */
 BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis);
+/**
+ * \param flag: #BVH_BUILD_SAH to build a tree that is faster to query (for large trees that are
+ * queried many times). Only used for trees with x, y and z axes (6, 8, 14 and 26-DOP).
+ */
+BVHTree *BLI_bvhtree_new_ex(int maxsize, float epsilon, char tree_type, char axis, int flag);
 void BLI_bvhtree_free(BVHTree *tree);
 
 /**
@@ -226,6 +235,25 @@ int BLI_bvhtree_find_nearest(BVHTree *tree,
                              BVHTree_NearestPointCallback callback,
                              void *userdata);
 
+/**
+ * Find the nearest node for many points at once,
+ * the result for every point matches #BLI_bvhtree_find_nearest_ex.
+ *
+ * The points are queried in a spatially coherent order, using the nearest node of the previous
+ * point to limit the search. Queries run in parallel, so \a callback must be thread-safe.
+ * It also has to store the squared distance to #BVHTreeNearest.co, like the default callbacks.
+ *
+ * \param nearest: One for every point, initialized like the nearest given to
+ * #BLI_bvhtree_find_nearest_ex (only nodes closer than #BVHTreeNearest.dist_sq are found).
+ */
+void BLI_bvhtree_find_nearest_array(BVHTree *tree,
+                                    const float (*co)[3],
+                                    int points_num,
+                                    BVHTreeNearest *nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag);
+
 /**
  * Find the first node nearby.
  * Favors speed over quality since it doesn't find the best target node.
@@ -277,6 +305,25 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
                               BVHTree_RayCastCallback callback,
                               void *userdata);
 
+/**
+ * Cast many rays at once, the result of every ray matches #BLI_bvhtree_ray_cast_ex.
+ *
+ * Consecutive rays are traversed together in small packets and the packets are cast in parallel,
+ * so \a callback must be thread-safe. Coherent rays (close origins and similar directions) should
+ * be next to each other for the best performance.
+ *
+ * \param hits: One hit for every ray, initialized like the hit given to #BLI_bvhtree_ray_cast_ex.
+ */
+void BLI_bvhtree_ray_cast_array(BVHTree *tree,
+                                const float (*origins)[3],
+                                const float (*directions)[3],
+                                int rays_num,
+                                float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag);
+
 float BLI_bvhtree_bb_raycast(const float bv[6],
                              const float light_start[3],
                              const float light_end[3],
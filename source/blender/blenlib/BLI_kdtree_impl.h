@@ -53,6 +53,18 @@ void BLI_kdtree_nd_(range_search_cb)(
     bool (*search_cb)(void *user_data, int index, const float co[KD_DIMS], float dist_sq),
     void *user_data);
 
+/** Batched versions of find/range search, running in parallel over the points in \a co. */
+void BLI_kdtree_nd_(find_nearest_array)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        uint co_len,
+                                        KDTreeNearest *r_nearest) ATTR_NONNULL(1, 4);
+uint BLI_kdtree_nd_(range_search_array)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        uint co_len,
+                                        float range,
+                                        uint **r_offsets,
+                                        KDTreeNearest **r_nearest) ATTR_NONNULL(1, 5, 6);
+
 int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
                                          float range,
                                          bool use_index_order,
@@ -0,0 +1,252 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A uniform grid for finding points within a fixed distance of each other, an alternative to
+ * #KDTree_3d when the search distance is known up-front and small compared to the bounds of the
+ * points, e.g. when merging by distance.
+ *
+ * Only non-empty cells are stored, in a hash table, so memory usage doesn't depend on the bounds.
+ * The points are sorted by cell along a Z-order curve, so nearby points are close in memory and
+ * searching the points in that order is cache friendly. Points in the same cell are sorted by
+ * index, so the order doesn't depend on the threads used to build the grid.
+ *
+ * A search only checks the cells overlapping the bounds of the search sphere, so the search
+ * distance must not be larger than the cell size. A cell size of about four times the search
+ * distance is usually fastest, fewer cells are searched while they stay small.
+ */
+
+#include "BLI_array.hh"
+#include "BLI_math_vec_types.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_span.hh"
+
+namespace blender {
+
+class SpatialHashGrid {
+ private:
+  struct CellSlot {
+    uint64_t key;
+    int cell;
+  };
+
+  float cell_size_;
+  float cell_size_inv_;
+  /** Cell coordinates are stored relative to the smallest cell containing a point. */
+  int3 cell_offset_;
+  /** Original indices of the points, sorted by cell along a Z-order curve. */
+  Array<int> indices_;
+  /** Positions in the same order as #indices_. */
+  Array<float3> positions_;
+  /** Start of the points of each non-empty cell, with the number of points at the end. */
+  Array<int> cell_starts_;
+  /** Open addressing table from cell keys to non-empty cells, the size is a power of two. */
+  Array<CellSlot> cell_table_;
+  uint64_t cell_table_mask_;
+
+  static constexpr uint64_t cell_key_empty = UINT64_MAX;
+  /** Bits per axis of relative cell coordinates in cell keys. */
+  static constexpr int cell_key_bits = 21;
+
+ public:
+  /**
+   * Insert all \a positions in parallel, the index of each point is its position in the span.
+   */
+  SpatialHashGrid(Span<float3> positions, float cell_size);
+
+  float cell_size() const
+  {
+    return cell_size_;
+  }
+
+  int size() const
+  {
+    return indices_.size();
+  }
+
+  /**
+   * Call \a fn for every point within \a radius of \a position, in no particular order.
+   * The callback has the signature `bool fn(int index, const float3 &position, float dist_sq)`,
+   * returning false stops the search.
+   *
+   * \return False when the search was stopped by the callback.
+   */
+  template<typename Fn>
+  bool foreach_in_radius(const float3 &position, const float radius, const Fn &fn) const
+  {
+    return this->foreach_in_radius_impl(
+        position,
+        radius,
+        [&](const int slot, const float dist_sq) {
+          return fn(indices_[slot], positions_[slot], dist_sq);
+        },
+        nullptr);
+  }
+
+  /**
+   * Find duplicate points within \a merge_distance, with the same rules as
+   * #BLI_kdtree_3d_calc_duplicates_fast. Points are visited in the order of the grid, which only
+   * depends on the positions and the cell size, like the k-d tree when not using index order.
+   * The searches run in parallel, merging is done afterwards in order.
+   *
+   * \param duplicates: One value for every point, values initialized to -1 are candidates to be
+   * merged, setting a value to its own index prevents the point from being merged although it can
+   * still be used as a target.
+   * \return The number of merges found.
+   */
+  int calc_duplicates(float merge_distance, MutableSpan<int> duplicates) const;
+
+ private:
+  /**
+   * Results of recent cell lookups, consecutive searches of nearby positions mostly search the
+   * same cells, which avoids random access into the cell table.
+   */
+  struct CellLookupCache {
+    static constexpr int size = 64;
+    uint64_t keys[size];
+    int cells[size];
+
+    CellLookupCache()
+    {
+      std::fill_n(keys, size, cell_key_empty);
+    }
+  };
+
+  /**
+   * Same as #foreach_in_radius, the callback gets the position of the point in the sorted arrays
+   * instead: `bool fn(int slot, float dist_sq)`.
+   */
+  template<typename Fn>
+  bool foreach_in_radius_impl(const float3 &position,
+                              const float radius,
+                              const Fn &fn,
+                              CellLookupCache *cache) const
+  {
+    BLI_assert(radius <= cell_size_);
+    if (indices_.is_empty()) {
+      return true;
+    }
+    const int3 cell_min = this->cell_coord(position - float3(radius));
+    /* Clamp in case of precision loss, the radius spans three cells at most. */
+    const int3 cell_max = math::min(this->cell_coord(position + float3(radius)), cell_min + 2);
+    const float radius_sq = radius * radius;
+
+    /* Build the keys from the bits of each axis. Cells far outside of the bounds share
+     * coordinates in keys, only search each key once. */
+    uint64_t axis_keys[3][3];
+    int axis_keys_num[3];
+    for (int axis = 0; axis < 3; axis++) {
+      axis_keys_num[axis] = 0;
+      for (int c = cell_min[axis]; c <= cell_max[axis]; c++) {
+        const uint64_t axis_key = this->cell_key_axis(c, axis);
+        if (axis_keys_num[axis] == 0 || axis_keys[axis][axis_keys_num[axis] - 1] != axis_key) {
+          axis_keys[axis][axis_keys_num[axis]++] = axis_key;
+        }
+      }
+    }
+    uint64_t keys[27];
+    int keys_num = 0;
+    for (int z = 0; z < axis_keys_num[2]; z++) {
+      for (int y = 0; y < axis_keys_num[1]; y++) {
+        for (int x = 0; x < axis_keys_num[0]; x++) {
+          keys[keys_num++] = axis_keys[0][x] | axis_keys[1][y] | axis_keys[2][z];
+        }
+      }
+    }
+
+    for (const uint64_t key : Span<uint64_t>(keys, keys_num)) {
+      int cell;
+      if (cache) {
+        const int cache_slot = int((key ^ (key >> 9) ^ (key >> 18)) % CellLookupCache::size);
+        if (cache->keys[cache_slot] != key) {
+          cache->keys[cache_slot] = key;
+          cache->cells[cache_slot] = this->find_cell(key);
+        }
+        cell = cache->cells[cache_slot];
+      }
+      else {
+        cell = this->find_cell(key);
+      }
+      if (cell == -1) {
+        continue;
+      }
+      for (int i = cell_starts_[cell]; i < cell_starts_[cell + 1]; i++) {
+        const float dist_sq = math::distance_squared(positions_[i], position);
+        if (dist_sq <= radius_sq) {
+          if (!fn(i, dist_sq)) {
+            return false;
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  int3 cell_coord(const float3 &position) const
+  {
+    /* Clamp to keep neighbor coordinates in range. Non-finite values end up at the lower
+     * limit. Avoid #std::floor which isn't inlined without SSE4. */
+    const float limit = float(1 << 30);
+    int3 cell;
+    for (int i = 0; i < 3; i++) {
+      const float f = position[i] * cell_size_inv_;
+      const float f_clamped = (f > -limit) ? std::min(f, limit) : -limit;
+      const int c = int(f_clamped);
+      cell[i] = c - int(float(c) > f_clamped);
+    }
+    return cell;
+  }
+
+  /**
+   * Bits of one axis of a cell key, keys interleave the bits of the relative cell coordinates.
+   * Cells outside of the range of the key share keys with the cells at the limit, which is slow
+   * for distant points but still correct, since the same clamping is used when building and
+   * searching.
+   */
+  uint64_t cell_key_axis(const int c, const int axis) const
+  {
+    constexpr int64_t limit = (int64_t(1) << cell_key_bits) - 1;
+    uint64_t bits = uint64_t(
+        std::clamp(int64_t(c) - int64_t(cell_offset_[axis]), int64_t(0), limit));
+    bits = (bits | bits << 32) & 0x1f00000000ffffull;
+    bits = (bits | bits << 16) & 0x1f0000ff0000ffull;
+    bits = (bits | bits << 8) & 0x100f00f00f00f00full;
+    bits = (bits | bits << 4) & 0x10c30c30c30c30c3ull;
+    bits = (bits | bits << 2) & 0x1249249249249249ull;
+    return bits << axis;
+  }
+
+  uint64_t cell_key(const int3 &cell) const
+  {
+    return this->cell_key_axis(cell.x, 0) | this->cell_key_axis(cell.y, 1) |
+           this->cell_key_axis(cell.z, 2);
+  }
+
+  static uint64_t cell_key_hash(uint64_t key)
+  {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return key;
+  }
+
+  /** \return The index of the cell in #cell_starts_, or -1 when the cell is empty. */
+  int find_cell(const uint64_t key) const
+  {
+    for (uint64_t slot = cell_key_hash(key) & cell_table_mask_;;
+         slot = (slot + 1) & cell_table_mask_) {
+      const CellSlot &cell_slot = cell_table_[slot];
+      if (cell_slot.key == key) {
+        return cell_slot.cell;
+      }
+      if (cell_slot.key == cell_key_empty) {
+        return -1;
+      }
+    }
+  }
+};
+
+}  // namespace blender
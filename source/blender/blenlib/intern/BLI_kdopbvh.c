@@ -24,10 +24,14 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_alloca.h"
 #include "BLI_heap_simple.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_math.h"
+#include "BLI_math_bits.h"
+#include "BLI_simd.h"
 #include "BLI_stack.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
@@ -83,9 +87,13 @@ struct BVHTree {
   int totbranch;
   axis_t start_axis, stop_axis; /* bvhtree_kdop_axes array indices according to axis */
   axis_t axis;                  /* KDOP type (6 => OBB, 7 => AABB, ...) */
-  char tree_type;               /* type of tree (4 => quad-tree). */
+  /* Share a byte to stay small. */
+  unsigned char tree_type : 7; /* type of tree (4 => quad-tree), up to #MAX_TREETYPE. */
+  unsigned char use_sah : 1;   /* #BVH_BUILD_SAH */
 };
 
+BLI_STATIC_ASSERT(MAX_TREETYPE < (1 << 7), "tree_type bit-field too small")
+
 /* optimization, ensure we stay small */
 BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
                       (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
@@ -847,11 +855,393 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name SAH Build
+ *
+ * Alternative to the implicit tree, used with #BVH_BUILD_SAH.
+ *
+ * Leafs are split with the surface area heuristic, evaluated on #BVH_SAH_BINS bins of the leaf
+ * centers along each axis. Every branch collapses up to `tree_type` of these binary splits,
+ * always splitting the child with the largest surface area first. The resulting tree is not
+ * balanced, so it takes longer to build than the implicit tree, but queries have to visit fewer
+ * nodes, especially on meshes with uneven density.
+ *
+ * Like the implicit tree, every branch only covers a contiguous range of `tree->nodes`,
+ * and the children of a branch always have a greater index than their parent.
+ * \{ */
+
+#define BVH_SAH_BINS 16
+
+/* Leaf ranges above this size are binned and built in parallel. */
+#ifdef DEBUG
+#  define BVH_SAH_THREAD_LEAF_THRESHOLD 0
+#else
+#  define BVH_SAH_THREAD_LEAF_THRESHOLD 4096
+#endif
+
+typedef struct BVHSahBin {
+  /* Bounds of the leafs in the bin, laid out like #BVHNode.bv for the first three axes. */
+  float bounds[6];
+  int count;
+} BVHSahBin;
+
+typedef struct BVHSahBinning {
+  BVHSahBin bins[3][BVH_SAH_BINS];
+} BVHSahBinning;
+
+typedef struct BVHSahRange {
+  int begin, end;
+  float bounds[6];
+} BVHSahRange;
+
+typedef struct BVHSahBuildData {
+  BVHTree *tree;
+  BVHNode **leafs_array;
+  /* Number of branches used so far, incremented atomically. */
+  int branches_num;
+} BVHSahBuildData;
+
+typedef struct BVHSahBinningData {
+  BVHNode **leafs_array;
+  float center_min[3];
+  float center_scale[3];
+} BVHSahBinningData;
+
+typedef struct BVHSahBranchData {
+  BVHSahBuildData *build;
+  BVHNode *children[MAX_TREETYPE];
+  BVHSahRange ranges[MAX_TREETYPE];
+} BVHSahBranchData;
+
+static void bvh_sah_bounds_init(float bounds[6])
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bounds[2 * axis] = FLT_MAX;
+    bounds[2 * axis + 1] = -FLT_MAX;
+  }
+}
+
+static void bvh_sah_bounds_join(float bounds[6], const float other[6])
+{
+  for (int axis = 0; axis < 3; axis++) {
+    bounds[2 * axis] = min_ff(bounds[2 * axis], other[2 * axis]);
+    bounds[2 * axis + 1] = max_ff(bounds[2 * axis + 1], other[2 * axis + 1]);
+  }
+}
+
+static float bvh_sah_bounds_area(const float bounds[6])
+{
+  const float dx = bounds[1] - bounds[0];
+  const float dy = bounds[3] - bounds[2];
+  const float dz = bounds[5] - bounds[4];
+  return dx * dy + dy * dz + dz * dx;
+}
+
+BLI_INLINE float bvh_sah_leaf_center(const BVHNode *leaf, const int axis)
+{
+  return (leaf->bv[2 * axis] + leaf->bv[2 * axis + 1]) * 0.5f;
+}
+
+BLI_INLINE int bvh_sah_leaf_bin(const BVHSahBinningData *data, const BVHNode *leaf, const int axis)
+{
+  const int bin = (int)((bvh_sah_leaf_center(leaf, axis) - data->center_min[axis]) *
+                        data->center_scale[axis]);
+  return clamp_i(bin, 0, BVH_SAH_BINS - 1);
+}
+
+static void bvh_sah_binning_init(BVHSahBinning *binning)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < BVH_SAH_BINS; i++) {
+      bvh_sah_bounds_init(binning->bins[axis][i].bounds);
+      binning->bins[axis][i].count = 0;
+    }
+  }
+}
+
+static void bvh_sah_center_bounds_task_cb(void *__restrict userdata,
+                                          const int i,
+                                          const TaskParallelTLS *__restrict tls)
+{
+  const BVHSahBinningData *data = (const BVHSahBinningData *)userdata;
+  float *center_bounds = (float *)tls->userdata_chunk;
+  for (int axis = 0; axis < 3; axis++) {
+    const float center = bvh_sah_leaf_center(data->leafs_array[i], axis);
+    center_bounds[2 * axis] = min_ff(center_bounds[2 * axis], center);
+    center_bounds[2 * axis + 1] = max_ff(center_bounds[2 * axis + 1], center);
+  }
+}
+
+static void bvh_sah_center_bounds_reduce(const void *__restrict UNUSED(userdata),
+                                         void *__restrict chunk_join,
+                                         void *__restrict chunk)
+{
+  bvh_sah_bounds_join((float *)chunk_join, (const float *)chunk);
+}
+
+static void bvh_sah_binning_task_cb(void *__restrict userdata,
+                                    const int i,
+                                    const TaskParallelTLS *__restrict tls)
+{
+  const BVHSahBinningData *data = (const BVHSahBinningData *)userdata;
+  BVHSahBinning *binning = (BVHSahBinning *)tls->userdata_chunk;
+  const BVHNode *leaf = data->leafs_array[i];
+  for (int axis = 0; axis < 3; axis++) {
+    if (data->center_scale[axis] == 0.0f) {
+      continue;
+    }
+    BVHSahBin *bin = &binning->bins[axis][bvh_sah_leaf_bin(data, leaf, axis)];
+    bvh_sah_bounds_join(bin->bounds, leaf->bv);
+    bin->count++;
+  }
+}
+
+static void bvh_sah_binning_reduce(const void *__restrict UNUSED(userdata),
+                                   void *__restrict chunk_join,
+                                   void *__restrict chunk)
+{
+  BVHSahBinning *join = (BVHSahBinning *)chunk_join;
+  const BVHSahBinning *binning = (const BVHSahBinning *)chunk;
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < BVH_SAH_BINS; i++) {
+      bvh_sah_bounds_join(join->bins[axis][i].bounds, binning->bins[axis][i].bounds);
+      join->bins[axis][i].count += binning->bins[axis][i].count;
+    }
+  }
+}
+
+/**
+ * Split \a range in two with the surface area heuristic, reordering its leafs.
+ * \return The axis of the split.
+ */
+static int bvh_sah_split_range(BVHSahBuildData *build,
+                               const BVHSahRange *range,
+                               BVHSahRange *r_left,
+                               BVHSahRange *r_right)
+{
+  const int leafs_num = range->end - range->begin;
+  BVHSahBinningData data;
+  data.leafs_array = build->leafs_array;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (leafs_num > BVH_SAH_THREAD_LEAF_THRESHOLD);
+  settings.min_iter_per_thread = 1024;
+
+  float center_bounds[6];
+  bvh_sah_bounds_init(center_bounds);
+  settings.userdata_chunk = center_bounds;
+  settings.userdata_chunk_size = sizeof(center_bounds);
+  settings.func_reduce = bvh_sah_center_bounds_reduce;
+  BLI_task_parallel_range(
+      range->begin, range->end, &data, bvh_sah_center_bounds_task_cb, &settings);
+
+  for (int axis = 0; axis < 3; axis++) {
+    const float extent = center_bounds[2 * axis + 1] - center_bounds[2 * axis];
+    data.center_min[axis] = center_bounds[2 * axis];
+    /* Axes where all centers are the same can't be split. */
+    data.center_scale[axis] = (extent > 0.0f) ? (float)BVH_SAH_BINS / extent : 0.0f;
+  }
+
+  BVHSahBinning binning;
+  bvh_sah_binning_init(&binning);
+  settings.userdata_chunk = &binning;
+  settings.userdata_chunk_size = sizeof(binning);
+  settings.func_reduce = bvh_sah_binning_reduce;
+  BLI_task_parallel_range(range->begin, range->end, &data, bvh_sah_binning_task_cb, &settings);
+
+  /* Find the split with the smallest cost, sweeping the bins from both sides. */
+  int best_axis = -1, best_bin = 0;
+  float best_cost = FLT_MAX;
+  float best_bounds[2][6];
+  for (int axis = 0; axis < 3; axis++) {
+    if (data.center_scale[axis] == 0.0f) {
+      continue;
+    }
+    const BVHSahBin *bins = binning.bins[axis];
+    float right_bounds[BVH_SAH_BINS][6];
+    float right_cost[BVH_SAH_BINS];
+    float bounds[6];
+    int count = 0;
+    bvh_sah_bounds_init(bounds);
+    for (int i = BVH_SAH_BINS - 1; i > 0; i--) {
+      bvh_sah_bounds_join(bounds, bins[i].bounds);
+      count += bins[i].count;
+      memcpy(right_bounds[i], bounds, sizeof(bounds));
+      right_cost[i] = (count != 0) ? bvh_sah_bounds_area(bounds) * (float)count : -1.0f;
+    }
+    bvh_sah_bounds_init(bounds);
+    count = 0;
+    for (int i = 1; i < BVH_SAH_BINS; i++) {
+      bvh_sah_bounds_join(bounds, bins[i - 1].bounds);
+      count += bins[i - 1].count;
+      if (count == 0 || right_cost[i] < 0.0f) {
+        continue;
+      }
+      const float cost = bvh_sah_bounds_area(bounds) * (float)count + right_cost[i];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = i;
+        memcpy(best_bounds[0], bounds, sizeof(bounds));
+        memcpy(best_bounds[1], right_bounds[i], sizeof(bounds));
+      }
+    }
+  }
+
+  BVHNode **leafs_array = build->leafs_array;
+  int mid;
+  if (best_axis == -1) {
+    /* All leaf centers are the same, any split is as good as another. */
+    mid = range->begin + leafs_num / 2;
+    best_axis = 0;
+    bvh_sah_bounds_init(best_bounds[0]);
+    bvh_sah_bounds_init(best_bounds[1]);
+    for (int i = range->begin; i < range->end; i++) {
+      bvh_sah_bounds_join(best_bounds[i < mid ? 0 : 1], leafs_array[i]->bv);
+    }
+  }
+  else {
+    int i = range->begin, j = range->end - 1;
+    while (i <= j) {
+      if (bvh_sah_leaf_bin(&data, leafs_array[i], best_axis) < best_bin) {
+        i++;
+      }
+      else {
+        SWAP(BVHNode *, leafs_array[i], leafs_array[j]);
+        j--;
+      }
+    }
+    mid = i;
+  }
+  BLI_assert(mid > range->begin && mid < range->end);
+
+  r_left->begin = range->begin;
+  r_left->end = mid;
+  memcpy(r_left->bounds, best_bounds[0], sizeof(r_left->bounds));
+  r_right->begin = mid;
+  r_right->end = range->end;
+  memcpy(r_right->bounds, best_bounds[1], sizeof(r_right->bounds));
+  return best_axis;
+}
+
+static void bvh_sah_build_branch(BVHSahBuildData *build, BVHNode *node, const BVHSahRange *range);
+
+static void bvh_sah_build_children_task_cb(void *__restrict userdata,
+                                           const int i,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHSahBranchData *data = (BVHSahBranchData *)userdata;
+  if (data->ranges[i].end - data->ranges[i].begin > 1) {
+    bvh_sah_build_branch(data->build, data->children[i], &data->ranges[i]);
+  }
+}
+
+static void bvh_sah_build_branch(BVHSahBuildData *build, BVHNode *node, const BVHSahRange *range)
+{
+  BVHTree *tree = build->tree;
+  BVHSahBranchData data;
+  data.build = build;
+
+  if (tree->stop_axis == 3) {
+    /* The bounds of the range are the whole bounding volume. */
+    memcpy(node->bv, range->bounds, sizeof(range->bounds));
+  }
+  else {
+    refit_kdop_hull(tree, node, range->begin, range->end);
+  }
+  node->main_axis = (char)(get_largest_axis(node->bv) / 2);
+
+  /* Collapse binary splits into the children of this branch. */
+  int ranges_num = 1;
+  data.ranges[0] = *range;
+  while (ranges_num < tree->tree_type) {
+    int split = -1;
+    float split_area = -1.0f;
+    for (int i = 0; i < ranges_num; i++) {
+      if (data.ranges[i].end - data.ranges[i].begin > 1) {
+        const float area = bvh_sah_bounds_area(data.ranges[i].bounds);
+        if (area > split_area) {
+          split = i;
+          split_area = area;
+        }
+      }
+    }
+    if (split == -1) {
+      break;
+    }
+
+    BVHSahRange left, right;
+    const int axis = bvh_sah_split_range(build, &data.ranges[split], &left, &right);
+    if (ranges_num == 1) {
+      /* The first split is the most significant one, use it to order the children. */
+      node->main_axis = (char)axis;
+    }
+    /* Keep the children ordered like their leafs, so the order along the split axis is kept. */
+    memmove(&data.ranges[split + 2],
+            &data.ranges[split + 1],
+            sizeof(*data.ranges) * (size_t)(ranges_num - split - 1));
+    data.ranges[split] = left;
+    data.ranges[split + 1] = right;
+    ranges_num++;
+  }
+
+  for (int i = 0; i < ranges_num; i++) {
+    BVHNode *child;
+    if (data.ranges[i].end - data.ranges[i].begin == 1) {
+      child = build->leafs_array[data.ranges[i].begin];
+    }
+    else {
+      const int branch_index = atomic_fetch_and_add_int32(&build->branches_num, 1);
+      child = &tree->nodearray[tree->totleaf + branch_index];
+    }
+    child->parent = node;
+    node->children[i] = child;
+    data.children[i] = child;
+  }
+  node->totnode = (char)ranges_num;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (range->end - range->begin > BVH_SAH_THREAD_LEAF_THRESHOLD);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, ranges_num, &data, bvh_sah_build_children_task_cb, &settings);
+}
+
+/**
+ * Build the branches of \a tree with the surface area heuristic.
+ * \return The number of branches.
+ */
+static int bvh_sah_build(BVHTree *tree)
+{
+  BVHSahBuildData build;
+  build.tree = tree;
+  build.leafs_array = tree->nodes;
+  /* The root is the first branch. */
+  build.branches_num = 1;
+
+  BVHNode *root = &tree->nodearray[tree->totleaf];
+  root->parent = NULL;
+
+  BVHSahRange range;
+  range.begin = 0;
+  range.end = tree->totleaf;
+  bvh_sah_bounds_init(range.bounds);
+  for (int i = 0; i < tree->totleaf; i++) {
+    bvh_sah_bounds_join(range.bounds, tree->nodes[i]->bv);
+  }
+
+  bvh_sah_build_branch(&build, root, &range);
+  return build.branches_num;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
 
-BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
+BVHTree *BLI_bvhtree_new_ex(int maxsize, float epsilon, char tree_type, char axis, int flag)
 {
   BVHTree *tree;
   int numnodes, i;
@@ -868,8 +1258,9 @@ BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
 
   if (tree) {
     tree->epsilon = epsilon;
-    tree->tree_type = tree_type;
+    tree->tree_type = (unsigned char)(tree_type & 0x7f);
     tree->axis = axis;
+    tree->use_sah = (flag & BVH_BUILD_SAH) != 0;
 
     if (axis == 26) {
       tree->start_axis = 0;
@@ -898,8 +1289,20 @@ BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
       goto fail;
     }
 
+    /* The SAH build only uses x, y and z, fall back to the implicit tree without them. */
+    if (tree->start_axis != 0) {
+      tree->use_sah = false;
+    }
+
     /* Allocate arrays */
-    numnodes = maxsize + implicit_needed_branches(tree_type, maxsize) + tree_type;
+    numnodes = maxsize + tree_type;
+    if (tree->use_sah) {
+      /* Every branch has at least two children, except when there is a single leaf. */
+      numnodes += max_ii(1, maxsize - 1);
+    }
+    else {
+      numnodes += implicit_needed_branches(tree_type, maxsize);
+    }
 
     tree->nodes = MEM_callocN(sizeof(BVHNode *) * (size_t)numnodes, "BVHNodes");
     tree->nodebv = MEM_callocN(sizeof(float) * (size_t)(axis * numnodes), "BVHNodeBV");
@@ -923,6 +1326,11 @@ fail:
   return NULL;
 }
 
+BVHTree *BLI_bvhtree_new(int maxsize, float epsilon, char tree_type, char axis)
+{
+  return BLI_bvhtree_new_ex(maxsize, epsilon, tree_type, axis, 0);
+}
+
 void BLI_bvhtree_free(BVHTree *tree)
 {
   if (tree) {
@@ -942,13 +1350,18 @@ void BLI_bvhtree_balance(BVHTree *tree)
    * (some big bug goes here if its being called more than once per tree) */
   BLI_assert(tree->totbranch == 0);
 
-  /* Build the implicit tree */
-  non_recursive_bvh_div_nodes(
-      tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+  if (tree->use_sah && tree->totleaf > 1) {
+    tree->totbranch = bvh_sah_build(tree);
+  }
+  else {
+    /* Build the implicit tree */
+    non_recursive_bvh_div_nodes(
+        tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+    tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
+  }
 
   /* current code expects the branches to be linked to the nodes array
    * we perform that linkage here */
-  tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
   for (int i = 0; i < tree->totbranch; i++) {
     tree->nodes[tree->totleaf + i] = &tree->nodearray[tree->totleaf + i];
   }
@@ -1233,7 +1646,7 @@ static bool tree_overlap_traverse_num(BVHOverlapData_Thread *data_thread,
 
 int BLI_bvhtree_overlap_thread_num(const BVHTree *tree)
 {
-  return (int)MIN2(tree->tree_type, tree->nodes[tree->totleaf]->totnode);
+  return MIN2((int)tree->tree_type, (int)tree->nodes[tree->totleaf]->totnode);
 }
 
 static void bvhtree_overlap_task_cb(void *__restrict userdata,
@@ -1624,6 +2037,199 @@ int BLI_bvhtree_find_nearest(BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_find_nearest_array
+ *
+ * Points are queried in the order of a Morton curve through their bounds, so consecutive
+ * queries are close to each other. The nearest element of the previous point then gives
+ * a tight upper bound for the next query, which culls most of the tree right away.
+ * \{ */
+
+/* Number of sorted points that are queried one after the other by a single task. */
+#define BVH_NEAREST_ARRAY_CHUNK_SIZE 256
+/* Bits per axis of the Morton codes. */
+#define BVH_MORTON_BITS 10
+
+typedef struct BVHNearestArrayData {
+  BVHTree *tree;
+  const float (*co)[3];
+  int points_num;
+  const int *order;
+  BVHTreeNearest *nearest;
+  BVHTree_NearestPointCallback callback;
+  void *userdata;
+  int flag;
+
+  /* Used to compute the Morton codes. */
+  float co_min[3];
+  float co_scale[3];
+  uint *codes;
+} BVHNearestArrayData;
+
+/**
+ * Spread the lower 10 bits of \a x, so there are two zero bits between every bit.
+ */
+static uint morton_expand_bits(uint x)
+{
+  x = (x * 0x00010001u) & 0xFF0000FFu;
+  x = (x * 0x00000101u) & 0x0F00F00Fu;
+  x = (x * 0x00000011u) & 0xC30C30C3u;
+  x = (x * 0x00000005u) & 0x49249249u;
+  return x;
+}
+
+static void bvhtree_nearest_array_morton_task_cb(void *__restrict userdata,
+                                                 const int i,
+                                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHNearestArrayData *data = (BVHNearestArrayData *)userdata;
+  uint code = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    const float f = (data->co[i][axis] - data->co_min[axis]) * data->co_scale[axis];
+    const uint cell = (uint)clamp_f(f, 0.0f, (float)((1 << BVH_MORTON_BITS) - 1));
+    code |= morton_expand_bits(cell) << axis;
+  }
+  data->codes[i] = code;
+}
+
+/**
+ * Sort the point indices along a Morton curve, with a radix sort of the codes.
+ */
+static void bvhtree_nearest_array_sort(BVHNearestArrayData *data, int *r_order)
+{
+  const int points_num = data->points_num;
+
+  float co_max[3];
+  INIT_MINMAX(data->co_min, co_max);
+  for (int i = 0; i < points_num; i++) {
+    minmax_v3v3_v3(data->co_min, co_max, data->co[i]);
+  }
+  for (int axis = 0; axis < 3; axis++) {
+    const float extent = co_max[axis] - data->co_min[axis];
+    data->co_scale[axis] = (extent > 0.0f) ? (float)(1 << BVH_MORTON_BITS) / extent : 0.0f;
+  }
+
+  uint *codes = MEM_malloc_arrayN((size_t)points_num, sizeof(*codes), __func__);
+  uint *codes_tmp = MEM_malloc_arrayN((size_t)points_num, sizeof(*codes_tmp), __func__);
+  int *order_tmp = MEM_malloc_arrayN((size_t)points_num, sizeof(*order_tmp), __func__);
+  data->codes = codes;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (points_num > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  settings.min_iter_per_thread = 4096;
+  BLI_task_parallel_range(0, points_num, data, bvhtree_nearest_array_morton_task_cb, &settings);
+
+  for (int i = 0; i < points_num; i++) {
+    r_order[i] = i;
+  }
+
+  /* One pass per axis worth of bits, sorting the codes along with the indices. */
+  uint *src_codes = codes, *dst_codes = codes_tmp;
+  int *src_order = r_order, *dst_order = order_tmp;
+  for (int pass = 0; pass < 3; pass++) {
+    const int shift = pass * BVH_MORTON_BITS;
+    const uint digit_mask = (1u << BVH_MORTON_BITS) - 1;
+    int offsets[1 << BVH_MORTON_BITS] = {0};
+    for (int i = 0; i < points_num; i++) {
+      offsets[(src_codes[i] >> shift) & digit_mask]++;
+    }
+    int offset = 0;
+    for (int digit = 0; digit < (1 << BVH_MORTON_BITS); digit++) {
+      const int count = offsets[digit];
+      offsets[digit] = offset;
+      offset += count;
+    }
+    for (int i = 0; i < points_num; i++) {
+      const int dst = offsets[(src_codes[i] >> shift) & digit_mask]++;
+      dst_codes[dst] = src_codes[i];
+      dst_order[dst] = src_order[i];
+    }
+    SWAP(uint *, src_codes, dst_codes);
+    SWAP(int *, src_order, dst_order);
+  }
+  /* An odd number of passes leaves the result in the temporary array. */
+  if (src_order != r_order) {
+    memcpy(r_order, src_order, sizeof(*r_order) * (size_t)points_num);
+  }
+
+  MEM_freeN(codes);
+  MEM_freeN(codes_tmp);
+  MEM_freeN(order_tmp);
+  data->codes = NULL;
+}
+
+static void bvhtree_nearest_array_task_cb(void *__restrict userdata,
+                                          const int chunk_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHNearestArrayData *data = (const BVHNearestArrayData *)userdata;
+  const int start = chunk_index * BVH_NEAREST_ARRAY_CHUNK_SIZE;
+  const int end = min_ii(start + BVH_NEAREST_ARRAY_CHUNK_SIZE, data->points_num);
+
+  const BVHTreeNearest *prev_nearest = NULL;
+  for (int i = start; i < end; i++) {
+    const int index = data->order[i];
+    BVHTreeNearest *nearest = &data->nearest[index];
+
+    if (prev_nearest != NULL && prev_nearest->index != -1) {
+      /* The nearest point of the previous query is on the surface too,
+       * the distance to it is an upper bound for the distance of this query. */
+      const float dist_sq = len_squared_v3v3(data->co[index], prev_nearest->co);
+      if (dist_sq < nearest->dist_sq) {
+        nearest->index = prev_nearest->index;
+        nearest->dist_sq = dist_sq;
+        copy_v3_v3(nearest->co, prev_nearest->co);
+        copy_v3_v3(nearest->no, prev_nearest->no);
+      }
+    }
+
+    BLI_bvhtree_find_nearest_ex(
+        data->tree, data->co[index], nearest, data->callback, data->userdata, data->flag);
+    prev_nearest = nearest;
+  }
+}
+
+void BLI_bvhtree_find_nearest_array(BVHTree *tree,
+                                    const float (*co)[3],
+                                    const int points_num,
+                                    BVHTreeNearest *nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag)
+{
+  if (points_num == 0) {
+    return;
+  }
+
+  BVHNearestArrayData data = {
+      .tree = tree,
+      .co = co,
+      .points_num = points_num,
+      .nearest = nearest,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  int *order = MEM_malloc_arrayN((size_t)points_num, sizeof(*order), __func__);
+  bvhtree_nearest_array_sort(&data, order);
+  data.order = order;
+
+  const int chunks_num = (points_num + BVH_NEAREST_ARRAY_CHUNK_SIZE - 1) /
+                         BVH_NEAREST_ARRAY_CHUNK_SIZE;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (points_num > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, chunks_num, &data, bvhtree_nearest_array_task_cb, &settings);
+
+  MEM_freeN(order);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_find_nearest_first
  * \{ */
@@ -2026,6 +2632,239 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_ray_cast_array
+ *
+ * Casts many rays by traversing the tree with packets of #BVH_RAY_PACKET_SIZE rays.
+ * Each node is visited once per packet and its bounds are tested against all rays of the
+ * packet at once (with SSE2 when available). Rays that miss a node are masked out of its
+ * children, so this works best when consecutive rays are coherent.
+ *
+ * \{ */
+
+#define BVH_RAY_PACKET_SIZE 4
+
+typedef struct BVHRayPacketData {
+  /* Data of every ray, also used for the callbacks. */
+  BVHRayCastData rays[BVH_RAY_PACKET_SIZE];
+  int rays_num;
+
+  /* Stored per axis, so the bounds can be tested against all rays of the packet at once. */
+  float origin[3][BVH_RAY_PACKET_SIZE];
+  float idot_axis[3][BVH_RAY_PACKET_SIZE];
+  /* Copy of the hit distance of every ray, kept in sync after every leaf. */
+  float hit_dist[BVH_RAY_PACKET_SIZE];
+
+  /* Use the same test as #fast_ray_nearest_hit, only valid for rays without a radius. */
+  bool use_fast;
+} BVHRayPacketData;
+
+typedef struct BVHRayCastArrayData {
+  const BVHTree *tree;
+  const float (*origins)[3];
+  const float (*directions)[3];
+  int rays_num;
+  float radius;
+  BVHTreeRayHit *hits;
+  BVHTree_RayCastCallback callback;
+  void *userdata;
+  int flag;
+} BVHRayCastArrayData;
+
+/**
+ * Packet version of #fast_ray_nearest_hit and #ray_nearest_hit.
+ * \return The mask of the rays in \a mask that hit the bounds of \a node closer than their
+ * current hit, with their distance to the bounds in \a r_dist.
+ */
+static int ray_packet_nearest_hit(const BVHRayPacketData *packet,
+                                  const BVHNode *node,
+                                  const int mask,
+                                  float r_dist[BVH_RAY_PACKET_SIZE])
+{
+  const float *bv = node->bv;
+
+  if (!packet->use_fast) {
+    int hit_mask = 0;
+    for (int i = 0; i < packet->rays_num; i++) {
+      if (mask & (1 << i)) {
+        r_dist[i] = ray_nearest_hit(&packet->rays[i], bv);
+        if (r_dist[i] < packet->hit_dist[i]) {
+          hit_mask |= (1 << i);
+        }
+      }
+    }
+    return hit_mask;
+  }
+
+#ifdef BLI_HAVE_SSE2
+  __m128 t_near, t_far;
+  for (int axis = 0; axis < 3; axis++) {
+    const __m128 origin = _mm_loadu_ps(packet->origin[axis]);
+    const __m128 idot = _mm_loadu_ps(packet->idot_axis[axis]);
+    const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[2 * axis]), origin), idot);
+    const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[2 * axis + 1]), origin), idot);
+    if (axis == 0) {
+      t_near = _mm_min_ps(t1, t2);
+      t_far = _mm_max_ps(t1, t2);
+    }
+    else {
+      t_near = _mm_max_ps(t_near, _mm_min_ps(t1, t2));
+      t_far = _mm_min_ps(t_far, _mm_max_ps(t1, t2));
+    }
+  }
+  const __m128 is_hit = _mm_and_ps(
+      _mm_and_ps(_mm_cmple_ps(t_near, t_far), _mm_cmpge_ps(t_far, _mm_setzero_ps())),
+      _mm_cmplt_ps(t_near, _mm_loadu_ps(packet->hit_dist)));
+  _mm_storeu_ps(r_dist, t_near);
+  return _mm_movemask_ps(is_hit) & mask;
+#else
+  int hit_mask = 0;
+  for (int i = 0; i < BVH_RAY_PACKET_SIZE; i++) {
+    float t_near = -FLT_MAX, t_far = FLT_MAX;
+    for (int axis = 0; axis < 3; axis++) {
+      const float t1 = (bv[2 * axis] - packet->origin[axis][i]) * packet->idot_axis[axis][i];
+      const float t2 = (bv[2 * axis + 1] - packet->origin[axis][i]) * packet->idot_axis[axis][i];
+      t_near = max_ff(t_near, min_ff(t1, t2));
+      t_far = min_ff(t_far, max_ff(t1, t2));
+    }
+    r_dist[i] = t_near;
+    if (t_near <= t_far && t_far >= 0.0f && t_near < packet->hit_dist[i]) {
+      hit_mask |= (1 << i);
+    }
+  }
+  return hit_mask & mask;
+#endif
+}
+
+static void dfs_raycast_packet(BVHRayPacketData *packet, const BVHNode *node, int mask)
+{
+  float dist[BVH_RAY_PACKET_SIZE];
+  mask = ray_packet_nearest_hit(packet, node, mask, dist);
+  if (mask == 0) {
+    return;
+  }
+
+  if (node->totnode == 0) {
+    for (int i = 0; i < packet->rays_num; i++) {
+      if ((mask & (1 << i)) == 0) {
+        continue;
+      }
+      BVHRayCastData *data = &packet->rays[i];
+      if (data->callback) {
+        data->callback(data->userdata, node->index, &data->ray, &data->hit);
+      }
+      else {
+        data->hit.index = node->index;
+        data->hit.dist = dist[i];
+        madd_v3_v3v3fl(data->hit.co, data->ray.origin, data->ray.direction, dist[i]);
+      }
+      packet->hit_dist[i] = data->hit.dist;
+    }
+  }
+  else {
+    /* Pick the loop direction from the first ray that is still active, see #dfs_raycast. */
+    const BVHRayCastData *data = &packet->rays[bitscan_forward_i(mask)];
+    if (data->ray_dot_axis[node->main_axis] > 0.0f) {
+      for (int i = 0; i != node->totnode; i++) {
+        dfs_raycast_packet(packet, node->children[i], mask);
+      }
+    }
+    else {
+      for (int i = node->totnode - 1; i >= 0; i--) {
+        dfs_raycast_packet(packet, node->children[i], mask);
+      }
+    }
+  }
+}
+
+static void bvhtree_ray_cast_array_task_cb(void *__restrict userdata,
+                                           const int packet_index,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHRayCastArrayData *data = (const BVHRayCastArrayData *)userdata;
+  const BVHNode *root = data->tree->nodes[data->tree->totleaf];
+  const int ray_start = packet_index * BVH_RAY_PACKET_SIZE;
+
+  BVHRayPacketData packet;
+  packet.rays_num = min_ii(BVH_RAY_PACKET_SIZE, data->rays_num - ray_start);
+  packet.use_fast = (data->radius == 0.0f);
+
+  for (int i = 0; i < BVH_RAY_PACKET_SIZE; i++) {
+    if (i >= packet.rays_num) {
+      /* Unused rays are never part of the mask, only avoid testing uninitialized values. */
+      for (int axis = 0; axis < 3; axis++) {
+        packet.origin[axis][i] = 0.0f;
+        packet.idot_axis[axis][i] = 0.0f;
+      }
+      packet.hit_dist[i] = 0.0f;
+      continue;
+    }
+    const int ray_index = ray_start + i;
+    BVHRayCastData *ray_data = &packet.rays[i];
+
+    BLI_ASSERT_UNIT_V3(data->directions[ray_index]);
+
+    ray_data->tree = data->tree;
+    ray_data->callback = data->callback;
+    ray_data->userdata = data->userdata;
+    copy_v3_v3(ray_data->ray.origin, data->origins[ray_index]);
+    copy_v3_v3(ray_data->ray.direction, data->directions[ray_index]);
+    ray_data->ray.radius = data->radius;
+    bvhtree_ray_cast_data_precalc(ray_data, data->flag);
+    memcpy(&ray_data->hit, &data->hits[ray_index], sizeof(ray_data->hit));
+
+    for (int axis = 0; axis < 3; axis++) {
+      packet.origin[axis][i] = ray_data->ray.origin[axis];
+      packet.idot_axis[axis][i] = ray_data->idot_axis[axis];
+    }
+    packet.hit_dist[i] = ray_data->hit.dist;
+  }
+
+  dfs_raycast_packet(&packet, root, (1 << packet.rays_num) - 1);
+
+  for (int i = 0; i < packet.rays_num; i++) {
+    memcpy(&data->hits[ray_start + i], &packet.rays[i].hit, sizeof(packet.rays[i].hit));
+  }
+}
+
+void BLI_bvhtree_ray_cast_array(BVHTree *tree,
+                                const float (*origins)[3],
+                                const float (*directions)[3],
+                                const int rays_num,
+                                float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag)
+{
+  BVHNode *root = tree->nodes[tree->totleaf];
+  if (root == NULL || rays_num == 0) {
+    return;
+  }
+
+  BVHRayCastArrayData data = {
+      .tree = tree,
+      .origins = origins,
+      .directions = directions,
+      .rays_num = rays_num,
+      .radius = radius,
+      .hits = hits,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  const int packets_num = (rays_num + BVH_RAY_PACKET_SIZE - 1) / BVH_RAY_PACKET_SIZE;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (rays_num > KDOPBVH_THREAD_LEAF_THRESHOLD);
+  settings.min_iter_per_thread = 64;
+  BLI_task_parallel_range(0, packets_num, &data, bvhtree_ray_cast_array_task_cb, &settings);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
@@ -12,9 +12,16 @@
 #include "BLI_endian_switch.h"
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
+/* Maximum number of frames that are decompressed in parallel when reading sequentially. */
+#define ZSTD_MAX_PREFETCH_FRAMES 16
+
 typedef struct {
   FileReader reader;
 
@@ -29,8 +36,15 @@ typedef struct {
     size_t *compressed_ofs;
     size_t *uncompressed_ofs;
 
+    /* Decompressed content of the frames `[cached_frame, cached_frame + num_cached_frames)`,
+     * which are contiguous in the uncompressed stream. */
     char *cached_content;
     int cached_frame;
+    int num_cached_frames;
+
+    /* Decompression contexts of the frames decompressed in parallel, one per frame so that
+     * tasks never share them. Created on first use and kept until the reader is closed. */
+    ZSTD_DCtx *prefetch_ctx[ZSTD_MAX_PREFETCH_FRAMES];
   } seek;
 } ZstdReader;
 
@@ -127,6 +141,7 @@ static bool zstd_read_seek_table(ZstdReader *zstd)
   }
 
   zstd->seek.cached_frame = -1;
+  zstd->seek.num_cached_frames = 0;
 
   return true;
 }
@@ -154,21 +169,77 @@ static int zstd_frame_from_pos(ZstdReader *zstd, size_t pos)
   return low;
 }
 
-/* Ensure that the currently loaded frame is the correct one. */
+typedef struct ZstdDecompressData {
+  const ZstdReader *zstd;
+  int first_frame;
+  const char *compressed_data;
+  char *uncompressed_data;
+  int error;
+} ZstdDecompressData;
+
+static void zstd_decompress_frame_fn(void *__restrict userdata,
+                                     const int i,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ZstdDecompressData *data = userdata;
+  const ZstdReader *zstd = data->zstd;
+  const int frame = data->first_frame + i;
+  ZSTD_DCtx *ctx = zstd->seek.prefetch_ctx[i];
+
+  const size_t *compressed_ofs = zstd->seek.compressed_ofs;
+  const size_t *uncompressed_ofs = zstd->seek.uncompressed_ofs;
+  const size_t compressed_size = compressed_ofs[frame + 1] - compressed_ofs[frame];
+  const size_t uncompressed_size = uncompressed_ofs[frame + 1] - uncompressed_ofs[frame];
+
+  size_t res = ZSTD_decompressDCtx(
+      ctx,
+      data->uncompressed_data + (uncompressed_ofs[frame] - uncompressed_ofs[data->first_frame]),
+      uncompressed_size,
+      data->compressed_data + (compressed_ofs[frame] - compressed_ofs[data->first_frame]),
+      compressed_size);
+  if (ZSTD_isError(res) || res < uncompressed_size) {
+    atomic_fetch_and_add_int32(&data->error, 1);
+  }
+}
+
+/* Ensure that the given frame is loaded. When the file is read sequentially (the frame follows
+ * the ones loaded before, possibly skipping over data that is read on demand), the next few
+ * frames are decompressed along with it in parallel, since they are going to be needed next.
+ * Random access only decompresses the requested frame. */
 static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
 {
-  if (zstd->seek.cached_frame == frame) {
-    /* Cached frame matches, so just return it. */
-    return zstd->seek.cached_content;
+  if (frame >= zstd->seek.cached_frame &&
+      frame < zstd->seek.cached_frame + zstd->seek.num_cached_frames) {
+    /* Cached frames contain the wanted one, so just return it. */
+    return zstd->seek.cached_content +
+           (zstd->seek.uncompressed_ofs[frame] -
+            zstd->seek.uncompressed_ofs[zstd->seek.cached_frame]);
   }
 
-  /* Cached frame doesn't match, so discard it and cache the wanted one instead. */
+  /* Cached frames don't match, so discard them and cache the wanted ones instead. */
+  const int cached_end = zstd->seek.cached_frame + zstd->seek.num_cached_frames;
+  const bool is_sequential = (frame == 0) || (frame >= cached_end &&
+                                              frame < cached_end + ZSTD_MAX_PREFETCH_FRAMES);
   MEM_SAFE_FREE(zstd->seek.cached_content);
+  zstd->seek.cached_frame = -1;
+  zstd->seek.num_cached_frames = 0;
+
+  int num_frames = 1;
+  if (is_sequential) {
+    num_frames = min_iii(zstd->seek.num_frames - frame,
+                         BLI_system_thread_count(),
+                         ZSTD_MAX_PREFETCH_FRAMES);
+    num_frames = max_ii(num_frames, 1);
+  }
+  const int end_frame = frame + num_frames;
 
-  size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
-  size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
+  size_t compressed_size = zstd->seek.compressed_ofs[end_frame] -
+                           zstd->seek.compressed_ofs[frame];
+  size_t uncompressed_size = zstd->seek.uncompressed_ofs[end_frame] -
                              zstd->seek.uncompressed_ofs[frame];
 
+  /* Frames are contiguous in the file, so their compressed data is read at once. Reading is not
+   * thread-safe, only the decompression is done in parallel. */
   char *uncompressed_data = MEM_mallocN(uncompressed_size, __func__);
   char *compressed_data = MEM_mallocN(compressed_size, __func__);
   if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
@@ -178,15 +249,31 @@ static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
     return NULL;
   }
 
-  size_t res = ZSTD_decompressDCtx(
-      zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
+  ZstdDecompressData data = {zstd, frame, compressed_data, uncompressed_data, 0};
+  if (num_frames == 1) {
+    size_t res = ZSTD_decompressDCtx(
+        zstd->ctx, uncompressed_data, uncompressed_size, compressed_data, compressed_size);
+    data.error = ZSTD_isError(res) || res < uncompressed_size;
+  }
+  else {
+    for (int i = 0; i < num_frames; i++) {
+      if (zstd->seek.prefetch_ctx[i] == NULL) {
+        zstd->seek.prefetch_ctx[i] = ZSTD_createDCtx();
+      }
+    }
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+    BLI_task_parallel_range(0, num_frames, &data, zstd_decompress_frame_fn, &settings);
+  }
   MEM_freeN(compressed_data);
-  if (ZSTD_isError(res) || res < uncompressed_size) {
+  if (data.error) {
     MEM_freeN(uncompressed_data);
     return NULL;
   }
 
   zstd->seek.cached_frame = frame;
+  zstd->seek.num_cached_frames = num_frames;
   zstd->seek.cached_content = uncompressed_data;
   return uncompressed_data;
 }
@@ -281,7 +368,12 @@ static void zstd_close(FileReader *reader)
   if (zstd->reader.seek) {
     MEM_freeN(zstd->seek.uncompressed_ofs);
     MEM_freeN(zstd->seek.compressed_ofs);
-    MEM_freeN(zstd->seek.cached_content);
+    MEM_SAFE_FREE(zstd->seek.cached_content);
+    for (int i = 0; i < ZSTD_MAX_PREFETCH_FRAMES; i++) {
+      if (zstd->seek.prefetch_ctx[i]) {
+        ZSTD_freeDCtx(zstd->seek.prefetch_ctx[i]);
+      }
+    }
   }
   else {
     MEM_freeN((void *)zstd->in_buf.src);
@@ -8,6 +8,7 @@
 
 #include "BLI_kdtree_impl.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_strict_flags.h"
 #include "BLI_utildefines.h"
 
@@ -44,6 +45,13 @@ struct KDTree {
 
 #define KD_NODE_UNSET ((uint)-1)
 
+/** Sub-trees with more nodes than this have their halves balanced in parallel. */
+#define KD_BALANCE_THREAD_THRESHOLD 8192
+/** Number of points handled by one task in batched queries. */
+#define KD_BATCH_CHUNK_SIZE 256
+/** Search duplicates using multiple threads for trees with more nodes than this. */
+#define KD_DEDUP_THREAD_THRESHOLD 1024
+
 /**
  * When set we know all values are unbalanced,
  * otherwise clear them when re-balancing: see T62210.
@@ -131,6 +139,33 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
+static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs);
+
+struct BalanceSplitData {
+  KDTreeNode *nodes;
+  uint nodes_len;
+  uint median;
+  uint axis;
+  uint ofs;
+};
+
+static void kdtree_balance_split_task_cb(void *__restrict userdata,
+                                         const int j,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const struct BalanceSplitData *data = userdata;
+  KDTreeNode *node = &data->nodes[data->median];
+  if (j == 0) {
+    node->left = kdtree_balance(data->nodes, data->median, data->axis, data->ofs);
+  }
+  else {
+    node->right = kdtree_balance(data->nodes + data->median + 1,
+                                 (data->nodes_len - (data->median + 1)),
+                                 data->axis,
+                                 (data->median + 1) + data->ofs);
+  }
+}
+
 static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
 {
   KDTreeNode *node;
@@ -180,9 +215,25 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
   node = &nodes[median];
   node->d = axis;
   axis = (axis + 1) % KD_DIMS;
-  node->left = kdtree_balance(nodes, median, axis, ofs);
-  node->right = kdtree_balance(
-      nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
+  if (nodes_len > KD_BALANCE_THREAD_THRESHOLD) {
+    /* Both halves are independent, balance them in parallel. */
+    struct BalanceSplitData data = {
+        .nodes = nodes,
+        .nodes_len = nodes_len,
+        .median = median,
+        .axis = axis,
+        .ofs = ofs,
+    };
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+    BLI_task_parallel_range(0, 2, &data, kdtree_balance_split_task_cb, &settings);
+  }
+  else {
+    node->left = kdtree_balance(nodes, median, axis, ofs);
+    node->right = kdtree_balance(
+        nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
+  }
 
   return median + ofs;
 }
@@ -318,6 +369,45 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
   return min_node->index;
 }
 
+struct FindNearestArrayData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  KDTreeNearest *r_nearest;
+};
+
+static void find_nearest_array_task_cb(void *__restrict userdata,
+                                       const int i,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const struct FindNearestArrayData *data = userdata;
+  if (BLI_kdtree_nd_(find_nearest)(data->tree, data->co[i], &data->r_nearest[i]) == -1) {
+    data->r_nearest[i].index = -1;
+  }
+}
+
+/**
+ * Batched version of #BLI_kdtree_3d_find_nearest, using multiple threads.
+ *
+ * \param r_nearest: Array of \a co_len results, the index is -1 when the tree is empty.
+ */
+void BLI_kdtree_nd_(find_nearest_array)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        KDTreeNearest *r_nearest)
+{
+  struct FindNearestArrayData data = {
+      .tree = tree,
+      .co = co,
+      .r_nearest = r_nearest,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (co_len > KD_BATCH_CHUNK_SIZE);
+  settings.min_iter_per_thread = KD_BATCH_CHUNK_SIZE;
+  BLI_task_parallel_range(0, (int)co_len, &data, find_nearest_array_task_cb, &settings);
+}
+
 /**
  * A version of #BLI_kdtree_3d_find_nearest which runs a callback
  * to filter out values.
@@ -611,8 +701,10 @@ static void nearest_add_in_range(KDTreeNearest **r_nearest,
   KDTreeNearest *to;
 
   if (UNLIKELY(nearest_index >= *nearest_len_capacity)) {
+    /* Grow geometrically, batched searches collect the results of many points in one array. */
+    *nearest_len_capacity += max_uu(KD_FOUND_ALLOC_INC, *nearest_len_capacity);
     *r_nearest = MEM_reallocN_id(
-        *r_nearest, (*nearest_len_capacity += KD_FOUND_ALLOC_INC) * sizeof(KDTreeNode), __func__);
+        *r_nearest, *nearest_len_capacity * sizeof(KDTreeNearest), __func__);
   }
 
   to = (*r_nearest) + nearest_index;
@@ -623,39 +715,31 @@ static void nearest_add_in_range(KDTreeNearest **r_nearest,
 }
 
 /**
- * Range search returns number of points nearest_len, with results in nearest
+ * Append the points in \a range of \a co to \a r_nearest, sorted by distance.
  *
- * \param r_nearest: Allocated array of nearest nearest_len (caller is responsible for freeing).
+ * \return The length of \a r_nearest including the new results.
  */
-int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
+static uint kdtree_range_search_append(
     const KDTree *tree,
     const float co[KD_DIMS],
-    KDTreeNearest **r_nearest,
     const float range,
     float (*len_sq_fn)(const float co_search[KD_DIMS],
                        const float co_test[KD_DIMS],
                        const void *user_data),
-    const void *user_data)
+    const void *user_data,
+    KDTreeNearest **r_nearest,
+    uint nearest_len,
+    uint *nearest_len_capacity)
 {
   const KDTreeNode *nodes = tree->nodes;
   uint *stack, stack_default[KD_STACK_INIT];
-  KDTreeNearest *nearest = NULL;
   const float range_sq = range * range;
+  const uint nearest_len_prev = nearest_len;
   float dist_sq;
   uint stack_len_capacity, cur = 0;
-  uint nearest_len = 0, nearest_len_capacity = 0;
-
-#ifdef DEBUG
-  BLI_assert(tree->is_balanced == true);
-#endif
 
   if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
-    return 0;
-  }
-
-  if (len_sq_fn == NULL) {
-    len_sq_fn = len_squared_vnvn_cb;
-    BLI_assert(user_data == NULL);
+    return nearest_len;
   }
 
   stack = stack_default;
@@ -680,7 +764,7 @@ int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
       dist_sq = len_sq_fn(co, node->co, user_data);
       if (dist_sq <= range_sq) {
         nearest_add_in_range(
-            &nearest, nearest_len++, &nearest_len_capacity, node->index, dist_sq, node->co);
+            r_nearest, nearest_len++, nearest_len_capacity, node->index, dist_sq, node->co);
       }
 
       if (node->left != KD_NODE_UNSET) {
@@ -700,10 +784,46 @@ int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
     MEM_freeN(stack);
   }
 
-  if (nearest_len) {
-    qsort(nearest, nearest_len, sizeof(KDTreeNearest), nearest_cmp_dist);
+  if (nearest_len - nearest_len_prev > 1) {
+    qsort(*r_nearest + nearest_len_prev,
+          nearest_len - nearest_len_prev,
+          sizeof(KDTreeNearest),
+          nearest_cmp_dist);
   }
 
+  return nearest_len;
+}
+
+/**
+ * Range search returns number of points nearest_len, with results in nearest
+ *
+ * \param r_nearest: Allocated array of nearest nearest_len (caller is responsible for freeing).
+ */
+int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
+    const KDTree *tree,
+    const float co[KD_DIMS],
+    KDTreeNearest **r_nearest,
+    const float range,
+    float (*len_sq_fn)(const float co_search[KD_DIMS],
+                       const float co_test[KD_DIMS],
+                       const void *user_data),
+    const void *user_data)
+{
+  KDTreeNearest *nearest = NULL;
+  uint nearest_len_capacity = 0;
+
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  if (len_sq_fn == NULL) {
+    len_sq_fn = len_squared_vnvn_cb;
+    BLI_assert(user_data == NULL);
+  }
+
+  const uint nearest_len = kdtree_range_search_append(
+      tree, co, range, len_sq_fn, user_data, &nearest, 0, &nearest_len_capacity);
+
   *r_nearest = nearest;
 
   return (int)nearest_len;
@@ -717,6 +837,117 @@ int BLI_kdtree_nd_(range_search)(const KDTree *tree,
   return BLI_kdtree_nd_(range_search_with_len_squared_cb)(tree, co, r_nearest, range, NULL, NULL);
 }
 
+struct RangeSearchArrayData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  uint co_len;
+  float range;
+  /** Number of results for each point, accumulated into offsets afterwards. */
+  uint *offsets;
+  /** Results buffered for every chunk of #KD_BATCH_CHUNK_SIZE points. */
+  KDTreeNearest **chunk_nearest;
+  uint *chunk_nearest_len;
+};
+
+static void range_search_array_task_cb(void *__restrict userdata,
+                                       const int chunk,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const struct RangeSearchArrayData *data = userdata;
+  const uint start = (uint)chunk * KD_BATCH_CHUNK_SIZE;
+  const uint end = min_uu(start + KD_BATCH_CHUNK_SIZE, data->co_len);
+  KDTreeNearest *nearest = NULL;
+  uint nearest_len = 0, nearest_len_capacity = 0;
+
+  for (uint i = start; i < end; i++) {
+    const uint nearest_len_prev = nearest_len;
+    nearest_len = kdtree_range_search_append(data->tree,
+                                             data->co[i],
+                                             data->range,
+                                             len_squared_vnvn_cb,
+                                             NULL,
+                                             &nearest,
+                                             nearest_len,
+                                             &nearest_len_capacity);
+    data->offsets[i] = nearest_len - nearest_len_prev;
+  }
+
+  data->chunk_nearest[chunk] = nearest;
+  data->chunk_nearest_len[chunk] = nearest_len;
+}
+
+/**
+ * Batched version of #BLI_kdtree_3d_range_search, using multiple threads.
+ * Results are collected per chunk of points and joined afterwards, so the output
+ * doesn't depend on the number of threads.
+ *
+ * \param r_offsets: Allocated array of `co_len + 1` offsets, the results for `co[i]`
+ * are `r_nearest[r_offsets[i]]` up to `r_nearest[r_offsets[i + 1]]`, sorted by distance.
+ * \param r_nearest: Allocated array of all results, NULL when none are found.
+ * The caller is responsible for freeing both arrays.
+ * \return The total number of results.
+ */
+uint BLI_kdtree_nd_(range_search_array)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        const float range,
+                                        uint **r_offsets,
+                                        KDTreeNearest **r_nearest)
+{
+  const uint chunks_len = divide_ceil_u(co_len, KD_BATCH_CHUNK_SIZE);
+  uint *offsets = MEM_mallocN(sizeof(*offsets) * (co_len + 1), __func__);
+  KDTreeNearest *nearest = NULL;
+
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  struct RangeSearchArrayData data = {
+      .tree = tree,
+      .co = co,
+      .co_len = co_len,
+      .range = range,
+      .offsets = offsets,
+      .chunk_nearest = MEM_mallocN(sizeof(*data.chunk_nearest) * chunks_len, __func__),
+      .chunk_nearest_len = MEM_mallocN(sizeof(*data.chunk_nearest_len) * chunks_len, __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (chunks_len > 1);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, (int)chunks_len, &data, range_search_array_task_cb, &settings);
+
+  uint nearest_len = 0;
+  for (uint i = 0; i < co_len; i++) {
+    const uint len = offsets[i];
+    offsets[i] = nearest_len;
+    nearest_len += len;
+  }
+  offsets[co_len] = nearest_len;
+
+  if (nearest_len) {
+    nearest = MEM_mallocN(sizeof(*nearest) * nearest_len, __func__);
+  }
+  KDTreeNearest *nearest_iter = nearest;
+  for (uint chunk = 0; chunk < chunks_len; chunk++) {
+    if (data.chunk_nearest[chunk]) {
+      memcpy(nearest_iter,
+             data.chunk_nearest[chunk],
+             sizeof(*nearest) * data.chunk_nearest_len[chunk]);
+      nearest_iter += data.chunk_nearest_len[chunk];
+      MEM_freeN(data.chunk_nearest[chunk]);
+    }
+  }
+  MEM_freeN(data.chunk_nearest);
+  MEM_freeN(data.chunk_nearest_len);
+
+  *r_offsets = offsets;
+  *r_nearest = nearest;
+
+  return nearest_len;
+}
+
 /**
  * A version of #BLI_kdtree_3d_range_search which runs a callback
  * instead of allocating an array.
@@ -852,11 +1083,202 @@ static void deduplicate_recursive(const struct DeDuplicateParams *p, uint i)
   }
 }
 
+/**
+ * Maximum number of duplicates stored for each point by the threaded search,
+ * points with more are searched again when merging (the results are the same).
+ */
+#define KD_DEDUP_FOUND_MAX 8
+#define KD_DEDUP_FOUND_OVERFLOW ((uchar)-1)
+
+/**
+ * Same as #deduplicate_recursive, storing the duplicates instead of tagging them.
+ * \return false when more than #KD_DEDUP_FOUND_MAX duplicates are found.
+ */
+static bool deduplicate_gather_recursive(const struct DeDuplicateParams *p,
+                                         uint i,
+                                         int found[KD_DEDUP_FOUND_MAX],
+                                         uint *found_len)
+{
+  const KDTreeNode *node = &p->nodes[i];
+  if (p->search_co[node->d] + p->range <= node->co[node->d]) {
+    if (node->left != KD_NODE_UNSET) {
+      return deduplicate_gather_recursive(p, node->left, found, found_len);
+    }
+  }
+  else if (p->search_co[node->d] - p->range >= node->co[node->d]) {
+    if (node->right != KD_NODE_UNSET) {
+      return deduplicate_gather_recursive(p, node->right, found, found_len);
+    }
+  }
+  else {
+    if ((p->search != node->index) && (p->duplicates[node->index] == -1)) {
+      if (len_squared_vnvn(node->co, p->search_co) <= p->range_sq) {
+        if (*found_len == KD_DEDUP_FOUND_MAX) {
+          return false;
+        }
+        found[(*found_len)++] = node->index;
+      }
+    }
+    if (node->left != KD_NODE_UNSET) {
+      if (!deduplicate_gather_recursive(p, node->left, found, found_len)) {
+        return false;
+      }
+    }
+    if (node->right != KD_NODE_UNSET) {
+      return deduplicate_gather_recursive(p, node->right, found, found_len);
+    }
+  }
+  return true;
+}
+
+struct DeDuplicateThreadedData {
+  const KDTree *tree;
+  const struct DeDuplicateParams *params;
+  /** Optional, from #kdtree_order. */
+  const uint *order;
+  /** Number of duplicates found for each search, or #KD_DEDUP_FOUND_OVERFLOW. */
+  uchar *found_len;
+  /** Duplicates buffered for every chunk of #KD_BATCH_CHUNK_SIZE searches. */
+  int **chunk_found;
+};
+
+static void deduplicate_search_index(const struct DeDuplicateThreadedData *data,
+                                     const uint i,
+                                     uint *r_node_index,
+                                     int *r_index)
+{
+  if (data->order) {
+    *r_node_index = data->order[i];
+    *r_index = (int)i;
+  }
+  else {
+    *r_node_index = i;
+    *r_index = data->tree->nodes[i].index;
+  }
+}
+
+static void deduplicate_gather_task_cb(void *__restrict userdata,
+                                       const int chunk,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const struct DeDuplicateThreadedData *data = userdata;
+  const uint start = (uint)chunk * KD_BATCH_CHUNK_SIZE;
+  const uint end = min_uu(start + KD_BATCH_CHUNK_SIZE, data->tree->nodes_len);
+  struct DeDuplicateParams p = *data->params;
+  int *chunk_found = NULL;
+  uint chunk_found_len = 0, chunk_found_len_capacity = 0;
+
+  for (uint i = start; i < end; i++) {
+    uint node_index;
+    int index;
+    deduplicate_search_index(data, i, &node_index, &index);
+    data->found_len[i] = 0;
+    if (!ELEM(p.duplicates[index], -1, index)) {
+      continue;
+    }
+    int found[KD_DEDUP_FOUND_MAX];
+    uint found_len = 0;
+    p.search = index;
+    copy_vn_vn(p.search_co, data->tree->nodes[node_index].co);
+    if (!deduplicate_gather_recursive(&p, data->tree->root, found, &found_len)) {
+      data->found_len[i] = KD_DEDUP_FOUND_OVERFLOW;
+      continue;
+    }
+    if (found_len == 0) {
+      continue;
+    }
+    if (chunk_found_len + found_len > chunk_found_len_capacity) {
+      chunk_found_len_capacity = max_uu(chunk_found_len_capacity * 2,
+                                        KD_BATCH_CHUNK_SIZE + KD_DEDUP_FOUND_MAX);
+      chunk_found = MEM_reallocN_id(
+          chunk_found, sizeof(*chunk_found) * chunk_found_len_capacity, __func__);
+    }
+    memcpy(&chunk_found[chunk_found_len], found, sizeof(*found) * found_len);
+    chunk_found_len += found_len;
+    data->found_len[i] = (uchar)found_len;
+  }
+
+  data->chunk_found[chunk] = chunk_found;
+}
+
+/**
+ * Threaded version of #BLI_kdtree_3d_calc_duplicates_fast.
+ *
+ * The searches run in parallel, only reading \a duplicates, then merging runs in order
+ * using the stored results, giving the same result as searching one point at a time.
+ * This works because values in \a duplicates are only ever changed from -1.
+ */
+static int deduplicate_threaded(const KDTree *tree,
+                                const struct DeDuplicateParams *p,
+                                const bool use_index_order)
+{
+  const uint chunks_len = divide_ceil_u(tree->nodes_len, KD_BATCH_CHUNK_SIZE);
+  int *duplicates = p->duplicates;
+  struct DeDuplicateThreadedData data = {
+      .tree = tree,
+      .params = p,
+      .order = use_index_order ? kdtree_order(tree) : NULL,
+      .found_len = MEM_mallocN(sizeof(*data.found_len) * tree->nodes_len, __func__),
+      .chunk_found = MEM_mallocN(sizeof(*data.chunk_found) * chunks_len, __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, (int)chunks_len, &data, deduplicate_gather_task_cb, &settings);
+
+  struct DeDuplicateParams p_search = *p;
+  for (uint chunk = 0; chunk < chunks_len; chunk++) {
+    const int *found_iter = data.chunk_found[chunk];
+    const uint start = chunk * KD_BATCH_CHUNK_SIZE;
+    const uint end = min_uu(start + KD_BATCH_CHUNK_SIZE, tree->nodes_len);
+    for (uint i = start; i < end; i++) {
+      uint node_index;
+      int index;
+      deduplicate_search_index(&data, i, &node_index, &index);
+      const uchar found_len = data.found_len[i];
+      if (ELEM(duplicates[index], -1, index)) {
+        int found_prev = *p->duplicates_found;
+        if (found_len == KD_DEDUP_FOUND_OVERFLOW) {
+          p_search.search = index;
+          copy_vn_vn(p_search.search_co, tree->nodes[node_index].co);
+          deduplicate_recursive(&p_search, tree->root);
+        }
+        else {
+          for (uint j = 0; j < found_len; j++) {
+            if (duplicates[found_iter[j]] == -1) {
+              duplicates[found_iter[j]] = index;
+              *p->duplicates_found += 1;
+            }
+          }
+        }
+        if (*p->duplicates_found != found_prev) {
+          /* Prevent chains of doubles. */
+          duplicates[index] = index;
+        }
+      }
+      if (found_len != KD_DEDUP_FOUND_OVERFLOW) {
+        found_iter += found_len;
+      }
+    }
+    MEM_SAFE_FREE(data.chunk_found[chunk]);
+  }
+
+  if (data.order) {
+    MEM_freeN((void *)data.order);
+  }
+  MEM_freeN(data.found_len);
+  MEM_freeN(data.chunk_found);
+
+  return *p->duplicates_found;
+}
+
 /**
  * Find duplicate points in \a range.
  * Favors speed over quality since it doesn't find the best target vertex for merging.
  * Nodes are looped over, duplicates are added when found.
  * Nevertheless results are predictable.
+ * Large trees are searched using multiple threads, giving the same results.
  *
  * \param range: Coordinates in this range are candidates to be merged.
  * \param use_index_order: Loop over the coordinates ordered by #KDTreeNode.index
@@ -884,6 +1306,10 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
       .duplicates_found = &found,
   };
 
+  if (tree->nodes_len > KD_DEDUP_THREAD_THRESHOLD) {
+    return deduplicate_threaded(tree, &p, use_index_order);
+  }
+
   if (use_index_order) {
     uint *order = kdtree_order(tree);
     for (uint i = 0; i < tree->nodes_len; i++) {
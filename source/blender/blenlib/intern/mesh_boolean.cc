@@ -872,6 +872,39 @@ static const Vert *find_flap_vert(const Face &tri, const Edge e, bool *r_rev)
   return flapv;
 }
 
+/**
+ * Return the same value as #orient3d on the exact coordinates of the vertices, using double
+ * arithmetic with an error bound first and only falling back to exact arithmetic when the sign
+ * is uncertain. The error bound uses the supremum and index functions of Burnikel et al, as
+ * #filter_plane_side in mesh_intersect.cc does, where the index of the determinant is 11.
+ */
+static int orient3d_filtered(const Vert *a, const Vert *b, const Vert *c, const Vert *d)
+{
+  if (ELEM(d, a, b, c)) {
+    return 0;
+  }
+  const double3 ad = a->co - d->co;
+  const double3 bd = b->co - d->co;
+  const double3 cd = c->co - d->co;
+  const double det = ad.z * (bd.x * cd.y - cd.x * bd.y) + bd.z * (cd.x * ad.y - ad.x * cd.y) +
+                     cd.z * (ad.x * bd.y - bd.x * ad.y);
+  if (det != 0.0) {
+    const double3 abs_d = math::abs(d->co);
+    const double3 sup_ad = math::abs(a->co) + abs_d;
+    const double3 sup_bd = math::abs(b->co) + abs_d;
+    const double3 sup_cd = math::abs(c->co) + abs_d;
+    const double supremum = sup_ad.z * (sup_bd.x * sup_cd.y + sup_cd.x * sup_bd.y) +
+                            sup_bd.z * (sup_cd.x * sup_ad.y + sup_ad.x * sup_cd.y) +
+                            sup_cd.z * (sup_ad.x * sup_bd.y + sup_bd.x * sup_ad.y);
+    constexpr int index_orient3d = 11;
+    const double err_bound = supremum * index_orient3d * DBL_EPSILON;
+    if (fabs(det) > err_bound) {
+      return det > 0 ? 1 : -1;
+    }
+  }
+  return orient3d(a->co_exact, b->co_exact, c->co_exact, d->co_exact);
+}
+
 /**
  * Triangle \a tri and tri0 share edge e.
  * Classify \a tri with respect to tri0 as described in
@@ -892,9 +925,6 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
   if (dbg_level > 0) {
     std::cout << "classify  e = " << e << "\n";
   }
-  mpq3 a0 = tri0[0]->co_exact;
-  mpq3 a1 = tri0[1]->co_exact;
-  mpq3 a2 = tri0[2]->co_exact;
   bool rev;
   bool rev0;
   const Vert *flapv0 = find_flap_vert(tri0, e, &rev0);
@@ -906,9 +936,8 @@ static int sort_tris_class(const Face &tri, const Face &tri0, const Edge e)
     std::cout << " rev = " << rev << " flapv = " << flapv << "\n";
   }
   BLI_assert(flapv != nullptr && flapv0 != nullptr);
-  const mpq3 flap = flapv->co_exact;
-  /* orient will be positive if flap is below oriented plane of a0,a1,a2. */
-  int orient = orient3d(a0, a1, a2, flap);
+  /* orient will be positive if flap is below oriented plane of tri0. */
+  int orient = orient3d_filtered(tri0[0], tri0[1], tri0[2], flapv);
   int ans;
   if (orient > 0) {
     ans = rev0 ? 4 : 3;
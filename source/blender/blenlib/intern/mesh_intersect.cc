@@ -1149,39 +1149,98 @@ static int filter_plane_side(const double3 &p,
  * The ab, ac, and dotbuf arguments are used as a temporaries; declaring them
  * in the caller can avoid many allocs and frees of mpq3 and mpq_class structures.
  */
-static inline mpq3 tti_interp(
-    const mpq3 &a, const mpq3 &b, const mpq3 &c, const mpq3 &n, mpq3 &ab, mpq3 &ac, mpq3 &dotbuf)
-{
-  ab = a;
-  ab -= b;
-  ac = a;
-  ac -= c;
+static inline mpq3 tti_interp(const Vert *a,
+                              const Vert *b,
+                              const Vert *c,
+                              const mpq3 &n,
+                              mpq3 &ab,
+                              mpq3 &ac,
+                              mpq3 &dotbuf)
+{
+  ab = a->co_exact;
+  ab -= b->co_exact;
+  ac = a->co_exact;
+  ac -= c->co_exact;
   mpq_class den = math::dot_with_buffer(ab, n, dotbuf);
   BLI_assert(den != 0);
-  mpq_class alpha = math::dot_with_buffer(ac, n, dotbuf) / den;
-  return a - alpha * ab;
+  mpq_class num = math::dot_with_buffer(ac, n, dotbuf);
+  /* Common when triangles share vertices, avoid the division. */
+  if (num == 0) {
+    return a->co_exact;
+  }
+  if (num == den) {
+    return b->co_exact;
+  }
+  mpq_class alpha = num / den;
+  return a->co_exact - alpha * ab;
+}
+
+/**
+ * The index of `dot(d - a, cross(b - a, c - a))` for inputs with index 1.
+ */
+constexpr int index_tti_above = 11;
+
+/**
+ * Return the approximate sign of `dot(d - a, cross(b - a, c - a))`, or 0 if the sign is uncertain.
+ * See #filter_plane_side.
+ */
+static int filter_tti_above(const double3 &a, const double3 &b, const double3 &c, const double3 &d)
+{
+  const double3 ba = b - a;
+  const double3 ca = c - a;
+  const double3 n(ba.y * ca.z - ba.z * ca.y, ba.z * ca.x - ba.x * ca.z, ba.x * ca.y - ba.y * ca.x);
+  const double det = math::dot(d - a, n);
+  if (det == 0.0) {
+    return 0;
+  }
+  const double3 abs_a = math::abs(a);
+  const double3 sup_ba = math::abs(b) + abs_a;
+  const double3 sup_ca = math::abs(c) + abs_a;
+  const double3 sup_n(sup_ba.y * sup_ca.z + sup_ba.z * sup_ca.y,
+                      sup_ba.z * sup_ca.x + sup_ba.x * sup_ca.z,
+                      sup_ba.x * sup_ca.y + sup_ba.y * sup_ca.x);
+  const double supremum = math::dot(math::abs(d) + abs_a, sup_n);
+  const double err_bound = supremum * index_tti_above * DBL_EPSILON;
+  if (fabs(det) > err_bound) {
+    return det > 0 ? 1 : -1;
+  }
+  return 0;
 }
 
 /**
- * Return +1, 0, -1 as a + ad is above, on, or below the oriented plane containing a, b, c in CCW
- * order. This is the same as -oriented(a, b, c, a + ad), but uses fewer arithmetic operations.
- * TODO: change arguments to `const Vert *` and use floating filters.
- * The ba, ca, n, and dotbuf arguments are used as temporaries; declaring them
+ * Return +1, 0, -1 as d is above, on, or below the oriented plane containing a, b, c in CCW
+ * order. This is the same as -oriented(a, b, c, d), but uses fewer arithmetic operations.
+ * Double arithmetic is tried first, exact arithmetic is only used when that isn't certain.
+ * The ad, ba, ca, n, and dotbuf arguments are used as temporaries; declaring them
  * in the caller can avoid many allocs and frees of mpq3 and mpq_class structures.
  */
-static inline int tti_above(const mpq3 &a,
-                            const mpq3 &b,
-                            const mpq3 &c,
-                            const mpq3 &ad,
+static inline int tti_above(const Vert *a,
+                            const Vert *b,
+                            const Vert *c,
+                            const Vert *d,
+                            mpq3 &ad,
                             mpq3 &ba,
                             mpq3 &ca,
                             mpq3 &n,
                             mpq3 &dotbuf)
 {
-  ba = b;
-  ba -= a;
-  ca = c;
-  ca -= a;
+  /* The filter can't decide degenerate cases, but they are common with shared vertices. */
+  if (ELEM(d, a, b, c) || ELEM(a, b, c) || b == c) {
+    return 0;
+  }
+  const int filter_result = filter_tti_above(a->co, b->co, c->co, d->co);
+  if (filter_result != 0) {
+    return filter_result;
+  }
+#  ifdef PERFDEBUG
+  incperfcount(5); /* Triangle-triangle above tests that needed exact arithmetic. */
+#  endif
+  ad = d->co_exact;
+  ad -= a->co_exact;
+  ba = b->co_exact;
+  ba -= a->co_exact;
+  ca = c->co_exact;
+  ca -= a->co_exact;
 
   n.x = ba.y * ca.z - ba.z * ca.y;
   n.y = ba.z * ca.x - ba.x * ca.z;
@@ -1203,12 +1262,12 @@ static inline int tti_above(const mpq3 &a,
  *   of the plane and at least one of q1 and r1 are off the plane.
  * Similarly for p2, q2, r2 with respect to the first triangle's plane.
  */
-static ITT_value itt_canon2(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon2(const Vert *p1,
+                            const Vert *q1,
+                            const Vert *r1,
+                            const Vert *p2,
+                            const Vert *q2,
+                            const Vert *r2,
                             const mpq3 &n1,
                             const mpq3 &n2)
 {
@@ -1219,33 +1278,46 @@ static ITT_value itt_canon2(const mpq3 &p1,
     std::cout << "p2=" << p2 << " q2=" << q2 << " r2=" << r2 << "\n";
     std::cout << "n1=" << n1 << " n2=" << n2 << "\n";
     std::cout << "approximate values:\n";
-    std::cout << "p1=(" << p1[0].get_d() << "," << p1[1].get_d() << "," << p1[2].get_d() << ")\n";
-    std::cout << "q1=(" << q1[0].get_d() << "," << q1[1].get_d() << "," << q1[2].get_d() << ")\n";
-    std::cout << "r1=(" << r1[0].get_d() << "," << r1[1].get_d() << "," << r1[2].get_d() << ")\n";
-    std::cout << "p2=(" << p2[0].get_d() << "," << p2[1].get_d() << "," << p2[2].get_d() << ")\n";
-    std::cout << "q2=(" << q2[0].get_d() << "," << q2[1].get_d() << "," << q2[2].get_d() << ")\n";
-    std::cout << "r2=(" << r2[0].get_d() << "," << r2[1].get_d() << "," << r2[2].get_d() << ")\n";
     std::cout << "n1=(" << n1[0].get_d() << "," << n1[1].get_d() << "," << n1[2].get_d() << ")\n";
     std::cout << "n2=(" << n2[0].get_d() << "," << n2[1].get_d() << "," << n2[2].get_d() << ")\n";
   }
-  mpq3 p1p2 = p2 - p1;
   mpq3 intersect_1;
   mpq3 intersect_2;
-  mpq3 buf[4];
+  mpq3 buf[5];
+  /* Intersect an edge of one triangle with the plane of the other. An end point that is a vertex
+   * of the other triangle is on that plane, which is common when triangles share vertices. */
+  auto interp_1 = [&](const Vert *a, const Vert *b) {
+    if (ELEM(a, p2, q2, r2)) {
+      return a->co_exact;
+    }
+    if (ELEM(b, p2, q2, r2)) {
+      return b->co_exact;
+    }
+    return tti_interp(a, b, p2, n2, buf[0], buf[1], buf[2]);
+  };
+  auto interp_2 = [&](const Vert *a, const Vert *b) {
+    if (ELEM(a, p1, q1, r1)) {
+      return a->co_exact;
+    }
+    if (ELEM(b, p1, q1, r1)) {
+      return b->co_exact;
+    }
+    return tti_interp(a, b, p1, n1, buf[0], buf[1], buf[2]);
+  };
   bool no_overlap = false;
   /* Top test in classification tree. */
-  if (tti_above(p1, q1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+  if (tti_above(p1, q1, r2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) > 0) {
     /* Middle right test in classification tree. */
-    if (tti_above(p1, r1, r2, p1p2, buf[0], buf[1], buf[2], buf[3]) <= 0) {
+    if (tti_above(p1, r1, r2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) <= 0) {
       /* Bottom right test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) > 0) {
+      if (tti_above(p1, r1, q2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) > 0) {
         /* Overlap is [k [i l] j]. */
         if (dbg_level > 0) {
           std::cout << "overlap [k [i l] j]\n";
         }
         /* i is intersect with p1r1. l is intersect with p2r2. */
-        intersect_1 = tti_interp(p1, r1, p2, n2, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p2, r2, p1, n1, buf[0], buf[1], buf[2]);
+        intersect_1 = interp_1(p1, r1);
+        intersect_2 = interp_2(p2, r2);
       }
       else {
         /* Overlap is [i [k l] j]. */
@@ -1253,8 +1325,8 @@ static ITT_value itt_canon2(const mpq3 &p1,
           std::cout << "overlap [i [k l] j]\n";
         }
         /* k is intersect with p2q2. l is intersect is p2r2. */
-        intersect_1 = tti_interp(p2, q2, p1, n1, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p2, r2, p1, n1, buf[0], buf[1], buf[2]);
+        intersect_1 = interp_2(p2, q2);
+        intersect_2 = interp_2(p2, r2);
       }
     }
     else {
@@ -1267,7 +1339,7 @@ static ITT_value itt_canon2(const mpq3 &p1,
   }
   else {
     /* Middle left test in classification tree. */
-    if (tti_above(p1, q1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) < 0) {
+    if (tti_above(p1, q1, q2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) < 0) {
       /* No overlap: [i j] [k l]. */
       if (dbg_level > 0) {
         std::cout << "no overlap: [i j] [k l]\n";
@@ -1276,14 +1348,14 @@ static ITT_value itt_canon2(const mpq3 &p1,
     }
     else {
       /* Bottom left test in classification tree. */
-      if (tti_above(p1, r1, q2, p1p2, buf[0], buf[1], buf[2], buf[3]) >= 0) {
+      if (tti_above(p1, r1, q2, p2, buf[0], buf[1], buf[2], buf[3], buf[4]) >= 0) {
         /* Overlap is [k [i j] l]. */
         if (dbg_level > 0) {
           std::cout << "overlap [k [i j] l]\n";
         }
         /* i is intersect with p1r1. j is intersect with p1q1. */
-        intersect_1 = tti_interp(p1, r1, p2, n2, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p1, q1, p2, n2, buf[0], buf[1], buf[2]);
+        intersect_1 = interp_1(p1, r1);
+        intersect_2 = interp_1(p1, q1);
       }
       else {
         /* Overlap is [i [k j] l]. */
@@ -1291,8 +1363,8 @@ static ITT_value itt_canon2(const mpq3 &p1,
           std::cout << "overlap [i [k j] l]\n";
         }
         /* k is intersect with p2q2. j is intersect with p1q1. */
-        intersect_1 = tti_interp(p2, q2, p1, n1, buf[0], buf[1], buf[2]);
-        intersect_2 = tti_interp(p1, q1, p2, n2, buf[0], buf[1], buf[2]);
+        intersect_1 = interp_2(p2, q2);
+        intersect_2 = interp_1(p1, q1);
       }
     }
   }
@@ -1313,12 +1385,12 @@ static ITT_value itt_canon2(const mpq3 &p1,
 
 /* Helper function for intersect_tri_tri. Arguments have been canonicalized for triangle 1. */
 
-static ITT_value itt_canon1(const mpq3 &p1,
-                            const mpq3 &q1,
-                            const mpq3 &r1,
-                            const mpq3 &p2,
-                            const mpq3 &q2,
-                            const mpq3 &r2,
+static ITT_value itt_canon1(const Vert *p1,
+                            const Vert *q1,
+                            const Vert *r1,
+                            const Vert *p2,
+                            const Vert *q2,
+                            const Vert *r2,
                             const mpq3 &n1,
                             const mpq3 &n2,
                             int sp2,
@@ -1443,6 +1515,8 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
     return ITT_value(INONE);
   }
 
+  /* Where the filter was uncertain, use exact arithmetic. Vertices shared by both triangles are
+   * known to be on the plane of the other triangle, which is common with self intersection. */
   mpq3 buf[2];
   const mpq3 &p1 = vp1->co_exact;
   const mpq3 &q1 = vq1->co_exact;
@@ -1452,17 +1526,17 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
   const mpq3 &r2 = vr2->co_exact;
 
   const mpq3 &n2 = tri2.plane->norm_exact;
-  if (sp1 == 0) {
+  if (sp1 == 0 && !ELEM(vp1, vp2, vq2, vr2)) {
     buf[0] = p1;
     buf[0] -= r2;
     sp1 = sgn(math::dot_with_buffer(buf[0], n2, buf[1]));
   }
-  if (sq1 == 0) {
+  if (sq1 == 0 && !ELEM(vq1, vp2, vq2, vr2)) {
     buf[0] = q1;
     buf[0] -= r2;
     sq1 = sgn(math::dot_with_buffer(buf[0], n2, buf[1]));
   }
-  if (sr1 == 0) {
+  if (sr1 == 0 && !ELEM(vr1, vp2, vq2, vr2)) {
     buf[0] = r1;
     buf[0] -= r2;
     sr1 = sgn(math::dot_with_buffer(buf[0], n2, buf[1]));
@@ -1484,17 +1558,17 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
 
   /* Repeat for signs of t2's vertices with respect to plane of t1. */
   const mpq3 &n1 = tri1.plane->norm_exact;
-  if (sp2 == 0) {
+  if (sp2 == 0 && !ELEM(vp2, vp1, vq1, vr1)) {
     buf[0] = p2;
     buf[0] -= r1;
     sp2 = sgn(math::dot_with_buffer(buf[0], n1, buf[1]));
   }
-  if (sq2 == 0) {
+  if (sq2 == 0 && !ELEM(vq2, vp1, vq1, vr1)) {
     buf[0] = q2;
     buf[0] -= r1;
     sq2 = sgn(math::dot_with_buffer(buf[0], n1, buf[1]));
   }
-  if (sr2 == 0) {
+  if (sr2 == 0 && !ELEM(vr2, vp1, vq1, vr1)) {
     buf[0] = r2;
     buf[0] -= r1;
     sr2 = sgn(math::dot_with_buffer(buf[0], n1, buf[1]));
@@ -1520,49 +1594,49 @@ static ITT_value intersect_tri_tri(const IMesh &tm, int t1, int t2)
   ITT_value ans;
   if (sp1 > 0) {
     if (sq1 > 0) {
-      ans = itt_canon1(r1, p1, q1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vr1, vp1, vq1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
     }
     else if (sr1 > 0) {
-      ans = itt_canon1(q1, r1, p1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vq1, vr1, vp1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
     }
     else {
-      ans = itt_canon1(p1, q1, r1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vp1, vq1, vr1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
     }
   }
   else if (sp1 < 0) {
     if (sq1 < 0) {
-      ans = itt_canon1(r1, p1, q1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vr1, vp1, vq1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
     }
     else if (sr1 < 0) {
-      ans = itt_canon1(q1, r1, p1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+      ans = itt_canon1(vq1, vr1, vp1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
     }
     else {
-      ans = itt_canon1(p1, q1, r1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+      ans = itt_canon1(vp1, vq1, vr1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
     }
   }
   else {
     if (sq1 < 0) {
       if (sr1 >= 0) {
-        ans = itt_canon1(q1, r1, p1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vq1, vr1, vp1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
       }
       else {
-        ans = itt_canon1(p1, q1, r1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vp1, vq1, vr1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
       }
     }
     else if (sq1 > 0) {
       if (sr1 > 0) {
-        ans = itt_canon1(p1, q1, r1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vp1, vq1, vr1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
       }
       else {
-        ans = itt_canon1(q1, r1, p1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vq1, vr1, vp1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
       }
     }
     else {
       if (sr1 > 0) {
-        ans = itt_canon1(r1, p1, q1, p2, q2, r2, n1, n2, sp2, sq2, sr2);
+        ans = itt_canon1(vr1, vp1, vq1, vp2, vq2, vr2, n1, n2, sp2, sq2, sr2);
       }
       else if (sr1 < 0) {
-        ans = itt_canon1(r1, p1, q1, p2, r2, q2, n1, n2, sp2, sr2, sq2);
+        ans = itt_canon1(vr1, vp1, vq1, vp2, vr2, vq2, n1, n2, sp2, sr2, sq2);
       }
       else {
         if (dbg_level > 0) {
@@ -3181,6 +3255,10 @@ static void perfdata_init()
   perfdata->count.append(0);
   perfdata->count_name.append("final non-NONE intersects");
 
+  /* count 5. */
+  perfdata->count.append(0);
+  perfdata->count_name.append("tri tri above tests decided by exact arithmetic");
+
   /* max 0. */
   perfdata->max.append(0);
   perfdata->max_name.append("total faces");
@@ -0,0 +1,206 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <algorithm>
+
+#include "BLI_bounds.hh"
+#include "BLI_math_base.h"
+#include "BLI_sort.hh"
+#include "BLI_spatial_hash_grid.hh"
+#include "BLI_task.hh"
+#include "BLI_vector.hh"
+
+#include "atomic_ops.h"
+
+namespace blender {
+
+SpatialHashGrid::SpatialHashGrid(const Span<float3> positions, const float cell_size)
+    : cell_size_(cell_size), cell_size_inv_(1.0f / cell_size)
+{
+  BLI_assert(cell_size > 0.0f);
+  const int points_num = positions.size();
+  if (points_num == 0) {
+    cell_offset_ = int3(0);
+    cell_starts_.reinitialize(1);
+    cell_starts_[0] = 0;
+    cell_table_mask_ = 0;
+    return;
+  }
+
+  const std::optional<bounds::MinMaxResult<float3>> bounds = bounds::min_max(positions);
+  cell_offset_ = this->cell_coord(bounds->min);
+
+  /* Sort the points by cell, then by index. */
+  struct PointKey {
+    uint64_t key;
+    int index;
+  };
+  Array<PointKey> point_keys(points_num);
+  threading::parallel_for(positions.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      point_keys[i] = {this->cell_key(this->cell_coord(positions[i])), i};
+    }
+  });
+  parallel_sort(point_keys.begin(), point_keys.end(), [](const PointKey &a, const PointKey &b) {
+    return a.key < b.key || (a.key == b.key && a.index < b.index);
+  });
+
+  indices_.reinitialize(points_num);
+  positions_.reinitialize(points_num);
+  threading::parallel_for(positions.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      indices_[i] = point_keys[i].index;
+      positions_[i] = positions[point_keys[i].index];
+    }
+  });
+
+  Vector<int> cell_starts;
+  cell_starts.append(0);
+  for (const int i : IndexRange(1, points_num - 1)) {
+    if (point_keys[i].key != point_keys[i - 1].key) {
+      cell_starts.append(i);
+    }
+  }
+  cell_starts.append(points_num);
+  cell_starts_ = cell_starts.as_span();
+  const int cells_num = cell_starts_.size() - 1;
+
+  /* Fill the table in parallel, keys are unique so a slot only has to be claimed. */
+  const int table_size = int(power_of_2_max_u(uint(cells_num) * 2));
+  cell_table_mask_ = uint64_t(table_size - 1);
+  cell_table_.reinitialize(table_size);
+  cell_table_.fill({cell_key_empty, -1});
+  threading::parallel_for(IndexRange(cells_num), 4096, [&](IndexRange range) {
+    for (const int cell : range) {
+      const uint64_t key = point_keys[cell_starts_[cell]].key;
+      uint64_t slot = cell_key_hash(key) & cell_table_mask_;
+      while (atomic_cas_uint64(&cell_table_[slot].key, cell_key_empty, key) != cell_key_empty) {
+        slot = (slot + 1) & cell_table_mask_;
+      }
+      cell_table_[slot].cell = cell;
+    }
+  });
+}
+
+/**
+ * Maximum number of duplicates stored for each point by the parallel search, points with more
+ * are searched again when merging.
+ */
+static constexpr int duplicates_found_max = 8;
+static constexpr uint8_t duplicates_found_overflow = 0xff;
+static constexpr int duplicates_chunk_size = 256;
+
+static IndexRange duplicates_chunk_range(const int chunk, const int points_num)
+{
+  const int start = chunk * duplicates_chunk_size;
+  return IndexRange(start, std::min(duplicates_chunk_size, points_num - start));
+}
+
+int SpatialHashGrid::calc_duplicates(const float merge_distance,
+                                     MutableSpan<int> duplicates) const
+{
+  const int points_num = this->size();
+  BLI_assert(duplicates.size() == points_num);
+
+  /* Work on a copy in the order of the grid, to avoid random access when searching. */
+  Array<int> sorted_duplicates(points_num);
+  threading::parallel_for(IndexRange(points_num), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      sorted_duplicates[i] = duplicates[indices_[i]];
+    }
+  });
+
+  /* Search all points in parallel, only reading the input state of the duplicates. Merging only
+   * changes values from -1, so the stored results contain all candidates of the serial search,
+   * which are checked again when merging. */
+  const int chunks_num = divide_ceil_u(uint(points_num), duplicates_chunk_size);
+  Array<uint8_t> found_len(points_num);
+  Array<Vector<int>> chunk_found(chunks_num);
+  threading::parallel_for(IndexRange(chunks_num), 1, [&](IndexRange chunks_range) {
+    for (const int chunk : chunks_range) {
+      CellLookupCache cache;
+      for (const int i : duplicates_chunk_range(chunk, points_num)) {
+        found_len[i] = 0;
+        if (!ELEM(sorted_duplicates[i], -1, indices_[i])) {
+          continue;
+        }
+        int found[duplicates_found_max];
+        int found_num = 0;
+        const bool finished = this->foreach_in_radius_impl(
+            positions_[i],
+            merge_distance,
+            [&](const int other, const float /*dist_sq*/) {
+              if (other == i || sorted_duplicates[other] != -1) {
+                return true;
+              }
+              if (found_num == duplicates_found_max) {
+                return false;
+              }
+              found[found_num++] = other;
+              return true;
+            },
+            &cache);
+        if (!finished) {
+          found_len[i] = duplicates_found_overflow;
+          continue;
+        }
+        chunk_found[chunk].extend(Span<int>(found, found_num));
+        found_len[i] = uint8_t(found_num);
+      }
+    }
+  });
+
+  int duplicates_num = 0;
+  CellLookupCache cache;
+  for (const int chunk : IndexRange(chunks_num)) {
+    const int *found_iter = chunk_found[chunk].data();
+    for (const int i : duplicates_chunk_range(chunk, points_num)) {
+      const int index = indices_[i];
+      const uint8_t len = found_len[i];
+      if (ELEM(sorted_duplicates[i], -1, index)) {
+        const int duplicates_num_prev = duplicates_num;
+        if (len == duplicates_found_overflow) {
+          this->foreach_in_radius_impl(
+              positions_[i],
+              merge_distance,
+              [&](const int other, const float /*dist_sq*/) {
+                if (other != i && sorted_duplicates[other] == -1) {
+                  sorted_duplicates[other] = index;
+                  duplicates_num++;
+                }
+                return true;
+              },
+              &cache);
+        }
+        else {
+          for (const int other : Span<int>(found_iter, len)) {
+            if (sorted_duplicates[other] == -1) {
+              sorted_duplicates[other] = index;
+              duplicates_num++;
+            }
+          }
+        }
+        if (duplicates_num != duplicates_num_prev) {
+          /* Prevent chains of doubles. */
+          sorted_duplicates[i] = index;
+        }
+      }
+      if (len != duplicates_found_overflow) {
+        found_iter += len;
+      }
+    }
+  }
+
+  threading::parallel_for(IndexRange(points_num), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      duplicates[indices_[i]] = sorted_duplicates[i];
+    }
+  });
+
+  return duplicates_num;
+}
+
+}  // namespace blender
@@ -8,6 +8,7 @@
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_kdopbvh.h"
+#include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 #include "BLI_rand.h"
 
@@ -66,11 +67,15 @@ static void optimal_check_callback(void *userdata,
  * Note that a small epsilon is added to the BVH nodes bounds, even if we pass in zero.
  * Use rounding to ensure very close nodes don't cause the wrong node to be found as nearest.
  */
-static void find_nearest_points_test(
-    int points_len, float scale, int round, int random_seed, bool optimal = false)
+static void find_nearest_points_test(int points_len,
+                                     float scale,
+                                     int round,
+                                     int random_seed,
+                                     bool optimal = false,
+                                     int build_flag = 0)
 {
   struct RNG *rng = BLI_rng_new(random_seed);
-  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 8, 8);
+  BVHTree *tree = BLI_bvhtree_new_ex(points_len, 0.0, 8, 8, build_flag);
 
   void *mem = MEM_mallocN(sizeof(float[3]) * points_len, __func__);
   float(*points)[3] = (float(*)[3])mem;
@@ -132,3 +137,194 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+static void nearest_point_callback(void *userdata,
+                                   int index,
+                                   const float co[3],
+                                   BVHTreeNearest *nearest)
+{
+  const float(*points)[3] = (const float(*)[3])userdata;
+  const float dist_sq = len_squared_v3v3(co, points[index]);
+  if (dist_sq < nearest->dist_sq) {
+    nearest->index = index;
+    nearest->dist_sq = dist_sq;
+    copy_v3_v3(nearest->co, points[index]);
+  }
+}
+
+/**
+ * Find the nearest points one by one and with #BLI_bvhtree_find_nearest_array,
+ * the distances must match.
+ */
+static void find_nearest_array_test(int points_len, int queries_len, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 4, 6);
+
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(*points) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance(tree);
+
+  float(*queries)[3] = (float(*)[3])MEM_mallocN(sizeof(*queries) * queries_len, __func__);
+  BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_mallocN(sizeof(*nearest) * queries_len,
+                                                          __func__);
+  for (int i = 0; i < queries_len; i++) {
+    rng_v3_round(queries[i], 3, rng, 1000, 1.5f);
+    nearest[i].index = -1;
+    /* Limit some of the queries, so not all of them find something. */
+    nearest[i].dist_sq = (i % 10 == 0) ? 0.0001f : FLT_MAX;
+  }
+
+  BLI_bvhtree_find_nearest_array(
+      tree, queries, queries_len, nearest, nearest_point_callback, points, 0);
+
+  for (int i = 0; i < queries_len; i++) {
+    BVHTreeNearest expected;
+    expected.index = -1;
+    expected.dist_sq = (i % 10 == 0) ? 0.0001f : FLT_MAX;
+    BLI_bvhtree_find_nearest_ex(tree, queries[i], &expected, nearest_point_callback, points, 0);
+    EXPECT_EQ(nearest[i].index == -1, expected.index == -1);
+    if (expected.index != -1) {
+      EXPECT_FLOAT_EQ(nearest[i].dist_sq, expected.dist_sq);
+    }
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+  MEM_freeN(nearest);
+}
+
+TEST(kdopbvh, FindNearestArray_1)
+{
+  find_nearest_array_test(1, 3, 1234);
+}
+TEST(kdopbvh, FindNearestArray_500)
+{
+  find_nearest_array_test(500, 5001, 12);
+}
+
+TEST(kdopbvh, SahFindNearest_2)
+{
+  find_nearest_points_test(2, 1.0, 1000, 123, false, BVH_BUILD_SAH);
+}
+TEST(kdopbvh, SahFindNearest_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, false, BVH_BUILD_SAH);
+}
+TEST(kdopbvh, SahOptimalFindNearest_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, true, BVH_BUILD_SAH);
+}
+
+static void raycast_tri_callback(void *userdata,
+                                 int index,
+                                 const BVHTreeRay *ray,
+                                 BVHTreeRayHit *hit)
+{
+  const float(*tris)[3][3] = (const float(*)[3][3])userdata;
+  float dist;
+  if (isect_ray_tri_v3(ray->origin, ray->direction, UNPACK3(tris[index]), &dist, nullptr) &&
+      dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+    madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+  }
+}
+
+/**
+ * Cast the same rays one by one and with #BLI_bvhtree_ray_cast_array, the hits must match.
+ */
+static void ray_cast_array_test(
+    int tris_len, int rays_len, float radius, int random_seed, int build_flag = 0)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new_ex(tris_len, 0.0, 4, 6, build_flag);
+
+  float(*tris)[3][3] = (float(*)[3][3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+  for (int i = 0; i < tris_len; i++) {
+    float center[3];
+    rng_v3_round(center, 3, rng, 1000, 1.0f);
+    for (int j = 0; j < 3; j++) {
+      rng_v3_round(tris[i][j], 3, rng, 1000, 0.1f);
+      add_v3_v3(tris[i][j], center);
+    }
+    BLI_bvhtree_insert(tree, i, &tris[i][0][0], 3);
+  }
+  BLI_bvhtree_balance(tree);
+
+  float(*origins)[3] = (float(*)[3])MEM_mallocN(sizeof(*origins) * rays_len, __func__);
+  float(*directions)[3] = (float(*)[3])MEM_mallocN(sizeof(*directions) * rays_len, __func__);
+  BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * rays_len, __func__);
+  for (int i = 0; i < rays_len; i++) {
+    rng_v3_round(origins[i], 3, rng, 1000, 2.0f);
+    /* Aim at the center with some spread, so most rays hit something. */
+    rng_v3_round(directions[i], 3, rng, 1000, 0.5f);
+    sub_v3_v3(directions[i], origins[i]);
+    normalize_v3(directions[i]);
+    hits[i].index = -1;
+    hits[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+
+  BVHTree_RayCastCallback callbacks[2] = {raycast_tri_callback, nullptr};
+  for (BVHTree_RayCastCallback callback : callbacks) {
+    for (int i = 0; i < rays_len; i++) {
+      hits[i].index = -1;
+      hits[i].dist = BVH_RAYCAST_DIST_MAX;
+    }
+    BLI_bvhtree_ray_cast_array(
+        tree, origins, directions, rays_len, radius, hits, callback, tris, BVH_RAYCAST_DEFAULT);
+
+    for (int i = 0; i < rays_len; i++) {
+      BVHTreeRayHit hit;
+      hit.index = -1;
+      hit.dist = BVH_RAYCAST_DIST_MAX;
+      BLI_bvhtree_ray_cast_ex(
+          tree, origins[i], directions[i], radius, &hit, callback, tris, BVH_RAYCAST_DEFAULT);
+      EXPECT_EQ(hits[i].index, hit.index);
+      if (hit.index != -1) {
+        EXPECT_FLOAT_EQ(hits[i].dist, hit.dist);
+      }
+      if (callback && radius == 0.0f) {
+        /* Compare with testing all triangles, to check that the tree contains all of them. */
+        BVHTreeRay ray = {};
+        copy_v3_v3(ray.origin, origins[i]);
+        copy_v3_v3(ray.direction, directions[i]);
+        hit.index = -1;
+        hit.dist = BVH_RAYCAST_DIST_MAX;
+        for (int j = 0; j < tris_len; j++) {
+          callback(tris, j, &ray, &hit);
+        }
+        EXPECT_EQ(hits[i].index, hit.index);
+      }
+    }
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(tris);
+  MEM_freeN(origins);
+  MEM_freeN(directions);
+  MEM_freeN(hits);
+}
+
+TEST(kdopbvh, RayCastArray_1)
+{
+  ray_cast_array_test(1, 3, 0.0f, 1234);
+}
+TEST(kdopbvh, RayCastArray_500)
+{
+  ray_cast_array_test(500, 1001, 0.0f, 12);
+}
+TEST(kdopbvh, RayCastArrayRadius_500)
+{
+  ray_cast_array_test(500, 1001, 0.05f, 123);
+}
+TEST(kdopbvh, SahRayCastArray_5000)
+{
+  ray_cast_array_test(5000, 1001, 0.0f, 12, BVH_BUILD_SAH);
+}
@@ -0,0 +1,207 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static float (*rng_points_new(const int points_len, const uint seed))[3]
+{
+  float(*points)[3] = static_cast<float(*)[3]>(
+      MEM_mallocN(sizeof(*points) * points_len, __func__));
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < points_len; i++) {
+    for (int j = 0; j < 3; j++) {
+      points[i][j] = BLI_rng_get_float(rng);
+    }
+  }
+  BLI_rng_free(rng);
+  return points;
+}
+
+static KDTree_3d *kdtree_from_points(const float (*points)[3], const int points_len)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+/**
+ * Reference for #BLI_kdtree_3d_calc_duplicates_fast, comparing all points in index order.
+ */
+static int calc_duplicates_brute_force(const float (*points)[3],
+                                       const int points_len,
+                                       const float range,
+                                       int *duplicates)
+{
+  int found = 0;
+  for (int i = 0; i < points_len; i++) {
+    if (!ELEM(duplicates[i], -1, i)) {
+      continue;
+    }
+    const int found_prev = found;
+    for (int j = 0; j < points_len; j++) {
+      if (j != i && duplicates[j] == -1 && len_v3v3(points[i], points[j]) <= range) {
+        duplicates[j] = i;
+        found++;
+      }
+    }
+    if (found != found_prev) {
+      duplicates[i] = i;
+    }
+  }
+  return found;
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+static void find_nearest_test(const int points_len, const int queries_len)
+{
+  float(*points)[3] = rng_points_new(points_len, 0);
+  float(*queries)[3] = rng_points_new(queries_len, 1);
+  KDTree_3d *tree = kdtree_from_points(points, points_len);
+
+  KDTreeNearest_3d *nearest = static_cast<KDTreeNearest_3d *>(
+      MEM_mallocN(sizeof(*nearest) * queries_len, __func__));
+  BLI_kdtree_3d_find_nearest_array(tree, queries, queries_len, nearest);
+
+  for (int i = 0; i < queries_len; i++) {
+    int index_expect = -1;
+    float dist_expect = FLT_MAX;
+    for (int j = 0; j < points_len; j++) {
+      const float dist = len_v3v3(queries[i], points[j]);
+      if (dist < dist_expect) {
+        dist_expect = dist;
+        index_expect = j;
+      }
+    }
+    KDTreeNearest_3d nearest_single;
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, queries[i], &nearest_single), index_expect);
+    EXPECT_EQ(nearest[i].index, index_expect);
+    EXPECT_FLOAT_EQ(nearest[i].dist, dist_expect);
+  }
+
+  MEM_freeN(nearest);
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+}
+
+TEST(kdtree, FindNearest_1)
+{
+  find_nearest_test(1, 10);
+}
+TEST(kdtree, FindNearest_1000)
+{
+  find_nearest_test(1000, 1000);
+}
+/* Enough points to balance the tree in parallel. */
+TEST(kdtree, FindNearest_100000)
+{
+  find_nearest_test(100000, 100);
+}
+
+TEST(kdtree, FindNearestArrayEmpty)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(0);
+  BLI_kdtree_3d_balance(tree);
+  const float co[1][3] = {{0.0f, 0.0f, 0.0f}};
+  KDTreeNearest_3d nearest;
+  BLI_kdtree_3d_find_nearest_array(tree, co, 1, &nearest);
+  EXPECT_EQ(nearest.index, -1);
+  BLI_kdtree_3d_free(tree);
+}
+
+static void range_search_test(const int points_len, const int queries_len, const float range)
+{
+  float(*points)[3] = rng_points_new(points_len, 2);
+  float(*queries)[3] = rng_points_new(queries_len, 3);
+  KDTree_3d *tree = kdtree_from_points(points, points_len);
+
+  uint *offsets;
+  KDTreeNearest_3d *nearest;
+  const uint nearest_len = BLI_kdtree_3d_range_search_array(
+      tree, queries, queries_len, range, &offsets, &nearest);
+  EXPECT_EQ(offsets[0], 0);
+  EXPECT_EQ(offsets[queries_len], nearest_len);
+
+  for (int i = 0; i < queries_len; i++) {
+    KDTreeNearest_3d *nearest_single;
+    const int found = BLI_kdtree_3d_range_search(tree, queries[i], &nearest_single, range);
+    EXPECT_EQ(offsets[i + 1] - offsets[i], found);
+    for (int j = 0; j < found; j++) {
+      EXPECT_EQ(nearest[offsets[i] + j].index, nearest_single[j].index);
+      EXPECT_EQ(nearest[offsets[i] + j].dist, nearest_single[j].dist);
+    }
+    MEM_SAFE_FREE(nearest_single);
+  }
+
+  MEM_SAFE_FREE(nearest);
+  MEM_freeN(offsets);
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+}
+
+TEST(kdtree, RangeSearch_None)
+{
+  range_search_test(100, 10, 0.0f);
+}
+TEST(kdtree, RangeSearch_1000)
+{
+  range_search_test(1000, 2000, 0.1f);
+}
+TEST(kdtree, RangeSearch_10000)
+{
+  range_search_test(10000, 5000, 0.05f);
+}
+
+static void calc_duplicates_test(const int points_len, const float range)
+{
+  float(*points)[3] = rng_points_new(points_len, 4);
+  KDTree_3d *tree = kdtree_from_points(points, points_len);
+
+  int *duplicates = static_cast<int *>(MEM_mallocN(sizeof(int) * points_len, __func__));
+  int *duplicates_expect = static_cast<int *>(MEM_mallocN(sizeof(int) * points_len, __func__));
+  for (int i = 0; i < points_len; i++) {
+    /* Some points are kept, they can still be used as a target. */
+    duplicates[i] = duplicates_expect[i] = (i % 7 == 0) ? i : -1;
+  }
+
+  const int found = BLI_kdtree_3d_calc_duplicates_fast(tree, range, true, duplicates);
+  const int found_expect = calc_duplicates_brute_force(
+      points, points_len, range, duplicates_expect);
+  EXPECT_EQ(found, found_expect);
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(duplicates[i], duplicates_expect[i]);
+  }
+
+  MEM_freeN(duplicates);
+  MEM_freeN(duplicates_expect);
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+}
+
+TEST(kdtree, CalcDuplicates_100)
+{
+  calc_duplicates_test(100, 0.1f);
+}
+/* Enough points to search in parallel, some with many duplicates. */
+TEST(kdtree, CalcDuplicates_5000)
+{
+  calc_duplicates_test(5000, 0.05f);
+}
+TEST(kdtree, CalcDuplicates_5000_Dense)
+{
+  calc_duplicates_test(5000, 0.2f);
+}
@@ -8,13 +8,19 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "PIL_time.h"
+
 #include "BLI_array.hh"
+#include "BLI_function_ref.hh"
 #include "BLI_map.hh"
 #include "BLI_math_mpq.hh"
 #include "BLI_math_vec_mpq_types.hh"
 #include "BLI_mesh_boolean.hh"
+#include "BLI_task.h"
 #include "BLI_vector.hh"
 
+#define DO_PERF_TESTS 0
+
 #ifdef WITH_GMP
 namespace blender::meshintersect::tests {
 
@@ -955,5 +961,168 @@ TEST(boolean_polymesh, CubePlane)
   }
 }
 
+#  if DO_PERF_TESTS
+
+/**
+ * Representative boolean operations on generated meshes, timing the whole exact boolean
+ * including triangulation. Most of the time is spent in the geometric predicates, which are
+ * first evaluated with error-bounded double arithmetic and only use #mpq_class when that
+ * can't decide.
+ */
+
+/** Add the faces of a UV-sphere with \a nrings rings and `2 * nrings` segments. */
+static void add_uv_sphere(
+    Vector<Face *> &faces, int nrings, const double3 &center, double radius, IMeshArena *arena)
+{
+  const int nsegs = 2 * nrings;
+  const int orig_start = arena->tot_allocated_verts();
+  Array<const Vert *> verts(nsegs * (nrings - 1));
+  for (int s = 0; s < nsegs; s++) {
+    const double phi = 2.0 * M_PI * s / nsegs;
+    for (int r = 1; r < nrings; r++) {
+      const double theta = M_PI * r / nrings;
+      const double3 co = center + double3(std::sin(theta) * std::cos(phi),
+                                          std::sin(theta) * std::sin(phi),
+                                          std::cos(theta)) *
+                                      radius;
+      verts[s * (nrings - 1) + r - 1] = arena->add_or_find_vert(mpq3(co.x, co.y, co.z),
+                                                                orig_start + s * nrings + r);
+    }
+  }
+  const double3 top = center + double3(0.0, 0.0, radius);
+  const double3 bottom = center - double3(0.0, 0.0, radius);
+  const Vert *v_top = arena->add_or_find_vert(mpq3(top.x, top.y, top.z), orig_start);
+  const Vert *v_bottom = arena->add_or_find_vert(mpq3(bottom.x, bottom.y, bottom.z),
+                                                 orig_start + 1);
+  auto vert = [&](int s, int r) {
+    return verts[(s % nsegs) * (nrings - 1) + r - 1];
+  };
+  for (int s = 0; s < nsegs; s++) {
+    faces.append(arena->add_face({v_top, vert(s, 1), vert(s + 1, 1)}, faces.size()));
+    for (int r = 1; r < nrings - 1; r++) {
+      faces.append(arena->add_face(
+          {vert(s, r), vert(s, r + 1), vert(s + 1, r + 1), vert(s + 1, r)}, faces.size()));
+    }
+    faces.append(arena->add_face({vert(s, nrings - 1), v_bottom, vert(s + 1, nrings - 1)},
+                                 faces.size()));
+  }
+}
+
+/** Add the faces of an axis aligned box with every side subdivided into a grid of quads. */
+static void add_grid_box(
+    Vector<Face *> &faces, int subdivs, const double3 &center, double size, IMeshArena *arena)
+{
+  const double step = size / subdivs;
+  const double3 corner = center - double3(size / 2.0);
+  auto vert = [&](int i, int j, int k) {
+    const double3 co = corner + double3(i, j, k) * step;
+    return arena->add_or_find_vert(mpq3(co.x, co.y, co.z), arena->tot_allocated_verts());
+  };
+  for (int axis = 0; axis < 3; axis++) {
+    const int axis_u = (axis + 1) % 3;
+    const int axis_v = (axis + 2) % 3;
+    for (const int side : {0, subdivs}) {
+      for (int u = 0; u < subdivs; u++) {
+        for (int v = 0; v < subdivs; v++) {
+          const int2 uv_corners[4] = {{u, v}, {u + 1, v}, {u + 1, v + 1}, {u, v + 1}};
+          Array<const Vert *> face_verts(4);
+          for (int i = 0; i < 4; i++) {
+            int3 co;
+            co[axis] = side;
+            co[axis_u] = uv_corners[i].x;
+            co[axis_v] = uv_corners[i].y;
+            /* The corners are counter-clockwise around the positive axis direction, reverse them
+             * on the negative side so all faces point outwards. */
+            face_verts[side == 0 ? 3 - i : i] = vert(co.x, co.y, co.z);
+          }
+          faces.append(arena->add_face(face_verts, faces.size()));
+        }
+      }
+    }
+  }
+}
+
+static void boolean_perf_test(const char *id,
+                              BoolOpType op,
+                              bool use_self,
+                              FunctionRef<int(Vector<Face *> &faces, IMeshArena *arena)> fill_fn)
+{
+  BLI_task_scheduler_init(); /* Without this, no parallelism. */
+  IMeshArena arena;
+  Vector<Face *> faces;
+  const int first_shape_len = fill_fn(faces, &arena);
+  IMesh mesh(faces);
+  const double time_start = PIL_check_seconds_timer();
+  IMesh out = boolean_mesh(
+      mesh,
+      op,
+      use_self ? 1 : 2,
+      [&](int f) { return (use_self || f < first_shape_len) ? 0 : 1; },
+      use_self,
+      false,
+      nullptr,
+      &arena);
+  const double time_boolean = PIL_check_seconds_timer();
+  out.populate_vert();
+  std::cout << id << ": " << faces.size() << " faces in, " << out.face_size()
+            << " faces out, boolean time: " << time_boolean - time_start << "\n";
+  if (DO_OBJ) {
+    write_obj_mesh(out, id);
+  }
+  BLI_task_scheduler_exit();
+}
+
+TEST(boolean_perf, SphereSphereUnion)
+{
+  boolean_perf_test(
+      "sphere_sphere_union", BoolOpType::Union, false, [](Vector<Face *> &faces, IMeshArena *a) {
+        add_uv_sphere(faces, 64, double3(0.0), 1.0, a);
+        const int first_shape_len = faces.size();
+        add_uv_sphere(faces, 64, double3(0.3, 0.4, 0.5), 1.0, a);
+        return first_shape_len;
+      });
+}
+
+TEST(boolean_perf, BoxSphereDifference)
+{
+  boolean_perf_test("box_sphere_difference",
+                    BoolOpType::Difference,
+                    false,
+                    [](Vector<Face *> &faces, IMeshArena *a) {
+                      add_grid_box(faces, 32, double3(0.0), 2.0, a);
+                      const int first_shape_len = faces.size();
+                      add_uv_sphere(faces, 64, double3(0.7, 0.6, 0.8), 0.9, a);
+                      return first_shape_len;
+                    });
+}
+
+/* Boxes sharing face planes, so most of the work is in co-planar clusters. */
+TEST(boolean_perf, BoxBoxCoplanarUnion)
+{
+  boolean_perf_test("box_box_coplanar_union",
+                    BoolOpType::Union,
+                    false,
+                    [](Vector<Face *> &faces, IMeshArena *a) {
+                      add_grid_box(faces, 32, double3(0.0), 2.0, a);
+                      const int first_shape_len = faces.size();
+                      add_grid_box(faces, 24, double3(1.0, 0.5, 0.0), 2.0, a);
+                      return first_shape_len;
+                    });
+}
+
+/* A single shape made of overlapping spheres, as with the "Self Intersection" option. */
+TEST(boolean_perf, SpheresSelfUnion)
+{
+  boolean_perf_test(
+      "spheres_self_union", BoolOpType::Union, true, [](Vector<Face *> &faces, IMeshArena *a) {
+        for (int i = 0; i < 4; i++) {
+          add_uv_sphere(faces, 32, double3(0.5 * i, 0.1 * i, 0.2 * (i % 2)), 0.8, a);
+        }
+        return faces.size();
+      });
+}
+
+#  endif
+
 }  // namespace blender::meshintersect::tests
 #endif
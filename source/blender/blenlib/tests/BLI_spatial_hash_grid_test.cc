@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "BLI_rand.hh"
+#include "BLI_set.hh"
+#include "BLI_spatial_hash_grid.hh"
+#include "BLI_vector.hh"
+
+#include "testing/testing.h"
+
+namespace blender::tests {
+
+static Array<float3> random_positions(const int size, const float scale, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Array<float3> positions(size);
+  for (float3 &position : positions) {
+    position = float3(rng.get_float(), rng.get_float(), rng.get_float()) * scale;
+  }
+  return positions;
+}
+
+TEST(spatial_hash_grid, Empty)
+{
+  SpatialHashGrid grid({}, 0.1f);
+  EXPECT_EQ(grid.size(), 0);
+  EXPECT_TRUE(grid.foreach_in_radius(
+      float3(0.0f), 0.1f, [](int, const float3 &, float) { return false; }));
+  EXPECT_EQ(grid.calc_duplicates(0.1f, {}), 0);
+}
+
+TEST(spatial_hash_grid, ForeachInRadius)
+{
+  const Array<float3> positions = random_positions(2000, 1.0f, 0);
+  const float radius = 0.05f;
+  SpatialHashGrid grid(positions, radius);
+  EXPECT_EQ(grid.size(), positions.size());
+
+  for (const int i : IndexRange(100)) {
+    const float3 &co = positions[i * 7];
+    Set<int> found;
+    grid.foreach_in_radius(co, radius, [&](const int index, const float3 &position, float) {
+      EXPECT_EQ(position, positions[index]);
+      EXPECT_TRUE(found.add(index));
+      return true;
+    });
+    for (const int j : positions.index_range()) {
+      EXPECT_EQ(found.contains(j), math::distance(co, positions[j]) <= radius);
+    }
+  }
+}
+
+TEST(spatial_hash_grid, ForeachInRadiusStop)
+{
+  const Array<float3> positions(10, float3(1.0f));
+  SpatialHashGrid grid(positions, 1.0f);
+  int calls = 0;
+  EXPECT_FALSE(grid.foreach_in_radius(float3(1.0f), 0.5f, [&](int, const float3 &, float) {
+    calls++;
+    return calls < 3;
+  }));
+  EXPECT_EQ(calls, 3);
+}
+
+/* Points far outside of the range of cell coordinates still find each other. */
+TEST(spatial_hash_grid, LargeCoordinates)
+{
+  const Array<float3> positions = {float3(1e20f), float3(1e20f), float3(-1e20f), float3(0.0f)};
+  SpatialHashGrid grid(positions, 0.001f);
+  Array<int> duplicates(positions.size(), -1);
+  EXPECT_EQ(grid.calc_duplicates(0.001f, duplicates), 1);
+  EXPECT_EQ(duplicates[0], 0);
+  EXPECT_EQ(duplicates[1], 0);
+  EXPECT_EQ(duplicates[2], -1);
+  EXPECT_EQ(duplicates[3], -1);
+}
+
+/**
+ * The merge targets depend on the order of the grid, check the rules of
+ * #BLI_kdtree_3d_calc_duplicates_fast instead of comparing with the k-d tree.
+ */
+static void calc_duplicates_test(const int size, const float merge_distance)
+{
+  const Array<float3> positions = random_positions(size, 1.0f, 1);
+
+  Array<int> duplicates(size);
+  for (const int i : positions.index_range()) {
+    /* Some points are kept, they can still be used as a target. */
+    duplicates[i] = (i % 7 == 0) ? i : -1;
+  }
+
+  SpatialHashGrid grid(positions, merge_distance * 4.0f);
+  const int found = grid.calc_duplicates(merge_distance, duplicates);
+
+  int found_expect = 0;
+  for (const int i : positions.index_range()) {
+    const int target = duplicates[i];
+    if (target == -1 || target == i) {
+      continue;
+    }
+    /* Merged points are merged into a kept point within the distance. */
+    found_expect++;
+    EXPECT_EQ(duplicates[target], target);
+    EXPECT_LE(math::distance(positions[i], positions[target]), merge_distance);
+  }
+  EXPECT_EQ(found, found_expect);
+
+  /* Points that were not merged and are not targets have no such neighbors left. */
+  for (const int i : positions.index_range()) {
+    if (duplicates[i] != -1) {
+      continue;
+    }
+    for (const int j : positions.index_range()) {
+      if (j != i && duplicates[j] == -1) {
+        EXPECT_GT(math::distance(positions[i], positions[j]), merge_distance);
+      }
+    }
+  }
+
+  /* The result doesn't depend on the threads. */
+  Array<int> duplicates_again(size);
+  for (const int i : positions.index_range()) {
+    duplicates_again[i] = (i % 7 == 0) ? i : -1;
+  }
+  EXPECT_EQ(grid.calc_duplicates(merge_distance, duplicates_again), found);
+  EXPECT_EQ_ARRAY(duplicates.data(), duplicates_again.data(), size);
+}
+
+TEST(spatial_hash_grid, CalcDuplicates)
+{
+  calc_duplicates_test(100, 0.1f);
+  calc_duplicates_test(5000, 0.02f);
+}
+
+/* Many points within the distance, the search results don't fit in the buffers. */
+TEST(spatial_hash_grid, CalcDuplicatesDense)
+{
+  calc_duplicates_test(5000, 0.2f);
+}
+
+}  // namespace blender::tests
@@ -0,0 +1,383 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_kdopbvh.h"
+#include "BLI_math_geom.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#define NUM_RUN_AVERAGED 10
+
+/* A height-field of triangles in the unit square, like a displaced grid mesh. */
+struct RayCastTestData {
+  BVHTree *tree;
+  float (*tris)[3][3];
+  float (*origins)[3];
+  float (*directions)[3];
+  BVHTreeRayHit *hits;
+  int rays_num;
+  double build_time;
+};
+
+static void raycast_tri_callback(void *userdata,
+                                 int index,
+                                 const BVHTreeRay *ray,
+                                 BVHTreeRayHit *hit)
+{
+  const float(*tris)[3][3] = (const float(*)[3][3])userdata;
+  float dist;
+  if (isect_ray_tri_watertight_v3(
+          ray->origin, ray->isect_precalc, UNPACK3(tris[index]), &dist, nullptr) &&
+      dist < hit->dist) {
+    hit->index = index;
+    hit->dist = dist;
+    madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+  }
+}
+
+static void raycast_test_data_init(RayCastTestData *data,
+                                   const int resolution,
+                                   const int rays_res,
+                                   const int build_flag = 0)
+{
+  struct RNG *rng = BLI_rng_new(1234);
+  const int tris_num = resolution * resolution * 2;
+  float *height = (float *)MEM_mallocN(sizeof(float) * (resolution + 1) * (resolution + 1),
+                                       __func__);
+  for (int i = 0; i < (resolution + 1) * (resolution + 1); i++) {
+    height[i] = BLI_rng_get_float(rng) * 0.01f;
+  }
+
+  data->tree = BLI_bvhtree_new_ex(tris_num, 0.0f, 4, 6, build_flag);
+  data->tris = (float(*)[3][3])MEM_mallocN(sizeof(*data->tris) * tris_num, __func__);
+  const float step = 1.0f / (float)resolution;
+  for (int y = 0; y < resolution; y++) {
+    for (int x = 0; x < resolution; x++) {
+      float quad[4][3];
+      const int corners[4][2] = {{x, y}, {x + 1, y}, {x + 1, y + 1}, {x, y + 1}};
+      for (int c = 0; c < 4; c++) {
+        quad[c][0] = (float)corners[c][0] * step;
+        quad[c][1] = (float)corners[c][1] * step;
+        quad[c][2] = height[corners[c][1] * (resolution + 1) + corners[c][0]];
+      }
+      const int tri_index = (y * resolution + x) * 2;
+      float(*tri_a)[3] = data->tris[tri_index];
+      float(*tri_b)[3] = data->tris[tri_index + 1];
+      copy_v3_v3(tri_a[0], quad[0]);
+      copy_v3_v3(tri_a[1], quad[1]);
+      copy_v3_v3(tri_a[2], quad[2]);
+      copy_v3_v3(tri_b[0], quad[0]);
+      copy_v3_v3(tri_b[1], quad[2]);
+      copy_v3_v3(tri_b[2], quad[3]);
+      BLI_bvhtree_insert(data->tree, tri_index, &tri_a[0][0], 3);
+      BLI_bvhtree_insert(data->tree, tri_index + 1, &tri_b[0][0], 3);
+    }
+  }
+  data->build_time = PIL_check_seconds_timer();
+  BLI_bvhtree_balance(data->tree);
+  data->build_time = PIL_check_seconds_timer() - data->build_time;
+  MEM_freeN(height);
+
+  /* Coherent rays from a camera above the grid, in scan-line order. */
+  data->rays_num = rays_res * rays_res;
+  data->origins = (float(*)[3])MEM_mallocN(sizeof(*data->origins) * data->rays_num, __func__);
+  data->directions = (float(*)[3])MEM_mallocN(sizeof(*data->directions) * data->rays_num,
+                                              __func__);
+  data->hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*data->hits) * data->rays_num, __func__);
+  for (int y = 0; y < rays_res; y++) {
+    for (int x = 0; x < rays_res; x++) {
+      const int i = y * rays_res + x;
+      const float target[3] = {(float)x / (float)rays_res, (float)y / (float)rays_res, 0.0f};
+      copy_v3_fl3(data->origins[i], 0.5f, 0.5f, 2.0f);
+      sub_v3_v3v3(data->directions[i], target, data->origins[i]);
+      normalize_v3(data->directions[i]);
+    }
+  }
+  BLI_rng_free(rng);
+}
+
+static void raycast_test_data_free(RayCastTestData *data)
+{
+  BLI_bvhtree_free(data->tree);
+  MEM_freeN(data->tris);
+  MEM_freeN(data->origins);
+  MEM_freeN(data->directions);
+  MEM_freeN(data->hits);
+}
+
+static void raycast_hits_reset(RayCastTestData *data)
+{
+  for (int i = 0; i < data->rays_num; i++) {
+    data->hits[i].index = -1;
+    data->hits[i].dist = BVH_RAYCAST_DIST_MAX;
+  }
+}
+
+static void raycast_single_task_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RayCastTestData *data = (RayCastTestData *)userdata;
+  BLI_bvhtree_ray_cast_ex(data->tree,
+                          data->origins[i],
+                          data->directions[i],
+                          0.0f,
+                          &data->hits[i],
+                          raycast_tri_callback,
+                          data->tris,
+                          BVH_RAYCAST_DEFAULT);
+}
+
+static void raycast_test(const char *id, const int resolution, const int rays_res)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  RayCastTestData data;
+  raycast_test_data_init(&data, resolution, rays_res);
+
+  double single_timing = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    raycast_hits_reset(&data);
+    const double init_time = PIL_check_seconds_timer();
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 256;
+    BLI_task_parallel_range(0, data.rays_num, &data, raycast_single_task_cb, &settings);
+    single_timing += PIL_check_seconds_timer() - init_time;
+  }
+
+  /* Keep the results of the single ray casts to compare them with the packets. */
+  int *expected_indices = (int *)MEM_mallocN(sizeof(int) * data.rays_num, __func__);
+  for (int i = 0; i < data.rays_num; i++) {
+    expected_indices[i] = data.hits[i].index;
+  }
+
+  double packet_timing = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    raycast_hits_reset(&data);
+    const double init_time = PIL_check_seconds_timer();
+    BLI_bvhtree_ray_cast_array(data.tree,
+                               data.origins,
+                               data.directions,
+                               data.rays_num,
+                               0.0f,
+                               data.hits,
+                               raycast_tri_callback,
+                               data.tris,
+                               BVH_RAYCAST_DEFAULT);
+    packet_timing += PIL_check_seconds_timer() - init_time;
+  }
+
+  for (int i = 0; i < data.rays_num; i++) {
+    EXPECT_EQ(data.hits[i].index, expected_indices[i]);
+  }
+  MEM_freeN(expected_indices);
+
+  printf("\tSingle rays: done in %fs on average over %d runs\n",
+         single_timing / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED);
+  printf("\tRay packets: done in %fs on average over %d runs\n",
+         packet_timing / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED);
+
+  raycast_test_data_free(&data);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, RayCast200kTris1MRays)
+{
+  raycast_test("Ray cast - 200k triangles - 1M coherent rays", 316, 1000);
+}
+
+TEST(kdopbvh, RayCast2MTris1MRays)
+{
+  raycast_test("Ray cast - 2M triangles - 1M coherent rays", 1000, 1000);
+}
+
+static void nearest_single_task_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  RayCastTestData *data = (RayCastTestData *)userdata;
+  /* Points just above the surface, in the same order as the rays. */
+  float co[3];
+  madd_v3_v3v3fl(co, data->origins[i], data->directions[i], 1.5f);
+  BVHTreeNearest nearest;
+  nearest.index = -1;
+  nearest.dist_sq = FLT_MAX;
+  BLI_bvhtree_find_nearest(data->tree, co, &nearest, nullptr, nullptr);
+}
+
+static void build_flag_test(const char *id, const int resolution, const int rays_res)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  const int build_flags[2] = {0, BVH_BUILD_SAH};
+  const char *build_names[2] = {"Implicit tree", "SAH tree"};
+  for (int flag_index = 0; flag_index < 2; flag_index++) {
+    double build_timing = 0.0;
+    double raycast_timing = 0.0;
+    double nearest_timing = 0.0;
+    for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+      RayCastTestData data;
+      raycast_test_data_init(&data, resolution, rays_res, build_flags[flag_index]);
+      build_timing += data.build_time;
+
+      raycast_hits_reset(&data);
+      double init_time = PIL_check_seconds_timer();
+      BLI_bvhtree_ray_cast_array(data.tree,
+                                 data.origins,
+                                 data.directions,
+                                 data.rays_num,
+                                 0.0f,
+                                 data.hits,
+                                 raycast_tri_callback,
+                                 data.tris,
+                                 BVH_RAYCAST_DEFAULT);
+      raycast_timing += PIL_check_seconds_timer() - init_time;
+
+      init_time = PIL_check_seconds_timer();
+      TaskParallelSettings settings;
+      BLI_parallel_range_settings_defaults(&settings);
+      settings.min_iter_per_thread = 256;
+      BLI_task_parallel_range(0, data.rays_num, &data, nearest_single_task_cb, &settings);
+      nearest_timing += PIL_check_seconds_timer() - init_time;
+
+      raycast_test_data_free(&data);
+    }
+
+    printf("\t%s: build in %fs, ray cast in %fs, nearest in %fs on average over %d runs\n",
+           build_names[flag_index],
+           build_timing / NUM_RUN_AVERAGED,
+           raycast_timing / NUM_RUN_AVERAGED,
+           nearest_timing / NUM_RUN_AVERAGED,
+           NUM_RUN_AVERAGED);
+  }
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, BuildFlag200kTris1MRays)
+{
+  build_flag_test("Build flags - 200k triangles - 1M queries", 316, 1000);
+}
+
+TEST(kdopbvh, BuildFlag2MTris1MRays)
+{
+  build_flag_test("Build flags - 2M triangles - 1M queries", 1000, 1000);
+}
+
+static void nearest_tri_callback(void *userdata,
+                                 int index,
+                                 const float co[3],
+                                 BVHTreeNearest *nearest)
+{
+  const float(*tris)[3][3] = (const float(*)[3][3])userdata;
+  float nearest_tmp[3];
+  closest_on_tri_to_point_v3(nearest_tmp, co, UNPACK3(tris[index]));
+  const float dist_sq = len_squared_v3v3(co, nearest_tmp);
+  if (dist_sq < nearest->dist_sq) {
+    nearest->index = index;
+    nearest->dist_sq = dist_sq;
+    copy_v3_v3(nearest->co, nearest_tmp);
+  }
+}
+
+struct NearestTestData {
+  RayCastTestData *raycast;
+  float (*points)[3];
+  BVHTreeNearest *nearest;
+};
+
+static void nearest_tri_task_cb(void *__restrict userdata,
+                                const int i,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  NearestTestData *data = (NearestTestData *)userdata;
+  BLI_bvhtree_find_nearest(data->raycast->tree,
+                           data->points[i],
+                           &data->nearest[i],
+                           nearest_tri_callback,
+                           data->raycast->tris);
+}
+
+static void nearest_array_test(const char *id, const int resolution, const int points_num)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  RayCastTestData raycast;
+  raycast_test_data_init(&raycast, resolution, 1);
+
+  /* Random points around the surface, in random order. */
+  struct RNG *rng = BLI_rng_new(1234);
+  NearestTestData data;
+  data.raycast = &raycast;
+  data.points = (float(*)[3])MEM_mallocN(sizeof(*data.points) * points_num, __func__);
+  data.nearest = (BVHTreeNearest *)MEM_mallocN(sizeof(*data.nearest) * points_num, __func__);
+  for (int i = 0; i < points_num; i++) {
+    data.points[i][0] = BLI_rng_get_float(rng);
+    data.points[i][1] = BLI_rng_get_float(rng);
+    data.points[i][2] = BLI_rng_get_float(rng) * 0.1f - 0.05f;
+  }
+  BLI_rng_free(rng);
+
+  double single_timing = 0.0;
+  double array_timing = 0.0;
+  for (int run = 0; run < NUM_RUN_AVERAGED; run++) {
+    for (int i = 0; i < points_num; i++) {
+      data.nearest[i].index = -1;
+      data.nearest[i].dist_sq = FLT_MAX;
+    }
+    double init_time = PIL_check_seconds_timer();
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 256;
+    BLI_task_parallel_range(0, points_num, &data, nearest_tri_task_cb, &settings);
+    single_timing += PIL_check_seconds_timer() - init_time;
+
+    for (int i = 0; i < points_num; i++) {
+      data.nearest[i].index = -1;
+      data.nearest[i].dist_sq = FLT_MAX;
+    }
+    init_time = PIL_check_seconds_timer();
+    BLI_bvhtree_find_nearest_array(raycast.tree,
+                                   data.points,
+                                   points_num,
+                                   data.nearest,
+                                   nearest_tri_callback,
+                                   raycast.tris,
+                                   0);
+    array_timing += PIL_check_seconds_timer() - init_time;
+  }
+
+  printf("\tSingle points: done in %fs on average over %d runs\n",
+         single_timing / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED);
+  printf("\tPoint array: done in %fs on average over %d runs\n",
+         array_timing / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED);
+
+  MEM_freeN(data.points);
+  MEM_freeN(data.nearest);
+  raycast_test_data_free(&raycast);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, NearestArray200kTris1MPoints)
+{
+  nearest_array_test("Nearest - 200k triangles - 1M random points", 316, 1000000);
+}
+
+TEST(kdopbvh, NearestArray2MTris4MPoints)
+{
+  nearest_array_test("Nearest - 2M triangles - 4M random points", 1000, 4000000);
+}
@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_kdtree.h"
+#include "BLI_rand.hh"
+#include "BLI_spatial_hash_grid.hh"
+
+#include "PIL_time.h"
+
+#define NUM_RUN_AVERAGED 10
+
+namespace blender::tests {
+
+/**
+ * Points like a scanned surface: several overlapping scans of the same wavy height-field, each
+ * sampled on a grid with some noise, so most points have a close neighbor from another scan.
+ */
+static Array<float3> scanned_surface_positions(const int resolution, const int scans_num)
+{
+  RandomNumberGenerator rng(1234);
+  const float step = 1.0f / float(resolution);
+  Array<float3> positions(resolution * resolution * scans_num);
+  int index = 0;
+  for (const int scan : IndexRange(scans_num)) {
+    const float offset = float(scan) * step / float(scans_num);
+    for (const int y : IndexRange(resolution)) {
+      for (const int x : IndexRange(resolution)) {
+        const float px = float(x) * step + offset + (rng.get_float() - 0.5f) * step * 0.1f;
+        const float py = float(y) * step + offset + (rng.get_float() - 0.5f) * step * 0.1f;
+        const float pz = 0.05f * std::sin(px * 20.0f) * std::cos(py * 20.0f) +
+                         (rng.get_float() - 0.5f) * step * 0.1f;
+        positions[index++] = float3(px, py, pz);
+      }
+    }
+  }
+  return positions;
+}
+
+static void merge_by_distance_test(const char *id, const int resolution, const int scans_num)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  const Array<float3> positions = scanned_surface_positions(resolution, scans_num);
+  const float merge_distance = 0.5f / float(resolution);
+
+  double kdtree_timing = 0.0;
+  int kdtree_found = 0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    Array<int> duplicates(positions.size(), -1);
+    const double init_time = PIL_check_seconds_timer();
+    KDTree_3d *tree = BLI_kdtree_3d_new(positions.size());
+    for (const int i : positions.index_range()) {
+      BLI_kdtree_3d_insert(tree, i, positions[i]);
+    }
+    BLI_kdtree_3d_balance(tree);
+    kdtree_found = BLI_kdtree_3d_calc_duplicates_fast(
+        tree, merge_distance, false, duplicates.data());
+    BLI_kdtree_3d_free(tree);
+    kdtree_timing += PIL_check_seconds_timer() - init_time;
+  }
+
+  double grid_timing = 0.0;
+  int grid_found = 0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    Array<int> duplicates(positions.size(), -1);
+    const double init_time = PIL_check_seconds_timer();
+    const SpatialHashGrid grid(positions, merge_distance * 4.0f);
+    grid_found = grid.calc_duplicates(merge_distance, duplicates);
+    grid_timing += PIL_check_seconds_timer() - init_time;
+  }
+
+  /* The merge targets depend on the loop order, the number of merges is close. */
+  printf("\tKD tree: %d merges, done in %fs on average over %d runs\n",
+         kdtree_found,
+         kdtree_timing / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED);
+  printf("\tSpatial hash grid: %d merges, done in %fs on average over %d runs\n",
+         grid_found,
+         grid_timing / NUM_RUN_AVERAGED,
+         NUM_RUN_AVERAGED);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(spatial_hash_grid, MergeByDistance1MPoints)
+{
+  merge_by_distance_test("Merge by distance - 1M points - 4 scans", 500, 4);
+}
+
+TEST(spatial_hash_grid, MergeByDistance10MPoints)
+{
+  merge_by_distance_test("Merge by distance - 10M points - 4 scans", 1581, 4);
+}
+
+}  // namespace blender::tests
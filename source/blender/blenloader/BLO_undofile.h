@@ -24,9 +24,16 @@ typedef struct {
    * detect unchanged IDs).
    * Defined when writing the next step (i.e. last undo step has those always false). */
   bool is_identical_future;
+  /** When true, this chunk doesn't own the memory either, it's shared with a chunk of the
+   * previous #MemFile that has the same content but a different position (e.g. because data
+   * before it in the same ID was added or removed). Unlike #is_identical, this doesn't mean the
+   * data is unchanged compared to the previous step. */
+  bool is_shared;
   /** Session UUID of the ID being currently written (MAIN_ID_SESSION_UUID_UNSET when not writing
    * ID-related data). Used to find matching chunks in previous memundo step. */
   uint id_session_uuid;
+  /** Hash of the content, used to find shared chunks. Zero when not computed yet. */
+  uint hash;
 } MemFileChunk;
 
 typedef struct MemFile {
@@ -43,6 +50,11 @@ typedef struct MemFileWriteData {
 
   /** Maps an ID session uuid to its first reference MemFileChunk, if existing. */
   struct GHash *id_session_uuid_mapping;
+
+  /** Maps content hashes to the reference chunks of the ID currently being written, created when
+   * a chunk of that ID doesn't match the reference chunk at the same position. */
+  struct GHash *id_chunks_hash_mapping;
+  uint id_chunks_hash_mapping_session_uuid;
 } MemFileWriteData;
 
 typedef struct MemFileUndoData {
@@ -78,6 +90,13 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
 /* **************** support for memory-write, for undo buffers *************** */
 
 extern void BLO_memfile_free(MemFile *memfile);
+/**
+ * Create a new memfile using the chunk buffers of `memfile` (to be freed with #BLO_memfile_free
+ * and `MEM_freeN`). The buffers are not copied, but they are kept alive as long as the new
+ * memfile uses them. Unlike the original, it stays valid while undo steps are added or freed, so
+ * it can be written to disk from another thread.
+ */
+extern MemFile *BLO_memfile_duplicate(const MemFile *memfile);
 /**
  * Result is that 'first' is being freed.
  * to keep list of memfiles consistent, 'first' is always first in list.
@@ -568,48 +568,6 @@ static bool blo_bhead_is_id_valid_type(const BHead *bhead)
   return BKE_idtype_idcode_is_valid(id_type_code);
 }
 
-#ifdef USE_GHASH_BHEAD
-static void read_file_bhead_idname_map_create(FileData *fd)
-{
-  BHead *bhead;
-
-  /* dummy values */
-  bool is_link = false;
-  int code_prev = ENDB;
-  uint reserve = 0;
-
-  for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
-    if (code_prev != bhead->code) {
-      code_prev = bhead->code;
-      is_link = blo_bhead_is_id_valid_type(bhead) ?
-                    BKE_idtype_idcode_is_linkable((short)code_prev) :
-                    false;
-    }
-
-    if (is_link) {
-      reserve += 1;
-    }
-  }
-
-  BLI_assert(fd->bhead_idname_hash == NULL);
-
-  fd->bhead_idname_hash = BLI_ghash_str_new_ex(__func__, reserve);
-
-  for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
-    if (code_prev != bhead->code) {
-      code_prev = bhead->code;
-      is_link = blo_bhead_is_id_valid_type(bhead) ?
-                    BKE_idtype_idcode_is_linkable((short)code_prev) :
-                    false;
-    }
-
-    if (is_link) {
-      BLI_ghash_insert(fd->bhead_idname_hash, (void *)blo_bhead_id_name(fd, bhead), bhead);
-    }
-  }
-}
-#endif
-
 static Main *blo_find_main(FileData *fd, const char *filepath, const char *relabase)
 {
   ListBase *mainlist = fd->mainlist;
@@ -4019,26 +3977,61 @@ static int verg_bheadsort(const void *v1, const void *v2)
   return 0;
 }
 
-static void sort_bhead_old_map(FileData *fd)
+static bool blo_bhead_is_linkable(const BHead *bhead)
 {
-  BHead *bhead;
-  struct BHeadSort *bhs;
-  int tot = 0;
+  return blo_bhead_is_id_valid_type(bhead) && BKE_idtype_idcode_is_linkable((short)bhead->code);
+}
 
-  for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
-    tot++;
+/**
+ * Create the index of the ID BHeads of the file, used to find data-blocks when linking:
+ * by old memory address (#find_bhead) and by name (#find_bhead_from_code_name).
+ *
+ * Data BHeads are left out, they are only reached through the ID they belong to. Since they make
+ * up the vast majority of BHeads in large files (and are not even read until needed, see
+ * #BHEAD_USE_READ_ON_DEMAND), this keeps the index cheap to build and small compared to the
+ * data-blocks that are actually linked. It is created on first use, so reading other information
+ * from a library (e.g. just the names of its data-blocks) doesn't pay for it.
+ */
+static void read_file_bhead_id_index_ensure(FileData *fd)
+{
+  if (fd->bheadmap != NULL) {
+    return;
   }
 
-  fd->tot_bheadmap = tot;
-  if (tot == 0) {
-    return;
+  int tot = 0;
+  uint tot_linkable = 0;
+  for (BHead *bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+    if (blo_bhead_is_id(bhead)) {
+      tot++;
+      if (blo_bhead_is_linkable(bhead)) {
+        tot_linkable++;
+      }
+    }
   }
 
-  bhs = fd->bheadmap = MEM_malloc_arrayN(tot, sizeof(struct BHeadSort), "BHeadSort");
+  /* Always allocated, a non-null map tells that the index exists. */
+  fd->bheadmap = MEM_malloc_arrayN(max_ii(tot, 1), sizeof(struct BHeadSort), "BHeadSort");
+  fd->tot_bheadmap = tot;
+#ifdef USE_GHASH_BHEAD
+  BLI_assert(fd->bhead_idname_hash == NULL);
+  fd->bhead_idname_hash = BLI_ghash_str_new_ex(__func__, tot_linkable);
+#else
+  UNUSED_VARS(tot_linkable);
+#endif
 
-  for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead), bhs++) {
+  struct BHeadSort *bhs = fd->bheadmap;
+  for (BHead *bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+    if (!blo_bhead_is_id(bhead)) {
+      continue;
+    }
     bhs->bhead = bhead;
     bhs->old = bhead->old;
+    bhs++;
+#ifdef USE_GHASH_BHEAD
+    if (blo_bhead_is_linkable(bhead)) {
+      BLI_ghash_insert(fd->bhead_idname_hash, (void *)blo_bhead_id_name(fd, bhead), bhead);
+    }
+#endif
   }
 
   qsort(fd->bheadmap, tot, sizeof(struct BHeadSort), verg_bheadsort);
@@ -4071,9 +4064,7 @@ static BHead *find_bhead(FileData *fd, void *old)
     return NULL;
   }
 
-  if (fd->bheadmap == NULL) {
-    sort_bhead_old_map(fd);
-  }
+  read_file_bhead_id_index_ensure(fd);
 
   bhs_s.old = old;
   bhs = bsearch(&bhs_s, fd->bheadmap, fd->tot_bheadmap, sizeof(struct BHeadSort), verg_bheadsort);
@@ -4096,6 +4087,7 @@ static BHead *find_bhead(FileData *fd, void *old)
 static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const char *name)
 {
 #ifdef USE_GHASH_BHEAD
+  read_file_bhead_id_index_ensure(fd);
 
   char idname_full[MAX_ID_NAME];
 
@@ -4126,6 +4118,7 @@ static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname)
 {
 #ifdef USE_GHASH_BHEAD
+  read_file_bhead_id_index_ensure(fd);
   return BLI_ghash_lookup(fd->bhead_idname_hash, idname);
 #else
   return find_bhead_from_code_name(fd, GS(idname), idname + 2);
@@ -4442,9 +4435,6 @@ static Main *library_link_begin(Main *mainvar,
   /* needed for do_version */
   mainl->versionfile = (*fd)->fileversion;
   read_file_version(*fd, mainl);
-#ifdef USE_GHASH_BHEAD
-  read_file_bhead_idname_map_create(*fd);
-#endif
 
   return mainl;
 }
@@ -4816,9 +4806,6 @@ static FileData *read_library_file_data(FileData *basefd,
 
     /* subversion */
     read_file_version(fd, mainptr);
-#ifdef USE_GHASH_BHEAD
-    read_file_bhead_idname_map_create(fd);
-#endif
   }
   else {
     mainptr->curlib->filedata = NULL;
@@ -21,10 +21,13 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_readfile.h"
 #include "BLO_undofile.h"
@@ -38,19 +41,71 @@
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/**
+ * Chunk buffers are preceded by a user count, so a duplicated memfile can keep using them after
+ * the undo steps that created them are freed. The header size keeps the data aligned.
+ */
+typedef union MemFileChunkBufferHeader {
+  int32_t users;
+  char _pad[16];
+} MemFileChunkBufferHeader;
+
+static char *memfile_chunk_buf_alloc(size_t size)
+{
+  MemFileChunkBufferHeader *header = MEM_mallocN(sizeof(*header) + size, "Chunk buffer");
+  header->users = 1;
+  return (char *)(header + 1);
+}
+
+static void memfile_chunk_buf_user_add(const char *buf)
+{
+  MemFileChunkBufferHeader *header = ((MemFileChunkBufferHeader *)buf) - 1;
+  atomic_add_and_fetch_int32(&header->users, 1);
+}
+
+static void memfile_chunk_buf_free(const char *buf)
+{
+  MemFileChunkBufferHeader *header = ((MemFileChunkBufferHeader *)buf) - 1;
+  if (atomic_sub_and_fetch_int32(&header->users, 1) == 0) {
+    MEM_freeN(header);
+  }
+}
+
+static bool memfile_chunk_owns_buf(const MemFileChunk *chunk)
+{
+  return !(chunk->is_identical || chunk->is_shared);
+}
+
 void BLO_memfile_free(MemFile *memfile)
 {
   MemFileChunk *chunk;
 
   while ((chunk = BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
+    if (memfile_chunk_owns_buf(chunk)) {
+      memfile_chunk_buf_free(chunk->buf);
     }
     MEM_freeN(chunk);
   }
   memfile->size = 0;
 }
 
+MemFile *BLO_memfile_duplicate(const MemFile *memfile)
+{
+  MemFile *memfile_copy = MEM_callocN(sizeof(MemFile), __func__);
+
+  LISTBASE_FOREACH (const MemFileChunk *, chunk, &memfile->chunks) {
+    MemFileChunk *chunk_copy = MEM_dupallocN(chunk);
+    /* Every chunk of the copy owns a user of its buffer, even when the original one shares it. */
+    chunk_copy->is_identical = false;
+    chunk_copy->is_shared = false;
+    memfile_chunk_buf_user_add(chunk_copy->buf);
+    BLI_addtail(&memfile_copy->chunks, chunk_copy);
+    memfile_copy->size += chunk->size;
+  }
+
+  return memfile_copy;
+}
+
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
   /* We use this mapping to store the memory buffers from second memfile chunks which are not owned
@@ -58,21 +113,27 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
   GHash *buffer_to_second_memchunk = BLI_ghash_new(
       BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, __func__);
 
-  /* First, detect all memchunks in second memfile that are not owned by it. */
+  /* First, detect all memchunks in second memfile that are not owned by it. Several of them may
+   * use the same buffer when it's shared with chunks of the same content, only the first one
+   * takes the ownership, the others keep sharing it. */
   for (MemFileChunk *sc = second->chunks.first; sc != NULL; sc = sc->next) {
-    if (sc->is_identical) {
-      BLI_ghash_insert(buffer_to_second_memchunk, (void *)sc->buf, sc);
+    if (!memfile_chunk_owns_buf(sc)) {
+      void **entry;
+      if (!BLI_ghash_ensure_p(buffer_to_second_memchunk, (void *)sc->buf, &entry)) {
+        *entry = sc;
+      }
     }
   }
 
   /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
    * it is also used by the second memfile, transfer the ownership. */
   for (MemFileChunk *fc = first->chunks.first; fc != NULL; fc = fc->next) {
-    if (!fc->is_identical) {
+    if (memfile_chunk_owns_buf(fc)) {
       MemFileChunk *sc = BLI_ghash_lookup(buffer_to_second_memchunk, fc->buf);
       if (sc != NULL) {
-        BLI_assert(sc->is_identical);
+        BLI_assert(!memfile_chunk_owns_buf(sc));
         sc->is_identical = false;
+        sc->is_shared = false;
         fc->is_identical = true;
       }
       /* Note that if the second memfile does not use that chunk, we assume that the first one
@@ -100,6 +161,7 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
   mem_data->written_memfile = written_memfile;
   mem_data->reference_memfile = reference_memfile;
   mem_data->reference_current_chunk = reference_memfile ? reference_memfile->chunks.first : NULL;
+  mem_data->id_chunks_hash_mapping = NULL;
 
   /* If we have a reference memfile, we generate a mapping between the session_uuid's of the
    * IDs stored in that previous undo step, and its first matching memchunk. This will allow
@@ -132,6 +194,78 @@ void BLO_memfile_write_finalize(MemFileWriteData *mem_data)
   if (mem_data->id_session_uuid_mapping != NULL) {
     BLI_ghash_free(mem_data->id_session_uuid_mapping, NULL, NULL);
   }
+  if (mem_data->id_chunks_hash_mapping != NULL) {
+    BLI_ghash_free(mem_data->id_chunks_hash_mapping, NULL, NULL);
+  }
+}
+
+static uint memfile_chunk_hash_calc(const char *buf, size_t size)
+{
+  const uint hash = BLI_hash_mm2((const uchar *)buf, size, 0);
+  /* Zero means the hash isn't computed yet. */
+  return hash != 0 ? hash : 1;
+}
+
+static uint memfile_chunk_hash_ensure(MemFileChunk *chunk)
+{
+  if (chunk->hash == 0) {
+    chunk->hash = memfile_chunk_hash_calc(chunk->buf, chunk->size);
+  }
+  return chunk->hash;
+}
+
+/**
+ * Find a chunk of the reference memfile with the given content, among the ones of the ID being
+ * written. Chunks are mostly compared by position, which fails for all the data of an ID after
+ * an array that changed size (e.g. when adding geometry to a mesh). The hashes are only computed
+ * for IDs that don't match by position, so unchanged data doesn't pay for it.
+ */
+static MemFileChunk *memfile_find_shared_chunk(MemFileWriteData *mem_data,
+                                               const char *buf,
+                                               size_t size,
+                                               uint *r_hash)
+{
+  const uint id_session_uuid = mem_data->current_id_session_uuid;
+  if (id_session_uuid == MAIN_ID_SESSION_UUID_UNSET ||
+      mem_data->id_session_uuid_mapping == NULL) {
+    return NULL;
+  }
+
+  if (mem_data->id_chunks_hash_mapping == NULL ||
+      mem_data->id_chunks_hash_mapping_session_uuid != id_session_uuid) {
+    MemFileChunk *ref_chunk = BLI_ghash_lookup(mem_data->id_session_uuid_mapping,
+                                               POINTER_FROM_UINT(id_session_uuid));
+    if (ref_chunk == NULL) {
+      /* New ID, there is nothing to share. */
+      return NULL;
+    }
+    if (mem_data->id_chunks_hash_mapping == NULL) {
+      mem_data->id_chunks_hash_mapping = BLI_ghash_new(
+          BLI_ghashutil_inthash_p_simple, BLI_ghashutil_intcmp, __func__);
+    }
+    else {
+      BLI_ghash_clear(mem_data->id_chunks_hash_mapping, NULL, NULL);
+    }
+    mem_data->id_chunks_hash_mapping_session_uuid = id_session_uuid;
+    for (; ref_chunk != NULL && ref_chunk->id_session_uuid == id_session_uuid;
+         ref_chunk = ref_chunk->next) {
+      void **entry;
+      /* Keep the first chunk in case of equal hashes, they are likely the same content. */
+      if (!BLI_ghash_ensure_p(mem_data->id_chunks_hash_mapping,
+                              POINTER_FROM_UINT(memfile_chunk_hash_ensure(ref_chunk)),
+                              &entry)) {
+        *entry = ref_chunk;
+      }
+    }
+  }
+
+  *r_hash = memfile_chunk_hash_calc(buf, size);
+  MemFileChunk *ref_chunk = BLI_ghash_lookup(mem_data->id_chunks_hash_mapping,
+                                             POINTER_FROM_UINT(*r_hash));
+  if (ref_chunk != NULL && ref_chunk->size == size && memcmp(ref_chunk->buf, buf, size) == 0) {
+    return ref_chunk;
+  }
+  return NULL;
 }
 
 void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t size)
@@ -143,6 +277,8 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   curchunk->size = size;
   curchunk->buf = NULL;
   curchunk->is_identical = false;
+  curchunk->is_shared = false;
+  curchunk->hash = 0;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
    * will then not be undo. Though it's not entirely clear that is wrong behavior. */
@@ -156,6 +292,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
     if (compchunk->size == curchunk->size) {
       if (memcmp(compchunk->buf, buf, size) == 0) {
         curchunk->buf = compchunk->buf;
+        curchunk->hash = compchunk->hash;
         curchunk->is_identical = true;
         compchunk->is_identical_future = true;
       }
@@ -163,9 +300,20 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
     *compchunk_step = compchunk->next;
   }
 
+  /* Not equal, look for the same data elsewhere in the ID. */
+  if (curchunk->buf == NULL) {
+    MemFileChunk *shared_chunk = memfile_find_shared_chunk(mem_data, buf, size, &curchunk->hash);
+    if (shared_chunk != NULL) {
+      curchunk->buf = shared_chunk->buf;
+      curchunk->is_shared = true;
+      /* Following data is likely to be shifted the same way, continue comparing from there. */
+      *compchunk_step = shared_chunk->next;
+    }
+  }
+
   /* not equal... */
   if (curchunk->buf == NULL) {
-    char *buf_new = MEM_mallocN(size, "Chunk buffer");
+    char *buf_new = memfile_chunk_buf_alloc(size);
     memcpy(buf_new, buf, size);
     curchunk->buf = buf_new;
     memfile->size += size;
@@ -195,6 +343,37 @@ struct Main *BLO_memfile_main_get(struct MemFile *memfile,
   return bmain_undo;
 }
 
+/**
+ * Write the whole buffer, `write` may write less than requested (it's limited to about 2 GiB
+ * on Linux and takes an `unsigned int` size on Windows).
+ */
+static bool memfile_write_buf(int file, const char *buf, size_t size)
+{
+  /* Bytes written by a single call, well below the limits of all platforms. */
+  const size_t write_size_max = 1 << 30;
+  while (size > 0) {
+    const size_t write_size = MIN2(size, write_size_max);
+#ifdef _WIN32
+    const int written = write(file, buf, (uint)write_size);
+#else
+    const ssize_t written = write(file, buf, write_size);
+#endif
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    if (written == 0) {
+      /* Avoid looping forever when nothing can be written. */
+      return false;
+    }
+    buf += written;
+    size -= (size_t)written;
+  }
+  return true;
+}
+
 bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
 {
   MemFileChunk *chunk;
@@ -227,12 +406,7 @@ bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
   }
 
   for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
-#ifdef _WIN32
-    if ((size_t)write(file, chunk->buf, (uint)chunk->size) != chunk->size)
-#else
-    if ((size_t)write(file, chunk->buf, chunk->size) != chunk->size)
-#endif
-    {
+    if (!memfile_write_buf(file, chunk->buf, chunk->size)) {
       break;
     }
   }
@@ -130,6 +130,8 @@
 
 #define ZSTD_BUFFER_SIZE (1 << 21) /* 2mb */
 #define ZSTD_CHUNK_SIZE (1 << 20)  /* 1mb */
+/** Uncompressed size of each zstd frame (except the last one), compressed independently. */
+#define ZSTD_FRAME_SIZE (1 << 20) /* 1mb */
 
 #define ZSTD_COMPRESSION_LEVEL 3
 
@@ -175,6 +177,12 @@ struct WriteWrap {
     int level;
     ListBase frames;
 
+    /** Data of the next frame, passed on for compression once it's full. */
+    char *frame_buf;
+    size_t frame_buf_len;
+    /** Compression contexts not in use by a task, reused to avoid reallocating them. */
+    LinkNode *free_contexts;
+
     bool write_error;
   } zstd;
 };
@@ -217,15 +225,24 @@ static void *zstd_write_task(void *userdata)
   ZstdWriteBlockTask *task = userdata;
   WriteWrap *ww = task->ww;
 
+  BLI_mutex_lock(&ww->zstd.mutex);
+  ZSTD_CCtx *ctx = BLI_linklist_pop(&ww->zstd.free_contexts);
+  BLI_mutex_unlock(&ww->zstd.mutex);
+  if (ctx == NULL) {
+    ctx = ZSTD_createCCtx();
+  }
+
   size_t out_buf_len = ZSTD_compressBound(task->size);
   void *out_buf = MEM_mallocN(out_buf_len, "Zstd out buffer");
-  size_t out_size = ZSTD_compress(
-      out_buf, out_buf_len, task->data, task->size, ZSTD_COMPRESSION_LEVEL);
+  size_t out_size = ZSTD_compressCCtx(
+      ctx, out_buf, out_buf_len, task->data, task->size, ZSTD_COMPRESSION_LEVEL);
 
   MEM_freeN(task->data);
 
   BLI_mutex_lock(&ww->zstd.mutex);
 
+  BLI_linklist_prepend(&ww->zstd.free_contexts, ctx);
+
   while (ww->zstd.next_frame != task->frame_number) {
     BLI_condition_wait(&ww->zstd.condition, &ww->zstd.mutex);
   }
@@ -310,33 +327,18 @@ static void zstd_write_seekable_frames(WriteWrap *ww)
   zstd_write_u32_le(ww, 0x8F92EAB1);
 }
 
-static bool ww_close_zstd(WriteWrap *ww)
-{
-  BLI_threadpool_end(&ww->zstd.threadpool);
-  BLI_freelistN(&ww->zstd.tasks);
-
-  BLI_mutex_end(&ww->zstd.mutex);
-  BLI_condition_end(&ww->zstd.condition);
-
-  zstd_write_seekable_frames(ww);
-  BLI_freelistN(&ww->zstd.frames);
-
-  return ww_close_none(ww) && !ww->zstd.write_error;
-}
-
-static size_t ww_write_zstd(WriteWrap *ww, const char *buf, size_t buf_len)
+/* Pass the current frame buffer on to a compression thread. */
+static void zstd_write_frame(WriteWrap *ww)
 {
-  if (ww->zstd.write_error) {
-    return 0;
-  }
-
   ZstdWriteBlockTask *task = MEM_mallocN(sizeof(ZstdWriteBlockTask), __func__);
-  task->data = MEM_mallocN(buf_len, __func__);
-  memcpy(task->data, buf, buf_len);
-  task->size = buf_len;
+  task->data = ww->zstd.frame_buf;
+  task->size = ww->zstd.frame_buf_len;
   task->frame_number = ww->zstd.num_frames++;
   task->ww = ww;
 
+  ww->zstd.frame_buf = NULL;
+  ww->zstd.frame_buf_len = 0;
+
   BLI_mutex_lock(&ww->zstd.mutex);
   BLI_addtail(&ww->zstd.tasks, task);
 
@@ -356,6 +358,62 @@ static size_t ww_write_zstd(WriteWrap *ww, const char *buf, size_t buf_len)
     MEM_freeN(first_task);
   }
   BLI_threadpool_insert(&ww->zstd.threadpool, task);
+}
+
+static void zstd_free_context(void *ctx)
+{
+  ZSTD_freeCCtx(ctx);
+}
+
+static bool ww_close_zstd(WriteWrap *ww)
+{
+  if (ww->zstd.frame_buf_len != 0 && !ww->zstd.write_error) {
+    zstd_write_frame(ww);
+  }
+  MEM_SAFE_FREE(ww->zstd.frame_buf);
+
+  BLI_threadpool_end(&ww->zstd.threadpool);
+  BLI_freelistN(&ww->zstd.tasks);
+
+  BLI_mutex_end(&ww->zstd.mutex);
+  BLI_condition_end(&ww->zstd.condition);
+
+  BLI_linklist_free(ww->zstd.free_contexts, zstd_free_context);
+  ww->zstd.free_contexts = NULL;
+
+  zstd_write_seekable_frames(ww);
+  BLI_freelistN(&ww->zstd.frames);
+
+  return ww_close_none(ww) && !ww->zstd.write_error;
+}
+
+/* Data is split into frames of #ZSTD_FRAME_SIZE, regardless of how it is passed in. Small
+ * frames compress badly and add overhead to the seek table, while bigger ones would make
+ * seeking when reading slower.
+ *
+ * The data is copied into the frame buffer, since the caller reuses or frees its memory while
+ * the frame is still being compressed. The full frame buffer is then passed on to the
+ * compression thread as is. */
+static size_t ww_write_zstd(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+  if (ww->zstd.write_error) {
+    return 0;
+  }
+
+  size_t written_len = 0;
+  while (written_len < buf_len) {
+    if (ww->zstd.frame_buf == NULL) {
+      ww->zstd.frame_buf = MEM_mallocN(ZSTD_FRAME_SIZE, __func__);
+    }
+    const size_t len = min_zz(buf_len - written_len, ZSTD_FRAME_SIZE - ww->zstd.frame_buf_len);
+    memcpy(ww->zstd.frame_buf + ww->zstd.frame_buf_len, buf + written_len, len);
+    ww->zstd.frame_buf_len += len;
+    written_len += len;
+
+    if (ww->zstd.frame_buf_len == ZSTD_FRAME_SIZE) {
+      zstd_write_frame(ww);
+    }
+  }
 
   return buf_len;
 }
@@ -322,6 +322,10 @@ extern "C" {
  *            so probably this settings could be passed in a nicer way.
  *            should be checked further, probably it'll be also needed for preview
  *            generation in display space
+ *
+ * \param viewer_visible_area: [struct rctf]
+ *    Normalized part of the viewer image that is displayed while editing, only that part is
+ *    calculated by the full frame execution model. Null to calculate the whole image.
  */
 /* clang-format off */
 
@@ -329,7 +333,8 @@ void COM_execute(RenderData *render_data,
                  Scene *scene,
                  bNodeTree *node_tree,
                  int rendering,
-                 const char *view_name);
+                 const char *view_name,
+                 const rctf *viewer_visible_area);
 
 /**
  * \brief Deinitialize the compositor caches and allocated memory.
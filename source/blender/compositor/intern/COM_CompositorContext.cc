@@ -12,6 +12,8 @@ CompositorContext::CompositorContext()
   quality_ = eCompositorQuality::High;
   hasActiveOpenCLDevices_ = false;
   fast_calculation_ = false;
+  result_cache_ = nullptr;
+  viewer_visible_area_ = nullptr;
   bnodetree_ = nullptr;
 }
 
@@ -13,6 +13,8 @@ struct bNodeInstanceHash;
 
 namespace blender::compositor {
 
+class OperationResultCache;
+
 /**
  * \brief Overall context of the compositor
  */
@@ -64,6 +66,16 @@ class CompositorContext {
    */
   bool fast_calculation_;
 
+  /**
+   * Results of previous executions that can be reused, null when results are not cached.
+   */
+  OperationResultCache *result_cache_;
+
+  /**
+   * Normalized part of the viewer image that is displayed while editing, null when all of it is.
+   */
+  const rctf *viewer_visible_area_;
+
   /**
    * \brief active rendering view name
    */
@@ -220,6 +232,24 @@ class CompositorContext {
   {
     return fast_calculation_;
   }
+
+  void set_result_cache(OperationResultCache *result_cache)
+  {
+    result_cache_ = result_cache;
+  }
+  OperationResultCache *get_result_cache() const
+  {
+    return result_cache_;
+  }
+
+  void set_viewer_visible_area(const rctf *viewer_visible_area)
+  {
+    viewer_visible_area_ = viewer_visible_area;
+  }
+  const rctf *get_viewer_visible_area() const
+  {
+    return viewer_visible_area_;
+  }
   bool is_groupnode_buffer_enabled() const
   {
     return (this->get_bnodetree()->flag & NTREE_COM_GROUPNODE_BUFFER) != 0;
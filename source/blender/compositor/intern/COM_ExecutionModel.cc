@@ -17,6 +17,12 @@ ExecutionModel::ExecutionModel(CompositorContext &context, Span<NodeOperation *>
                               viewer_border->ymin < viewer_border->ymax;
   border_.viewer_border = viewer_border;
 
+  const rctf *viewer_visible_area = context_.get_viewer_visible_area();
+  border_.use_viewer_visible_area = !context.is_rendering() && viewer_visible_area != nullptr &&
+                                    viewer_visible_area->xmin < viewer_visible_area->xmax &&
+                                    viewer_visible_area->ymin < viewer_visible_area->ymax;
+  border_.viewer_visible_area = viewer_visible_area;
+
   const RenderData *rd = context_.get_render_data();
   /* Case when cropping to render border happens is handled in
    * compositor output and render layer nodes. */
@@ -30,6 +30,9 @@ class ExecutionModel {
     const rctf *render_border;
     bool use_viewer_border;
     const rctf *viewer_border;
+    /** Only the visible area of the viewer is needed when editing. */
+    bool use_viewer_visible_area;
+    const rctf *viewer_visible_area;
   } border_;
 
   /**
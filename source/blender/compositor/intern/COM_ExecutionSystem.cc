@@ -23,7 +23,9 @@ ExecutionSystem::ExecutionSystem(RenderData *rd,
                                  bNodeTree *editingtree,
                                  bool rendering,
                                  bool fastcalculation,
-                                 const char *view_name)
+                                 const char *view_name,
+                                 const rctf *viewer_visible_area,
+                                 OperationResultCache *result_cache)
 {
   num_work_threads_ = WorkScheduler::get_num_cpu_threads();
   context_.set_view_name(view_name);
@@ -43,6 +45,11 @@ ExecutionSystem::ExecutionSystem(RenderData *rd,
                                      (editingtree->flag & NTREE_COM_OPENCL));
 
   context_.set_render_data(rd);
+  context_.set_viewer_visible_area(viewer_visible_area);
+  /* Only the full frame execution model reuses results. */
+  if (context_.get_execution_model() == eExecutionModel::FullFrame) {
+    context_.set_result_cache(result_cache);
+  }
 
   BLI_mutex_init(&work_mutex_);
   BLI_condition_init(&work_finished_cond_);
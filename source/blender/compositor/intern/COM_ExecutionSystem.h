@@ -107,6 +107,7 @@ namespace blender::compositor {
 class ExecutionGroup;
 class ExecutionModel;
 class NodeOperation;
+class OperationResultCache;
 
 /**
  * \brief the ExecutionSystem contains the whole compositor tree.
@@ -154,13 +155,17 @@ class ExecutionSystem {
    *
    * \param editingtree: [bNodeTree *]
    * \param rendering: [true false]
+   * \param viewer_visible_area: Normalized part of the viewer image to compute, can be null.
+   * \param result_cache: Results of previous executions to reuse, can be null.
    */
   ExecutionSystem(RenderData *rd,
                   Scene *scene,
                   bNodeTree *editingtree,
                   bool rendering,
                   bool fastcalculation,
-                  const char *view_name);
+                  const char *view_name,
+                  const rctf *viewer_visible_area,
+                  OperationResultCache *result_cache);
 
   /**
    * Destructor
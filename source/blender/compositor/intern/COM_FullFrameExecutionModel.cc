@@ -3,9 +3,13 @@
 
 #include "COM_FullFrameExecutionModel.h"
 
+#include "BLI_set.hh"
+
 #include "BLT_translation.h"
 
 #include "COM_Debug.h"
+#include "COM_ExecutionSystem.h"
+#include "COM_OperationResultCache.h"
 #include "COM_ViewerOperation.h"
 #include "COM_WorkScheduler.h"
 
@@ -20,8 +24,10 @@ FullFrameExecutionModel::FullFrameExecutionModel(CompositorContext &context,
                                                  Span<NodeOperation *> operations)
     : ExecutionModel(context, operations),
       active_buffers_(shared_buffers),
+      result_cache_(context.get_result_cache()),
       num_operations_finished_(0)
 {
+  active_buffers_.set_result_cache(result_cache_);
   priorities_.append(eCompositorPriority::High);
   if (!context.is_fast_calculation()) {
     priorities_.append(eCompositorPriority::Medium);
@@ -38,6 +44,27 @@ void FullFrameExecutionModel::execute(ExecutionSystem &exec_system)
 
   determine_areas_to_render_and_reads();
   render_operations();
+  if (result_cache_) {
+    result_cache_->execution_finished(exec_system.is_breaked());
+  }
+
+  char peak_memory_str[15];
+  BLI_str_format_byte_unit(peak_memory_str, active_buffers_.get_peak_memory(), false);
+  char buf[128];
+  if (result_cache_) {
+    char cache_memory_str[15];
+    BLI_str_format_byte_unit(cache_memory_str, result_cache_->get_memory(), false);
+    BLI_snprintf(buf,
+                 sizeof(buf),
+                 TIP_("Compositing | Peak buffer memory %s | Cached results %s"),
+                 peak_memory_str,
+                 cache_memory_str);
+  }
+  else {
+    BLI_snprintf(
+        buf, sizeof(buf), TIP_("Compositing | Peak buffer memory %s"), peak_memory_str);
+  }
+  node_tree->stats_draw(node_tree->sdh, buf);
 }
 
 void FullFrameExecutionModel::determine_areas_to_render_and_reads()
@@ -46,16 +73,39 @@ void FullFrameExecutionModel::determine_areas_to_render_and_reads()
   const bNodeTree *node_tree = context_.get_bnodetree();
 
   rcti area;
+  Vector<NodeOperation *> output_ops;
   for (eCompositorPriority priority : priorities_) {
     for (NodeOperation *op : operations_) {
       op->set_bnodetree(node_tree);
       if (op->is_output_operation(is_rendering) && op->get_render_priority() == priority) {
         get_output_render_area(op, area);
         determine_areas_to_render(op, area);
-        determine_reads(op);
+        output_ops.append(op);
       }
     }
   }
+
+  /* Reads depend on which operations are cached, so all areas have to be known first. */
+  if (result_cache_) {
+    use_cached_results();
+  }
+  for (NodeOperation *op : output_ops) {
+    determine_reads(op);
+  }
+}
+
+void FullFrameExecutionModel::use_cached_results()
+{
+  for (NodeOperation *op : operations_) {
+    const std::optional<uint64_t> result_key = op->get_result_key();
+    if (!result_key) {
+      continue;
+    }
+    const Vector<rcti> areas = active_buffers_.get_areas_to_render(op, 0, 0);
+    if (!areas.is_empty() && result_cache_->has_result(*result_key, areas)) {
+      active_buffers_.set_cached_buffer(op, result_cache_->use_result(*result_key));
+    }
+  }
 }
 
 Vector<MemoryBuffer *> FullFrameExecutionModel::get_input_buffers(NodeOperation *op,
@@ -88,7 +138,7 @@ MemoryBuffer *FullFrameExecutionModel::create_operation_buffer(NodeOperation *op
 
   const DataType data_type = op->get_output_socket(0)->get_data_type();
   const bool is_a_single_elem = op->get_flags().is_constant_operation;
-  return new MemoryBuffer(data_type, rect, is_a_single_elem);
+  return active_buffers_.create_buffer(data_type, rect, is_a_single_elem);
 }
 
 void FullFrameExecutionModel::render_operation(NodeOperation *op)
@@ -141,28 +191,115 @@ void FullFrameExecutionModel::render_operations()
 }
 
 /**
- * Returns all dependencies from inputs to outputs. A dependency may be repeated when
- * several operations depend on it.
+ * Memory of the buffer an operation renders into.
  */
-static Vector<NodeOperation *> get_operation_dependencies(NodeOperation *operation)
+static int64_t get_operation_buffer_bytes(NodeOperation *operation)
 {
-  /* Get dependencies from outputs to inputs. */
-  Vector<NodeOperation *> dependencies;
-  Vector<NodeOperation *> next_outputs;
-  next_outputs.append(operation);
-  while (next_outputs.size() > 0) {
-    Vector<NodeOperation *> outputs(next_outputs);
-    next_outputs.clear();
-    for (NodeOperation *output : outputs) {
-      for (int i = 0; i < output->get_number_of_input_sockets(); i++) {
-        next_outputs.append(output->get_input_operation(i));
+  if (operation->get_number_of_output_sockets() == 0) {
+    return 0;
+  }
+  const DataType data_type = operation->get_output_socket(0)->get_data_type();
+  const int64_t num_elems = operation->get_flags().is_constant_operation ?
+                                1 :
+                                int64_t(operation->get_width()) * operation->get_height();
+  return num_elems * COM_data_type_bytes_len(data_type);
+}
+
+/**
+ * Determines for every operation in the tree the order in which its inputs should be rendered
+ * and estimates the memory needed to render it. Rendering the input that needs most memory first
+ * minimizes the number of buffers that are alive at the same time (Sethi-Ullman ordering).
+ * Operations used by multiple readers make this an estimation.
+ */
+static Map<NodeOperation *, Vector<NodeOperation *>> get_inputs_render_order(
+    NodeOperation *output_op, SharedOperationBuffers &buffers)
+{
+  Map<NodeOperation *, int64_t> memory_needs;
+  Map<NodeOperation *, Vector<NodeOperation *>> inputs_by_operation;
+
+  Vector<NodeOperation *> stack;
+  stack.append(output_op);
+  while (stack.size() > 0) {
+    NodeOperation *operation = stack.last();
+    if (memory_needs.contains(operation)) {
+      stack.remove_last();
+      continue;
+    }
+
+    /* Cached operations don't need their inputs. */
+    const int num_inputs = buffers.is_operation_cached(operation) ?
+                               0 :
+                               operation->get_number_of_input_sockets();
+    Vector<NodeOperation *> inputs;
+    bool inputs_handled = true;
+    for (int i = 0; i < num_inputs; i++) {
+      NodeOperation *input_op = operation->get_input_operation(i);
+      inputs.append_non_duplicates(input_op);
+      if (!memory_needs.contains(input_op)) {
+        stack.append(input_op);
+        inputs_handled = false;
       }
     }
-    dependencies.extend(next_outputs);
+    if (!inputs_handled) {
+      continue;
+    }
+    stack.remove_last();
+
+    auto get_memory_released = [&](NodeOperation *input_op) {
+      return memory_needs.lookup(input_op) - get_operation_buffer_bytes(input_op);
+    };
+    std::stable_sort(inputs.begin(), inputs.end(), [&](NodeOperation *a, NodeOperation *b) {
+      return get_memory_released(a) > get_memory_released(b);
+    });
+
+    /* Buffers of inputs rendered earlier stay alive while later inputs are rendered. */
+    int64_t memory_need = 0;
+    int64_t inputs_bytes = 0;
+    for (NodeOperation *input_op : inputs) {
+      memory_need = std::max(memory_need, inputs_bytes + memory_needs.lookup(input_op));
+      inputs_bytes += get_operation_buffer_bytes(input_op);
+    }
+    memory_need = std::max(memory_need, inputs_bytes + get_operation_buffer_bytes(operation));
+
+    memory_needs.add_new(operation, memory_need);
+    inputs_by_operation.add_new(operation, std::move(inputs));
   }
+  return inputs_by_operation;
+}
+
+/**
+ * Returns all dependencies in an order they can be rendered in (inputs before the operations
+ * reading them). Every dependency is rendered right before it's needed, depth first, so that its
+ * buffer can be disposed early.
+ */
+static Vector<NodeOperation *> get_operation_dependencies(NodeOperation *operation,
+                                                         SharedOperationBuffers &buffers)
+{
+  const Map<NodeOperation *, Vector<NodeOperation *>> inputs_by_operation =
+      get_inputs_render_order(operation, buffers);
 
-  /* Reverse to get dependencies from inputs to outputs. */
-  std::reverse(dependencies.begin(), dependencies.end());
+  Vector<NodeOperation *> dependencies;
+  Set<NodeOperation *> added_operations;
+  /* Operations and the index of the next input to visit. */
+  Vector<std::pair<NodeOperation *, int>> stack;
+  stack.append({operation, 0});
+  added_operations.add(operation);
+  while (stack.size() > 0) {
+    auto [op, next_input_index] = stack.last();
+    const Span<NodeOperation *> inputs = inputs_by_operation.lookup(op);
+    if (next_input_index == inputs.size()) {
+      stack.remove_last();
+      if (op != operation) {
+        dependencies.append(op);
+      }
+      continue;
+    }
+    stack.last().second++;
+    NodeOperation *input_op = inputs[next_input_index];
+    if (added_operations.add(input_op)) {
+      stack.append({input_op, 0});
+    }
+  }
 
   return dependencies;
 }
@@ -170,7 +307,7 @@ static Vector<NodeOperation *> get_operation_dependencies(NodeOperation *operati
 void FullFrameExecutionModel::render_output_dependencies(NodeOperation *output_op)
 {
   BLI_assert(output_op->is_output_operation(context_.is_rendering()));
-  Vector<NodeOperation *> dependencies = get_operation_dependencies(output_op);
+  Vector<NodeOperation *> dependencies = get_operation_dependencies(output_op, active_buffers_);
   for (NodeOperation *op : dependencies) {
     if (!active_buffers_.is_operation_rendered(op)) {
       render_operation(op);
@@ -218,6 +355,9 @@ void FullFrameExecutionModel::determine_reads(NodeOperation *output_op)
   stack.append(output_op);
   while (stack.size() > 0) {
     NodeOperation *operation = stack.pop_last();
+    if (active_buffers_.is_operation_cached(operation)) {
+      continue;
+    }
     const int num_inputs = operation->get_number_of_input_sockets();
     for (int i = 0; i < num_inputs; i++) {
       NodeOperation *input_op = operation->get_input_operation(i);
@@ -253,6 +393,20 @@ void FullFrameExecutionModel::get_output_render_area(NodeOperation *output_op, r
     r_area.ymin = canvas.ymin + norm_border->ymin * h;
     r_area.ymax = canvas.ymin + norm_border->ymax * h;
   }
+
+  /* Only render what is visible in the backdrop, reading operations only render the areas of
+   * interest of the viewer. Previews always show the whole image. */
+  if (border_.use_viewer_visible_area && output_op->get_flags().is_viewer_operation) {
+    const rctf *norm_area = border_.viewer_visible_area;
+    const int w = output_op->get_width();
+    const int h = output_op->get_height();
+    rcti visible_area;
+    visible_area.xmin = canvas.xmin + floorf(norm_area->xmin * w);
+    visible_area.xmax = canvas.xmin + ceilf(norm_area->xmax * w);
+    visible_area.ymin = canvas.ymin + floorf(norm_area->ymin * h);
+    visible_area.ymax = canvas.ymin + ceilf(norm_area->ymax * h);
+    BLI_rcti_isect(&r_area, &visible_area, &r_area);
+  }
 }
 
 void FullFrameExecutionModel::operation_finished(NodeOperation *operation)
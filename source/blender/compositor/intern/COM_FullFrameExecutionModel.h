@@ -19,6 +19,7 @@ class CompositorContext;
 class ExecutionSystem;
 class MemoryBuffer;
 class NodeOperation;
+class OperationResultCache;
 class SharedOperationBuffers;
 
 /**
@@ -32,6 +33,11 @@ class FullFrameExecutionModel : public ExecutionModel {
    */
   SharedOperationBuffers &active_buffers_;
 
+  /**
+   * Results of previous executions, null when results are not cached.
+   */
+  OperationResultCache *result_cache_;
+
   /**
    * Number of operations finished.
    */
@@ -51,6 +57,11 @@ class FullFrameExecutionModel : public ExecutionModel {
 
  private:
   void determine_areas_to_render_and_reads();
+  /**
+   * Uses the cached results of operations whose areas to render are all in the cache. Their
+   * inputs are neither read nor rendered.
+   */
+  void use_cached_results();
   /**
    * Render output operations in order of priority.
    */
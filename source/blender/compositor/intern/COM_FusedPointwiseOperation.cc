@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#include <optional>
+
+#include "BLI_array.hh"
+#include "BLI_map.hh"
+
+#include "MEM_guardedalloc.h"
+
+#include "COM_FusedPointwiseOperation.h"
+
+namespace blender::compositor {
+
+/**
+ * Maximum number of floats of the intermediate results of a block of rows. Chosen so that the
+ * intermediate results and the rows of the input and output buffers fit in the L2 cache.
+ */
+static constexpr int64_t max_block_floats = 16 * 1024;
+
+FusedPointwiseOperation::FusedPointwiseOperation(Span<MultiThreadedOperation *> operations)
+{
+  BLI_assert(operations.size() > 1);
+  Map<const NodeOperation *, int> step_indices;
+  for (MultiThreadedOperation *operation : operations) {
+    BLI_assert(operation->get_flags().is_pointwise_operation);
+    Step step;
+    step.operation = operation;
+    for (int i = 0; i < operation->get_number_of_input_sockets(); i++) {
+      const int step_index = step_indices.lookup_default(operation->get_input_operation(i), -1);
+      if (step_index != -1) {
+        step.inputs.append({true, step_index});
+        continue;
+      }
+      /* Inputs that are linked to the same output share the input of the fused operation. */
+      NodeOperationOutput *link = operation->get_input_socket(i)->get_link();
+      int input_index = input_links_.first_index_of_try(link);
+      if (input_index == -1) {
+        input_index = input_links_.append_and_get_index(link);
+        this->add_input_socket(link->get_data_type(), ResizeMode::None);
+      }
+      step.inputs.append({false, input_index});
+    }
+    step_indices.add_new(operation, steps_.size());
+    steps_.append(std::move(step));
+  }
+
+  MultiThreadedOperation *root = operations.last();
+  this->add_output_socket(root->get_output_socket()->get_data_type());
+  this->set_canvas(root->get_canvas());
+  this->set_name(root->get_name());
+}
+
+FusedPointwiseOperation::~FusedPointwiseOperation()
+{
+  for (Step &step : steps_) {
+    delete step.operation;
+  }
+}
+
+void FusedPointwiseOperation::init_data()
+{
+  for (Step &step : steps_) {
+    step.operation->init_data();
+  }
+}
+
+void FusedPointwiseOperation::init_execution()
+{
+  for (Step &step : steps_) {
+    step.operation->init_execution();
+  }
+}
+
+void FusedPointwiseOperation::deinit_execution()
+{
+  for (Step &step : steps_) {
+    step.operation->deinit_execution();
+  }
+}
+
+void FusedPointwiseOperation::update_memory_buffer_partial(MemoryBuffer *output,
+                                                           const rcti &area,
+                                                           Span<MemoryBuffer *> inputs)
+{
+  const int width = BLI_rcti_size_x(&area);
+  const int height = BLI_rcti_size_y(&area);
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+
+  /* All steps but the root write their results to small buffers that are reused for every block
+   * of rows. The root writes to the output buffer directly. */
+  const int intermediate_steps_num = steps_.size() - 1;
+  int intermediate_channels_num = 0;
+  for (const int step_index : IndexRange(intermediate_steps_num)) {
+    intermediate_channels_num += COM_data_type_num_channels(
+        steps_[step_index].operation->get_output_socket()->get_data_type());
+  }
+  const int block_height = std::clamp<int64_t>(
+      max_block_floats / (int64_t(width) * intermediate_channels_num), 1, height);
+  float *block_data = (float *)MEM_mallocN_aligned(
+      sizeof(float) * width * block_height * intermediate_channels_num, 16, __func__);
+
+  Array<std::optional<MemoryBuffer>> step_outputs(intermediate_steps_num);
+  Vector<MemoryBuffer *> step_inputs;
+  for (int y = area.ymin; y < area.ymax; y += block_height) {
+    rcti block;
+    BLI_rcti_init(&block, area.xmin, area.xmax, y, std::min(y + block_height, area.ymax));
+
+    float *step_data = block_data;
+    for (const int step_index : steps_.index_range()) {
+      const Step &step = steps_[step_index];
+      step_inputs.clear();
+      for (const InputSource &source : step.inputs) {
+        step_inputs.append(source.is_step ? &*step_outputs[source.index] : inputs[source.index]);
+      }
+
+      MemoryBuffer *step_output = output;
+      if (step_index < intermediate_steps_num) {
+        const int num_channels = COM_data_type_num_channels(
+            step.operation->get_output_socket()->get_data_type());
+        step_outputs[step_index].emplace(step_data, num_channels, block);
+        step_data += width * block_height * num_channels;
+        step_output = &*step_outputs[step_index];
+      }
+      step.operation->update_memory_buffer_partial(step_output, block, step_inputs);
+    }
+  }
+
+  MEM_freeN(block_data);
+}
+
+}  // namespace blender::compositor
@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#pragma once
+
+#include "COM_MultiThreadedOperation.h"
+
+namespace blender::compositor {
+
+/**
+ * Executes a tree of pointwise operations (see #NodeOperationFlags::is_pointwise_operation) in a
+ * single pass. Instead of writing a full-frame intermediate buffer for every operation, rows are
+ * processed in small blocks through all fused operations while the intermediate results are
+ * still in cache.
+ *
+ * The fused operations keep their original input links, they are used to know which inputs are
+ * computed by other fused operations. All other inputs become inputs of this operation.
+ */
+class FusedPointwiseOperation : public MultiThreadedOperation {
+ private:
+  struct InputSource {
+    /** Whether the input is the output of another step, otherwise it's an input of this
+     * operation. */
+    bool is_step;
+    int index;
+  };
+
+  struct Step {
+    MultiThreadedOperation *operation;
+    Vector<InputSource> inputs;
+  };
+
+  /** Sorted so that steps only read the outputs of previous steps. The last one is the root. */
+  Vector<Step> steps_;
+  /** Operation outputs that are linked to the inputs of this operation, in the same order. */
+  Vector<NodeOperationOutput *> input_links_;
+
+ public:
+  /**
+   * \param operations: Operations to fuse, owned by this operation from now on. They must be
+   * sorted so that operations come after the operations they read from. The last one is the
+   * operation whose output is the result of this operation.
+   */
+  FusedPointwiseOperation(Span<MultiThreadedOperation *> operations);
+  ~FusedPointwiseOperation();
+
+  /** Outputs of non-fused operations that have to be linked to the inputs of this operation. */
+  Span<NodeOperationOutput *> get_input_links() const
+  {
+    return input_links_;
+  }
+
+  int get_number_of_fused_operations() const
+  {
+    return steps_.size();
+  }
+
+  void init_data() override;
+  void init_execution() override;
+  void deinit_execution() override;
+
+ protected:
+  void update_memory_buffer_partial(MemoryBuffer *output,
+                                    const rcti &area,
+                                    Span<MemoryBuffer *> inputs) override;
+};
+
+}  // namespace blender::compositor
@@ -50,6 +50,9 @@ class MultiThreadedOperation : public NodeOperation {
   void update_memory_buffer(MemoryBuffer *output,
                             const rcti &area,
                             Span<MemoryBuffer *> inputs) override;
+
+  /* Calls #update_memory_buffer_partial of the operations it fuses. */
+  friend class FusedPointwiseOperation;
 };
 
 }  // namespace blender::compositor
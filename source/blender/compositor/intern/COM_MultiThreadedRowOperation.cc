@@ -10,6 +10,11 @@ MultiThreadedRowOperation::PixelCursor::PixelCursor(const int num_inputs)
 {
 }
 
+MultiThreadedRowOperation::MultiThreadedRowOperation()
+{
+  flags_.is_pointwise_operation = true;
+}
+
 void MultiThreadedRowOperation::update_memory_buffer_partial(MemoryBuffer *output,
                                                              const rcti &area,
                                                              Span<MemoryBuffer *> inputs)
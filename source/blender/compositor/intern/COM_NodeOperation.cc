@@ -3,6 +3,9 @@
 
 #include <cstdio>
 
+#include "BLI_hash_mm2a.h"
+#include "BLI_task.hh"
+
 #include "COM_BufferOperation.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_ReadBufferOperation.h"
@@ -84,6 +87,63 @@ std::optional<NodeOperationHash> NodeOperation::generate_hash()
   return hash;
 }
 
+std::optional<uint64_t> NodeOperation::generate_result_key()
+{
+  std::optional<NodeOperationHash> hash = generate_hash();
+  if (!hash) {
+    return std::nullopt;
+  }
+  hash_output_data();
+
+  /* Combined in order like #generate_hash does for the parents, so that swapped inputs or equal
+   * channels don't cancel out. */
+  size_t key = hash->type_hash_;
+  combine_hashes(key, params_hash_);
+  for (const int index : inputs_.index_range()) {
+    NodeOperationInput &socket = inputs_[index];
+    if (!socket.is_connected()) {
+      continue;
+    }
+
+    combine_hashes(key, get_default_hash(index));
+    NodeOperation &input = socket.get_link()->get_operation();
+    if (input.get_flags().is_constant_operation) {
+      const float *elem = ((ConstantOperation *)&input)->get_constant_elem();
+      const int num_channels = COM_data_type_num_channels(socket.get_data_type());
+      for (const int i : IndexRange(num_channels)) {
+        combine_hashes(key, get_default_hash(elem[i]));
+      }
+    }
+    else if (input.result_key_) {
+      combine_hashes(key, *input.result_key_);
+    }
+    else {
+      return std::nullopt;
+    }
+  }
+  return key;
+}
+
+void NodeOperation::hash_data(const void *data, const int64_t size)
+{
+  /* Hash chunks in parallel, hashing large images takes a noticeable time otherwise. */
+  constexpr int64_t chunk_size = 1024 * 1024;
+  const int64_t chunks_num = (size + chunk_size - 1) / chunk_size;
+  Array<uint32_t> chunk_hashes(chunks_num);
+  threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange range) {
+    for (const int64_t chunk : range) {
+      const int64_t offset = chunk * chunk_size;
+      chunk_hashes[chunk] = BLI_hash_mm2(static_cast<const uchar *>(data) + offset,
+                                         std::min(chunk_size, size - offset),
+                                         0);
+    }
+  });
+  hash_param(size);
+  for (const uint32_t chunk_hash : chunk_hashes) {
+    hash_param(chunk_hash);
+  }
+}
+
 NodeOperationOutput *NodeOperation::get_output_socket(unsigned int index)
 {
   return &outputs_[index];
@@ -490,6 +550,9 @@ std::ostream &operator<<(std::ostream &os, const NodeOperationFlags &node_operat
   if (node_operation_flags.can_be_constant) {
     os << "can_be_constant,";
   }
+  if (node_operation_flags.is_pointwise_operation) {
+    os << "pointwise,";
+  }
 
   return os;
 }
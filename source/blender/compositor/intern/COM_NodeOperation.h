@@ -237,6 +237,13 @@ struct NodeOperationFlags {
    */
   bool can_be_constant : 1;
 
+  /**
+   * Whether each output pixel only depends on the input pixels at the same coordinates and is
+   * computed in a single #MultiThreadedOperation pass. Such operations are fused with the
+   * operations reading them in full-frame execution, see #FusedPointwiseOperation.
+   */
+  bool is_pointwise_operation : 1;
+
   NodeOperationFlags()
   {
     complex = false;
@@ -255,6 +262,7 @@ struct NodeOperationFlags {
     is_fullframe_operation = false;
     is_constant_operation = false;
     can_be_constant = false;
+    is_pointwise_operation = false;
   }
 };
 
@@ -310,6 +318,9 @@ class NodeOperation {
   size_t params_hash_;
   bool is_hash_output_params_implemented_;
 
+  /** See #generate_result_key. */
+  std::optional<uint64_t> result_key_;
+
   /**
    * \brief the index of the input socket that will be used to determine the canvas
    */
@@ -390,6 +401,24 @@ class NodeOperation {
    */
   std::optional<NodeOperationHash> generate_hash();
 
+  /**
+   * Generate a key that identifies the operation result across executions, unlike
+   * #generate_hash which only identifies it in the current execution. It includes the result
+   * keys of the non-constant inputs, so these have to be set with #set_result_key before.
+   * Returns `std::nullopt` when the operation or any of its inputs can't be identified.
+   */
+  std::optional<uint64_t> generate_result_key();
+
+  void set_result_key(const std::optional<uint64_t> key)
+  {
+    result_key_ = key;
+  }
+
+  std::optional<uint64_t> get_result_key() const
+  {
+    return result_key_;
+  }
+
   unsigned int get_number_of_input_sockets() const
   {
     return inputs_.size();
@@ -661,6 +690,16 @@ class NodeOperation {
     is_hash_output_params_implemented_ = false;
   }
 
+  /* Overridden by subclasses whose output depends on data that can change between executions
+   * without their parameters changing, like images and render results. Implementations must hash
+   * that data using `hash_param` or `hash_data` methods. Only used for result keys. */
+  virtual void hash_output_data()
+  {
+  }
+
+  /** Hash the content of a potentially large buffer, e.g. the pixels of an image. */
+  void hash_data(const void *data, int64_t size);
+
   static void combine_hashes(size_t &combined, size_t other)
   {
     combined = BLI_ghashutil_combine_hash(combined, other);
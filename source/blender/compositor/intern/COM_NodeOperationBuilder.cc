@@ -4,11 +4,13 @@
 #include <set>
 
 #include "BLI_multi_value_map.hh"
+#include "BLI_set.hh"
 
 #include "COM_Converter.h"
 #include "COM_Debug.h"
 
 #include "COM_ExecutionGroup.h"
+#include "COM_FusedPointwiseOperation.h"
 #include "COM_PreviewOperation.h"
 #include "COM_ReadBufferOperation.h"
 #include "COM_SetColorOperation.h"
@@ -19,6 +21,7 @@
 
 #include "COM_ConstantFolder.h"
 #include "COM_NodeOperationBuilder.h" /* own include */
+#include "COM_PointwiseOperationFuser.h"
 
 namespace blender::compositor {
 
@@ -92,6 +95,16 @@ void NodeOperationBuilder::convert_to_operations(ExecutionSystem *system)
   save_graphviz("compositor_prior_merging");
   merge_equal_operations();
 
+  if (context_->get_result_cache()) {
+    generate_result_keys();
+  }
+
+  if (context_->get_execution_model() == eExecutionModel::FullFrame) {
+    save_graphviz("compositor_prior_fusing");
+    PointwiseOperationFuser fuser(*this);
+    fuser.fuse_operations();
+  }
+
   if (context_->get_execution_model() == eExecutionModel::Tiled) {
     /* surround complex ops with read/write buffer */
     add_complex_operation_buffers();
@@ -134,6 +147,48 @@ void NodeOperationBuilder::replace_operation_with_constant(NodeOperation *operat
   add_operation(constant_operation);
 }
 
+void NodeOperationBuilder::replace_operations_with_fused(
+    Span<MultiThreadedOperation *> operations, FusedPointwiseOperation *fused_operation)
+{
+  Set<const NodeOperation *> fused_ops;
+  for (const MultiThreadedOperation *op : operations) {
+    fused_ops.add_new(op);
+  }
+  NodeOperation *root_op = operations.last();
+
+  int i = 0;
+  while (i < links_.size()) {
+    Link &link = links_[i];
+    if (fused_ops.contains(&link.to()->get_operation())) {
+      /* Inputs of fused operations stay linked, the fused operation reads them to know where
+       * their values come from. */
+      links_.remove(i);
+      continue;
+    }
+
+    if (&link.from()->get_operation() == root_op) {
+      link.to()->set_link(fused_operation->get_output_socket());
+      links_[i] = Link(fused_operation->get_output_socket(), link.to());
+    }
+    i++;
+  }
+
+  const Span<NodeOperationOutput *> input_links = fused_operation->get_input_links();
+  for (const int input_index : input_links.index_range()) {
+    add_link(input_links[input_index], fused_operation->get_input_socket(input_index));
+  }
+
+  /* Take the place of the root operation to keep the operations order and ids. */
+  fused_operation->set_id(root_op->get_id());
+  fused_operation->set_result_key(root_op->get_result_key());
+  fused_operation->set_execution_model(context_->get_execution_model());
+  fused_operation->set_execution_system(exec_system_);
+  operations_[operations_.first_index_of(root_op)] = fused_operation;
+  for (const MultiThreadedOperation *op : operations.drop_back(1)) {
+    operations_.remove_first_occurrence_and_reorder(const_cast<MultiThreadedOperation *>(op));
+  }
+}
+
 void NodeOperationBuilder::unlink_inputs_and_relink_outputs(NodeOperation *unlinked_op,
                                                             NodeOperation *linked_op)
 {
@@ -498,6 +553,42 @@ void NodeOperationBuilder::merge_equal_operations(NodeOperation *from, NodeOpera
   delete from;
 }
 
+void NodeOperationBuilder::generate_result_keys()
+{
+  /* Keys of inputs are needed first. */
+  Set<NodeOperation *> handled_ops;
+  Vector<NodeOperation *> stack;
+  for (NodeOperation *output_op : operations_) {
+    if (!output_op->is_output_operation(context_->is_rendering())) {
+      continue;
+    }
+    stack.append(output_op);
+    while (stack.size() > 0) {
+      NodeOperation *op = stack.last();
+      if (handled_ops.contains(op)) {
+        stack.remove_last();
+        continue;
+      }
+
+      bool inputs_handled = true;
+      for (int i = 0; i < op->get_number_of_input_sockets(); i++) {
+        NodeOperation *input_op = op->get_input_operation(i);
+        if (input_op && !handled_ops.contains(input_op)) {
+          stack.append(input_op);
+          inputs_handled = false;
+        }
+      }
+      if (!inputs_handled) {
+        continue;
+      }
+      stack.remove_last();
+
+      op->set_result_key(op->generate_result_key());
+      handled_ops.add_new(op);
+    }
+  }
+}
+
 Vector<NodeOperationInput *> NodeOperationBuilder::cache_output_links(
     NodeOperationOutput *output) const
 {
@@ -26,6 +26,8 @@ class PreviewOperation;
 class WriteBufferOperation;
 class ViewerOperation;
 class ConstantOperation;
+class MultiThreadedOperation;
+class FusedPointwiseOperation;
 
 class NodeOperationBuilder {
  public:
@@ -86,6 +88,12 @@ class NodeOperationBuilder {
   void add_operation(NodeOperation *operation);
   void replace_operation_with_constant(NodeOperation *operation,
                                        ConstantOperation *constant_operation);
+  /**
+   * Replace \a operations with \a fused_operation, which takes ownership of them. The last
+   * operation is the one whose readers are relinked to the fused operation.
+   */
+  void replace_operations_with_fused(Span<MultiThreadedOperation *> operations,
+                                     FusedPointwiseOperation *fused_operation);
 
   /** Map input socket of the current node to an operation socket */
   void map_input_socket(NodeInput *node_socket, NodeOperationInput *operation_socket);
@@ -157,6 +165,11 @@ class NodeOperationBuilder {
   /** Merge operations with same type, inputs and parameters that produce the same result. */
   void merge_equal_operations();
   void merge_equal_operations(NodeOperation *from, NodeOperation *into);
+  /**
+   * Set the result key of all operations reachable from outputs, used to find their results in
+   * the result cache of previous executions.
+   */
+  void generate_result_keys();
   void save_graphviz(StringRefNull name = "");
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:NodeCompilerImpl")
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#include "COM_OperationResultCache.h"
+#include "COM_MemoryBuffer.h"
+
+#include "MEM_guardedalloc.h"
+
+namespace blender::compositor {
+
+OperationResultCache::OperationResultCache(const int64_t max_bytes)
+    : bytes_(0), max_bytes_(max_bytes), execution_(0)
+{
+}
+
+OperationResultCache::~OperationResultCache()
+{
+  clear();
+}
+
+bool OperationResultCache::has_result(const uint64_t key, Span<rcti> areas) const
+{
+  const Result *result = results_.lookup_ptr(key);
+  if (result == nullptr) {
+    return false;
+  }
+  for (const rcti &area : areas) {
+    bool is_rendered = false;
+    for (const rcti &rendered_area : result->areas) {
+      if (BLI_rcti_inside_rcti(&rendered_area, &area)) {
+        is_rendered = true;
+        break;
+      }
+    }
+    if (!is_rendered) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::unique_ptr<MemoryBuffer> OperationResultCache::use_result(const uint64_t key)
+{
+  Result &result = results_.lookup(key);
+  result.is_used = true;
+  result.last_execution = execution_;
+  return std::make_unique<MemoryBuffer>(result.data, result.num_channels, result.rect);
+}
+
+bool OperationResultCache::store_result(const uint64_t key, MemoryBuffer &buffer, Span<rcti> areas)
+{
+  BLI_assert(!buffer.is_a_single_elem());
+  const int64_t bytes = sizeof(float) * buffer.get_num_channels() * buffer.get_width() *
+                        buffer.get_height();
+  Result *old_result = results_.lookup_ptr(key);
+  if (old_result) {
+    if (old_result->is_used || old_result->is_new) {
+      /* Still referenced by buffers of the current execution. */
+      return false;
+    }
+    free_result(*old_result);
+    results_.remove_contained(key);
+  }
+  if (!free_memory_for(bytes)) {
+    return false;
+  }
+
+  Result result;
+  result.data = buffer.get_buffer();
+  result.num_channels = buffer.get_num_channels();
+  result.rect = buffer.get_rect();
+  result.areas = areas;
+  result.bytes = bytes;
+  result.last_execution = execution_;
+  result.is_used = false;
+  result.is_new = true;
+  results_.add_new(key, std::move(result));
+  bytes_ += bytes;
+  return true;
+}
+
+void OperationResultCache::execution_finished(const bool is_canceled)
+{
+  Vector<uint64_t> canceled_keys;
+  for (auto item : results_.items()) {
+    Result &result = item.value;
+    if (is_canceled && result.is_new) {
+      free_result(result);
+      canceled_keys.append(item.key);
+    }
+    result.is_used = false;
+    result.is_new = false;
+  }
+  for (const uint64_t key : canceled_keys) {
+    results_.remove_contained(key);
+  }
+  execution_++;
+}
+
+void OperationResultCache::clear()
+{
+  for (Result &result : results_.values()) {
+    free_result(result);
+  }
+  results_.clear();
+}
+
+bool OperationResultCache::free_memory_for(const int64_t bytes)
+{
+  if (bytes > max_bytes_) {
+    return false;
+  }
+  while (bytes_ + bytes > max_bytes_) {
+    const uint64_t *lru_key = nullptr;
+    const Result *lru_result = nullptr;
+    for (auto item : results_.items()) {
+      const Result &result = item.value;
+      /* Results of the current execution may be referenced by its buffers. */
+      if (result.is_used || result.is_new) {
+        continue;
+      }
+      if (lru_result == nullptr || result.last_execution < lru_result->last_execution) {
+        lru_key = &item.key;
+        lru_result = &result;
+      }
+    }
+    if (lru_result == nullptr) {
+      return false;
+    }
+    const uint64_t key = *lru_key;
+    free_result(results_.lookup(key));
+    results_.remove_contained(key);
+  }
+  return true;
+}
+
+void OperationResultCache::free_result(Result &result)
+{
+  MEM_freeN(result.data);
+  bytes_ -= result.bytes;
+}
+
+}  // namespace blender::compositor
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#pragma once
+
+#include <memory>
+
+#include "BLI_map.hh"
+#include "BLI_span.hh"
+#include "BLI_vector.hh"
+
+#include "DNA_vec_types.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+namespace blender::compositor {
+
+class MemoryBuffer;
+
+/**
+ * Keeps operation results between compositor executions, so that operations whose result key
+ * didn't change (see #NodeOperation::generate_result_key) don't have to be rendered again. E.g.
+ * when tweaking a node, only the operations reading its result are rendered.
+ *
+ * Results are stored once all readers of an operation buffer have finished reading it and are
+ * kept across executions, e.g. when changing frame only the operations depending on animated
+ * inputs are rendered. When the memory budget is exceeded the least recently used results are
+ * freed.
+ */
+class OperationResultCache {
+ private:
+  struct Result {
+    /** Buffer memory, owned by the cache. */
+    float *data;
+    int num_channels;
+    /** Rect of the buffer. */
+    rcti rect;
+    /** Rendered areas of the buffer, in operation canvas coordinates. */
+    Vector<rcti> areas;
+    int64_t bytes;
+    /** Last execution that used or stored the result, for least recently used eviction. */
+    int64_t last_execution;
+    /** Whether the result has been used in the current execution. */
+    bool is_used;
+    /** Whether the result has been stored in the current execution. */
+    bool is_new;
+  };
+  Map<uint64_t, Result> results_;
+
+  /** Memory of all results. */
+  int64_t bytes_;
+  /** Memory budget of all results. */
+  int64_t max_bytes_;
+  /** Number of the current execution. */
+  int64_t execution_;
+
+ public:
+  /**
+   * Default memory budget. Results are kept while the compositor is idle, so it's kept low enough
+   * to not compete with the rest of Blender.
+   */
+  static constexpr int64_t default_max_bytes = int64_t(1024) * 1024 * 1024;
+
+  OperationResultCache(int64_t max_bytes = default_max_bytes);
+  ~OperationResultCache();
+
+  /**
+   * Whether there is a result for \a key with all given areas rendered.
+   */
+  bool has_result(uint64_t key, Span<rcti> areas) const;
+  /**
+   * Returns a buffer referencing the memory of the result for \a key, which must exist. The
+   * memory is kept at least until the end of the current execution.
+   */
+  std::unique_ptr<MemoryBuffer> use_result(uint64_t key);
+  /**
+   * Stores the memory of \a buffer as the result for \a key, taking ownership of it. Least
+   * recently used results are freed when needed to stay within the memory limit.
+   * \return Whether it has been stored, it isn't when results of the current execution already
+   * take the memory.
+   */
+  bool store_result(uint64_t key, MemoryBuffer &buffer, Span<rcti> areas);
+
+  /**
+   * When the execution has been canceled, frees the results stored in it as they may be
+   * incomplete.
+   */
+  void execution_finished(bool is_canceled);
+
+  void clear();
+
+  int64_t get_memory() const
+  {
+    return bytes_;
+  }
+
+ private:
+  void free_result(Result &result);
+  /** Frees least recently used results of previous executions until \a bytes fit. */
+  bool free_memory_for(int64_t bytes);
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:OperationResultCache")
+#endif
+};
+
+}  // namespace blender::compositor
@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#include "COM_PointwiseOperationFuser.h"
+#include "COM_CompositorContext.h"
+#include "COM_FusedPointwiseOperation.h"
+#include "COM_NodeOperationBuilder.h"
+
+namespace blender::compositor {
+
+PointwiseOperationFuser::PointwiseOperationFuser(NodeOperationBuilder &operations_builder)
+    : operations_builder_(operations_builder)
+{
+  for (const NodeOperationBuilder::Link &link : operations_builder_.get_links()) {
+    readers_.add(&link.from()->get_operation(), &link.to()->get_operation());
+  }
+}
+
+bool PointwiseOperationFuser::is_fusable(NodeOperation *operation) const
+{
+  if (!operation->get_flags().is_pointwise_operation ||
+      operation->is_output_operation(operations_builder_.context().is_rendering())) {
+    return false;
+  }
+  for (int i = 0; i < operation->get_number_of_input_sockets(); i++) {
+    if (operation->get_input_operation(i) == nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PointwiseOperationFuser::is_fused_into_reader(NodeOperation *operation) const
+{
+  const Span<NodeOperation *> readers = readers_.lookup(operation);
+  if (readers.size() != 1 || !is_fusable(operation) || !is_fusable(readers[0])) {
+    return false;
+  }
+  /* Pointwise operations only read their inputs in their own canvas. */
+  return BLI_rcti_compare(&operation->get_canvas(), &readers[0]->get_canvas());
+}
+
+void PointwiseOperationFuser::collect_fused_operations(
+    MultiThreadedOperation *operation, Vector<MultiThreadedOperation *> &r_operations) const
+{
+  for (int i = 0; i < operation->get_number_of_input_sockets(); i++) {
+    NodeOperation *input = operation->get_input_operation(i);
+    if (is_fused_into_reader(input)) {
+      collect_fused_operations(static_cast<MultiThreadedOperation *>(input), r_operations);
+    }
+  }
+  r_operations.append(operation);
+}
+
+int PointwiseOperationFuser::fuse_operations()
+{
+  int fused_count = 0;
+  /* Copy because fused operations are removed from the builder. */
+  const Vector<NodeOperation *> operations = operations_builder_.get_operations();
+  for (NodeOperation *op : operations) {
+    if (!is_fusable(op) || is_fused_into_reader(op)) {
+      continue;
+    }
+    /* Pointwise operations always derive from #MultiThreadedOperation. */
+    Vector<MultiThreadedOperation *> fused_ops;
+    collect_fused_operations(static_cast<MultiThreadedOperation *>(op), fused_ops);
+    if (fused_ops.size() < 2) {
+      continue;
+    }
+    FusedPointwiseOperation *fused_op = new FusedPointwiseOperation(fused_ops);
+    operations_builder_.replace_operations_with_fused(fused_ops, fused_op);
+    fused_count++;
+  }
+  return fused_count;
+}
+
+}  // namespace blender::compositor
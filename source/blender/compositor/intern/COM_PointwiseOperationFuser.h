@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#pragma once
+
+#include "BLI_multi_value_map.hh"
+#include "BLI_vector.hh"
+
+namespace blender::compositor {
+
+class NodeOperation;
+class NodeOperationBuilder;
+class MultiThreadedOperation;
+
+/**
+ * Replaces trees of pointwise operations with #FusedPointwiseOperation, so that their
+ * intermediate results don't have to be written to full-frame buffers.
+ *
+ * An operation is fused into the operation reading it when it's the only reader of its output
+ * and both operations have the same canvas.
+ */
+class PointwiseOperationFuser {
+ private:
+  NodeOperationBuilder &operations_builder_;
+
+  /** Operations reading the output of each operation, once per linked input. */
+  MultiValueMap<NodeOperation *, NodeOperation *> readers_;
+
+ public:
+  /**
+   * \param operations_builder: Contains all operations to fuse.
+   */
+  PointwiseOperationFuser(NodeOperationBuilder &operations_builder);
+
+  /**
+   * Fuse pointwise operations.
+   * \return Number of created fused operations.
+   */
+  int fuse_operations();
+
+ private:
+  bool is_fusable(NodeOperation *operation) const;
+  bool is_fused_into_reader(NodeOperation *operation) const;
+  void collect_fused_operations(MultiThreadedOperation *operation,
+                                Vector<MultiThreadedOperation *> &r_operations) const;
+};
+
+}  // namespace blender::compositor
@@ -3,11 +3,42 @@
 
 #include "COM_SharedOperationBuffers.h"
 #include "COM_NodeOperation.h"
+#include "COM_OperationResultCache.h"
+
+#include "MEM_guardedalloc.h"
 
 namespace blender::compositor {
 
+/** Number of floats in a buffer. */
+static int64_t get_buffer_len(const int num_channels, const rcti &rect, bool is_a_single_elem)
+{
+  if (is_a_single_elem) {
+    return num_channels;
+  }
+  return int64_t(BLI_rcti_size_x(&rect)) * BLI_rcti_size_y(&rect) * num_channels;
+}
+
+SharedOperationBuffers::SharedOperationBuffers()
+    : free_bytes_(0), used_bytes_(0), peak_bytes_(0), result_cache_(nullptr)
+{
+}
+
+SharedOperationBuffers::~SharedOperationBuffers()
+{
+  for (BufferData &buf_data : buffers_.values()) {
+    if (buf_data.buffer && !buf_data.is_cached) {
+      dispose_buffer(std::move(buf_data.buffer));
+    }
+  }
+  free_unused_buffers_data();
+}
+
 SharedOperationBuffers::BufferData::BufferData()
-    : buffer(nullptr), registered_reads(0), received_reads(0), is_rendered(false)
+    : buffer(nullptr),
+      registered_reads(0),
+      received_reads(0),
+      is_rendered(false),
+      is_cached(false)
 {
 }
 
@@ -73,6 +104,65 @@ void SharedOperationBuffers::set_rendered_buffer(NodeOperation *op,
   buf_data.is_rendered = true;
 }
 
+void SharedOperationBuffers::set_cached_buffer(NodeOperation *op,
+                                               std::unique_ptr<MemoryBuffer> buffer)
+{
+  set_rendered_buffer(op, std::move(buffer));
+  get_buffer_data(op).is_cached = true;
+}
+
+bool SharedOperationBuffers::is_operation_cached(NodeOperation *op)
+{
+  return get_buffer_data(op).is_cached;
+}
+
+MemoryBuffer *SharedOperationBuffers::create_buffer(const DataType data_type,
+                                                    const rcti &rect,
+                                                    const bool is_a_single_elem)
+{
+  const int num_channels = COM_data_type_num_channels(data_type);
+  const int64_t buffer_len = get_buffer_len(num_channels, rect, is_a_single_elem);
+  const int64_t buffer_bytes = buffer_len * sizeof(float);
+
+  float *data;
+  Vector<float *> *free_datas = free_buffers_data_.lookup_ptr(buffer_len);
+  if (free_datas && !free_datas->is_empty()) {
+    data = free_datas->pop_last();
+    free_bytes_ -= buffer_bytes;
+  }
+  else {
+    /* Buffers with other sizes are needed now, don't keep unused memory around any longer. */
+    free_unused_buffers_data();
+    data = (float *)MEM_mallocN_aligned(buffer_bytes, 16, "COM_MemoryBuffer");
+  }
+  used_bytes_ += buffer_bytes;
+  peak_bytes_ = std::max(peak_bytes_, used_bytes_ + free_bytes_);
+
+  /* The data is owned by this class, the buffer only references it. */
+  return new MemoryBuffer(data, num_channels, rect, is_a_single_elem);
+}
+
+void SharedOperationBuffers::dispose_buffer(std::unique_ptr<MemoryBuffer> buffer)
+{
+  const int64_t buffer_len = get_buffer_len(
+      buffer->get_num_channels(), buffer->get_rect(), buffer->is_a_single_elem());
+  const int64_t buffer_bytes = buffer_len * sizeof(float);
+  free_buffers_data_.lookup_or_add_default(buffer_len).append(buffer->get_buffer());
+  used_bytes_ -= buffer_bytes;
+  free_bytes_ += buffer_bytes;
+}
+
+void SharedOperationBuffers::free_unused_buffers_data()
+{
+  for (Vector<float *> &datas : free_buffers_data_.values()) {
+    for (float *data : datas) {
+      MEM_freeN(data);
+    }
+  }
+  free_buffers_data_.clear();
+  free_bytes_ = 0;
+}
+
 MemoryBuffer *SharedOperationBuffers::get_rendered_buffer(NodeOperation *op)
 {
   BLI_assert(is_operation_rendered(op));
@@ -84,10 +174,30 @@ void SharedOperationBuffers::read_finished(NodeOperation *read_op)
   BufferData &buf_data = get_buffer_data(read_op);
   buf_data.received_reads++;
   BLI_assert(buf_data.received_reads > 0 && buf_data.received_reads <= buf_data.registered_reads);
-  if (buf_data.received_reads == buf_data.registered_reads) {
-    /* Dispose buffer. */
-    buf_data.buffer = nullptr;
+  if (buf_data.received_reads == buf_data.registered_reads && buf_data.buffer) {
+    if (buf_data.is_cached) {
+      /* Memory is owned by the result cache. */
+      buf_data.buffer.reset();
+    }
+    else if (!store_buffer_in_cache(read_op, buf_data)) {
+      /* Dispose buffer, keeping its memory for reuse. */
+      dispose_buffer(std::move(buf_data.buffer));
+    }
+  }
+}
+
+bool SharedOperationBuffers::store_buffer_in_cache(NodeOperation *op, BufferData &buf_data)
+{
+  const std::optional<uint64_t> result_key = op->get_result_key();
+  MemoryBuffer &buffer = *buf_data.buffer;
+  if (result_cache_ == nullptr || !result_key || buffer.is_a_single_elem() ||
+      !result_cache_->store_result(*result_key, buffer, buf_data.render_areas)) {
+    return false;
   }
+  used_bytes_ -= get_buffer_len(buffer.get_num_channels(), buffer.get_rect(), false) *
+                 sizeof(float);
+  buf_data.buffer.reset();
+  return true;
 }
 
 }  // namespace blender::compositor
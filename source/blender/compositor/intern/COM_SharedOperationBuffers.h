@@ -8,6 +8,8 @@
 
 #include "DNA_vec_types.h"
 
+#include "COM_defines.h"
+
 #ifdef WITH_CXX_GUARDEDALLOC
 #  include "MEM_guardedalloc.h"
 #endif
@@ -16,10 +18,16 @@ namespace blender::compositor {
 
 class MemoryBuffer;
 class NodeOperation;
+class OperationResultCache;
 
 /**
  * Stores and shares operations rendered buffers including render data. Buffers are
  * disposed once all dependent operations have finished reading them.
+ *
+ * The memory of disposed buffers is kept in a pool and reused for new buffers with the same
+ * size, which is common because most operations have the same resolution and data type. This
+ * avoids allocating and freeing large buffers for every operation. When a result cache is set,
+ * buffers of operations with a result key are stored in it instead.
  */
 class SharedOperationBuffers {
  private:
@@ -31,10 +39,34 @@ class SharedOperationBuffers {
     int registered_reads;
     int received_reads;
     bool is_rendered;
+    /** Whether the buffer memory is owned by the result cache. */
+    bool is_cached;
   } BufferData;
   blender::Map<NodeOperation *, BufferData> buffers_;
 
+  /** Memory of disposed buffers that can be reused, by number of floats. */
+  blender::Map<int64_t, blender::Vector<float *>> free_buffers_data_;
+  /** Memory of buffers in #free_buffers_data_. */
+  int64_t free_bytes_;
+  /** Memory of buffers that have not been disposed yet. */
+  int64_t used_bytes_;
+  /** Maximum of the memory held by this class at any time. */
+  int64_t peak_bytes_;
+
+  OperationResultCache *result_cache_;
+
  public:
+  SharedOperationBuffers();
+  ~SharedOperationBuffers();
+
+  /**
+   * Cache to store rendered buffers of operations with a result key in, can be null.
+   */
+  void set_result_cache(OperationResultCache *result_cache)
+  {
+    result_cache_ = result_cache;
+  }
+
   /**
    * Whether given operation area to render is already registered.
    */
@@ -62,10 +94,23 @@ class SharedOperationBuffers {
    * Whether this operation buffer has already been rendered.
    */
   bool is_operation_rendered(NodeOperation *op);
+  /**
+   * Creates a buffer for rendering an operation. Its memory is reused from disposed buffers when
+   * possible. The buffer must be stored with #set_rendered_buffer.
+   */
+  MemoryBuffer *create_buffer(DataType data_type, const rcti &rect, bool is_a_single_elem);
   /**
    * Stores given operation rendered buffer.
    */
   void set_rendered_buffer(NodeOperation *op, std::unique_ptr<MemoryBuffer> buffer);
+  /**
+   * Stores given operation buffer from the result cache, the operation is not rendered.
+   */
+  void set_cached_buffer(NodeOperation *op, std::unique_ptr<MemoryBuffer> buffer);
+  /**
+   * Whether given operation buffer is from the result cache.
+   */
+  bool is_operation_cached(NodeOperation *op);
   /**
    * Get given operation rendered buffer.
    */
@@ -77,8 +122,19 @@ class SharedOperationBuffers {
    */
   void read_finished(NodeOperation *read_op);
 
+  /**
+   * Maximum memory used by operation buffers, including the memory kept for reuse.
+   */
+  int64_t get_peak_memory() const
+  {
+    return peak_bytes_;
+  }
+
  private:
   BufferData &get_buffer_data(NodeOperation *op);
+  void dispose_buffer(std::unique_ptr<MemoryBuffer> buffer);
+  bool store_buffer_in_cache(NodeOperation *op, BufferData &buf_data);
+  void free_unused_buffers_data();
 
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:SharedOperationBuffers")
@@ -9,12 +9,15 @@
 #include "BKE_scene.h"
 
 #include "COM_ExecutionSystem.h"
+#include "COM_OperationResultCache.h"
 #include "COM_WorkScheduler.h"
 #include "COM_compositor.h"
 
 static struct {
   bool is_initialized = false;
   ThreadMutex mutex;
+  /** Operation results kept between executions while editing. */
+  blender::compositor::OperationResultCache *result_cache = nullptr;
 } g_compositor;
 
 /* Make sure node tree has previews.
@@ -49,13 +52,15 @@ void COM_execute(RenderData *render_data,
                  Scene *scene,
                  bNodeTree *node_tree,
                  int rendering,
-                 const char *view_name)
+                 const char *view_name,
+                 const rctf *viewer_visible_area)
 {
   /* Initialize mutex, TODO: this mutex init is actually not thread safe and
    * should be done somewhere as part of blender startup, all the other
    * initializations can be done lazily. */
   if (!g_compositor.is_initialized) {
     BLI_mutex_init(&g_compositor.mutex);
+    g_compositor.result_cache = new blender::compositor::OperationResultCache();
     g_compositor.is_initialized = true;
   }
 
@@ -78,8 +83,9 @@ void COM_execute(RenderData *render_data,
   /* Execute. */
   const bool twopass = (node_tree->flag & NTREE_TWO_PASS) && !rendering;
   if (twopass) {
+    /* Fast calculation results differ from final ones, don't cache them. */
     blender::compositor::ExecutionSystem fast_pass(
-        render_data, scene, node_tree, rendering, true, view_name);
+        render_data, scene, node_tree, rendering, true, view_name, viewer_visible_area, nullptr);
     fast_pass.execute();
 
     if (node_tree->test_break(node_tree->tbh)) {
@@ -88,8 +94,15 @@ void COM_execute(RenderData *render_data,
     }
   }
 
-  blender::compositor::ExecutionSystem system(
-      render_data, scene, node_tree, rendering, false, view_name);
+  /* Results are only reused while editing, renders usually change all inputs. */
+  blender::compositor::ExecutionSystem system(render_data,
+                                              scene,
+                                              node_tree,
+                                              rendering,
+                                              false,
+                                              view_name,
+                                              viewer_visible_area,
+                                              rendering ? nullptr : g_compositor.result_cache);
   system.execute();
 
   BLI_mutex_unlock(&g_compositor.mutex);
@@ -100,6 +113,8 @@ void COM_deinitialize()
   if (g_compositor.is_initialized) {
     BLI_mutex_lock(&g_compositor.mutex);
     blender::compositor::WorkScheduler::deinitialize();
+    delete g_compositor.result_cache;
+    g_compositor.result_cache = nullptr;
     g_compositor.is_initialized = false;
     BLI_mutex_unlock(&g_compositor.mutex);
     BLI_mutex_end(&g_compositor.mutex);
@@ -21,6 +21,7 @@ void BokehBlurNode::convert_to_operations(NodeConverter &converter,
 
   bool connected_size_socket = input_size_socket->is_linked();
   const bool extend_bounds = (b_node->custom1 & CMP_NODEFLAG_BLUR_EXTEND_BOUNDS) != 0;
+  const CMPNodeBokehBlurAlgorithm algorithm = (CMPNodeBokehBlurAlgorithm)b_node->custom2;
 
   if ((b_node->custom1 & CMP_NODEFLAG_BLUR_VARIABLE_SIZE) && connected_size_socket) {
     VariableSizeBokehBlurOperation *operation = new VariableSizeBokehBlurOperation();
@@ -28,6 +29,7 @@ void BokehBlurNode::convert_to_operations(NodeConverter &converter,
     operation->set_threshold(0.0f);
     operation->set_max_blur(b_node->custom4);
     operation->set_do_scale_size(true);
+    operation->set_algorithm(algorithm);
 
     converter.add_operation(operation);
     converter.map_input_socket(get_input_socket(0), operation->get_input_socket(0));
@@ -39,6 +41,7 @@ void BokehBlurNode::convert_to_operations(NodeConverter &converter,
     BokehBlurOperation *operation = new BokehBlurOperation();
     operation->set_quality(context.get_quality());
     operation->set_extend_bounds(extend_bounds);
+    operation->set_algorithm(algorithm);
 
     converter.add_operation(operation);
     converter.map_input_socket(get_input_socket(0), operation->get_input_socket(0));
@@ -98,6 +98,7 @@ void DefocusNode::convert_to_operations(NodeConverter &converter,
   }
   operation->set_max_blur(data->maxblur);
   operation->set_threshold(data->bthresh);
+  operation->set_algorithm((CMPNodeBokehBlurAlgorithm)data->algorithm);
   converter.add_operation(operation);
 
   converter.add_link(bokeh->get_output_socket(), operation->get_input_socket(1));
@@ -235,4 +235,13 @@ void BlurBaseOperation::get_area_of_interest(const int input_idx,
   }
 }
 
+void BlurBaseOperation::hash_output_params()
+{
+  hash_params(data_.sizex, data_.sizey, data_.relative);
+  hash_params(data_.aspect, data_.percentx, data_.percenty);
+  hash_params(data_.filtertype, int(data_.bokeh), int(data_.gamma));
+  hash_params(size_, sizeavailable_, extend_bounds_);
+  hash_params(use_variable_size_, int(get_quality()));
+}
+
 }  // namespace blender::compositor
@@ -79,6 +79,9 @@ class BlurBaseOperation : public MultiThreadedOperation, public QualityStepHelpe
   virtual void get_area_of_interest(int input_idx,
                                     const rcti &output_area,
                                     rcti &r_input_area) override;
+
+ protected:
+  void hash_output_params() override;
 };
 
 }  // namespace blender::compositor
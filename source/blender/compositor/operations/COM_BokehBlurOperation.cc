@@ -31,6 +31,7 @@ BokehBlurOperation::BokehBlurOperation()
   input_bounding_box_reader_ = nullptr;
 
   extend_bounds_ = false;
+  algorithm_ = CMP_NODE_BOKEH_BLUR_ACCURATE;
 }
 
 void BokehBlurOperation::init_data()
@@ -306,12 +307,40 @@ void BokehBlurOperation::get_area_of_interest(const int input_idx,
   }
 }
 
+int BokehBlurOperation::get_pixel_size() const
+{
+  const float max_dim = MAX2(this->get_width(), this->get_height());
+  return size_ * max_dim / 100.0f;
+}
+
+bool BokehBlurOperation::use_fast_algorithm(Span<MemoryBuffer *> inputs) const
+{
+  /* Small blurs are as fast with the accurate algorithm. */
+  return algorithm_ == CMP_NODE_BOKEH_BLUR_FAST && get_pixel_size() >= 2 &&
+         !inputs[IMAGE_INPUT_INDEX]->is_a_single_elem();
+}
+
+void BokehBlurOperation::update_memory_buffer_started(MemoryBuffer *UNUSED(output),
+                                                      const rcti &UNUSED(area),
+                                                      Span<MemoryBuffer *> inputs)
+{
+  if (use_fast_algorithm(inputs)) {
+    const MemoryBuffer *image_input = inputs[IMAGE_INPUT_INDEX];
+    bokeh_spans_.init(*inputs[BOKEH_INPUT_INDEX]);
+    image_sums_.init(*image_input, image_input->get_rect());
+  }
+}
+
 void BokehBlurOperation::update_memory_buffer_partial(MemoryBuffer *output,
                                                       const rcti &area,
                                                       Span<MemoryBuffer *> inputs)
 {
-  const float max_dim = MAX2(this->get_width(), this->get_height());
-  const int pixel_size = size_ * max_dim / 100.0f;
+  if (use_fast_algorithm(inputs)) {
+    update_memory_buffer_partial_fast(output, area, inputs);
+    return;
+  }
+
+  const int pixel_size = get_pixel_size();
   const float m = bokehDimension_ / pixel_size;
 
   const MemoryBuffer *image_input = inputs[IMAGE_INPUT_INDEX];
@@ -363,4 +392,68 @@ void BokehBlurOperation::update_memory_buffer_partial(MemoryBuffer *output,
   }
 }
 
+void BokehBlurOperation::update_memory_buffer_partial_fast(MemoryBuffer *output,
+                                                           const rcti &area,
+                                                           Span<MemoryBuffer *> inputs)
+{
+  const int pixel_size = get_pixel_size();
+  const float m = bokehDimension_ / pixel_size;
+
+  const MemoryBuffer *image_input = inputs[IMAGE_INPUT_INDEX];
+  MemoryBuffer *bounding_input = inputs[BOUNDING_BOX_INPUT_INDEX];
+  BuffersIterator<float> it = output->iterate_with({bounding_input}, area);
+  const rcti &image_rect = image_input->get_rect();
+  for (; !it.is_end(); ++it) {
+    const int x = it.x;
+    const int y = it.y;
+    const float bounding_box = *it.in(0);
+    if (bounding_box <= 0.0f) {
+      image_input->read_elem(x, y, it.out);
+      continue;
+    }
+
+    float color_accum[4] = {0};
+    float multiplier_accum[4] = {0};
+    const int miny = MAX2(y - pixel_size, image_rect.ymin);
+    const int maxy = MIN2(y + pixel_size, image_rect.ymax);
+    for (int ny = miny; ny < maxy; ny++) {
+      /* Same bokeh coordinates as the accurate algorithm, `u = bokeh_mid_x_ - (nx - x) * m`. */
+      const int v = floorf(bokeh_mid_y_ - (ny - y) * m);
+      int min_offset, max_offset;
+      const float *weight;
+      if (!bokeh_spans_.get_row_offsets(v, bokeh_mid_x_, -m, min_offset, max_offset, &weight)) {
+        continue;
+      }
+      min_offset = MAX2(min_offset, -pixel_size);
+      max_offset = MIN2(max_offset, pixel_size - 1);
+      image_sums_.accumulate(
+          ny, x + min_offset, x + max_offset, weight, color_accum, multiplier_accum);
+    }
+
+    if (multiplier_accum[0] <= 0.0f || multiplier_accum[1] <= 0.0f ||
+        multiplier_accum[2] <= 0.0f || multiplier_accum[3] <= 0.0f) {
+      image_input->read_elem(x, y, it.out);
+      continue;
+    }
+    it.out[0] = color_accum[0] * (1.0f / multiplier_accum[0]);
+    it.out[1] = color_accum[1] * (1.0f / multiplier_accum[1]);
+    it.out[2] = color_accum[2] * (1.0f / multiplier_accum[2]);
+    it.out[3] = color_accum[3] * (1.0f / multiplier_accum[3]);
+  }
+}
+
+void BokehBlurOperation::update_memory_buffer_finished(MemoryBuffer *UNUSED(output),
+                                                       const rcti &UNUSED(area),
+                                                       Span<MemoryBuffer *> UNUSED(inputs))
+{
+  bokeh_spans_.clear();
+  image_sums_.clear();
+}
+
+void BokehBlurOperation::hash_output_params()
+{
+  hash_params(size_, sizeavailable_, extend_bounds_);
+  hash_params(int(get_quality()), int(algorithm_));
+}
+
 }  // namespace blender::compositor
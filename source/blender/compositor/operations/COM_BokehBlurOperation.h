@@ -3,9 +3,12 @@
 
 #pragma once
 
+#include "COM_BokehRowSums.h"
 #include "COM_MultiThreadedOperation.h"
 #include "COM_QualityStepHelper.h"
 
+#include "DNA_node_types.h"
+
 namespace blender::compositor {
 
 class BokehBlurOperation : public MultiThreadedOperation, public QualityStepHelper {
@@ -22,6 +25,11 @@ class BokehBlurOperation : public MultiThreadedOperation, public QualityStepHelp
   float bokehDimension_;
   bool extend_bounds_;
 
+  CMPNodeBokehBlurAlgorithm algorithm_;
+  /* Used by the fast algorithm. */
+  BokehRowSpans bokeh_spans_;
+  ImageRowSums image_sums_;
+
  public:
   BokehBlurOperation();
 
@@ -65,12 +73,37 @@ class BokehBlurOperation : public MultiThreadedOperation, public QualityStepHelp
     extend_bounds_ = extend_bounds;
   }
 
+  /**
+   * Only supported by the full frame execution model, tiled execution always uses the accurate
+   * algorithm.
+   */
+  void set_algorithm(CMPNodeBokehBlurAlgorithm algorithm)
+  {
+    algorithm_ = algorithm;
+  }
+
   void determine_canvas(const rcti &preferred_area, rcti &r_area) override;
 
   void get_area_of_interest(int input_idx, const rcti &output_area, rcti &r_input_area) override;
+  void update_memory_buffer_started(MemoryBuffer *output,
+                                    const rcti &area,
+                                    Span<MemoryBuffer *> inputs) override;
   void update_memory_buffer_partial(MemoryBuffer *output,
                                     const rcti &area,
                                     Span<MemoryBuffer *> inputs) override;
+  void update_memory_buffer_finished(MemoryBuffer *output,
+                                     const rcti &area,
+                                     Span<MemoryBuffer *> inputs) override;
+
+ protected:
+  void hash_output_params() override;
+
+ private:
+  int get_pixel_size() const;
+  bool use_fast_algorithm(Span<MemoryBuffer *> inputs) const;
+  void update_memory_buffer_partial_fast(MemoryBuffer *output,
+                                         const rcti &area,
+                                         Span<MemoryBuffer *> inputs);
 };
 
 }  // namespace blender::compositor
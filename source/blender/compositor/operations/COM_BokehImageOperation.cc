@@ -139,4 +139,10 @@ void BokehImageOperation::determine_canvas(const rcti &preferred_area, rcti &r_a
                 preferred_area.ymin + COM_BLUR_BOKEH_PIXELS);
 }
 
+void BokehImageOperation::hash_output_params()
+{
+  hash_params(data_->angle, data_->flaps, data_->rounding);
+  hash_params(data_->catadioptric, data_->lensshift);
+}
+
 }  // namespace blender::compositor
@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#include "COM_BokehRowSums.h"
+#include "COM_MemoryBuffer.h"
+
+#include "BLI_task.hh"
+
+namespace blender::compositor {
+
+/**
+ * Bokeh pixels with a lower weight than this factor of the maximum weight are outside the shape.
+ * Keeps anti-aliased and rounded edges from widening the spans.
+ */
+static constexpr float bokeh_edge_threshold = 0.1f;
+
+static float get_bokeh_weight(const float *elem)
+{
+  return (elem[0] + elem[1] + elem[2]) / 3.0f;
+}
+
+BokehRowSpans::BokehRowSpans() : ymin_(0)
+{
+}
+
+void BokehRowSpans::init(const MemoryBuffer &bokeh)
+{
+  const rcti &rect = bokeh.get_rect();
+  const int width = BLI_rcti_size_x(&rect);
+  const int height = BLI_rcti_size_y(&rect);
+  ymin_ = rect.ymin;
+  rows_.reinitialize(height);
+
+  float max_weight = 0.0f;
+  for (int y = rect.ymin; y < rect.ymax; y++) {
+    for (int x = rect.xmin; x < rect.xmax; x++) {
+      max_weight = MAX2(max_weight, get_bokeh_weight(bokeh.get_elem(x, y)));
+    }
+  }
+  const float min_weight = max_weight * bokeh_edge_threshold;
+
+  for (const int row : IndexRange(height)) {
+    RowSpan &span = rows_[row];
+    span.xmin = rect.xmax;
+    span.xmax = rect.xmin - 1;
+    for (const int col : IndexRange(width)) {
+      if (get_bokeh_weight(bokeh.get_elem(rect.xmin + col, rect.ymin + row)) > min_weight) {
+        span.xmin = MIN2(span.xmin, rect.xmin + col);
+        span.xmax = rect.xmin + col;
+      }
+    }
+
+    zero_v4(span.weight);
+    if (span.xmin > span.xmax) {
+      continue;
+    }
+    for (int x = span.xmin; x <= span.xmax; x++) {
+      add_v4_v4(span.weight, bokeh.get_elem(x, rect.ymin + row));
+    }
+    mul_v4_fl(span.weight, 1.0f / (span.xmax - span.xmin + 1));
+  }
+}
+
+void BokehRowSpans::clear()
+{
+  rows_.reinitialize(0);
+}
+
+bool BokehRowSpans::get_row_offsets(const int y,
+                                    const float center_x,
+                                    const float scale,
+                                    int &r_min,
+                                    int &r_max,
+                                    const float **r_weight) const
+{
+  const int row = y - ymin_;
+  if (row < 0 || row >= rows_.size() || scale == 0.0f) {
+    return false;
+  }
+  const RowSpan &span = rows_[row];
+  if (span.xmin > span.xmax) {
+    return false;
+  }
+
+  /* Columns are floored, so the span covers `[xmin, xmax + 1)`. */
+  const float start = (span.xmin - center_x) / scale;
+  const float end = (span.xmax + 1 - center_x) / scale;
+  if (scale > 0.0f) {
+    r_min = int(ceilf(start));
+    r_max = int(ceilf(end)) - 1;
+  }
+  else {
+    r_min = int(floorf(end)) + 1;
+    r_max = int(floorf(start));
+  }
+  *r_weight = span.weight;
+  return r_min <= r_max;
+}
+
+ImageRowSums::ImageRowSums()
+{
+  BLI_rcti_init(&rect_, 0, 0, 0, 0);
+}
+
+void ImageRowSums::init(const MemoryBuffer &image,
+                        const rcti &rect,
+                        const MemoryBuffer *size,
+                        const float min_size)
+{
+  rect_ = rect;
+  const int width = BLI_rcti_size_x(&rect);
+  const int row_len = (width + 1) * NUM_CHANNELS;
+  sums_.reinitialize(int64_t(row_len) * BLI_rcti_size_y(&rect));
+
+  threading::parallel_for(IndexRange(BLI_rcti_size_y(&rect)), 16, [&](const IndexRange rows) {
+    for (const int row : rows) {
+      const int y = rect.ymin + row;
+      double *sum = &sums_[int64_t(row) * row_len];
+      for (const int i : IndexRange(NUM_CHANNELS)) {
+        sum[i] = 0.0;
+      }
+      for (int x = rect.xmin; x < rect.xmax; x++, sum += NUM_CHANNELS) {
+        double *next_sum = sum + NUM_CHANNELS;
+        if (size && *size->get_elem(x, y) <= min_size) {
+          for (const int i : IndexRange(NUM_CHANNELS)) {
+            next_sum[i] = sum[i];
+          }
+          continue;
+        }
+        const float *elem = image.get_elem(x, y);
+        for (const int i : IndexRange(4)) {
+          next_sum[i] = sum[i] + elem[i];
+        }
+        next_sum[4] = sum[4] + 1.0;
+      }
+    }
+  });
+}
+
+void ImageRowSums::clear()
+{
+  sums_.reinitialize(0);
+}
+
+void ImageRowSums::accumulate(const int y,
+                              const int xmin,
+                              const int xmax,
+                              const float weight[4],
+                              float color_accum[4],
+                              float multiplier_accum[4]) const
+{
+  const int start = MAX2(xmin, rect_.xmin) - rect_.xmin;
+  const int end = MIN2(xmax + 1, rect_.xmax) - rect_.xmin;
+  if (y < rect_.ymin || y >= rect_.ymax || start >= end) {
+    return;
+  }
+
+  const int64_t row_offset = int64_t(y - rect_.ymin) * (BLI_rcti_size_x(&rect_) + 1);
+  const double *start_sum = &sums_[(row_offset + start) * NUM_CHANNELS];
+  const double *end_sum = &sums_[(row_offset + end) * NUM_CHANNELS];
+  float color[4];
+  for (const int i : IndexRange(4)) {
+    color[i] = float(end_sum[i] - start_sum[i]);
+  }
+  madd_v4_v4v4(color_accum, weight, color);
+  madd_v4_v4fl(multiplier_accum, weight, float(end_sum[4] - start_sum[4]));
+}
+
+}  // namespace blender::compositor
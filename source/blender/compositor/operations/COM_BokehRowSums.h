@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#pragma once
+
+#include "BLI_array.hh"
+
+#include "DNA_vec_types.h"
+
+namespace blender::compositor {
+
+class MemoryBuffer;
+
+/**
+ * Approximation of a bokeh image as one span of constant weight per row, used by the fast
+ * algorithm of bokeh blur operations together with #ImageRowSums. Hollow shapes are filled and
+ * the weight of a row is the average of its span.
+ */
+class BokehRowSpans {
+ private:
+  struct RowSpan {
+    /** First and last columns of the span, empty when `xmin > xmax`. */
+    int xmin;
+    int xmax;
+    float weight[4];
+  };
+  Array<RowSpan> rows_;
+  int ymin_;
+
+ public:
+  BokehRowSpans();
+
+  void init(const MemoryBuffer &bokeh);
+  void clear();
+
+  /**
+   * Gets the range of offsets `d` of bokeh row \a y for which `floor(center_x + d * scale)` is
+   * a column of the row span, and the span weight.
+   * \return False when the row is outside the bokeh or empty.
+   */
+  bool get_row_offsets(
+      int y, float center_x, float scale, int &r_min, int &r_max, const float **r_weight) const;
+};
+
+/**
+ * Prefix sums of every image row, so that any range of a row is summed in constant time.
+ */
+class ImageRowSums {
+ private:
+  static constexpr int NUM_CHANNELS = 5;
+
+  rcti rect_;
+  /**
+   * Colors and number of included pixels, summed along rows. Double precision keeps the
+   * difference of two large sums accurate at the end of long rows.
+   */
+  Array<double> sums_;
+
+ public:
+  ImageRowSums();
+
+  /**
+   * Sums \a image inside \a rect. When \a size is given, pixels whose size is lower than or
+   * equal to \a min_size are excluded.
+   */
+  void init(const MemoryBuffer &image,
+            const rcti &rect,
+            const MemoryBuffer *size = nullptr,
+            float min_size = 0.0f);
+  void clear();
+
+  /**
+   * Adds the colors of row \a y from \a xmin to \a xmax (inclusive) multiplied by \a weight to
+   * \a color_accum and their weights to \a multiplier_accum. Pixels outside the summed rect are
+   * ignored.
+   */
+  void accumulate(int y,
+                  int xmin,
+                  int xmax,
+                  const float weight[4],
+                  float color_accum[4],
+                  float multiplier_accum[4]) const;
+};
+
+}  // namespace blender::compositor
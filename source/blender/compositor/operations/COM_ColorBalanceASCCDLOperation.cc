@@ -81,4 +81,11 @@ void ColorBalanceASCCDLOperation::deinit_execution()
   input_color_operation_ = nullptr;
 }
 
+void ColorBalanceASCCDLOperation::hash_output_params()
+{
+  for (int i = 0; i < 3; i++) {
+    hash_params(offset_[i], power_[i], slope_[i]);
+  }
+}
+
 }  // namespace blender::compositor
@@ -86,4 +86,11 @@ void ColorBalanceLGGOperation::deinit_execution()
   input_color_operation_ = nullptr;
 }
 
+void ColorBalanceLGGOperation::hash_output_params()
+{
+  for (int i = 0; i < 3; i++) {
+    hash_params(gain_[i], lift_[i], gamma_inv_[i]);
+  }
+}
+
 }  // namespace blender::compositor
@@ -222,4 +222,15 @@ void ColorCorrectionOperation::deinit_execution()
   input_mask_ = nullptr;
 }
 
+void ColorCorrectionOperation::hash_output_params()
+{
+  hash_params(red_channel_enabled_, green_channel_enabled_, blue_channel_enabled_);
+  hash_params(data_->startmidtones, data_->endmidtones);
+  for (const ColorCorrectionData *settings :
+       {&data_->master, &data_->shadows, &data_->midtones, &data_->highlights}) {
+    hash_params(settings->saturation, settings->contrast, settings->gamma);
+    hash_params(settings->gain, settings->lift);
+  }
+}
+
 }  // namespace blender::compositor
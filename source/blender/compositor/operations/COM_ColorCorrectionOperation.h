@@ -56,6 +56,9 @@ class ColorCorrectionOperation : public MultiThreadedRowOperation {
   }
 
   void update_memory_buffer_row(PixelCursor &p) override;
+
+ protected:
+  void hash_output_params() override;
 };
 
 }  // namespace blender::compositor
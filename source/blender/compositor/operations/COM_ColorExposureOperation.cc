@@ -57,4 +57,9 @@ void ExposureOperation::deinit_execution()
   input_exposure_program_ = nullptr;
 }
 
+void ExposureOperation::hash_output_params()
+{
+  /* No parameters, the result only depends on the inputs. */
+}
+
 }  // namespace blender::compositor
@@ -29,8 +29,14 @@ float ConvertDepthToRadiusOperation::determine_focal_distance()
   return 10.0f;
 }
 
-void ConvertDepthToRadiusOperation::init_execution()
+void ConvertDepthToRadiusOperation::determine_canvas(const rcti &preferred_area, rcti &r_area)
 {
+  MultiThreadedOperation::determine_canvas(preferred_area, r_area);
+
+  /* Done here instead of in #init_execution so that the post blur has its sigma when hashed,
+   * and even when this operation is not rendered because its result is cached. */
+  const int width = BLI_rcti_size_x(&r_area);
+  const int height = BLI_rcti_size_y(&r_area);
   float cam_sensor = DEFAULT_SENSOR_WIDTH;
   Camera *camera = nullptr;
 
@@ -39,17 +45,14 @@ void ConvertDepthToRadiusOperation::init_execution()
     cam_sensor = BKE_camera_sensor_size(camera->sensor_fit, camera->sensor_x, camera->sensor_y);
   }
 
-  input_operation_ = this->get_input_socket_reader(0);
   float focal_distance = determine_focal_distance();
   if (focal_distance == 0.0f) {
     focal_distance = 1e10f; /* If the DOF is 0.0 then set it to be far away. */
   }
   inverse_focal_distance_ = 1.0f / focal_distance;
-  aspect_ = (this->get_width() > this->get_height()) ?
-                (this->get_height() / (float)this->get_width()) :
-                (this->get_width() / (float)this->get_height());
+  aspect_ = (width > height) ? (height / (float)width) : (width / (float)height);
   aperture_ = 0.5f * (cam_lens_ / (aspect_ * cam_sensor)) / f_stop_;
-  const float minsz = MIN2(get_width(), get_height());
+  const float minsz = MIN2(width, height);
   dof_sp_ = minsz / ((cam_sensor / 2.0f) /
                      cam_lens_); /* <- == `aspect * MIN2(img->x, img->y) / tan(0.5f * fov)` */
 
@@ -58,6 +61,27 @@ void ConvertDepthToRadiusOperation::init_execution()
   }
 }
 
+void ConvertDepthToRadiusOperation::init_execution()
+{
+  input_operation_ = this->get_input_socket_reader(0);
+}
+
+void ConvertDepthToRadiusOperation::hash_output_params()
+{
+  hash_params(f_stop_, max_radius_, camera_object_);
+}
+
+void ConvertDepthToRadiusOperation::hash_output_data()
+{
+  /* Camera settings can change without any parameter changing. */
+  if (camera_object_ && camera_object_->type == OB_CAMERA) {
+    const Camera *camera = (const Camera *)camera_object_->data;
+    hash_params(camera->lens, int(camera->sensor_fit));
+    hash_params(camera->sensor_x, camera->sensor_y);
+    hash_param(BKE_camera_object_dof_distance(camera_object_));
+  }
+}
+
 void ConvertDepthToRadiusOperation::execute_pixel_sampled(float output[4],
                                                           float x,
                                                           float y,
@@ -69,9 +69,14 @@ class ConvertDepthToRadiusOperation : public MultiThreadedOperation {
     blur_post_operation_ = operation;
   }
 
+  void determine_canvas(const rcti &preferred_area, rcti &r_area) override;
   void update_memory_buffer_partial(MemoryBuffer *output,
                                     const rcti &area,
                                     Span<MemoryBuffer *> inputs) override;
+
+ protected:
+  void hash_output_params() override;
+  void hash_output_data() override;
 };
 
 }  // namespace blender::compositor
@@ -424,4 +424,9 @@ void FastGaussianBlurValueOperation::update_memory_buffer_partial(MemoryBuffer *
   }
 }
 
+void FastGaussianBlurValueOperation::hash_output_params()
+{
+  hash_params(sigma_, overlay_);
+}
+
 }  // namespace blender::compositor
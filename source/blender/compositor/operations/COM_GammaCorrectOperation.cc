@@ -146,4 +146,14 @@ void GammaUncorrectOperation::deinit_execution()
   input_program_ = nullptr;
 }
 
+void GammaCorrectOperation::hash_output_params()
+{
+  /* No parameters, the result only depends on the inputs. */
+}
+
+void GammaUncorrectOperation::hash_output_params()
+{
+  /* No parameters, the result only depends on the inputs. */
+}
+
 }  // namespace blender::compositor
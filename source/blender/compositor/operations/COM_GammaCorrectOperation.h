@@ -35,6 +35,9 @@ class GammaCorrectOperation : public MultiThreadedOperation {
   void update_memory_buffer_partial(MemoryBuffer *output,
                                     const rcti &area,
                                     Span<MemoryBuffer *> inputs) override;
+
+ protected:
+  void hash_output_params() override;
 };
 
 class GammaUncorrectOperation : public MultiThreadedOperation {
@@ -65,6 +68,9 @@ class GammaUncorrectOperation : public MultiThreadedOperation {
   void update_memory_buffer_partial(MemoryBuffer *output,
                                     const rcti &area,
                                     Span<MemoryBuffer *> inputs) override;
+
+ protected:
+  void hash_output_params() override;
 };
 
 }  // namespace blender::compositor
@@ -56,4 +56,9 @@ void GammaOperation::deinit_execution()
   input_gamma_program_ = nullptr;
 }
 
+void GammaOperation::hash_output_params()
+{
+  /* No parameters, the result only depends on the inputs. */
+}
+
 }  // namespace blender::compositor
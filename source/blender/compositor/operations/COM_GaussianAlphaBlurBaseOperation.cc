@@ -145,4 +145,10 @@ void GaussianAlphaBlurBaseOperation::update_memory_buffer_partial(MemoryBuffer *
   }
 }
 
+void GaussianAlphaBlurBaseOperation::hash_output_params()
+{
+  BlurBaseOperation::hash_output_params();
+  hash_params(falloff_, do_subtract_);
+}
+
 }  // namespace blender::compositor
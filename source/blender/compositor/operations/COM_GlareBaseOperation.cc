@@ -87,4 +87,12 @@ void GlareBaseOperation::update_memory_buffer(MemoryBuffer *output,
   }
 }
 
+void GlareBaseOperation::hash_output_params()
+{
+  hash_params(int(settings_->quality), int(settings_->type), int(settings_->iter));
+  hash_params(int(settings_->size), int(settings_->star_45), int(settings_->streaks));
+  hash_params(settings_->colmod, settings_->threshold, settings_->fade);
+  hash_param(settings_->angle_ofs);
+}
+
 }  // namespace blender::compositor
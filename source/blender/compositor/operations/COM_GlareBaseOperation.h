@@ -67,6 +67,9 @@ class GlareBaseOperation : public SingleThreadedOperation {
   virtual void generate_glare(float *data, MemoryBuffer *input_tile, NodeGlare *settings) = 0;
 
   MemoryBuffer *create_memory_buffer(rcti *rect) override;
+
+ protected:
+  void hash_output_params() override;
 };
 
 }  // namespace blender::compositor
@@ -75,4 +75,9 @@ void GlareThresholdOperation::update_memory_buffer_partial(MemoryBuffer *output,
   }
 }
 
+void GlareThresholdOperation::hash_output_params()
+{
+  hash_param(settings_->threshold);
+}
+
 }  // namespace blender::compositor
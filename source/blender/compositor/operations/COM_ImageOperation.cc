@@ -103,6 +103,40 @@ void BaseImageOperation::determine_canvas(const rcti &UNUSED(preferred_area), rc
   BKE_image_release_ibuf(image_, stackbuf, nullptr);
 }
 
+void BaseImageOperation::hash_output_params()
+{
+  hash_params(image_, framenumber_, StringRef(view_name_ ? view_name_ : ""));
+  if (image_user_) {
+    const ImageUser &iuser = *image_user_;
+    hash_params(iuser.scene, iuser.framenr, iuser.frames);
+    hash_params(iuser.offset, iuser.sfra, int(iuser.cycl));
+    hash_params(iuser.pass, iuser.tile, iuser.multi_index);
+    hash_params(iuser.view, iuser.layer, iuser.flag);
+  }
+}
+
+void BaseImageOperation::hash_output_data()
+{
+  /* Image pixels may change without any parameter changing, e.g. when painting or reloading. */
+  ImBuf *ibuf = get_im_buf();
+  if (ibuf == nullptr) {
+    return;
+  }
+
+  const int64_t pixels_num = int64_t(ibuf->x) * ibuf->y;
+  hash_params(ibuf->channels, ibuf->rect_colorspace);
+  if (ibuf->rect_float) {
+    hash_data(ibuf->rect_float, sizeof(float) * pixels_num * ibuf->channels);
+  }
+  else {
+    hash_data(ibuf->rect, sizeof(unsigned int) * pixels_num);
+  }
+  if (ibuf->zbuf_float) {
+    hash_data(ibuf->zbuf_float, sizeof(float) * pixels_num);
+  }
+  BKE_image_release_ibuf(image_, ibuf, nullptr);
+}
+
 static void sample_image_at_location(
     ImBuf *ibuf, float x, float y, PixelSampler sampler, bool make_linear_rgb, float color[4])
 {
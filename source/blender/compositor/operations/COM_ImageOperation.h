@@ -43,6 +43,9 @@ class BaseImageOperation : public MultiThreadedOperation {
 
   virtual ImBuf *get_im_buf();
 
+  void hash_output_params() override;
+  void hash_output_data() override;
+
  public:
   void init_execution() override;
   void deinit_execution() override;
@@ -19,6 +19,7 @@ MixBaseOperation::MixBaseOperation()
   this->set_use_value_alpha_multiply(false);
   this->set_use_clamp(false);
   flags_.can_be_constant = true;
+  flags_.is_pointwise_operation = true;
 }
 
 void MixBaseOperation::init_execution()
@@ -82,6 +83,11 @@ void MixBaseOperation::deinit_execution()
   input_color2_operation_ = nullptr;
 }
 
+void MixBaseOperation::hash_output_params()
+{
+  hash_params(value_alpha_multiply_, use_clamp_);
+}
+
 void MixBaseOperation::update_memory_buffer_partial(MemoryBuffer *output,
                                                     const rcti &area,
                                                     Span<MemoryBuffer *> inputs)
@@ -17,6 +17,8 @@ class MultilayerBaseOperation : public BaseImageOperation {
   RenderPass *render_pass_;
   ImBuf *get_im_buf() override;
 
+  void hash_output_params() override;
+
  public:
   /**
    * Constructor
@@ -50,6 +50,34 @@ void RenderLayersProg::init_execution()
   }
 }
 
+void RenderLayersProg::hash_output_params()
+{
+  hash_params(scene_, layer_id_, StringRef(pass_name_));
+  hash_params(StringRef(view_name_ ? view_name_ : ""), elementsize_);
+}
+
+void RenderLayersProg::hash_output_data()
+{
+  /* The render result changes without any parameter changing, e.g. when re-rendering. */
+  Scene *scene = this->get_scene();
+  Render *re = (scene) ? RE_GetSceneRender(scene) : nullptr;
+  if (re == nullptr) {
+    return;
+  }
+
+  RenderResult *rr = RE_AcquireResultRead(re);
+  if (rr) {
+    ViewLayer *view_layer = (ViewLayer *)BLI_findlink(&scene->view_layers, get_layer_id());
+    RenderLayer *rl = view_layer ? RE_GetRenderLayer(rr, view_layer->name) : nullptr;
+    const float *pass_buffer = rl ? RE_RenderLayerGetPass(rl, pass_name_.c_str(), view_name_) :
+                                    nullptr;
+    if (pass_buffer) {
+      hash_data(pass_buffer, sizeof(float) * elementsize_ * get_width() * get_height());
+    }
+  }
+  RE_ReleaseResult(re);
+}
+
 void RenderLayersProg::do_interpolation(float output[4], float x, float y, PixelSampler sampler)
 {
   unsigned int offset;
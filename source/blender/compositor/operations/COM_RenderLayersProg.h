@@ -70,6 +70,9 @@ class RenderLayersProg : public MultiThreadedOperation {
 
   void do_interpolation(float output[4], float x, float y, PixelSampler sampler);
 
+  void hash_output_params() override;
+  void hash_output_data() override;
+
  public:
   /**
    * Constructor
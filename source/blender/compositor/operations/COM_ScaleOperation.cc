@@ -543,4 +543,17 @@ void ScaleFixedSizeOperation::update_memory_buffer_partial(MemoryBuffer *output,
   }
 }
 
+void BaseScaleOperation::hash_output_params()
+{
+  hash_params(sampler_, variable_size_);
+}
+
+void ScaleFixedSizeOperation::hash_output_params()
+{
+  BaseScaleOperation::hash_output_params();
+  hash_params(new_width_, new_height_);
+  hash_params(offset_x_, offset_y_);
+  hash_params(is_aspect_, is_crop_);
+}
+
 }  // namespace blender::compositor
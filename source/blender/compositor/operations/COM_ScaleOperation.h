@@ -35,6 +35,8 @@ class BaseScaleOperation : public MultiThreadedOperation {
   int sampler_;
   /* TODO(manzanilla): to be removed with tiled implementation. */
   bool variable_size_;
+
+  void hash_output_params() override;
 };
 
 class ScaleOperation : public BaseScaleOperation {
@@ -197,6 +199,9 @@ class ScaleFixedSizeOperation : public BaseScaleOperation {
 
  private:
   void init_data(const rcti &input_canvas);
+
+ protected:
+  void hash_output_params() override;
 };
 
 }  // namespace blender::compositor
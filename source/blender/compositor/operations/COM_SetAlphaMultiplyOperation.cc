@@ -14,6 +14,7 @@ SetAlphaMultiplyOperation::SetAlphaMultiplyOperation()
   input_color_ = nullptr;
   input_alpha_ = nullptr;
   flags_.can_be_constant = true;
+  flags_.is_pointwise_operation = true;
 }
 
 void SetAlphaMultiplyOperation::init_execution()
@@ -53,4 +54,9 @@ void SetAlphaMultiplyOperation::update_memory_buffer_partial(MemoryBuffer *outpu
   }
 }
 
+void SetAlphaMultiplyOperation::hash_output_params()
+{
+  /* No parameters, the result only depends on the inputs. */
+}
+
 }  // namespace blender::compositor
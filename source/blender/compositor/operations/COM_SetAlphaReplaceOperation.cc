@@ -14,6 +14,7 @@ SetAlphaReplaceOperation::SetAlphaReplaceOperation()
   input_color_ = nullptr;
   input_alpha_ = nullptr;
   flags_.can_be_constant = true;
+  flags_.is_pointwise_operation = true;
 }
 
 void SetAlphaReplaceOperation::init_execution()
@@ -52,4 +53,9 @@ void SetAlphaReplaceOperation::update_memory_buffer_partial(MemoryBuffer *output
   }
 }
 
+void SetAlphaReplaceOperation::hash_output_params()
+{
+  /* No parameters, the result only depends on the inputs. */
+}
+
 }  // namespace blender::compositor
@@ -33,6 +33,9 @@ class SetAlphaReplaceOperation : public MultiThreadedOperation {
   void update_memory_buffer_partial(MemoryBuffer *output,
                                     const rcti &area,
                                     Span<MemoryBuffer *> inputs) override;
+
+ protected:
+  void hash_output_params() override;
 };
 
 }  // namespace blender::compositor
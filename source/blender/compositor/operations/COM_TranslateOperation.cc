@@ -154,4 +154,11 @@ void TranslateCanvasOperation::determine_canvas(const rcti &preferred_area, rcti
   }
 }
 
+void TranslateOperation::hash_output_params()
+{
+  /* Deltas are read from the inputs. */
+  hash_params(factor_x_, factor_y_);
+  hash_params(int(x_extend_mode_), int(y_extend_mode_));
+}
+
 }  // namespace blender::compositor
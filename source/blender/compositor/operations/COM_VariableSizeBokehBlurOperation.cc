@@ -25,6 +25,7 @@ VariableSizeBokehBlurOperation::VariableSizeBokehBlurOperation()
   max_blur_ = 32.0f;
   threshold_ = 1.0f;
   do_size_scale_ = false;
+  algorithm_ = CMP_NODE_BOKEH_BLUR_ACCURATE;
 #ifdef COM_DEFOCUS_SEARCH
   input_search_program_ = nullptr;
 #endif
@@ -268,9 +269,7 @@ void VariableSizeBokehBlurOperation::get_area_of_interest(const int input_idx,
   switch (input_idx) {
     case IMAGE_INPUT_INDEX:
     case SIZE_INPUT_INDEX: {
-      const float max_dim = MAX2(get_width(), get_height());
-      const float scalar = do_size_scale_ ? (max_dim / 100.0f) : 1.0f;
-      const int max_blur_scalar = max_blur_ * scalar;
+      const int max_blur_scalar = max_blur_ * get_size_scalar();
       r_input_area.xmax = output_area.xmax + max_blur_scalar + 2;
       r_input_area.xmin = output_area.xmin - max_blur_scalar - 2;
       r_input_area.ymax = output_area.ymax + max_blur_scalar + 2;
@@ -370,10 +369,81 @@ static void blur_pixel(int x, int y, PixelData &p)
   }
 }
 
+/**
+ * Approximation of #blur_pixel summing rows of the bokeh shape of the center pixel size at once.
+ * Contributing pixels are assumed to be at least as large as the center one, only pixels under
+ * the size threshold are excluded.
+ */
+static void blur_pixel_fast(int x,
+                            int y,
+                            PixelData &p,
+                            const BokehRowSpans &bokeh_spans,
+                            const ImageRowSums &image_sums)
+{
+  const float radius = MIN2(p.size_center, float(p.max_blur_scalar));
+  const int max_offset = int(ceilf(radius)) - 1;
+  const float bokeh_center = float(COM_BLUR_BOKEH_PIXELS / 2);
+  const float bokeh_scale = float((COM_BLUR_BOKEH_PIXELS / 2) - 1) / radius;
+
+  float color_accum[4] = {0};
+  float multiplier_accum[4] = {0};
+  const int miny = MAX2(y - max_offset, 0);
+  const int maxy = MIN2(y + max_offset + 1, p.image_height);
+  for (int ny = miny; ny < maxy; ny++) {
+    const int v = floorf(bokeh_center + (ny - y) * bokeh_scale);
+    int min_x, max_x;
+    const float *weight;
+    if (!bokeh_spans.get_row_offsets(v, bokeh_center, bokeh_scale, min_x, max_x, &weight)) {
+      continue;
+    }
+    min_x = MAX2(x + MAX2(min_x, -max_offset), 0);
+    max_x = MIN2(x + MIN2(max_x, max_offset), p.image_width - 1);
+    image_sums.accumulate(ny, min_x, max_x, weight, color_accum, multiplier_accum);
+  }
+
+  /* Keep the center pixel when nothing has been summed, e.g. with an empty bokeh. */
+  if (multiplier_accum[0] > 0.0f && multiplier_accum[1] > 0.0f && multiplier_accum[2] > 0.0f &&
+      multiplier_accum[3] > 0.0f) {
+    copy_v4_v4(p.color_accum, color_accum);
+    copy_v4_v4(p.multiplier_accum, multiplier_accum);
+  }
+}
+
+float VariableSizeBokehBlurOperation::get_size_scalar() const
+{
+  const float max_dim = MAX2(this->get_width(), this->get_height());
+  return do_size_scale_ ? (max_dim / 100.0f) : 1.0f;
+}
+
+bool VariableSizeBokehBlurOperation::use_fast_algorithm(Span<MemoryBuffer *> inputs) const
+{
+  return algorithm_ == CMP_NODE_BOKEH_BLUR_FAST && !inputs[IMAGE_INPUT_INDEX]->is_a_single_elem();
+}
+
+void VariableSizeBokehBlurOperation::update_memory_buffer_started(MemoryBuffer *UNUSED(output),
+                                                                  const rcti &UNUSED(area),
+                                                                  Span<MemoryBuffer *> inputs)
+{
+  if (!use_fast_algorithm(inputs)) {
+    return;
+  }
+
+  const MemoryBuffer *image_input = inputs[IMAGE_INPUT_INDEX];
+  const MemoryBuffer *size_input = inputs[SIZE_INPUT_INDEX];
+  rcti sums_rect;
+  BLI_rcti_init(&sums_rect, 0, this->get_width(), 0, this->get_height());
+  BLI_rcti_isect(&sums_rect, &image_input->get_rect(), &sums_rect);
+  BLI_rcti_isect(&sums_rect, &size_input->get_rect(), &sums_rect);
+
+  bokeh_spans_.init(*inputs[BOKEH_INPUT_INDEX]);
+  image_sums_.init(*image_input, sums_rect, size_input, threshold_ / get_size_scalar());
+}
+
 void VariableSizeBokehBlurOperation::update_memory_buffer_partial(MemoryBuffer *output,
                                                                   const rcti &area,
                                                                   Span<MemoryBuffer *> inputs)
 {
+  const bool use_fast = use_fast_algorithm(inputs);
   PixelData p;
   p.bokeh_input = inputs[BOKEH_INPUT_INDEX];
   p.size_input = inputs[SIZE_INPUT_INDEX];
@@ -388,8 +458,7 @@ void VariableSizeBokehBlurOperation::update_memory_buffer_partial(MemoryBuffer *
   BLI_rcti_isect(&scalar_area, &p.size_input->get_rect(), &scalar_area);
   const float max_size = p.size_input->get_max_value(scalar_area);
 
-  const float max_dim = MAX2(this->get_width(), this->get_height());
-  p.scalar = do_size_scale_ ? (max_dim / 100.0f) : 1.0f;
+  p.scalar = get_size_scalar();
   p.max_blur_scalar = static_cast<int>(max_size * p.scalar);
   CLAMP(p.max_blur_scalar, 1, max_blur_);
 
@@ -403,7 +472,12 @@ void VariableSizeBokehBlurOperation::update_memory_buffer_partial(MemoryBuffer *
     p.size_center = size * p.scalar;
 
     if (p.size_center > p.threshold) {
-      blur_pixel(it.x, it.y, p);
+      if (use_fast) {
+        blur_pixel_fast(it.x, it.y, p, bokeh_spans_, image_sums_);
+      }
+      else {
+        blur_pixel(it.x, it.y, p);
+      }
     }
 
     it.out[0] = p.color_accum[0] / p.multiplier_accum[0];
@@ -530,4 +604,17 @@ bool InverseSearchRadiusOperation::determine_depending_area_of_interest(
 }
 #endif
 
+void VariableSizeBokehBlurOperation::update_memory_buffer_finished(
+    MemoryBuffer *UNUSED(output), const rcti &UNUSED(area), Span<MemoryBuffer *> UNUSED(inputs))
+{
+  bokeh_spans_.clear();
+  image_sums_.clear();
+}
+
+void VariableSizeBokehBlurOperation::hash_output_params()
+{
+  hash_params(max_blur_, threshold_, do_size_scale_);
+  hash_params(int(get_quality()), int(algorithm_));
+}
+
 }  // namespace blender::compositor
@@ -3,9 +3,12 @@
 
 #pragma once
 
+#include "COM_BokehRowSums.h"
 #include "COM_MultiThreadedOperation.h"
 #include "COM_QualityStepHelper.h"
 
+#include "DNA_node_types.h"
+
 namespace blender::compositor {
 
 //#define COM_DEFOCUS_SEARCH
@@ -22,6 +25,10 @@ class VariableSizeBokehBlurOperation : public MultiThreadedOperation, public Qua
   int max_blur_;
   float threshold_;
   bool do_size_scale_; /* scale size, matching 'BokehBlurNode' */
+  CMPNodeBokehBlurAlgorithm algorithm_;
+  /* Used by the fast algorithm. */
+  BokehRowSpans bokeh_spans_;
+  ImageRowSums image_sums_;
   SocketReader *input_program_;
   SocketReader *input_bokeh_program_;
   SocketReader *input_size_program_;
@@ -70,6 +77,15 @@ class VariableSizeBokehBlurOperation : public MultiThreadedOperation, public Qua
     do_size_scale_ = scale_size;
   }
 
+  /**
+   * Only supported by the full frame execution model, tiled execution always uses the accurate
+   * algorithm.
+   */
+  void set_algorithm(CMPNodeBokehBlurAlgorithm algorithm)
+  {
+    algorithm_ = algorithm;
+  }
+
   void execute_opencl(OpenCLDevice *device,
                       MemoryBuffer *output_memory_buffer,
                       cl_mem cl_output_buffer,
@@ -78,9 +94,22 @@ class VariableSizeBokehBlurOperation : public MultiThreadedOperation, public Qua
                       std::list<cl_kernel> *cl_kernels_to_clean_up) override;
 
   void get_area_of_interest(int input_idx, const rcti &output_area, rcti &r_input_area) override;
+  void update_memory_buffer_started(MemoryBuffer *output,
+                                    const rcti &area,
+                                    Span<MemoryBuffer *> inputs) override;
   void update_memory_buffer_partial(MemoryBuffer *output,
                                     const rcti &area,
                                     Span<MemoryBuffer *> inputs) override;
+  void update_memory_buffer_finished(MemoryBuffer *output,
+                                     const rcti &area,
+                                     Span<MemoryBuffer *> inputs) override;
+
+ protected:
+  void hash_output_params() override;
+
+ private:
+  float get_size_scalar() const;
+  bool use_fast_algorithm(Span<MemoryBuffer *> inputs) const;
 };
 
 /* Currently unused. If ever used, it needs full-frame implementation. */
@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#include "testing/testing.h"
+
+#include "BLI_rect.h"
+
+#include "COM_BokehRowSums.h"
+#include "COM_MemoryBuffer.h"
+
+namespace blender::compositor::tests {
+
+static void fill_image(MemoryBuffer &image)
+{
+  const rcti &rect = image.get_rect();
+  for (int y = rect.ymin; y < rect.ymax; y++) {
+    for (int x = rect.xmin; x < rect.xmax; x++) {
+      float *elem = image.get_elem(x, y);
+      elem[0] = x;
+      elem[1] = y;
+      elem[2] = x * y;
+      elem[3] = 1.0f;
+    }
+  }
+}
+
+TEST(ImageRowSums, accumulate)
+{
+  rcti rect;
+  BLI_rcti_init(&rect, 2, 12, 1, 6);
+  MemoryBuffer image(DataType::Color, rect);
+  fill_image(image);
+
+  ImageRowSums sums;
+  sums.init(image, rect);
+
+  const float weight[4] = {1.0f, 2.0f, 1.0f, 0.5f};
+  float color_accum[4] = {0};
+  float multiplier_accum[4] = {0};
+  /* Partially outside of the rect, only columns 2 to 4 are summed. */
+  sums.accumulate(3, -1, 4, weight, color_accum, multiplier_accum);
+  EXPECT_FLOAT_EQ(color_accum[0], 2.0f + 3.0f + 4.0f);
+  EXPECT_FLOAT_EQ(color_accum[1], 2.0f * (3.0f * 3.0f));
+  EXPECT_FLOAT_EQ(color_accum[2], 3.0f * (2.0f + 3.0f + 4.0f));
+  EXPECT_FLOAT_EQ(color_accum[3], 0.5f * 3.0f);
+  EXPECT_FLOAT_EQ(multiplier_accum[0], 3.0f);
+  EXPECT_FLOAT_EQ(multiplier_accum[1], 6.0f);
+  EXPECT_FLOAT_EQ(multiplier_accum[3], 1.5f);
+
+  /* Rows outside of the rect are ignored. */
+  sums.accumulate(6, 2, 4, weight, color_accum, multiplier_accum);
+  EXPECT_FLOAT_EQ(multiplier_accum[0], 3.0f);
+}
+
+TEST(ImageRowSums, excluded_sizes)
+{
+  rcti rect;
+  BLI_rcti_init(&rect, 0, 4, 0, 1);
+  MemoryBuffer image(DataType::Color, rect);
+  fill_image(image);
+  MemoryBuffer size(DataType::Value, rect);
+  const float sizes[4] = {3.0f, 0.5f, 2.0f, 1.0f};
+  for (int x = 0; x < 4; x++) {
+    *size.get_elem(x, 0) = sizes[x];
+  }
+
+  ImageRowSums sums;
+  sums.init(image, rect, &size, 1.0f);
+
+  const float weight[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  float color_accum[4] = {0};
+  float multiplier_accum[4] = {0};
+  sums.accumulate(0, 0, 3, weight, color_accum, multiplier_accum);
+  EXPECT_FLOAT_EQ(color_accum[0], 0.0f + 2.0f);
+  EXPECT_FLOAT_EQ(multiplier_accum[0], 2.0f);
+}
+
+TEST(ImageRowSums, long_row_precision)
+{
+  /* The sums of the row get large, small ranges at its end must stay accurate. */
+  const int width = 200000;
+  rcti rect;
+  BLI_rcti_init(&rect, 0, width, 0, 1);
+  MemoryBuffer image(DataType::Color, rect);
+  for (int x = 0; x < width; x++) {
+    copy_v4_fl(image.get_elem(x, 0), 1000.0f);
+  }
+  copy_v4_fl(image.get_elem(width - 1, 0), 0.1f);
+
+  ImageRowSums sums;
+  sums.init(image, rect);
+
+  const float weight[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  float color_accum[4] = {0};
+  float multiplier_accum[4] = {0};
+  sums.accumulate(0, width - 1, width - 1, weight, color_accum, multiplier_accum);
+  EXPECT_FLOAT_EQ(color_accum[0], 0.1f);
+  EXPECT_FLOAT_EQ(multiplier_accum[0], 1.0f);
+}
+
+TEST(BokehRowSpans, get_row_offsets)
+{
+  /* Diamond shape with a dimmer center row. */
+  rcti rect;
+  BLI_rcti_init(&rect, 0, 5, 0, 5);
+  MemoryBuffer bokeh(DataType::Color, rect);
+  bokeh.clear();
+  for (int y = 0; y < 5; y++) {
+    const int half_width = 2 - abs(y - 2);
+    for (int x = 2 - half_width; x <= 2 + half_width; x++) {
+      copy_v4_fl(bokeh.get_elem(x, y), y == 2 ? 0.5f : 1.0f);
+    }
+  }
+
+  BokehRowSpans spans;
+  spans.init(bokeh);
+
+  int min_offset, max_offset;
+  const float *weight;
+  EXPECT_TRUE(spans.get_row_offsets(2, 2.0f, 1.0f, min_offset, max_offset, &weight));
+  EXPECT_EQ(min_offset, -2);
+  EXPECT_EQ(max_offset, 2);
+  EXPECT_FLOAT_EQ(weight[0], 0.5f);
+
+  /* Twice larger and mirrored. */
+  EXPECT_TRUE(spans.get_row_offsets(1, 2.0f, -0.5f, min_offset, max_offset, &weight));
+  EXPECT_EQ(min_offset, -3);
+  EXPECT_EQ(max_offset, 2);
+  EXPECT_FLOAT_EQ(weight[0], 1.0f);
+
+  EXPECT_FALSE(spans.get_row_offsets(5, 2.0f, 1.0f, min_offset, max_offset, &weight));
+}
+
+}  // namespace blender::compositor::tests
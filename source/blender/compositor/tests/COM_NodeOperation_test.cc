@@ -71,6 +71,52 @@ class HashedOperation : public NodeOperation {
   }
 };
 
+class TwoInputsOperation : public NodeOperation {
+ public:
+  TwoInputsOperation(NodeOperation &input1, NodeOperation &input2)
+  {
+    add_input_socket(DataType::Value);
+    add_input_socket(DataType::Value);
+    add_output_socket(DataType::Value);
+    set_width(2);
+    set_height(3);
+    get_input_socket(0)->set_link(input1.get_output_socket());
+    get_input_socket(1)->set_link(input2.get_output_socket());
+  }
+
+  void hash_output_params() override
+  {
+  }
+};
+
+class DataHashedOperation : public NodeOperation {
+ private:
+  Vector<float> data_;
+
+ public:
+  DataHashedOperation()
+  {
+    add_output_socket(DataType::Value);
+    set_width(2);
+    set_height(3);
+    data_ = {1.0f, 2.0f, 3.0f};
+  }
+
+  void set_data_elem(int index, float value)
+  {
+    data_[index] = value;
+  }
+
+  void hash_output_params() override
+  {
+  }
+
+  void hash_output_data() override
+  {
+    hash_data(data_.data(), data_.size() * sizeof(float));
+  }
+};
+
 static void test_non_equal_hashes_compare(NodeOperationHash &h1,
                                           NodeOperationHash &h2,
                                           NodeOperationHash &h3)
@@ -151,4 +197,79 @@ TEST(NodeOperation, generate_hash)
   }
 }
 
+TEST(NodeOperation, generate_result_key)
+{
+  /* Constant input. */
+  {
+    NonHashedConstantOperation input_op(1);
+    HashedOperation op(input_op, 6, 4);
+    std::optional<uint64_t> key1 = op.generate_result_key();
+    EXPECT_NE(key1, std::nullopt);
+
+    input_op.set_constant(3.0f);
+    EXPECT_NE(key1, op.generate_result_key());
+    input_op.set_constant(1.0f);
+    EXPECT_EQ(key1, op.generate_result_key());
+  }
+
+  /* Non constant input. */
+  {
+    NonHashedOperation input_op1(1);
+    HashedOperation op1(input_op1, 6, 4);
+    EXPECT_EQ(op1.generate_result_key(), std::nullopt);
+
+    input_op1.set_result_key(5);
+    std::optional<uint64_t> key1 = op1.generate_result_key();
+    EXPECT_NE(key1, std::nullopt);
+
+    /* Unlike hashes, keys don't depend on the ids of the inputs. */
+    NonHashedOperation input_op2(2);
+    input_op2.set_result_key(5);
+    HashedOperation op2(input_op2, 6, 4);
+    EXPECT_EQ(key1, op2.generate_result_key());
+
+    input_op2.set_result_key(6);
+    EXPECT_NE(key1, op2.generate_result_key());
+
+    op1.set_param1(-1);
+    EXPECT_NE(key1, op1.generate_result_key());
+  }
+
+  /* Inputs order. */
+  {
+    NonHashedOperation input_op1(1);
+    NonHashedOperation input_op2(2);
+    TwoInputsOperation op(input_op1, input_op2);
+    input_op1.set_result_key(5);
+    input_op2.set_result_key(6);
+    std::optional<uint64_t> key1 = op.generate_result_key();
+
+    /* Swapped inputs. */
+    input_op1.set_result_key(6);
+    input_op2.set_result_key(5);
+    EXPECT_NE(key1, op.generate_result_key());
+
+    /* Equal inputs don't cancel out. */
+    input_op1.set_result_key(5);
+    input_op2.set_result_key(5);
+    std::optional<uint64_t> key2 = op.generate_result_key();
+    input_op1.set_result_key(6);
+    input_op2.set_result_key(6);
+    EXPECT_NE(key2, op.generate_result_key());
+  }
+
+  /* Data. */
+  {
+    DataHashedOperation op;
+    std::optional<uint64_t> key = op.generate_result_key();
+    EXPECT_NE(key, std::nullopt);
+    EXPECT_EQ(key, op.generate_result_key());
+
+    op.set_data_elem(1, 4.0f);
+    EXPECT_NE(key, op.generate_result_key());
+    op.set_data_elem(1, 2.0f);
+    EXPECT_EQ(key, op.generate_result_key());
+  }
+}
+
 }  // namespace blender::compositor::tests
@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_rect.h"
+
+#include "COM_MemoryBuffer.h"
+#include "COM_OperationResultCache.h"
+
+namespace blender::compositor::tests {
+
+constexpr int buffer_width = 4;
+constexpr int buffer_height = 4;
+constexpr int64_t buffer_bytes = sizeof(float) * buffer_width * buffer_height;
+
+static rcti create_area()
+{
+  rcti area;
+  BLI_rcti_init(&area, 0, buffer_width, 0, buffer_height);
+  return area;
+}
+
+static bool store_new_result(OperationResultCache &cache, const uint64_t key)
+{
+  const rcti area = create_area();
+  float *data = (float *)MEM_mallocN(buffer_bytes, __func__);
+  MemoryBuffer buffer(data, 1, area);
+  if (!cache.store_result(key, buffer, {area})) {
+    MEM_freeN(data);
+    return false;
+  }
+  return true;
+}
+
+static bool has_result(OperationResultCache &cache, const uint64_t key)
+{
+  const rcti area = create_area();
+  return cache.has_result(key, {area});
+}
+
+TEST(OperationResultCache, store_and_use)
+{
+  OperationResultCache cache;
+  EXPECT_FALSE(has_result(cache, 1));
+  EXPECT_TRUE(store_new_result(cache, 1));
+  EXPECT_TRUE(has_result(cache, 1));
+  EXPECT_EQ(cache.get_memory(), buffer_bytes);
+
+  /* Results are kept across executions even when unused. */
+  cache.execution_finished(false);
+  cache.execution_finished(false);
+  EXPECT_TRUE(has_result(cache, 1));
+
+  /* Larger areas than the stored ones are not available. */
+  rcti larger_area;
+  BLI_rcti_init(&larger_area, 0, buffer_width * 2, 0, buffer_height);
+  EXPECT_FALSE(cache.has_result(1, {larger_area}));
+
+  std::unique_ptr<MemoryBuffer> buffer = cache.use_result(1);
+  EXPECT_EQ(buffer->get_width(), buffer_width);
+  EXPECT_EQ(buffer->get_height(), buffer_height);
+  /* Used results can't be replaced during the execution. */
+  EXPECT_FALSE(store_new_result(cache, 1));
+
+  cache.clear();
+  EXPECT_FALSE(has_result(cache, 1));
+  EXPECT_EQ(cache.get_memory(), 0);
+}
+
+TEST(OperationResultCache, canceled_execution)
+{
+  OperationResultCache cache;
+  EXPECT_TRUE(store_new_result(cache, 1));
+  cache.execution_finished(false);
+
+  EXPECT_TRUE(store_new_result(cache, 2));
+  cache.use_result(1);
+  cache.execution_finished(true);
+  EXPECT_TRUE(has_result(cache, 1));
+  EXPECT_FALSE(has_result(cache, 2));
+  EXPECT_EQ(cache.get_memory(), buffer_bytes);
+}
+
+TEST(OperationResultCache, least_recently_used_eviction)
+{
+  OperationResultCache cache(buffer_bytes * 2);
+  EXPECT_TRUE(store_new_result(cache, 1));
+  cache.execution_finished(false);
+  EXPECT_TRUE(store_new_result(cache, 2));
+  cache.execution_finished(false);
+
+  /* Result 1 is used again, making result 2 the least recently used. */
+  cache.use_result(1);
+  cache.execution_finished(false);
+
+  EXPECT_TRUE(store_new_result(cache, 3));
+  EXPECT_TRUE(has_result(cache, 1));
+  EXPECT_FALSE(has_result(cache, 2));
+  EXPECT_TRUE(has_result(cache, 3));
+  EXPECT_EQ(cache.get_memory(), buffer_bytes * 2);
+
+  /* Results of the current execution are never evicted. */
+  cache.use_result(1);
+  EXPECT_FALSE(store_new_result(cache, 4));
+  EXPECT_TRUE(has_result(cache, 1));
+  EXPECT_TRUE(has_result(cache, 3));
+}
+
+}  // namespace blender::compositor::tests
@@ -0,0 +1,240 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later
+ * Copyright 2022 Blender Foundation. */
+
+#include "testing/testing.h"
+
+#include "BLI_map.hh"
+#include "BLI_rect.h"
+
+#include "DNA_node_types.h"
+
+#include "COM_CompositorContext.h"
+#include "COM_FusedPointwiseOperation.h"
+#include "COM_MathBaseOperation.h"
+#include "COM_MixOperation.h"
+#include "COM_NodeOperationBuilder.h"
+#include "COM_PointwiseOperationFuser.h"
+#include "COM_SetAlphaReplaceOperation.h"
+
+namespace blender::compositor::tests {
+
+/* Large enough for the fused operation to process the rows in several blocks. */
+constexpr int canvas_width = 256;
+constexpr int canvas_height = 64;
+
+/** Provides the inputs of the tested operations, it isn't executed itself. */
+class InputOperation : public NodeOperation {
+ public:
+  InputOperation(DataType data_type, const rcti &canvas)
+  {
+    add_output_socket(data_type);
+    set_canvas(canvas);
+  }
+};
+
+/**
+ * Gives access to #MultiThreadedOperation::update_memory_buffer_partial, which can't be called
+ * through a base class reference from a derived class. Its address can be taken through the
+ * derived class though.
+ */
+class PartialUpdateAccess : public MultiThreadedOperation {
+ public:
+  static void update(MultiThreadedOperation &operation,
+                     MemoryBuffer *output,
+                     Span<MemoryBuffer *> inputs)
+  {
+    const auto update_partial = &PartialUpdateAccess::update_memory_buffer_partial;
+    (operation.*update_partial)(output, output->get_rect(), inputs);
+  }
+};
+
+static rcti create_canvas(const int width)
+{
+  rcti canvas;
+  BLI_rcti_init(&canvas, 0, width, 0, canvas_height);
+  return canvas;
+}
+
+static void fill_buffer(MemoryBuffer &buffer, const float seed)
+{
+  const int64_t floats_num = int64_t(buffer.get_width()) * buffer.get_height() *
+                             buffer.get_num_channels();
+  float *data = buffer.get_buffer();
+  for (const int64_t i : IndexRange(floats_num)) {
+    data[i] = fmodf(seed * (i + 1), 1.0f);
+  }
+}
+
+static bool buffers_equal(MemoryBuffer &a, MemoryBuffer &b)
+{
+  const int64_t floats_num = int64_t(a.get_width()) * a.get_height() * a.get_num_channels();
+  return memcmp(a.get_buffer(), b.get_buffer(), sizeof(float) * floats_num) == 0;
+}
+
+/**
+ * `SetAlpha(Mix(Add(values_a, values_b), colors_a, colors_b), values_a)`, all three pointwise
+ * operations have a single reader.
+ */
+class PointwiseChain {
+ public:
+  bNodeTree node_tree = {};
+  CompositorContext context;
+  std::unique_ptr<NodeOperationBuilder> builder;
+
+  InputOperation *values_a;
+  InputOperation *values_b;
+  InputOperation *colors_a;
+  InputOperation *colors_b;
+  MathAddOperation *add;
+  MixBlendOperation *mix;
+  SetAlphaReplaceOperation *set_alpha;
+
+  PointwiseChain(const int add_width = canvas_width)
+  {
+    context.set_bnodetree(&node_tree);
+    context.set_rendering(false);
+    builder = std::make_unique<NodeOperationBuilder>(&context, &node_tree, nullptr);
+
+    const rcti canvas = create_canvas(canvas_width);
+    values_a = add_operation(new InputOperation(DataType::Value, canvas));
+    values_b = add_operation(new InputOperation(DataType::Value, canvas));
+    colors_a = add_operation(new InputOperation(DataType::Color, canvas));
+    colors_b = add_operation(new InputOperation(DataType::Color, canvas));
+    add = add_operation(new MathAddOperation());
+    add->set_canvas(create_canvas(add_width));
+    mix = add_operation(new MixBlendOperation());
+    mix->set_canvas(canvas);
+    set_alpha = add_operation(new SetAlphaReplaceOperation());
+    set_alpha->set_canvas(canvas);
+
+    link(values_a, add, 0);
+    link(values_b, add, 1);
+    link(values_b, add, 2);
+    link(add, mix, 0);
+    link(colors_a, mix, 1);
+    link(colors_b, mix, 2);
+    link(mix, set_alpha, 0);
+    link(values_a, set_alpha, 1);
+  }
+
+  ~PointwiseChain()
+  {
+    /* Fused operations are deleted by the operation fusing them. */
+    for (NodeOperation *operation : builder->get_operations()) {
+      delete operation;
+    }
+  }
+
+  template<typename T> T *add_operation(T *operation)
+  {
+    builder->add_operation(operation);
+    return operation;
+  }
+
+  void link(NodeOperation *from, NodeOperation *to, const int input_index)
+  {
+    builder->add_link(from->get_output_socket(), to->get_input_socket(input_index));
+  }
+
+  int fuse()
+  {
+    PointwiseOperationFuser fuser(*builder);
+    return fuser.fuse_operations();
+  }
+
+  /** The fused operation reading the output of the operations fused into it. */
+  FusedPointwiseOperation *find_fused_operation() const
+  {
+    for (NodeOperation *operation : builder->get_operations()) {
+      if (FusedPointwiseOperation *fused = dynamic_cast<FusedPointwiseOperation *>(operation)) {
+        return fused;
+      }
+    }
+    return nullptr;
+  }
+
+  bool contains(const NodeOperation *operation) const
+  {
+    return builder->get_operations().contains(const_cast<NodeOperation *>(operation));
+  }
+};
+
+TEST(PointwiseOperationFuser, fused_result_matches_unfused)
+{
+  PointwiseChain chain;
+  const rcti canvas = create_canvas(canvas_width);
+  MemoryBuffer values_a(DataType::Value, canvas);
+  MemoryBuffer values_b(DataType::Value, canvas);
+  MemoryBuffer colors_a(DataType::Color, canvas);
+  MemoryBuffer colors_b(DataType::Color, canvas);
+  fill_buffer(values_a, 0.37f);
+  fill_buffer(values_b, 0.61f);
+  fill_buffer(colors_a, 0.13f);
+  fill_buffer(colors_b, 0.89f);
+
+  /* Execute every operation on its own, with full-frame intermediate buffers. */
+  MemoryBuffer add_result(DataType::Value, canvas);
+  PartialUpdateAccess::update(*chain.add, &add_result, {&values_a, &values_b, &values_b});
+  MemoryBuffer mix_result(DataType::Color, canvas);
+  PartialUpdateAccess::update(*chain.mix, &mix_result, {&add_result, &colors_a, &colors_b});
+  MemoryBuffer expected(DataType::Color, canvas);
+  PartialUpdateAccess::update(*chain.set_alpha, &expected, {&mix_result, &values_a});
+
+  EXPECT_EQ(chain.fuse(), 1);
+  FusedPointwiseOperation *fused = chain.find_fused_operation();
+  ASSERT_NE(fused, nullptr);
+  EXPECT_EQ(fused->get_number_of_fused_operations(), 3);
+  EXPECT_FALSE(chain.contains(chain.add));
+  EXPECT_FALSE(chain.contains(chain.mix));
+  EXPECT_FALSE(chain.contains(chain.set_alpha));
+
+  Map<const NodeOperation *, MemoryBuffer *> input_buffers;
+  input_buffers.add_new(chain.values_a, &values_a);
+  input_buffers.add_new(chain.values_b, &values_b);
+  input_buffers.add_new(chain.colors_a, &colors_a);
+  input_buffers.add_new(chain.colors_b, &colors_b);
+  Vector<MemoryBuffer *> inputs;
+  for (const NodeOperationOutput *input_link : fused->get_input_links()) {
+    inputs.append(input_buffers.lookup(&input_link->get_operation()));
+  }
+  /* Inputs linked to the same output are only read once. */
+  EXPECT_EQ(inputs.size(), 4);
+
+  MemoryBuffer result(DataType::Color, canvas);
+  PartialUpdateAccess::update(*fused, &result, inputs);
+  EXPECT_TRUE(buffers_equal(result, expected));
+}
+
+TEST(PointwiseOperationFuser, intermediate_with_two_readers_not_fused)
+{
+  PointwiseChain chain;
+  SetAlphaReplaceOperation *second_reader = chain.add_operation(new SetAlphaReplaceOperation());
+  second_reader->set_canvas(create_canvas(canvas_width));
+  chain.link(chain.mix, second_reader, 0);
+  chain.link(chain.values_b, second_reader, 1);
+
+  /* Only the add operation is fused into the mix operation, which both readers read. */
+  EXPECT_EQ(chain.fuse(), 1);
+  FusedPointwiseOperation *fused = chain.find_fused_operation();
+  ASSERT_NE(fused, nullptr);
+  EXPECT_EQ(fused->get_number_of_fused_operations(), 2);
+  EXPECT_TRUE(chain.contains(chain.set_alpha));
+  EXPECT_TRUE(chain.contains(second_reader));
+  EXPECT_EQ(chain.set_alpha->get_input_operation(0), fused);
+  EXPECT_EQ(second_reader->get_input_operation(0), fused);
+}
+
+TEST(PointwiseOperationFuser, intermediate_with_different_canvas_not_fused)
+{
+  PointwiseChain chain(canvas_width / 2);
+
+  /* Only the mix operation is fused into the set alpha operation. */
+  EXPECT_EQ(chain.fuse(), 1);
+  FusedPointwiseOperation *fused = chain.find_fused_operation();
+  ASSERT_NE(fused, nullptr);
+  EXPECT_EQ(fused->get_number_of_fused_operations(), 2);
+  EXPECT_TRUE(chain.contains(chain.add));
+  EXPECT_EQ(fused->get_input_links().first(), chain.add->get_output_socket());
+}
+
+}  // namespace blender::compositor::tests
@@ -9,3 +9,4 @@
 struct wmOperatorType;
 
 void WM_OT_obj_export(struct wmOperatorType *ot);
+void WM_OT_obj_import(struct wmOperatorType *ot);
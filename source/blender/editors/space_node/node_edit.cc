@@ -26,6 +26,7 @@
 #include "BKE_node_tree_update.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
+#include "BKE_screen.h"
 #include "BKE_workspace.h"
 
 #include "DEG_depsgraph.h"
@@ -80,6 +81,9 @@ struct CompoJob {
   ViewLayer *view_layer;
   bNodeTree *ntree;
   int recalc_flags;
+  /** Part of the viewer image to compute, see #compo_get_viewer_visible_area. */
+  bool use_viewer_visible_area;
+  rctf viewer_visible_area;
   /* Evaluated state/ */
   Depsgraph *compositor_depsgraph;
   bNodeTree *localtree;
@@ -161,6 +165,72 @@ static int compo_get_recalc_flags(const bContext *C)
   return recalc_flags;
 }
 
+/**
+ * Get the normalized part of the viewer image that is visible in the backdrop of the node
+ * editors showing \a nodetree. The editors store it, to composite again when other parts
+ * become visible.
+ * \return False when the whole image is needed, because it is displayed in an image editor or
+ * in no backdrop at all.
+ */
+static bool compo_get_viewer_visible_area(const bContext *C,
+                                          const bNodeTree *nodetree,
+                                          rctf *r_area)
+{
+  wmWindowManager *wm = CTX_wm_manager(C);
+  Image *ima = BKE_image_ensure_viewer(CTX_data_main(C), IMA_TYPE_COMPOSITE, "Viewer Node");
+  void *lock;
+  ImBuf *ibuf = BKE_image_acquire_ibuf(ima, nullptr, &lock);
+  const int2 image_size = ibuf ? int2(ibuf->x, ibuf->y) : int2(0);
+  BKE_image_release_ibuf(ima, ibuf, lock);
+
+  bool use_area = true;
+  bool has_area = false;
+  Vector<SpaceNode *> backdrop_editors;
+  LISTBASE_FOREACH (wmWindow *, win, &wm->windows) {
+    const bScreen *screen = WM_window_get_active_screen(win);
+
+    LISTBASE_FOREACH (ScrArea *, area, &screen->areabase) {
+      if (area->spacetype == SPACE_IMAGE) {
+        const SpaceImage *sima = (const SpaceImage *)area->spacedata.first;
+        if (sima->image && sima->image->type == IMA_TYPE_COMPOSITE) {
+          use_area = false;
+        }
+      }
+      else if (area->spacetype == SPACE_NODE) {
+        SpaceNode *snode = (SpaceNode *)area->spacedata.first;
+        const ARegion *region = BKE_area_find_region_type(area, RGN_TYPE_WINDOW);
+        if (snode->nodetree != nodetree || !(snode->flag & SNODE_BACKDRAW) ||
+            snode->runtime == nullptr || region == nullptr) {
+          continue;
+        }
+        backdrop_editors.append(snode);
+        rctf snode_area;
+        if (!snode_bg_visible_area_get(*snode, *region, image_size, snode_area)) {
+          continue;
+        }
+        if (has_area) {
+          BLI_rctf_union(r_area, &snode_area);
+        }
+        else {
+          *r_area = snode_area;
+          has_area = true;
+        }
+      }
+    }
+  }
+
+  use_area = use_area && has_area;
+  for (SpaceNode *snode : backdrop_editors) {
+    if (use_area) {
+      snode->runtime->viewer_composited_area = *r_area;
+    }
+    else {
+      BLI_rctf_init(&snode->runtime->viewer_composited_area, 0.0f, 0.0f, 0.0f, 0.0f);
+    }
+  }
+  return use_area;
+}
+
 /* called by compo, only to check job 'stop' value */
 static int compo_breakjob(void *cjv)
 {
@@ -273,16 +343,19 @@ static void compo_startjob(void *cjv,
 
   // XXX BIF_store_spare();
   /* 1 is do_previews */
+  const rctf *viewer_visible_area = cj->use_viewer_visible_area ? &cj->viewer_visible_area :
+                                                                  nullptr;
 
   if ((cj->scene->r.scemode & R_MULTIVIEW) == 0) {
-    ntreeCompositExecTree(cj->scene, ntree, &cj->scene->r, false, true, "");
+    ntreeCompositExecTree(cj->scene, ntree, &cj->scene->r, false, true, "", viewer_visible_area);
   }
   else {
     LISTBASE_FOREACH (SceneRenderView *, srv, &scene->r.views) {
       if (BKE_scene_multiview_is_render_view_active(&scene->r, srv) == false) {
         continue;
       }
-      ntreeCompositExecTree(cj->scene, ntree, &cj->scene->r, false, true, srv->name);
+      ntreeCompositExecTree(
+          cj->scene, ntree, &cj->scene->r, false, true, srv->name, viewer_visible_area);
     }
   }
 
@@ -327,6 +400,8 @@ void ED_node_composite_job(const bContext *C, struct bNodeTree *nodetree, Scene
   cj->view_layer = view_layer;
   cj->ntree = nodetree;
   cj->recalc_flags = compo_get_recalc_flags(C);
+  cj->use_viewer_visible_area = compo_get_viewer_visible_area(
+      C, nodetree, &cj->viewer_visible_area);
 
   /* setup job */
   WM_jobs_customdata_set(wm_job, cj, compo_freejob);
@@ -77,6 +77,14 @@ struct SpaceNode_Runtime {
   /** For auto compositing. */
   bool recalc;
 
+  /**
+   * Normalized part of the viewer image computed by the last compositor execution, empty when
+   * the whole image was computed. See #ED_node_composite_job.
+   */
+  rctf viewer_composited_area = {0.0f, 0.0f, 0.0f, 0.0f};
+  /** Size of the main region when the visible part of the backdrop was last checked. */
+  int2 backdrop_region_size = int2(0);
+
   /** Temporary data for modal linking operator. */
   std::unique_ptr<bNodeLinkDrag> linkdrag;
 
@@ -179,6 +187,19 @@ bool space_node_view_flag(
 void NODE_OT_view_all(wmOperatorType *ot);
 void NODE_OT_view_selected(wmOperatorType *ot);
 
+/**
+ * Get the normalized part of an image of \a image_size that is visible in the backdrop.
+ * \return False when the image is out of view.
+ */
+bool snode_bg_visible_area_get(const SpaceNode &snode,
+                               const ARegion &region,
+                               const int2 &image_size,
+                               rctf &r_area);
+/**
+ * Composite again when parts of the viewer image that were not computed become visible in the
+ * backdrop, e.g. after moving or zooming it, or resizing the region.
+ */
+void snode_bg_visible_area_check(const bContext &C, SpaceNode &snode, const ARegion &region);
 void NODE_OT_backimage_move(wmOperatorType *ot);
 void NODE_OT_backimage_zoom(wmOperatorType *ot);
 void NODE_OT_backimage_fit(wmOperatorType *ot);
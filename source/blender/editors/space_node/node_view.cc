@@ -181,6 +181,56 @@ struct NodeViewMove {
   int xmin, ymin, xmax, ymax;
 };
 
+bool snode_bg_visible_area_get(const SpaceNode &snode,
+                               const ARegion &region,
+                               const int2 &image_size,
+                               rctf &r_area)
+{
+  const float bufx = image_size.x * snode.zoom;
+  const float bufy = image_size.y * snode.zoom;
+  if (bufx <= 0.0f || bufy <= 0.0f) {
+    return false;
+  }
+
+  /* Region corners in normalized backdrop coordinates, see #ED_space_node_color_sample. */
+  r_area.xmin = max_ff((-0.5f * region.winx - snode.xof) / bufx + 0.5f, 0.0f);
+  r_area.xmax = min_ff((0.5f * region.winx - snode.xof) / bufx + 0.5f, 1.0f);
+  r_area.ymin = max_ff((-0.5f * region.winy - snode.yof) / bufy + 0.5f, 0.0f);
+  r_area.ymax = min_ff((0.5f * region.winy - snode.yof) / bufy + 0.5f, 1.0f);
+  return !BLI_rctf_is_empty(&r_area);
+}
+
+void snode_bg_visible_area_check(const bContext &C, SpaceNode &snode, const ARegion &region)
+{
+  const rctf &composited_area = snode.runtime->viewer_composited_area;
+  if (BLI_rctf_is_empty(&composited_area)) {
+    /* The whole viewer image was computed. */
+    return;
+  }
+
+  Main *bmain = CTX_data_main(&C);
+  Image *ima = BKE_image_ensure_viewer(bmain, IMA_TYPE_COMPOSITE, "Viewer Node");
+  void *lock;
+  ImBuf *ibuf = BKE_image_acquire_ibuf(ima, nullptr, &lock);
+  if (ibuf == nullptr) {
+    BKE_image_release_ibuf(ima, ibuf, lock);
+    return;
+  }
+  const int2 image_size(ibuf->x, ibuf->y);
+  BKE_image_release_ibuf(ima, ibuf, lock);
+
+  rctf area;
+  if (!snode_bg_visible_area_get(snode, region, image_size, area)) {
+    /* Nothing more is needed while the image is out of view. */
+    return;
+  }
+  if (!BLI_rctf_inside_rctf(&composited_area, &area)) {
+    /* Composite again, computing the area visible in all backdrops, see
+     * #ED_node_composite_job. */
+    ED_area_tag_refresh(CTX_wm_area(&C));
+  }
+}
+
 static int snode_bg_viewmove_modal(bContext *C, wmOperator *op, const wmEvent *event)
 {
   SpaceNode *snode = CTX_wm_space_node(C);
@@ -211,6 +261,7 @@ static int snode_bg_viewmove_modal(bContext *C, wmOperator *op, const wmEvent *e
       if (event->val == KM_RELEASE) {
         MEM_freeN(nvm);
         op->customdata = nullptr;
+        snode_bg_visible_area_check(*C, *snode, *region);
         return OPERATOR_FINISHED;
       }
       break;
@@ -293,6 +344,7 @@ static int backimage_zoom_exec(bContext *C, wmOperator *op)
   float fac = RNA_float_get(op->ptr, "factor");
 
   snode->zoom *= fac;
+  snode_bg_visible_area_check(*C, *snode, *region);
   ED_region_tag_redraw(region);
   WM_main_add_notifier(NC_NODE | ND_DISPLAY, nullptr);
   WM_main_add_notifier(NC_SPACE | ND_SPACE_NODE_VIEW, nullptr);
@@ -357,6 +409,7 @@ static int backimage_fit_exec(bContext *C, wmOperator *UNUSED(op))
 
   snode->xof = 0;
   snode->yof = 0;
+  snode_bg_visible_area_check(*C, *snode, *region);
 
   ED_region_tag_redraw(region);
   WM_main_add_notifier(NC_NODE | ND_DISPLAY, nullptr);
@@ -600,6 +600,15 @@ static void node_main_region_init(wmWindowManager *wm, ARegion *region)
 
 static void node_main_region_draw(const bContext *C, ARegion *region)
 {
+  SpaceNode *snode = CTX_wm_space_node(C);
+  const int2 region_size(region->winx, region->winy);
+  if (snode->runtime->backdrop_region_size != region_size) {
+    /* Parts of the viewer image that were not computed may become visible in a larger region. */
+    snode->runtime->backdrop_region_size = region_size;
+    if (snode->flag & SNODE_BACKDRAW) {
+      snode_bg_visible_area_check(*C, *snode, *region);
+    }
+  }
   node_draw_space(*C, *region);
 }
 
@@ -302,6 +302,24 @@ class FieldContext {
                                        ResourceScope &scope) const;
 };
 
+/**
+ * Information about the optimizations that have been applied to the field trees when they were
+ * compiled into procedures for evaluation.
+ */
+struct FieldEvaluationStatistics {
+  /**
+   * Operations and constants that were skipped because a structurally equal node exists in the
+   * same field tree (common sub-expression elimination). Such duplicates are common when the same
+   * node group is used multiple times.
+   */
+  int deduplicated_nodes = 0;
+  /**
+   * Operations that don't depend on varying inputs but are used by varying operations. They are
+   * evaluated only once before the main procedure is executed (constant folding).
+   */
+  int folded_constants = 0;
+};
+
 /**
  * Utility class that makes it easier to evaluate fields.
  */
@@ -326,6 +344,8 @@ class FieldEvaluator : NonMovable, NonCopyable {
   Field<bool> selection_field_;
   IndexMask selection_mask_;
 
+  FieldEvaluationStatistics statistics_;
+
  public:
   /** Takes #mask by pointer because the mask has to live longer than the evaluator. */
   FieldEvaluator(const FieldContext &context, const IndexMask *mask)
@@ -436,6 +456,13 @@ class FieldEvaluator : NonMovable, NonCopyable {
    * some cases, so it must live at least as long as the returned mask.
    */
   IndexMask get_evaluated_as_mask(int field_index);
+
+  /** Optimizations that were applied when the fields and the selection were evaluated. */
+  const FieldEvaluationStatistics &statistics() const
+  {
+    BLI_assert(is_evaluated_);
+    return statistics_;
+  }
 };
 
 /**
@@ -453,6 +480,7 @@ class FieldEvaluator : NonMovable, NonCopyable {
  *   instead of into newly created ones. That allows making the computed data live longer than
  *   #scope and is more efficient when the data will be written into those virtual arrays
  *   later anyway.
+ * \param r_statistics: If provided, information about the optimized field tree is added to it.
  * \return The computed virtual arrays for each provided field. If #dst_varrays is passed, the
  *   provided virtual arrays are returned.
  */
@@ -460,7 +488,8 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
                                 Span<GFieldRef> fields_to_evaluate,
                                 IndexMask mask,
                                 const FieldContext &context,
-                                Span<GVMutableArray> dst_varrays = {});
+                                Span<GVMutableArray> dst_varrays = {},
+                                FieldEvaluationStatistics *r_statistics = nullptr);
 
 /* -------------------------------------------------------------------- */
 /** \name Utility functions for simple field creation and evaluation
@@ -10,14 +10,30 @@
 
 namespace blender::fn {
 
-/** A multi-function that executes a procedure internally. */
+/**
+ * A multi-function that executes a procedure internally.
+ *
+ * Large masks are processed in chunks. The entire procedure is executed for one chunk before
+ * the next chunk is started. That way the intermediate values of long chains of cheap functions
+ * (e.g. math nodes) are kept in small buffers that stay in the CPU cache, instead of being
+ * written to and read from arrays that are as large as the entire mask.
+ */
 class MFProcedureExecutor : public MultiFunction {
+ public:
+  /**
+   * Chunks have to be large enough so that the per-instruction overhead of the executor is
+   * negligible, but small enough so that the buffers of a few variables fit into the cache.
+   */
+  static constexpr int64_t default_chunk_size = 8192;
+
  private:
   MFSignature signature_;
   const MFProcedure &procedure_;
+  /** Number of indices processed at once. Zero means that the entire mask is processed at once. */
+  int64_t chunk_size_;
 
  public:
-  MFProcedureExecutor(const MFProcedure &procedure);
+  MFProcedureExecutor(const MFProcedure &procedure, int64_t chunk_size = default_chunk_size);
 
   void call(IndexMask mask, MFParams params, MFContext context) const override;
 
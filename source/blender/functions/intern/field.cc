@@ -19,10 +19,16 @@ namespace blender::fn {
  */
 
 struct FieldTreeInfo {
+  /**
+   * Structurally equal nodes may exist multiple times in the field tree, e.g. when the same node
+   * group is used more than once. All those nodes are mapped to the same node here, so that they
+   * are only computed once. Every node in the field tree is in this map.
+   */
+  Map<const FieldNode *, const FieldNode *> deduplicated_nodes;
   /**
    * When fields are built, they only have references to the fields that they depend on. This map
    * allows traversal of fields in the opposite direction. So for every field it stores the other
-   * fields that depend on it directly.
+   * fields that depend on it directly. Only contains deduplicated fields.
    */
   MultiValueMap<GFieldRef, GFieldRef> field_users;
   /**
@@ -30,19 +36,149 @@ struct FieldTreeInfo {
    * the tree is constructed. This set contains every different input only once.
    */
   VectorSet<std::reference_wrapper<const FieldInput>> deduplicated_field_inputs;
+  /** Number of nodes that have been replaced by a structurally equal node. */
+  int deduplicated_nodes_num = 0;
+
+  /** Get the field that is computed instead of the given field. */
+  GFieldRef deduplicated(const GFieldRef field) const
+  {
+    return {*deduplicated_nodes.lookup(&field.node()), field.node_output_index()};
+  }
+};
+
+/**
+ * Identifies a field node by what it computes. The inputs of operations are expected to be
+ * deduplicated already, so that comparing two keys does not have to traverse the entire tree.
+ */
+struct FieldNodeKey {
+  const FieldNode *node;
+  /** Deduplicated inputs, only used for operations. */
+  Span<GFieldRef> inputs;
+
+  uint64_t hash() const
+  {
+    switch (node->node_type()) {
+      case FieldNodeType::Input: {
+        return node->hash();
+      }
+      case FieldNodeType::Operation: {
+        const FieldOperation &operation = static_cast<const FieldOperation &>(*node);
+        uint64_t hash = operation.multi_function().hash();
+        for (const GFieldRef &input : inputs) {
+          hash = get_default_hash_2(hash, input);
+        }
+        return hash;
+      }
+      case FieldNodeType::Constant: {
+        const FieldConstant &constant = static_cast<const FieldConstant &>(*node);
+        const GPointer value = constant.value();
+        return value.type()->hash_or_fallback(value.get(), get_default_hash(node));
+      }
+    }
+    BLI_assert_unreachable();
+    return 0;
+  }
+
+  friend bool operator==(const FieldNodeKey &a, const FieldNodeKey &b)
+  {
+    if (a.node == b.node) {
+      return true;
+    }
+    if (a.node->node_type() != b.node->node_type()) {
+      return false;
+    }
+    switch (a.node->node_type()) {
+      case FieldNodeType::Input: {
+        return *a.node == *b.node;
+      }
+      case FieldNodeType::Operation: {
+        const MultiFunction &fn_a = static_cast<const FieldOperation &>(*a.node).multi_function();
+        const MultiFunction &fn_b = static_cast<const FieldOperation &>(*b.node).multi_function();
+        if (&fn_a != &fn_b && !fn_a.equals(fn_b)) {
+          return false;
+        }
+        return a.inputs == b.inputs;
+      }
+      case FieldNodeType::Constant: {
+        const GPointer value_a = static_cast<const FieldConstant &>(*a.node).value();
+        const GPointer value_b = static_cast<const FieldConstant &>(*b.node).value();
+        if (value_a.type() != value_b.type()) {
+          return false;
+        }
+        return value_a.type()->is_equal_or_false(value_a.get(), value_b.get());
+      }
+    }
+    BLI_assert_unreachable();
+    return false;
+  }
 };
 
+/**
+ * Map every node in the field tree to a representative of all structurally equal nodes. The tree
+ * is traversed bottom-up, so that the inputs of a node are deduplicated before the node itself.
+ */
+static void deduplicate_field_nodes(Span<GFieldRef> entry_fields, FieldTreeInfo &field_tree_info)
+{
+  /* Owns the deduplicated inputs that are referenced by the keys. */
+  LinearAllocator<> allocator;
+  Map<FieldNodeKey, const FieldNode *> node_by_key;
+  Stack<const FieldNode *> nodes_to_check;
+
+  for (const GFieldRef &field : entry_fields) {
+    nodes_to_check.push(&field.node());
+  }
+
+  while (!nodes_to_check.is_empty()) {
+    const FieldNode &field_node = *nodes_to_check.peek();
+    if (field_tree_info.deduplicated_nodes.contains(&field_node)) {
+      nodes_to_check.pop();
+      continue;
+    }
+    FieldNodeKey key{&field_node, {}};
+    if (field_node.node_type() == FieldNodeType::Operation) {
+      const FieldOperation &operation = static_cast<const FieldOperation &>(field_node);
+      const Span<GField> operation_inputs = operation.inputs();
+      bool all_inputs_handled = true;
+      for (const GField &input : operation_inputs) {
+        if (!field_tree_info.deduplicated_nodes.contains(&input.node())) {
+          nodes_to_check.push(&input.node());
+          all_inputs_handled = false;
+        }
+      }
+      if (!all_inputs_handled) {
+        continue;
+      }
+      MutableSpan<GFieldRef> inputs = allocator.construct_array<GFieldRef>(
+          operation_inputs.size());
+      for (const int i : operation_inputs.index_range()) {
+        inputs[i] = field_tree_info.deduplicated(operation_inputs[i]);
+      }
+      key.inputs = inputs;
+    }
+    nodes_to_check.pop();
+
+    const FieldNode *deduplicated_node = node_by_key.lookup_or_add(key, &field_node);
+    if (deduplicated_node != &field_node && field_node.node_type() != FieldNodeType::Input) {
+      /* Separate input nodes are deduplicated by #deduplicated_field_inputs already. */
+      field_tree_info.deduplicated_nodes_num++;
+    }
+    field_tree_info.deduplicated_nodes.add_new(&field_node, deduplicated_node);
+  }
+}
+
 /**
  * Collects some information from the field tree that is required by later steps.
  */
 static FieldTreeInfo preprocess_field_tree(Span<GFieldRef> entry_fields)
 {
   FieldTreeInfo field_tree_info;
+  deduplicate_field_nodes(entry_fields, field_tree_info);
 
   Stack<GFieldRef> fields_to_check;
   Set<GFieldRef> handled_fields;
 
   for (GFieldRef field : entry_fields) {
+    field = field_tree_info.deduplicated(field);
     if (handled_fields.add(field)) {
       fields_to_check.push(field);
     }
@@ -60,9 +196,10 @@ static FieldTreeInfo preprocess_field_tree(Span<GFieldRef> entry_fields)
       case FieldNodeType::Operation: {
         const FieldOperation &operation = static_cast<const FieldOperation &>(field_node);
         for (const GFieldRef operation_input : operation.inputs()) {
-          field_tree_info.field_users.add(operation_input, field);
-          if (handled_fields.add(operation_input)) {
-            fields_to_check.push(operation_input);
+          const GFieldRef input_field = field_tree_info.deduplicated(operation_input);
+          field_tree_info.field_users.add(input_field, field);
+          if (handled_fields.add(input_field)) {
+            fields_to_check.push(input_field);
           }
         }
         break;
@@ -138,11 +275,15 @@ static Set<GFieldRef> find_varying_fields(const FieldTreeInfo &field_tree_info,
 
 /**
  * Builds the #procedure so that it computes the fields.
+ * \param folded_values: Values of fields that have been computed already. They are used as
+ *   constants in the procedure.
  */
-static void build_multi_function_procedure_for_fields(MFProcedure &procedure,
-                                                      ResourceScope &scope,
-                                                      const FieldTreeInfo &field_tree_info,
-                                                      Span<GFieldRef> output_fields)
+static void build_multi_function_procedure_for_fields(
+    MFProcedure &procedure,
+    ResourceScope &scope,
+    const FieldTreeInfo &field_tree_info,
+    Span<GFieldRef> output_fields,
+    const Map<GFieldRef, GPointer> &folded_values = {})
 {
   MFProcedureBuilder builder{procedure};
   /* Every input, intermediate and output field corresponds to a variable in the procedure. */
@@ -174,6 +315,13 @@ static void build_multi_function_procedure_for_fields(MFProcedure &procedure,
         fields_to_check.pop();
         continue;
       }
+      if (const GPointer *folded_value = folded_values.lookup_ptr(field)) {
+        const MultiFunction &fn = procedure.construct_function<CustomMF_GenericConstant>(
+            *folded_value->type(), folded_value->get(), false);
+        MFVariable &new_variable = *builder.add_call<1>(fn)[0];
+        variable_by_field.add_new(field, &new_variable);
+        continue;
+      }
       const FieldNode &field_node = field.node();
       switch (field_node.node_type()) {
         case FieldNodeType::Input: {
@@ -187,7 +335,8 @@ static void build_multi_function_procedure_for_fields(MFProcedure &procedure,
           if (field_with_index.current_input_index < operation_inputs.size()) {
             /* Not all inputs are handled yet. Push the next input field to the stack and increment
              * the input index. */
-            fields_to_check.push({operation_inputs[field_with_index.current_input_index]});
+            fields_to_check.push({field_tree_info.deduplicated(
+                operation_inputs[field_with_index.current_input_index])});
             field_with_index.current_input_index++;
           }
           else {
@@ -202,7 +351,8 @@ static void build_multi_function_procedure_for_fields(MFProcedure &procedure,
               const MFParamType param_type = multi_function.param_type(param_index);
               const MFParamType::InterfaceType interface_type = param_type.interface_type();
               if (interface_type == MFParamType::Input) {
-                const GField &input_field = operation_inputs[param_input_index];
+                const GFieldRef input_field = field_tree_info.deduplicated(
+                    operation_inputs[param_input_index]);
                 variables[param_index] = variable_by_field.lookup(input_field);
                 param_input_index++;
               }
@@ -277,7 +427,8 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
                                 Span<GFieldRef> fields_to_evaluate,
                                 IndexMask mask,
                                 const FieldContext &context,
-                                Span<GVMutableArray> dst_varrays)
+                                Span<GVMutableArray> dst_varrays,
+                                FieldEvaluationStatistics *r_statistics)
 {
   Vector<GVArray> r_varrays(fields_to_evaluate.size());
   Array<bool> is_output_written_to_dst(fields_to_evaluate.size(), false);
@@ -307,13 +458,19 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
   /* Traverse the field tree and prepare some data that is used in later steps. */
   FieldTreeInfo field_tree_info = preprocess_field_tree(fields_to_evaluate);
 
+  /* Only the deduplicated fields are used below. */
+  Array<GFieldRef> deduplicated_fields(fields_to_evaluate.size());
+  for (const int i : fields_to_evaluate.index_range()) {
+    deduplicated_fields[i] = field_tree_info.deduplicated(fields_to_evaluate[i]);
+  }
+
   /* Get inputs that will be passed into the field when evaluated. */
   Vector<GVArray> field_context_inputs = get_field_context_inputs(
       scope, mask, context, field_tree_info.deduplicated_field_inputs);
 
   /* Finish fields that don't need any processing directly. */
   for (const int out_index : fields_to_evaluate.index_range()) {
-    const GFieldRef &field = fields_to_evaluate[out_index];
+    const GFieldRef &field = deduplicated_fields[out_index];
     const FieldNode &field_node = field.node();
     switch (field_node.node_type()) {
       case FieldNodeType::Input: {
@@ -349,7 +506,7 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
       /* Already done. */
       continue;
     }
-    GFieldRef field = fields_to_evaluate[i];
+    GFieldRef field = deduplicated_fields[i];
     if (varying_fields.contains(field)) {
       varying_fields_to_evaluate.append(field);
       varying_field_indices.append(i);
@@ -360,12 +517,73 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
     }
   }
 
+  /* Operations that don't vary but are used by varying operations are evaluated only once before
+   * the varying procedure, which then uses their values as constants (constant folding). */
+  VectorSet<GFieldRef> fields_to_fold;
+  if (!varying_fields_to_evaluate.is_empty()) {
+    for (const GFieldRef &field : varying_fields) {
+      const FieldOperation &operation = static_cast<const FieldOperation &>(field.node());
+      for (const GField &input : operation.inputs()) {
+        const GFieldRef input_field = field_tree_info.deduplicated(input);
+        if (input_field.node().node_type() == FieldNodeType::Operation &&
+            !varying_fields.contains(input_field)) {
+          fields_to_fold.add(input_field);
+        }
+      }
+    }
+  }
+  Map<GFieldRef, GPointer> folded_values;
+
+  /* Evaluate constant fields if necessary. */
+  if (!constant_fields_to_evaluate.is_empty() || !fields_to_fold.is_empty()) {
+    /* Build the procedure for those fields. */
+    Vector<GFieldRef> fields_to_compute = constant_fields_to_evaluate;
+    fields_to_compute.extend(fields_to_fold.as_span());
+    MFProcedure procedure;
+    build_multi_function_procedure_for_fields(
+        procedure, scope, field_tree_info, fields_to_compute);
+    MFProcedureExecutor procedure_executor{procedure};
+    MFParamsBuilder mf_params{procedure_executor, 1};
+    MFContextBuilder mf_context;
+
+    /* Provide inputs to the procedure executor. */
+    for (const GVArray &varray : field_context_inputs) {
+      mf_params.add_readonly_single_input(varray);
+    }
+
+    for (const int i : fields_to_compute.index_range()) {
+      const GFieldRef &field = fields_to_compute[i];
+      const CPPType &type = field.cpp_type();
+      /* Allocate memory where the computed value will be stored in. */
+      void *buffer = scope.linear_allocator().allocate(type.size(), type.alignment());
+
+      if (!type.is_trivially_destructible()) {
+        /* Destruct value in the end. */
+        scope.add_destruct_call([buffer, &type]() { type.destruct(buffer); });
+      }
+
+      /* Pass output buffer to the procedure executor. */
+      mf_params.add_uninitialized_single_output({type, buffer, 1});
+
+      if (i < constant_fields_to_evaluate.size()) {
+        /* Create virtual array that can be used after the procedure has been executed below. */
+        const int out_index = constant_field_indices[i];
+        r_varrays[out_index] = GVArray::ForSingleRef(type, array_size, buffer);
+      }
+      else {
+        folded_values.add_new(field, {type, buffer});
+      }
+    }
+
+    procedure_executor.call(IndexRange(1), mf_params, mf_context);
+  }
+
   /* Evaluate varying fields if necessary. */
   if (!varying_fields_to_evaluate.is_empty()) {
     /* Build the procedure for those fields. */
     MFProcedure procedure;
     build_multi_function_procedure_for_fields(
-        procedure, scope, field_tree_info, varying_fields_to_evaluate);
+        procedure, scope, field_tree_info, varying_fields_to_evaluate, folded_values);
     MFProcedureExecutor procedure_executor{procedure};
 
     MFParamsBuilder mf_params{procedure_executor, &mask};
@@ -412,43 +630,6 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
     procedure_executor.call_auto(mask, mf_params, mf_context);
   }
 
-  /* Evaluate constant fields if necessary. */
-  if (!constant_fields_to_evaluate.is_empty()) {
-    /* Build the procedure for those fields. */
-    MFProcedure procedure;
-    build_multi_function_procedure_for_fields(
-        procedure, scope, field_tree_info, constant_fields_to_evaluate);
-    MFProcedureExecutor procedure_executor{procedure};
-    MFParamsBuilder mf_params{procedure_executor, 1};
-    MFContextBuilder mf_context;
-
-    /* Provide inputs to the procedure executor. */
-    for (const GVArray &varray : field_context_inputs) {
-      mf_params.add_readonly_single_input(varray);
-    }
-
-    for (const int i : constant_fields_to_evaluate.index_range()) {
-      const GFieldRef &field = constant_fields_to_evaluate[i];
-      const CPPType &type = field.cpp_type();
-      /* Allocate memory where the computed value will be stored in. */
-      void *buffer = scope.linear_allocator().allocate(type.size(), type.alignment());
-
-      if (!type.is_trivially_destructible()) {
-        /* Destruct value in the end. */
-        scope.add_destruct_call([buffer, &type]() { type.destruct(buffer); });
-      }
-
-      /* Pass output buffer to the procedure executor. */
-      mf_params.add_uninitialized_single_output({type, buffer, 1});
-
-      /* Create virtual array that can be used after the procedure has been executed below. */
-      const int out_index = constant_field_indices[i];
-      r_varrays[out_index] = GVArray::ForSingleRef(type, array_size, buffer);
-    }
-
-    procedure_executor.call(IndexRange(1), mf_params, mf_context);
-  }
-
   /* Copy data to supplied destination arrays if necessary. In some cases the evaluation above
    * has written the computed data in the right place already. */
   if (!dst_varrays.is_empty()) {
@@ -481,6 +662,11 @@ Vector<GVArray> evaluate_fields(ResourceScope &scope,
       r_varrays[out_index] = dst_varray;
     }
   }
+
+  if (r_statistics != nullptr) {
+    r_statistics->deduplicated_nodes += field_tree_info.deduplicated_nodes_num;
+    r_statistics->folded_constants += fields_to_fold.size();
+  }
   return r_varrays;
 }
 
@@ -752,11 +938,13 @@ int FieldEvaluator::add(GField field)
 static IndexMask evaluate_selection(const Field<bool> &selection_field,
                                     const FieldContext &context,
                                     IndexMask full_mask,
-                                    ResourceScope &scope)
+                                    ResourceScope &scope,
+                                    FieldEvaluationStatistics *r_statistics)
 {
   if (selection_field) {
     VArray<bool> selection =
-        evaluate_fields(scope, {selection_field}, full_mask, context)[0].typed<bool>();
+        evaluate_fields(scope, {selection_field}, full_mask, context, {}, r_statistics)[0]
+            .typed<bool>();
     if (selection.is_single()) {
       if (selection.get_internal_single()) {
         return full_mask;
@@ -772,13 +960,14 @@ void FieldEvaluator::evaluate()
 {
   BLI_assert_msg(!is_evaluated_, "Cannot evaluate fields twice.");
 
-  selection_mask_ = evaluate_selection(selection_field_, context_, mask_, scope_);
+  selection_mask_ = evaluate_selection(selection_field_, context_, mask_, scope_, &statistics_);
 
   Array<GFieldRef> fields(fields_to_evaluate_.size());
   for (const int i : fields_to_evaluate_.index_range()) {
     fields[i] = fields_to_evaluate_[i];
   }
-  evaluated_varrays_ = evaluate_fields(scope_, fields, selection_mask_, context_, dst_varrays_);
+  evaluated_varrays_ = evaluate_fields(
+      scope_, fields, selection_mask_, context_, dst_varrays_, &statistics_);
   BLI_assert(fields_to_evaluate_.size() == evaluated_varrays_.size());
   for (const int i : fields_to_evaluate_.index_range()) {
     OutputPointerInfo &info = output_pointer_infos_[i];
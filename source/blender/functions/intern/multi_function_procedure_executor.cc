@@ -6,7 +6,8 @@
 
 namespace blender::fn {
 
-MFProcedureExecutor::MFProcedureExecutor(const MFProcedure &procedure) : procedure_(procedure)
+MFProcedureExecutor::MFProcedureExecutor(const MFProcedure &procedure, const int64_t chunk_size)
+    : procedure_(procedure), chunk_size_(chunk_size)
 {
   MFSignatureBuilder signature("Procedure Executor");
 
@@ -16,6 +17,14 @@ MFProcedureExecutor::MFProcedureExecutor(const MFProcedure &procedure) : procedu
 
   signature_ = signature.build();
   this->set_signature(&signature_);
+
+  /* Vector arrays can't be sliced cheaply, so procedures that use them are executed at once. */
+  for (const MFVariable *variable : procedure.variables()) {
+    if (variable->data_type().is_vector()) {
+      chunk_size_ = 0;
+      break;
+    }
+  }
 }
 
 using IndicesSplitVectors = std::array<Vector<int64_t>, 2>;
@@ -134,6 +143,13 @@ class ValueAllocator : NonCopyable, NonMovable {
   /** All buffers in the free-lists below have been allocated with this allocator. */
   LinearAllocator<> &linear_allocator_;
 
+  /**
+   * Span buffers are allocated with at least this size. This is necessary when the allocator is
+   * used to execute the procedure on multiple chunks whose masks have different sizes, because
+   * the free-lists don't remember the size of the buffers.
+   */
+  int64_t min_span_buffer_size_;
+
   /**
    * Use stacks so that the most recently used buffers are reused first. This improves cache
    * efficiency.
@@ -153,7 +169,8 @@ class ValueAllocator : NonCopyable, NonMovable {
   Stack<void *> variable_state_free_list_;
 
  public:
-  ValueAllocator(LinearAllocator<> &linear_allocator) : linear_allocator_(linear_allocator)
+  ValueAllocator(LinearAllocator<> &linear_allocator, const int64_t min_span_buffer_size = 0)
+      : linear_allocator_(linear_allocator), min_span_buffer_size_(min_span_buffer_size)
   {
   }
 
@@ -176,9 +193,10 @@ class ValueAllocator : NonCopyable, NonMovable {
     return this->obtain<VariableValue_Span>(buffer, false);
   }
 
-  VariableValue_Span *obtain_Span(const CPPType &type, int size)
+  VariableValue_Span *obtain_Span(const CPPType &type, int64_t size)
   {
     void *buffer = nullptr;
+    size = std::max(size, min_span_buffer_size_);
 
     const int64_t element_size = type.size();
     const int64_t alignment = type.alignment();
@@ -814,13 +832,13 @@ void ValueAllocator::release_variable_state(VariableState *state)
 /** Keeps track of the states of all variables during evaluation. */
 class VariableStates {
  private:
-  ValueAllocator value_allocator_;
+  ValueAllocator &value_allocator_;
   Map<const MFVariable *, VariableState *> variable_states_;
   IndexMask full_mask_;
 
  public:
-  VariableStates(LinearAllocator<> &linear_allocator, IndexMask full_mask)
-      : value_allocator_(linear_allocator), full_mask_(full_mask)
+  VariableStates(ValueAllocator &value_allocator, IndexMask full_mask)
+      : value_allocator_(value_allocator), full_mask_(full_mask)
   {
   }
 
@@ -1163,17 +1181,18 @@ class InstructionScheduler {
   }
 };
 
-void MFProcedureExecutor::call(IndexMask full_mask, MFParams params, MFContext context) const
+static void execute_procedure(const MFProcedureExecutor &fn,
+                              const MFProcedure &procedure,
+                              const IndexMask full_mask,
+                              MFParams params,
+                              const MFContext &context,
+                              ValueAllocator &value_allocator)
 {
-  BLI_assert(procedure_.validate());
-
-  LinearAllocator<> linear_allocator;
-
-  VariableStates variable_states{linear_allocator, full_mask};
-  variable_states.add_initial_variable_states(*this, procedure_, params);
+  VariableStates variable_states{value_allocator, full_mask};
+  variable_states.add_initial_variable_states(fn, procedure, params);
 
   InstructionScheduler scheduler;
-  scheduler.add_referenced_indices(*procedure_.entry(), full_mask);
+  scheduler.add_referenced_indices(*procedure.entry(), full_mask);
 
   /* Loop until all indices got to a return instruction. */
   while (NextInstructionInfo instr_info = scheduler.pop_next()) {
@@ -1219,9 +1238,9 @@ void MFProcedureExecutor::call(IndexMask full_mask, MFParams params, MFContext c
     }
   }
 
-  for (const int param_index : this->param_indices()) {
-    const MFParamType param_type = this->param_type(param_index);
-    const MFVariable *variable = procedure_.params()[param_index].variable;
+  for (const int param_index : fn.param_indices()) {
+    const MFParamType param_type = fn.param_type(param_index);
+    const MFVariable *variable = procedure.params()[param_index].variable;
     VariableState &variable_state = variable_states.get_variable_state(*variable);
     switch (param_type.interface_type()) {
       case MFParamType::Input: {
@@ -1242,6 +1261,98 @@ void MFProcedureExecutor::call(IndexMask full_mask, MFParams params, MFContext c
   }
 }
 
+/**
+ * Size of the buffers that have to be allocated for every variable when the mask is processed in
+ * chunks, i.e. the largest index range covered by a single chunk.
+ */
+static int64_t max_chunk_array_size(const IndexMask mask, const int64_t chunk_size)
+{
+  if (mask.is_range()) {
+    return std::min(mask.size(), chunk_size);
+  }
+  int64_t max_size = 0;
+  for (int64_t start = 0; start < mask.size(); start += chunk_size) {
+    const int64_t last = std::min(start + chunk_size, mask.size()) - 1;
+    max_size = std::max(max_size, mask[last] - mask[start] + 1);
+  }
+  return max_size;
+}
+
+static void execute_procedure_chunk(const MFProcedureExecutor &fn,
+                                    const MFProcedure &procedure,
+                                    const IndexMask full_mask,
+                                    const IndexRange chunk_range,
+                                    MFParams params,
+                                    const MFContext &context,
+                                    ValueAllocator &value_allocator)
+{
+  Vector<int64_t> offset_mask_indices;
+  const IndexMask chunk_mask = full_mask.slice_and_offset(chunk_range, offset_mask_indices);
+  const IndexRange array_range{full_mask[chunk_range.first()], chunk_mask.min_array_size()};
+
+  /* Slice all parameters so that the chunk can be processed as if it was the entire mask. */
+  MFParamsBuilder chunk_params{fn, chunk_mask.min_array_size()};
+  for (const int param_index : fn.param_indices()) {
+    const MFParamType param_type = fn.param_type(param_index);
+    switch (param_type.category()) {
+      case MFParamType::SingleInput: {
+        const GVArray &varray = params.readonly_single_input(param_index);
+        chunk_params.add_readonly_single_input(varray.slice(array_range));
+        break;
+      }
+      case MFParamType::SingleMutable: {
+        const GMutableSpan span = params.single_mutable(param_index);
+        chunk_params.add_single_mutable(span.slice(array_range));
+        break;
+      }
+      case MFParamType::SingleOutput: {
+        const GMutableSpan span = params.uninitialized_single_output_if_required(param_index);
+        if (span.is_empty()) {
+          chunk_params.add_ignored_single_output();
+        }
+        else {
+          chunk_params.add_uninitialized_single_output(span.slice(array_range));
+        }
+        break;
+      }
+      case MFParamType::VectorInput:
+      case MFParamType::VectorMutable:
+      case MFParamType::VectorOutput: {
+        BLI_assert_unreachable();
+        break;
+      }
+    }
+  }
+
+  execute_procedure(fn, procedure, chunk_mask, chunk_params, context, value_allocator);
+}
+
+void MFProcedureExecutor::call(IndexMask full_mask, MFParams params, MFContext context) const
+{
+  BLI_assert(procedure_.validate());
+
+  LinearAllocator<> linear_allocator;
+
+  if (chunk_size_ > 0 && full_mask.size() > chunk_size_) {
+    const int64_t array_size = max_chunk_array_size(full_mask, chunk_size_);
+    /* For very sparse masks, every chunk would need buffers much larger than the chunk itself. */
+    if (array_size <= chunk_size_ * 4) {
+      /* Process the mask in small chunks, so that the intermediate buffers of the entire
+       * procedure stay in the CPU cache and are reused for every chunk. */
+      ValueAllocator value_allocator{linear_allocator, array_size};
+      for (int64_t start = 0; start < full_mask.size(); start += chunk_size_) {
+        const IndexRange chunk_range{start, std::min(chunk_size_, full_mask.size() - start)};
+        execute_procedure_chunk(
+            *this, procedure_, full_mask, chunk_range, params, context, value_allocator);
+      }
+      return;
+    }
+  }
+
+  ValueAllocator value_allocator{linear_allocator};
+  execute_procedure(*this, procedure_, full_mask, params, context, value_allocator);
+}
+
 MultiFunction::ExecutionHints MFProcedureExecutor::get_execution_hints() const
 {
   ExecutionHints hints;
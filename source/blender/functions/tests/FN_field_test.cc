@@ -289,4 +289,66 @@ TEST(field, IgnoredOutput)
   EXPECT_EQ(results.get(3), 5);
 }
 
+TEST(field, DeduplicateEqualNodes)
+{
+  static CustomMF_SI_SI_SO<int, int, int> add_fn{"add", [](int a, int b) { return a + b; }};
+  static CustomMF_SI_SI_SO<int, int, int> mul_fn{"mul", [](int a, int b) { return a * b; }};
+
+  /* Build the same field twice, as it happens when a node group is used multiple times. */
+  GField index_field{std::make_shared<IndexFieldInput>()};
+  auto build_field = [&]() {
+    GField sum_field{
+        std::make_shared<FieldOperation>(add_fn, Vector<GField>{index_field, index_field})};
+    return GField{std::make_shared<FieldOperation>(
+        mul_fn, Vector<GField>{sum_field, make_constant_field<int>(3)})};
+  };
+  GField field_1 = build_field();
+  GField field_2 = build_field();
+
+  Array<int> result_1(5);
+  Array<int> result_2(5);
+
+  FieldContext context;
+  FieldEvaluator evaluator{context, 5};
+  evaluator.add_with_destination(field_1, result_1.as_mutable_span());
+  evaluator.add_with_destination(field_2, result_2.as_mutable_span());
+  evaluator.evaluate();
+
+  for (const int i : IndexRange(5)) {
+    EXPECT_EQ(result_1[i], i * 6);
+    EXPECT_EQ(result_2[i], i * 6);
+  }
+  /* The second sum, the second constant and the second product. */
+  EXPECT_EQ(evaluator.statistics().deduplicated_nodes, 3);
+  EXPECT_EQ(evaluator.statistics().folded_constants, 0);
+}
+
+TEST(field, FoldConstantOperations)
+{
+  static CustomMF_SI_SI_SO<int, int, int> add_fn{"add", [](int a, int b) { return a + b; }};
+  static CustomMF_SI_SI_SO<int, int, int> mul_fn{"mul", [](int a, int b) { return a * b; }};
+
+  GField index_field{std::make_shared<IndexFieldInput>()};
+  GField constant_sum_field{std::make_shared<FieldOperation>(
+      add_fn, Vector<GField>{make_constant_field<int>(3), make_constant_field<int>(4)})};
+  GField output_field{
+      std::make_shared<FieldOperation>(mul_fn, Vector<GField>{index_field, constant_sum_field})};
+
+  Array<int> result(5);
+  Array<int> constant_result(5);
+
+  FieldContext context;
+  FieldEvaluator evaluator{context, 5};
+  evaluator.add_with_destination(output_field, result.as_mutable_span());
+  evaluator.add_with_destination(constant_sum_field, constant_result.as_mutable_span());
+  evaluator.evaluate();
+
+  for (const int i : IndexRange(5)) {
+    EXPECT_EQ(result[i], i * 7);
+    EXPECT_EQ(constant_result[i], 7);
+  }
+  EXPECT_EQ(evaluator.statistics().deduplicated_nodes, 0);
+  EXPECT_EQ(evaluator.statistics().folded_constants, 1);
+}
+
 }  // namespace blender::fn::tests
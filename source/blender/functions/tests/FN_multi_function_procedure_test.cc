@@ -2,11 +2,15 @@
 
 #include "testing/testing.h"
 
+#include "BLI_timeit.hh"
+
 #include "FN_multi_function_builder.hh"
 #include "FN_multi_function_procedure_builder.hh"
 #include "FN_multi_function_procedure_executor.hh"
 #include "FN_multi_function_test_common.hh"
 
+#define DO_PERF_TESTS 0
+
 namespace blender::fn::tests {
 
 TEST(multi_function_procedure, ConstantOutput)
@@ -378,4 +382,118 @@ TEST(multi_function_procedure, BufferReuse)
   EXPECT_EQ(results[4], 53);
 }
 
+TEST(multi_function_procedure, ChunkedExecution)
+{
+  /**
+   * procedure(int a, int b, int *out) {
+   *   int c = a * b;
+   *   if (c > 100) {
+   *     c += 100;
+   *   }
+   *   out = c + a;
+   * }
+   */
+
+  CustomMF_SI_SI_SO<int, int, int> add_fn{"add", [](int a, int b) { return a + b; }};
+  CustomMF_SI_SI_SO<int, int, int> mul_fn{"mul", [](int a, int b) { return a * b; }};
+  CustomMF_SI_SO<int, bool> greater_fn{"greater", [](int a) { return a > 100; }};
+  CustomMF_SM<int> add_100_fn{"add_100", [](int &a) { a += 100; }};
+
+  MFProcedure procedure;
+  MFProcedureBuilder builder{procedure};
+
+  MFVariable *var_a = &builder.add_single_input_parameter<int>();
+  MFVariable *var_b = &builder.add_single_input_parameter<int>();
+  auto [var_c] = builder.add_call<1>(mul_fn, {var_a, var_b});
+  builder.add_destruct(*var_b);
+  auto [var_cond] = builder.add_call<1>(greater_fn, {var_c});
+  MFProcedureBuilder::Branch branch = builder.add_branch(*var_cond);
+  branch.branch_true.add_call(add_100_fn, {var_c});
+  branch.branch_true.add_destruct(*var_cond);
+  branch.branch_false.add_destruct(*var_cond);
+  builder.set_cursor_after_branch(branch);
+  auto [var_out] = builder.add_call<1>(add_fn, {var_c, var_a});
+  builder.add_destruct({var_a, var_c});
+  builder.add_return();
+  builder.add_output_parameter(*var_out);
+
+  EXPECT_TRUE(procedure.validate());
+
+  const int64_t size = 5000;
+  Array<int> inputs(size);
+  for (const int64_t i : inputs.index_range()) {
+    inputs[i] = int(i % 37);
+  }
+  Vector<int64_t> indices;
+  for (int64_t i = 3; i < size; i += 3) {
+    indices.append(i);
+  }
+  const IndexMask mask{indices};
+
+  /* Compare chunked execution with execution on the entire mask at once. */
+  for (const int64_t chunk_size : {int64_t(0), int64_t(7), int64_t(64), int64_t(512)}) {
+    MFProcedureExecutor procedure_fn{procedure, chunk_size};
+
+    Array<int> results(size, -1);
+    MFParamsBuilder params{procedure_fn, size};
+    params.add_readonly_single_input(inputs.as_span());
+    params.add_readonly_single_input_value(4);
+    params.add_uninitialized_single_output(results.as_mutable_span());
+
+    MFContextBuilder context;
+    procedure_fn.call(mask, params, context);
+
+    for (const int64_t i : IndexRange(size)) {
+      if (i > 0 && i % 3 == 0) {
+        const int c = inputs[i] * 4;
+        EXPECT_EQ(results[i], (c > 100 ? c + 100 : c) + inputs[i]);
+      }
+      else {
+        EXPECT_EQ(results[i], -1);
+      }
+    }
+  }
+}
+
+#if DO_PERF_TESTS
+TEST(multi_function_procedure, ChunkedExecutionPerformance)
+{
+  /* Long chain of cheap math functions, similar to what is built for math-heavy fields. */
+  CustomMF_SI_SI_SO<float, float, float> add_fn{"add", [](float a, float b) { return a + b; }};
+  CustomMF_SI_SI_SO<float, float, float> mul_fn{"mul", [](float a, float b) { return a * b; }};
+
+  MFProcedure procedure;
+  MFProcedureBuilder builder{procedure};
+
+  MFVariable *var_in = &builder.add_single_input_parameter<float>();
+  MFVariable *var_prev = var_in;
+  for (const int i : IndexRange(20)) {
+    auto [var_next] = builder.add_call<1>(i % 2 == 0 ? add_fn : mul_fn, {var_prev, var_in});
+    if (var_prev != var_in) {
+      builder.add_destruct(*var_prev);
+    }
+    var_prev = var_next;
+  }
+  builder.add_destruct(*var_in);
+  builder.add_return();
+  builder.add_output_parameter(*var_prev);
+
+  EXPECT_TRUE(procedure.validate());
+
+  const int64_t size = 4'000'000;
+  Array<float> inputs(size, 0.5f);
+  Array<float> results(size);
+
+  for (const int64_t chunk_size : {int64_t(0), MFProcedureExecutor::default_chunk_size}) {
+    MFProcedureExecutor procedure_fn{procedure, chunk_size};
+    MFParamsBuilder params{procedure_fn, size};
+    params.add_readonly_single_input(inputs.as_span());
+    params.add_uninitialized_single_output(results.as_mutable_span());
+    MFContextBuilder context;
+    SCOPED_TIMER(chunk_size == 0 ? "unchunked" : "chunked");
+    procedure_fn.call(IndexRange(size), params, context);
+  }
+}
+#endif
+
 }  // namespace blender::fn::tests
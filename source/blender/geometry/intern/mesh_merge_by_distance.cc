@@ -5,6 +5,8 @@
 #include "BLI_kdtree.h"
 #include "BLI_math_vector.h"
 #include "BLI_math_vector.hh"
+#include "BLI_spatial_hash_grid.hh"
+#include "BLI_task.hh"
 #include "BLI_vector.hh"
 
 #include "DNA_mesh_types.h"
@@ -1601,17 +1603,40 @@ std::optional<Mesh *> mesh_merge_by_distance_all(const Mesh &mesh,
                                                  const float merge_distance)
 {
   Array<int> vert_dest_map(mesh.totvert, OUT_OF_CONTEXT);
+  int vert_kill_len;
 
-  KDTree_3d *tree = BLI_kdtree_3d_new(selection.size());
-
-  for (const int i : selection) {
-    BLI_kdtree_3d_insert(tree, i, mesh.mvert[i].co);
+  if (merge_distance > 0.0f) {
+    /* A uniform grid is cheaper to build and search than a KD tree for small distances.
+     * It only contains the selected vertices, so map the results back to vertex indices. */
+    Array<float3> selected_positions(selection.size());
+    threading::parallel_for(selection.index_range(), 4096, [&](IndexRange range) {
+      for (const int i : range) {
+        selected_positions[i] = mesh.mvert[selection[i]].co;
+      }
+    });
+    const SpatialHashGrid grid(selected_positions, merge_distance * 4.0f);
+    Array<int> selection_dest_map(selection.size(), OUT_OF_CONTEXT);
+    vert_kill_len = grid.calc_duplicates(merge_distance, selection_dest_map);
+    threading::parallel_for(selection.index_range(), 4096, [&](IndexRange range) {
+      for (const int i : range) {
+        if (selection_dest_map[i] != OUT_OF_CONTEXT) {
+          vert_dest_map[selection[i]] = selection[selection_dest_map[i]];
+        }
+      }
+    });
   }
+  else {
+    KDTree_3d *tree = BLI_kdtree_3d_new(selection.size());
+
+    for (const int i : selection) {
+      BLI_kdtree_3d_insert(tree, i, mesh.mvert[i].co);
+    }
 
-  BLI_kdtree_3d_balance(tree);
-  const int vert_kill_len = BLI_kdtree_3d_calc_duplicates_fast(
-      tree, merge_distance, false, vert_dest_map.data());
-  BLI_kdtree_3d_free(tree);
+    BLI_kdtree_3d_balance(tree);
+    vert_kill_len = BLI_kdtree_3d_calc_duplicates_fast(
+        tree, merge_distance, false, vert_dest_map.data());
+    BLI_kdtree_3d_free(tree);
+  }
 
   if (vert_kill_len == 0) {
     return std::nullopt;
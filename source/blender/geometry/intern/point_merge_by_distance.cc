@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
 #include "BLI_kdtree.h"
+#include "BLI_spatial_hash_grid.hh"
 #include "BLI_task.hh"
 
 #include "DNA_pointcloud_types.h"
@@ -21,21 +22,32 @@ PointCloud *point_merge_by_distance(const PointCloudComponent &src_points,
   const int src_size = src_pointcloud.totpoint;
   Span<float3> positions{reinterpret_cast<float3 *>(src_pointcloud.co), src_size};
 
-  /* Create the KD tree based on only the selected points, to speed up merge detection and
-   * balancing. */
-  KDTree_3d *tree = BLI_kdtree_3d_new(selection.size());
-  for (const int i : selection.index_range()) {
-    BLI_kdtree_3d_insert(tree, i, positions[selection[i]]);
-  }
-  BLI_kdtree_3d_balance(tree);
-
-  /* Find the duplicates in the KD tree. Because the tree only contains the selected points, the
+  /* Find the duplicates among the selected points only, to speed up merge detection. The
    * resulting indices are indices into the selection, rather than indices of the source point
    * cloud. */
   Array<int> selection_merge_indices(selection.size(), -1);
-  const int duplicate_count = BLI_kdtree_3d_calc_duplicates_fast(
-      tree, merge_distance, false, selection_merge_indices.data());
-  BLI_kdtree_3d_free(tree);
+  int duplicate_count;
+  if (merge_distance > 0.0f) {
+    /* A uniform grid is cheaper to build and search than a KD tree for small distances. */
+    Array<float3> selected_positions(selection.size());
+    threading::parallel_for(selection.index_range(), 4096, [&](IndexRange range) {
+      for (const int i : range) {
+        selected_positions[i] = positions[selection[i]];
+      }
+    });
+    const SpatialHashGrid grid(selected_positions, merge_distance * 4.0f);
+    duplicate_count = grid.calc_duplicates(merge_distance, selection_merge_indices);
+  }
+  else {
+    KDTree_3d *tree = BLI_kdtree_3d_new(selection.size());
+    for (const int i : selection.index_range()) {
+      BLI_kdtree_3d_insert(tree, i, positions[selection[i]]);
+    }
+    BLI_kdtree_3d_balance(tree);
+    duplicate_count = BLI_kdtree_3d_calc_duplicates_fast(
+        tree, merge_distance, false, selection_merge_indices.data());
+    BLI_kdtree_3d_free(tree);
+  }
 
   /* Create the new point cloud and add it to a temporary component for the attribute API. */
   const int dst_size = src_size - duplicate_count;
@@ -9,6 +9,7 @@
 #include "IO_wavefront_obj.h"
 
 #include "obj_exporter.hh"
+#include "obj_importer.hh"
 
 /**
  * C-interface for the exporter.
@@ -18,3 +19,9 @@ void OBJ_export(bContext *C, const OBJExportParams *export_params)
   SCOPED_TIMER("OBJ export");
   blender::io::obj::exporter_main(C, *export_params);
 }
+
+void OBJ_import(bContext *C, const OBJImportParams *import_params)
+{
+  SCOPED_TIMER("OBJ import");
+  blender::io::obj::importer_main(C, *import_params);
+}
@@ -7,9 +7,11 @@
 #include <cstdio>
 #include <exception>
 #include <memory>
+#include <mutex>
 
 #include "BKE_scene.h"
 
+#include "BLI_array.hh"
 #include "BLI_path_util.h"
 #include "BLI_task.hh"
 #include "BLI_vector.hh"
@@ -143,8 +145,9 @@ static void write_mesh_objects(Vector<std::unique_ptr<OBJMesh>> exportable_as_me
                                const OBJExportParams &export_params)
 {
   /* Parallelization is over meshes/objects, which means
-   * we have to have the output text buffer for each object,
-   * and write them all into the file at the end. */
+   * we have to have the output text buffer for each object.
+   * Buffers are written into the file in object order as soon as
+   * all the objects before them are done, see below. */
   size_t count = exportable_as_mesh.size();
   std::vector<FormatHandler<eFileType::OBJ>> buffers(count);
 
@@ -191,6 +194,22 @@ static void write_mesh_objects(Vector<std::unique_ptr<OBJMesh>> exportable_as_me
     offsets.normal_offset += obj.tot_normal_indices();
   }
 
+  /* Write the finished object text buffers into the output file, in order. A buffer is only
+   * written once all the previous ones are, so that the text of all objects never has to be
+   * kept in memory at the same time. */
+  FILE *f = obj_writer.get_outfile();
+  std::mutex write_mutex;
+  Array<bool> is_finished(count, false);
+  size_t next_to_write = 0;
+  auto write_finished_buffers = [&](const int finished_index) {
+    std::lock_guard lock(write_mutex);
+    is_finished[finished_index] = true;
+    while (next_to_write < count && is_finished[next_to_write]) {
+      buffers[next_to_write].write_to_file(f);
+      next_to_write++;
+    }
+  };
+
   /* Parallel over meshes: main result writing. */
   blender::threading::parallel_for(IndexRange(count), 1, [&](IndexRange range) {
     for (const int i : range) {
@@ -229,14 +248,11 @@ static void write_mesh_objects(Vector<std::unique_ptr<OBJMesh>> exportable_as_me
       /* Nothing will need this object's data after this point, release
        * various arrays here. */
       obj.clear();
+
+      write_finished_buffers(i);
     }
   });
-
-  /* Write all the object text buffers into the output file. */
-  FILE *f = obj_writer.get_outfile();
-  for (auto &b : buffers) {
-    b.write_to_file(f);
-  }
+  BLI_assert(next_to_write == count);
 }
 
 /**
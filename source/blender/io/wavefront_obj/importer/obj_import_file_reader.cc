@@ -0,0 +1,518 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include <array>
+#include <optional>
+
+#include "BLI_array.hh"
+#include "BLI_index_range.hh"
+#include "BLI_task.hh"
+
+#include "obj_import_file_reader.hh"
+#include "obj_import_string_utils.hh"
+
+namespace blender::io::obj {
+
+/* -------------------------------------------------------------------- */
+/** \name Chunk Parsing
+ *
+ * Every chunk is parsed without knowing anything about the text before it. Element indices are
+ * kept chunk-relative where needed and state changes ("o", "usemtl", "s") are recorded as events
+ * with the position in the chunk's face list where they happen.
+ * \{ */
+
+/**
+ * An element index as written in a chunk. Positive OBJ indices are absolute and can be resolved
+ * immediately, negative ones are relative to the number of elements declared so far, which is
+ * only known once all previous chunks are parsed.
+ */
+struct ChunkIndex {
+  int index = -1;
+  bool relative = false;
+
+  int resolve(const int chunk_offset) const
+  {
+    return relative ? chunk_offset + index : index;
+  }
+};
+
+struct ChunkCorner {
+  ChunkIndex vert;
+  ChunkIndex uv_vert;
+  ChunkIndex vertex_normal;
+};
+
+struct ChunkFace {
+  int start_index;
+  int corner_count;
+};
+
+enum class eChunkEventType {
+  NewObject,
+  Material,
+  SmoothGroup,
+};
+
+struct ChunkEvent {
+  eChunkEventType type;
+  /** Number of faces, edges and vertices of the chunk that come before this event. */
+  int face_index;
+  int edge_index;
+  int vertex_index;
+  std::string name;
+  bool shaded_smooth = false;
+};
+
+struct ChunkData {
+  Vector<float3> vertices;
+  Vector<float2> uv_vertices;
+  Vector<float3> vertex_normals;
+  Vector<ChunkFace> faces;
+  Vector<ChunkCorner> corners;
+  Vector<std::array<ChunkIndex, 2>> edges;
+  Vector<ChunkEvent> events;
+};
+
+/**
+ * Convert a one-based (or negative, relative) OBJ index into a zero-based chunk index.
+ * Zero is not a valid OBJ index and results in an invalid index.
+ */
+static ChunkIndex make_chunk_index(const int obj_index, const int64_t chunk_element_count)
+{
+  if (obj_index > 0) {
+    return {obj_index - 1, false};
+  }
+  if (obj_index < 0) {
+    return {int(chunk_element_count) + obj_index, true};
+  }
+  return {-1, false};
+}
+
+/**
+ * Check whether the line starts with the given keyword followed by white-space (or the end of
+ * the line), and skip past the keyword if it does.
+ */
+static bool parse_keyword(const char *&p, const char *end, StringRef keyword)
+{
+  const int64_t keyword_len = keyword.size();
+  if (end - p < keyword_len) {
+    return false;
+  }
+  if (memcmp(p, keyword.data(), keyword_len) != 0) {
+    return false;
+  }
+  /* Treat any ASCII control character as white-space. */
+  if (end - p > keyword_len && p[keyword_len] > ' ') {
+    return false;
+  }
+  p += std::min(keyword_len + 1, int64_t(end - p));
+  return true;
+}
+
+/** Rest of the line without surrounding white-space. */
+static std::string parse_name(const char *p, const char *end)
+{
+  p = drop_whitespace(p, end);
+  while (end > p && end[-1] <= ' ') {
+    --end;
+  }
+  return std::string(p, end);
+}
+
+static void add_event(ChunkData &r_data, const eChunkEventType type)
+{
+  r_data.events.append_as();
+  ChunkEvent &event = r_data.events.last();
+  event.type = type;
+  event.face_index = int(r_data.faces.size());
+  event.edge_index = int(r_data.edges.size());
+  event.vertex_index = int(r_data.vertices.size());
+}
+
+static void geom_add_polygon(const char *p, const char *end, ChunkData &r_data)
+{
+  ChunkFace face;
+  face.start_index = int(r_data.corners.size());
+  face.corner_count = 0;
+  while (true) {
+    p = drop_whitespace(p, end);
+    if (p >= end) {
+      break;
+    }
+    ChunkCorner corner;
+    int index;
+    p = parse_int(p, end, 0, index, false);
+    corner.vert = make_chunk_index(index, r_data.vertices.size());
+    if (p < end && *p == '/') {
+      ++p;
+      if (p < end && *p != '/') {
+        p = parse_int(p, end, 0, index, false);
+        corner.uv_vert = make_chunk_index(index, r_data.uv_vertices.size());
+      }
+      if (p < end && *p == '/') {
+        ++p;
+        p = parse_int(p, end, 0, index, false);
+        corner.vertex_normal = make_chunk_index(index, r_data.vertex_normals.size());
+      }
+    }
+    /* Skip anything unexpected up to the next corner. */
+    p = drop_non_whitespace(p, end);
+    r_data.corners.append(corner);
+    face.corner_count++;
+  }
+  if (face.corner_count > 0) {
+    r_data.faces.append(face);
+  }
+}
+
+static void geom_add_polyline(const char *p, const char *end, ChunkData &r_data)
+{
+  ChunkIndex prev_vert;
+  bool has_prev = false;
+  while (true) {
+    p = drop_whitespace(p, end);
+    if (p >= end) {
+      break;
+    }
+    int index;
+    p = parse_int(p, end, 0, index, false);
+    /* Texture vertex indices of lines are not used. */
+    p = drop_non_whitespace(p, end);
+    const ChunkIndex vert = make_chunk_index(index, r_data.vertices.size());
+    if (has_prev) {
+      r_data.edges.append({prev_vert, vert});
+    }
+    prev_vert = vert;
+    has_prev = true;
+  }
+}
+
+static void parse_line(const char *p, const char *end, ChunkData &r_data)
+{
+  p = drop_whitespace(p, end);
+  if (p >= end || *p == '#') {
+    return;
+  }
+  if (parse_keyword(p, end, "v")) {
+    float3 vert;
+    parse_floats(p, end, 0.0f, vert, 3);
+    r_data.vertices.append(vert);
+  }
+  else if (parse_keyword(p, end, "vn")) {
+    float3 normal;
+    parse_floats(p, end, 0.0f, normal, 3);
+    r_data.vertex_normals.append(normal);
+  }
+  else if (parse_keyword(p, end, "vt")) {
+    float2 uv;
+    parse_floats(p, end, 0.0f, uv, 2);
+    r_data.uv_vertices.append(uv);
+  }
+  else if (parse_keyword(p, end, "f")) {
+    geom_add_polygon(p, end, r_data);
+  }
+  else if (parse_keyword(p, end, "l")) {
+    geom_add_polyline(p, end, r_data);
+  }
+  else if (parse_keyword(p, end, "o") || parse_keyword(p, end, "g")) {
+    std::string name = parse_name(p, end);
+    if (!name.empty()) {
+      add_event(r_data, eChunkEventType::NewObject);
+      r_data.events.last().name = std::move(name);
+    }
+  }
+  else if (parse_keyword(p, end, "usemtl")) {
+    add_event(r_data, eChunkEventType::Material);
+    r_data.events.last().name = parse_name(p, end);
+  }
+  else if (parse_keyword(p, end, "s")) {
+    p = drop_whitespace(p, end);
+    const std::string value = parse_name(p, end);
+    add_event(r_data, eChunkEventType::SmoothGroup);
+    r_data.events.last().shaded_smooth = !(value.empty() || value == "off" || value == "0");
+  }
+  /* Other statements (materials libraries, free-form geometry, ...) are not supported. */
+}
+
+static void parse_chunk(StringRef chunk, ChunkData &r_data)
+{
+  while (!chunk.is_empty()) {
+    const StringRef line = read_next_line(chunk);
+    parse_line(line.begin(), line.end(), r_data);
+  }
+}
+
+/** True if the character at `i` ends a line, i.e. is a line break that is not escaped. */
+static bool is_line_end(StringRef buffer, int64_t i)
+{
+  if (buffer[i] != '\n') {
+    return false;
+  }
+  int64_t prev = i - 1;
+  if (prev >= 0 && buffer[prev] == '\r') {
+    prev--;
+  }
+  return prev < 0 || buffer[prev] != '\\';
+}
+
+/**
+ * Split the buffer into pieces of roughly `chunk_size` bytes, ending at line boundaries that
+ * are not line continuations.
+ */
+static Vector<StringRef> split_into_chunks(StringRef buffer, const int64_t chunk_size)
+{
+  Vector<StringRef> chunks;
+  while (!buffer.is_empty()) {
+    int64_t chunk_len = std::min(chunk_size, buffer.size());
+    while (chunk_len < buffer.size() && !is_line_end(buffer, chunk_len - 1)) {
+      chunk_len++;
+    }
+    chunks.append(buffer.substr(0, chunk_len));
+    buffer = buffer.drop_prefix(chunk_len);
+  }
+  return chunks;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Stitching Chunks Together
+ * \{ */
+
+/** Position of a chunk's elements in the global arrays. */
+struct ChunkOffsets {
+  int vertex = 0;
+  int uv_vertex = 0;
+  int vertex_normal = 0;
+};
+
+/** A range of a chunk's faces and edges that all end up in the same #Geometry. */
+struct ChunkCopyTask {
+  int chunk;
+  int geometry;
+  IndexRange faces;
+  IndexRange edges;
+  int dst_face_start;
+  int dst_corner_start;
+  int dst_edge_start;
+  int material_index;
+  bool shaded_smooth;
+  /* Filled in while copying. */
+  bool has_uv = false;
+  bool has_vertex_normals = false;
+};
+
+struct GeometrySize {
+  int faces = 0;
+  int corners = 0;
+  int edges = 0;
+};
+
+static int chunk_face_range_corner_count(const ChunkData &data, const IndexRange faces)
+{
+  if (faces.is_empty()) {
+    return 0;
+  }
+  const ChunkFace &first = data.faces[faces.first()];
+  const ChunkFace &last = data.faces[faces.last()];
+  return last.start_index + last.corner_count - first.start_index;
+}
+
+static void copy_chunk_elements(const ChunkData &data,
+                                const ChunkOffsets &offsets,
+                                ChunkCopyTask &task,
+                                Geometry &geometry)
+{
+  if (!task.faces.is_empty()) {
+    const int src_corner_start = data.faces[task.faces.first()].start_index;
+    for (const int i : IndexRange(task.faces.size())) {
+      const ChunkFace &src = data.faces[task.faces[i]];
+      PolyElem &dst = geometry.face_elements[task.dst_face_start + i];
+      dst.start_index = task.dst_corner_start + src.start_index - src_corner_start;
+      dst.corner_count = src.corner_count;
+      dst.material_index = task.material_index;
+      dst.shaded_smooth = task.shaded_smooth;
+    }
+    const int corner_count = chunk_face_range_corner_count(data, task.faces);
+    for (const int i : IndexRange(corner_count)) {
+      const ChunkCorner &src = data.corners[src_corner_start + i];
+      PolyCorner &dst = geometry.face_corners[task.dst_corner_start + i];
+      dst.vert_index = src.vert.resolve(offsets.vertex);
+      dst.uv_vert_index = src.uv_vert.resolve(offsets.uv_vertex);
+      dst.vertex_normal_index = src.vertex_normal.resolve(offsets.vertex_normal);
+      task.has_uv |= dst.uv_vert_index >= 0;
+      task.has_vertex_normals |= dst.vertex_normal_index >= 0;
+    }
+  }
+  for (const int i : IndexRange(task.edges.size())) {
+    const std::array<ChunkIndex, 2> &src = data.edges[task.edges[i]];
+    geometry.edges[task.dst_edge_start + i] = {src[0].resolve(offsets.vertex),
+                                               src[1].resolve(offsets.vertex)};
+  }
+}
+
+template<typename T>
+static void copy_chunk_arrays(Span<ChunkData> chunks,
+                              Span<int> offsets,
+                              Vector<T> ChunkData::*member,
+                              Vector<T> &r_dst)
+{
+  r_dst.resize(offsets.last());
+  threading::parallel_for(chunks.index_range(), 1, [&](IndexRange range) {
+    for (const int i : range) {
+      const Vector<T> &src = chunks[i].*member;
+      std::copy(src.begin(), src.end(), r_dst.begin() + offsets[i]);
+    }
+  });
+}
+
+/** \} */
+
+OBJParser::OBJParser(StringRef default_name, const size_t chunk_size)
+    : default_name_(default_name), chunk_size_(std::max<size_t>(chunk_size, 1))
+{
+}
+
+void OBJParser::parse(StringRef buffer,
+                      Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                      GlobalVertices &r_global_vertices) const
+{
+  const Vector<StringRef> chunks = split_into_chunks(buffer, chunk_size_);
+  Array<ChunkData> chunk_data(chunks.size());
+  threading::parallel_for(chunks.index_range(), 1, [&](IndexRange range) {
+    for (const int i : range) {
+      parse_chunk(chunks[i], chunk_data[i]);
+    }
+  });
+
+  /* Global offsets of every chunk's vertex data. */
+  Array<int> vertex_offsets(chunks.size() + 1);
+  Array<int> uv_offsets(chunks.size() + 1);
+  Array<int> normal_offsets(chunks.size() + 1);
+  vertex_offsets[0] = uv_offsets[0] = normal_offsets[0] = 0;
+  for (const int i : chunk_data.index_range()) {
+    vertex_offsets[i + 1] = vertex_offsets[i] + chunk_data[i].vertices.size();
+    uv_offsets[i + 1] = uv_offsets[i] + chunk_data[i].uv_vertices.size();
+    normal_offsets[i + 1] = normal_offsets[i] + chunk_data[i].vertex_normals.size();
+  }
+  Array<ChunkOffsets> chunk_offsets(chunks.size());
+  for (const int i : chunk_data.index_range()) {
+    chunk_offsets[i] = {vertex_offsets[i], uv_offsets[i], normal_offsets[i]};
+  }
+  copy_chunk_arrays<float3>(
+      chunk_data, vertex_offsets, &ChunkData::vertices, r_global_vertices.vertices);
+  copy_chunk_arrays<float2>(
+      chunk_data, uv_offsets, &ChunkData::uv_vertices, r_global_vertices.uv_vertices);
+  copy_chunk_arrays<float3>(
+      chunk_data, normal_offsets, &ChunkData::vertex_normals, r_global_vertices.vertex_normals);
+
+  /* Walk through the state changes in file order, and plan which ranges of faces and edges go
+   * into which geometry. */
+  Vector<std::unique_ptr<Geometry>> geometries;
+  Vector<GeometrySize> geometry_sizes;
+  Vector<ChunkCopyTask> tasks;
+  std::optional<std::string> material_name;
+  bool shaded_smooth = false;
+
+  geometries.append(std::make_unique<Geometry>());
+  geometries.last()->geometry_name = default_name_;
+  geometry_sizes.append({});
+
+  auto add_task = [&](const int chunk, const IndexRange faces, const IndexRange edges) {
+    if (faces.is_empty() && edges.is_empty()) {
+      return;
+    }
+    const int geometry_index = geometries.size() - 1;
+    Geometry &geometry = *geometries.last();
+    GeometrySize &size = geometry_sizes.last();
+    ChunkCopyTask task;
+    task.chunk = chunk;
+    task.geometry = geometry_index;
+    task.faces = faces;
+    task.edges = edges;
+    task.dst_face_start = size.faces;
+    task.dst_corner_start = size.corners;
+    task.dst_edge_start = size.edges;
+    task.material_index = material_name ? geometry.material_names.index_of_or_add(*material_name) :
+                                          -1;
+    task.shaded_smooth = shaded_smooth;
+    tasks.append(task);
+    size.faces += faces.size();
+    size.corners += chunk_face_range_corner_count(chunk_data[chunk], faces);
+    size.edges += edges.size();
+  };
+
+  for (const int chunk : chunk_data.index_range()) {
+    const ChunkData &data = chunk_data[chunk];
+    int face_index = 0;
+    int edge_index = 0;
+    for (const ChunkEvent &event : data.events) {
+      add_task(chunk,
+               IndexRange(face_index, event.face_index - face_index),
+               IndexRange(edge_index, event.edge_index - edge_index));
+      face_index = event.face_index;
+      edge_index = event.edge_index;
+      switch (event.type) {
+        case eChunkEventType::NewObject: {
+          const int vertex_index = chunk_offsets[chunk].vertex + event.vertex_index;
+          Geometry &current = *geometries.last();
+          const GeometrySize &current_size = geometry_sizes.last();
+          if (current_size.faces == 0 && current_size.edges == 0 &&
+              current.vertex_start == vertex_index) {
+            /* Nothing was added to the current object yet, reuse it. */
+            current.geometry_name = event.name;
+            break;
+          }
+          current.vertex_count = vertex_index - current.vertex_start;
+          geometries.append(std::make_unique<Geometry>());
+          geometries.last()->geometry_name = event.name;
+          geometries.last()->vertex_start = vertex_index;
+          geometry_sizes.append({});
+          break;
+        }
+        case eChunkEventType::Material:
+          material_name = event.name;
+          break;
+        case eChunkEventType::SmoothGroup:
+          shaded_smooth = event.shaded_smooth;
+          break;
+      }
+    }
+    add_task(chunk,
+             IndexRange(face_index, data.faces.size() - face_index),
+             IndexRange(edge_index, data.edges.size() - edge_index));
+  }
+  geometries.last()->vertex_count = vertex_offsets.last() - geometries.last()->vertex_start;
+
+  for (const int i : geometries.index_range()) {
+    geometries[i]->face_elements.resize(geometry_sizes[i].faces);
+    geometries[i]->face_corners.resize(geometry_sizes[i].corners);
+    geometries[i]->edges.resize(geometry_sizes[i].edges);
+  }
+
+  threading::parallel_for(tasks.index_range(), 1, [&](IndexRange range) {
+    for (const int i : range) {
+      ChunkCopyTask &task = tasks[i];
+      copy_chunk_elements(
+          chunk_data[task.chunk], chunk_offsets[task.chunk], task, *geometries[task.geometry]);
+    }
+  });
+
+  for (const ChunkCopyTask &task : tasks) {
+    Geometry &geometry = *geometries[task.geometry];
+    geometry.has_uv |= task.has_uv;
+    geometry.has_vertex_normals |= task.has_vertex_normals;
+  }
+
+  for (std::unique_ptr<Geometry> &geometry : geometries) {
+    if (geometry->is_vertex_only() && geometry->vertex_count == 0) {
+      continue;
+    }
+    r_all_geometries.append(std::move(geometry));
+  }
+}
+
+}  // namespace blender::io::obj
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "BLI_string_ref.hh"
+#include "BLI_vector.hh"
+
+#include "obj_import_objects.hh"
+
+namespace blender::io::obj {
+
+/**
+ * Parses the text of an OBJ file into #Geometry objects and #GlobalVertices.
+ *
+ * The text is split into chunks at line boundaries, the chunks are parsed in parallel into
+ * chunk-local arrays, and the results are then stitched together in file order. Relative
+ * (negative) indices are resolved against the global element counts while stitching, so the
+ * result does not depend on the chunk size.
+ */
+class OBJParser {
+ private:
+  std::string default_name_;
+  size_t chunk_size_;
+
+ public:
+  /** Size of the text chunks that are parsed independently. */
+  static constexpr size_t default_chunk_size = 256 * 1024;
+
+  /**
+   * \param default_name: Name of the object that receives elements which appear before any
+   * "o" or "g" statement.
+   */
+  OBJParser(StringRef default_name, size_t chunk_size = default_chunk_size);
+
+  /**
+   * Parse the full contents of an OBJ file.
+   * Objects without any elements are not added to `r_all_geometries`.
+   */
+  void parse(StringRef buffer,
+             Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+             GlobalVertices &r_global_vertices) const;
+};
+
+}  // namespace blender::io::obj
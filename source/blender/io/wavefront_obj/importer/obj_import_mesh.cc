@@ -0,0 +1,259 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include "DNA_material_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+#include "BKE_material.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+
+#include "BLI_array.hh"
+#include "BLI_math_vector.h"
+#include "BLI_task.hh"
+
+#include "obj_import_mesh.hh"
+
+namespace blender::io::obj {
+
+/**
+ * Maps a contiguous range of global vertex indices to mesh vertex indices,
+ * with -1 for vertices that are not part of the mesh.
+ */
+struct VertexMap {
+  int global_start = 0;
+  Array<int> mesh_indices;
+  /** Global index of every mesh vertex. */
+  Vector<int> global_indices;
+
+  int mesh_index(const int global_index) const
+  {
+    return mesh_indices[global_index - global_start];
+  }
+};
+
+bool MeshFromGeometry::is_valid_poly(const PolyElem &poly) const
+{
+  if (poly.corner_count < 3) {
+    return false;
+  }
+  const int tot_verts = global_vertices_.vertices.size();
+  const Span<PolyCorner> corners = mesh_geometry_.face_corners.as_span().slice(poly.start_index,
+                                                                               poly.corner_count);
+  for (const int i : corners.index_range()) {
+    const int vert = corners[i].vert_index;
+    if (vert < 0 || vert >= tot_verts) {
+      return false;
+    }
+    /* Faces with degenerate edges (the same vertex used by consecutive corners). */
+    if (vert == corners[(i + 1) % corners.size()].vert_index) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool is_valid_edge(const int2 &edge, const int tot_verts)
+{
+  return edge[0] >= 0 && edge[0] < tot_verts && edge[1] >= 0 && edge[1] < tot_verts &&
+         edge[0] != edge[1];
+}
+
+static void build_vertex_map(const Geometry &geometry,
+                             Span<int> polys,
+                             Span<int2> edges,
+                             Span<bool> vertex_is_used,
+                             VertexMap &r_map)
+{
+  if (polys.is_empty() && edges.is_empty()) {
+    /* Point cloud: use the declared vertices that no other object uses. */
+    r_map.global_start = geometry.vertex_start;
+    r_map.mesh_indices.reinitialize(geometry.vertex_count);
+    for (const int i : IndexRange(geometry.vertex_count)) {
+      const int global_index = geometry.vertex_start + i;
+      if (!vertex_is_used.is_empty() && vertex_is_used[global_index]) {
+        r_map.mesh_indices[i] = -1;
+        continue;
+      }
+      r_map.mesh_indices[i] = r_map.global_indices.append_and_get_index(global_index);
+    }
+    return;
+  }
+
+  int min_index = INT_MAX;
+  int max_index = -1;
+  for (const int poly_index : polys) {
+    const PolyElem &poly = geometry.face_elements[poly_index];
+    for (const int i : IndexRange(poly.start_index, poly.corner_count)) {
+      const int vert = geometry.face_corners[i].vert_index;
+      min_index = std::min(min_index, vert);
+      max_index = std::max(max_index, vert);
+    }
+  }
+  for (const int2 &edge : edges) {
+    min_index = std::min({min_index, edge[0], edge[1]});
+    max_index = std::max({max_index, edge[0], edge[1]});
+  }
+
+  /* Mark the used vertices with zero, then number them in file order. */
+  r_map.global_start = min_index;
+  r_map.mesh_indices.reinitialize(max_index - min_index + 1);
+  r_map.mesh_indices.fill(-1);
+  for (const int poly_index : polys) {
+    const PolyElem &poly = geometry.face_elements[poly_index];
+    for (const int i : IndexRange(poly.start_index, poly.corner_count)) {
+      r_map.mesh_indices[geometry.face_corners[i].vert_index - min_index] = 0;
+    }
+  }
+  for (const int2 &edge : edges) {
+    r_map.mesh_indices[edge[0] - min_index] = 0;
+    r_map.mesh_indices[edge[1] - min_index] = 0;
+  }
+  for (const int i : r_map.mesh_indices.index_range()) {
+    if (r_map.mesh_indices[i] == 0) {
+      r_map.mesh_indices[i] = r_map.global_indices.append_and_get_index(min_index + i);
+    }
+  }
+}
+
+Mesh *MeshFromGeometry::create_mesh(const OBJImportParams &import_params,
+                                    Span<bool> vertex_is_used) const
+{
+  const int tot_global_verts = global_vertices_.vertices.size();
+
+  /* Skip invalid faces and edges instead of failing the whole import. */
+  Vector<int> polys;
+  Array<int> loop_offsets(mesh_geometry_.face_elements.size() + 1);
+  int tot_loops = 0;
+  for (const int i : mesh_geometry_.face_elements.index_range()) {
+    const PolyElem &poly = mesh_geometry_.face_elements[i];
+    if (!is_valid_poly(poly)) {
+      continue;
+    }
+    loop_offsets[polys.size()] = tot_loops;
+    polys.append(i);
+    tot_loops += poly.corner_count;
+  }
+  loop_offsets[polys.size()] = tot_loops;
+
+  Vector<int2> edges;
+  for (const int2 &edge : mesh_geometry_.edges) {
+    if (is_valid_edge(edge, tot_global_verts)) {
+      edges.append(edge);
+    }
+  }
+
+  VertexMap vertex_map;
+  build_vertex_map(mesh_geometry_, polys, edges, vertex_is_used, vertex_map);
+  if (vertex_map.global_indices.is_empty()) {
+    return nullptr;
+  }
+
+  Mesh *mesh = BKE_mesh_new_nomain(
+      vertex_map.global_indices.size(), edges.size(), 0, tot_loops, polys.size());
+
+  threading::parallel_for(vertex_map.global_indices.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      copy_v3_v3(mesh->mvert[i].co, global_vertices_.vertices[vertex_map.global_indices[i]]);
+    }
+  });
+
+  const bool has_uv = mesh_geometry_.has_uv && !global_vertices_.uv_vertices.is_empty();
+  const bool has_normals = mesh_geometry_.has_vertex_normals &&
+                           !global_vertices_.vertex_normals.is_empty();
+  MLoopUV *mloopuv = nullptr;
+  if (has_uv) {
+    mloopuv = static_cast<MLoopUV *>(CustomData_add_layer_named(
+        &mesh->ldata, CD_MLOOPUV, CD_CALLOC, nullptr, tot_loops, "UVMap"));
+  }
+  Array<float3> loop_normals(has_normals ? tot_loops : 0);
+  const int tot_uv_verts = global_vertices_.uv_vertices.size();
+  const int tot_normals = global_vertices_.vertex_normals.size();
+
+  threading::parallel_for(polys.index_range(), 1024, [&](IndexRange range) {
+    for (const int i : range) {
+      const PolyElem &poly = mesh_geometry_.face_elements[polys[i]];
+      MPoly &mpoly = mesh->mpoly[i];
+      mpoly.loopstart = loop_offsets[i];
+      mpoly.totloop = poly.corner_count;
+      mpoly.mat_nr = std::max(poly.material_index, 0);
+      if (poly.shaded_smooth) {
+        mpoly.flag |= ME_SMOOTH;
+      }
+      for (const int j : IndexRange(poly.corner_count)) {
+        const PolyCorner &corner = mesh_geometry_.face_corners[poly.start_index + j];
+        const int loop_index = mpoly.loopstart + j;
+        mesh->mloop[loop_index].v = vertex_map.mesh_index(corner.vert_index);
+        if (mloopuv) {
+          const int uv_index = corner.uv_vert_index;
+          if (uv_index >= 0 && uv_index < tot_uv_verts) {
+            copy_v2_v2(mloopuv[loop_index].uv, global_vertices_.uv_vertices[uv_index]);
+          }
+        }
+        if (has_normals) {
+          const int normal_index = corner.vertex_normal_index;
+          /* Zero normals make #BKE_mesh_set_custom_normals use the automatic normal. */
+          loop_normals[loop_index] = (normal_index >= 0 && normal_index < tot_normals) ?
+                                         global_vertices_.vertex_normals[normal_index] :
+                                         float3(0.0f);
+        }
+      }
+    }
+  });
+
+  for (const int i : edges.index_range()) {
+    MEdge &medge = mesh->medge[i];
+    medge.v1 = vertex_map.mesh_index(edges[i][0]);
+    medge.v2 = vertex_map.mesh_index(edges[i][1]);
+    medge.flag = ME_EDGEDRAW | ME_EDGERENDER | ME_LOOSEEDGE;
+  }
+  /* Add the edges of the faces, keeping the loose edges from the file. */
+  BKE_mesh_calc_edges(mesh, true, false);
+
+  if (has_normals) {
+    mesh->flag |= ME_AUTOSMOOTH;
+    BKE_mesh_set_custom_normals(mesh, reinterpret_cast<float(*)[3]>(loop_normals.data()));
+  }
+
+  if (import_params.validate_meshes) {
+    BKE_mesh_validate(mesh, false, true);
+  }
+  return mesh;
+}
+
+void MeshFromGeometry::create_materials(Main *bmain, Object *obj) const
+{
+  for (const std::string &name : mesh_geometry_.material_names) {
+    Material *mat = reinterpret_cast<Material *>(
+        BKE_libblock_find_name(bmain, ID_MA, name.c_str()));
+    const bool is_new = mat == nullptr;
+    if (is_new) {
+      mat = BKE_material_add(bmain, name.c_str());
+    }
+    BKE_object_material_slot_add(bmain, obj);
+    BKE_object_material_assign(bmain, obj, mat, obj->totcol, BKE_MAT_ASSIGN_USERPREF);
+    if (is_new) {
+      /* The material is only used by the object. */
+      id_us_min(&mat->id);
+    }
+  }
+}
+
+Object *MeshFromGeometry::create_object(Main *bmain, Mesh *mesh) const
+{
+  const char *name = mesh_geometry_.geometry_name.c_str();
+  Object *obj = BKE_object_add_only_object(bmain, OB_MESH, name);
+  obj->data = BKE_object_obdata_add_from_type(bmain, OB_MESH, name);
+  BKE_mesh_nomain_to_mesh(mesh, static_cast<Mesh *>(obj->data), obj, &CD_MASK_EVERYTHING, true);
+  create_materials(bmain, obj);
+  return obj;
+}
+
+}  // namespace blender::io::obj
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include "BLI_span.hh"
+#include "BLI_utility_mixins.hh"
+
+#include "IO_wavefront_obj.h"
+
+#include "obj_import_objects.hh"
+
+struct Main;
+struct Mesh;
+struct Object;
+
+namespace blender::io::obj {
+
+/**
+ * Make a Blender Mesh from a #Geometry and the #GlobalVertices it indexes into.
+ */
+class MeshFromGeometry : NonMovable, NonCopyable {
+ private:
+  const Geometry &mesh_geometry_;
+  const GlobalVertices &global_vertices_;
+
+ public:
+  MeshFromGeometry(const Geometry &mesh_geometry, const GlobalVertices &global_vertices)
+      : mesh_geometry_(mesh_geometry), global_vertices_(global_vertices)
+  {
+  }
+
+  /**
+   * Create a mesh outside of #Main. This does not touch any global data, so meshes of
+   * different objects can be created in parallel.
+   *
+   * Vertices referenced by faces or edges become mesh vertices. Objects without faces and edges
+   * get the vertices declared in their part of the file instead; `vertex_is_used`, if not empty,
+   * tells which of those are referenced by other objects and should be skipped.
+   *
+   * \return The new mesh, or null if there is nothing to create.
+   */
+  Mesh *create_mesh(const OBJImportParams &import_params, Span<bool> vertex_is_used) const;
+
+  /**
+   * Add an object using `mesh` (created by #create_mesh, ownership is taken) to `bmain`,
+   * and assign its materials. The object is not linked to any collection.
+   */
+  Object *create_object(Main *bmain, Mesh *mesh) const;
+
+ private:
+  bool is_valid_poly(const PolyElem &poly) const;
+  void create_materials(Main *bmain, Object *obj) const;
+};
+
+}  // namespace blender::io::obj
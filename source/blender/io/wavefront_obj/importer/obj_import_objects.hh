@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include <string>
+
+#include "BLI_math_vec_types.hh"
+#include "BLI_vector.hh"
+#include "BLI_vector_set.hh"
+
+namespace blender::io::obj {
+
+/**
+ * All vertex positions, UV vertices and normals of an OBJ file.
+ * Face corners of every #Geometry index into these arrays.
+ */
+struct GlobalVertices {
+  Vector<float3> vertices;
+  Vector<float2> uv_vertices;
+  Vector<float3> vertex_normals;
+};
+
+/**
+ * A face corner: indices into #GlobalVertices arrays, or -1 for elements
+ * that are not present (or were invalid) in the file.
+ */
+struct PolyCorner {
+  int vert_index = -1;
+  int uv_vert_index = -1;
+  int vertex_normal_index = -1;
+};
+
+struct PolyElem {
+  /** Index of the first corner in #Geometry.face_corners. */
+  int start_index = 0;
+  int corner_count = 0;
+  /** Index into #Geometry.material_names, or -1 if no material was set. */
+  int material_index = -1;
+  bool shaded_smooth = false;
+};
+
+/**
+ * Contains data for one object ("o" or "g" statement) of the OBJ file.
+ */
+struct Geometry {
+  std::string geometry_name;
+
+  /** Vertices declared ("v" statements) while this object was the current one. */
+  int vertex_start = 0;
+  int vertex_count = 0;
+
+  Vector<PolyElem> face_elements;
+  Vector<PolyCorner> face_corners;
+  /** Loose edges from "l" statements, as indices into #GlobalVertices.vertices. */
+  Vector<int2> edges;
+  /** Names of the materials used by the faces, in order of first use. */
+  VectorSet<std::string> material_names;
+
+  bool has_uv = false;
+  bool has_vertex_normals = false;
+
+  /** True if the object has neither faces nor loose edges. */
+  bool is_vertex_only() const
+  {
+    return face_elements.is_empty() && edges.is_empty();
+  }
+};
+
+}  // namespace blender::io::obj
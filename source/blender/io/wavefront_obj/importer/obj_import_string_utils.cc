@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include <charconv>
+#include <cmath>
+
+#include "BLI_utildefines.h"
+
+#include "obj_import_string_utils.hh"
+
+namespace blender::io::obj {
+
+StringRef read_next_line(StringRef &buffer)
+{
+  const char *start = buffer.begin();
+  const char *end = buffer.end();
+  size_t len = 0;
+  char prev = 0;
+  const char *ptr = start;
+  while (ptr < end) {
+    char c = *ptr++;
+    if (c == '\n' && prev != '\\') {
+      break;
+    }
+    /* Also allow line continuations with Windows line endings. */
+    if (c != '\r') {
+      prev = c;
+    }
+    ++len;
+  }
+
+  buffer = StringRef(ptr, end);
+  return StringRef(start, len);
+}
+
+static bool is_whitespace(char c)
+{
+  return c <= ' ' || c == '\\';
+}
+
+static bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+const char *drop_whitespace(const char *p, const char *end)
+{
+  while (p < end && is_whitespace(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+const char *drop_non_whitespace(const char *p, const char *end)
+{
+  while (p < end && !is_whitespace(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+static const char *drop_plus(const char *p, const char *end)
+{
+  if (p < end && *p == '+') {
+    ++p;
+  }
+  return p;
+}
+
+const char *parse_int(const char *p, const char *end, int fallback, int &dst, bool skip_space)
+{
+  if (skip_space) {
+    p = drop_whitespace(p, end);
+  }
+  p = drop_plus(p, end);
+  std::from_chars_result res = std::from_chars(p, end, dst);
+  if (res.ec == std::errc::invalid_argument || res.ec == std::errc::result_out_of_range) {
+    dst = fallback;
+    return p;
+  }
+  return res.ptr;
+}
+
+/**
+ * Exact powers of ten representable in a double. Scaling by these only rounds once, so up to
+ * 19 significant digits are parsed with float accuracy.
+ */
+static const double exact_powers_of_ten[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                             1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                             1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static double scale_by_power_of_ten(double value, int exponent)
+{
+  const int max_exact = ARRAY_SIZE(exact_powers_of_ten) - 1;
+  if (exponent >= 0) {
+    return exponent <= max_exact ? value * exact_powers_of_ten[exponent] :
+                                   value * std::pow(10.0, exponent);
+  }
+  return -exponent <= max_exact ? value / exact_powers_of_ten[-exponent] :
+                                  value * std::pow(10.0, exponent);
+}
+
+const char *parse_float(
+    const char *p, const char *end, float fallback, float &dst, bool skip_space)
+{
+  if (skip_space) {
+    p = drop_whitespace(p, end);
+  }
+  const char *start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  /* Accumulate up to 19 significant digits into an integer mantissa, and track the decimal
+   * exponent separately. Digits beyond that do not affect a float result. */
+  uint64_t mantissa = 0;
+  int significant_digits = 0;
+  int exponent = 0;
+  bool any_digits = false;
+  while (p < end && is_digit(*p)) {
+    if (significant_digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      significant_digits += mantissa != 0;
+    }
+    else {
+      exponent++;
+    }
+    any_digits = true;
+    ++p;
+  }
+  if (p < end && *p == '.') {
+    ++p;
+    while (p < end && is_digit(*p)) {
+      if (significant_digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        significant_digits += mantissa != 0;
+        exponent--;
+      }
+      any_digits = true;
+      ++p;
+    }
+  }
+  if (!any_digits) {
+    dst = fallback;
+    return start;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    int exp_value = 0;
+    const char *exp_end = parse_int(p + 1, end, 0, exp_value, false);
+    if (exp_end != p + 1) {
+      exponent += exp_value;
+      p = exp_end;
+    }
+  }
+
+  const double value = scale_by_power_of_ten(double(mantissa), exponent);
+  dst = float(negative ? -value : value);
+  return p;
+}
+
+const char *parse_floats(const char *p, const char *end, float fallback, float *dst, int count)
+{
+  for (int i = 0; i < count; ++i) {
+    p = parse_float(p, end, fallback, dst[i]);
+  }
+  return p;
+}
+
+}  // namespace blender::io::obj
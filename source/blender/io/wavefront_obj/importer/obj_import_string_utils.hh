@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include "BLI_string_ref.hh"
+
+/*
+ * Various text parsing utilities used by OBJ importer.
+ * The utilities are not directly usable by other formats, since
+ * they treat backslash (\) as a whitespace character (OBJ format
+ * allows backslashes to function as a line-continuation character).
+ *
+ * Many of these functions take two pointers (p, end) indicating
+ * which part of a string to operate on, and return a possibly
+ * changed new start of the string. They could be taking a StringRef
+ * as input and returning a new StringRef, but this is a hot path
+ * in OBJ parsing, and the StringRef approach prevents the compiler
+ * from doing some optimizations.
+ */
+
+namespace blender::io::obj {
+
+/**
+ * Fetches next line from an input string buffer.
+ *
+ * The returned line will not have '\n' characters at the end;
+ * the `buffer` is modified to contain remaining text without
+ * the input line.
+ *
+ * Note that backslash (\) character is treated as a line
+ * continuation.
+ */
+StringRef read_next_line(StringRef &buffer);
+
+/**
+ * Drop leading white-space from a string part.
+ * Note that backslash character is considered white-space.
+ */
+const char *drop_whitespace(const char *p, const char *end);
+
+/**
+ * Drop leading non-white-space from a string part.
+ */
+const char *drop_non_whitespace(const char *p, const char *end);
+
+/**
+ * Parse an integer from an input string.
+ * The parsed result is stored in `dst`; the function returns
+ * the position in the string after the parsed number. If the
+ * number could not be parsed, `dst` is set to `fallback` and the
+ * input position is returned unchanged.
+ *
+ * \param skip_space: whether to drop leading white-space first.
+ */
+const char *parse_int(
+    const char *p, const char *end, int fallback, int &dst, bool skip_space = true);
+
+/**
+ * Parse a float from an input string.
+ * The parsed result is stored in `dst`; the function returns
+ * the position in the string after the parsed number. If the
+ * number could not be parsed, `dst` is set to `fallback` and the
+ * input position is returned unchanged.
+ *
+ * Parsing does not depend on the current locale, and only accepts
+ * plain decimal notation with an optional exponent.
+ *
+ * \param skip_space: whether to drop leading white-space first.
+ */
+const char *parse_float(
+    const char *p, const char *end, float fallback, float &dst, bool skip_space = true);
+
+/**
+ * Parse a number of white-space separated floats from an input string.
+ * The parsed result is stored in `dst`, which must be large enough to hold `count` values.
+ * Numbers that could not be parsed are set to `fallback`.
+ */
+const char *parse_floats(const char *p, const char *end, float fallback, float *dst, int count);
+
+}  // namespace blender::io::obj
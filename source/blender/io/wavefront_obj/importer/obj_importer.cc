@@ -0,0 +1,239 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#include <fcntl.h>
+#include <iostream>
+
+#ifndef WIN32
+#  include <unistd.h> /* For close. */
+#else
+#  include <io.h>
+#endif
+
+#include "DNA_collection_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_collection.h"
+#include "BKE_layer.h"
+#include "BKE_object.h"
+
+#include "BLI_array.hh"
+#include "BLI_fileops.h"
+#include "BLI_math_matrix.h"
+#include "BLI_math_vector.h"
+#include "BLI_math_rotation.h"
+#include "BLI_mmap.h"
+#include "BLI_path_util.h"
+#include "BLI_task.hh"
+#include "BLI_utility_mixins.hh"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "obj_import_file_reader.hh"
+#include "obj_import_mesh.hh"
+#include "obj_import_objects.hh"
+#include "obj_importer.hh"
+
+namespace blender::io::obj {
+
+/**
+ * Read-only contents of a file. The file is memory-mapped when possible, so that the parser
+ * threads read straight from the page cache instead of a copy.
+ */
+class OBJFileBuffer : NonMovable, NonCopyable {
+ private:
+  int file_ = -1;
+  BLI_mmap_file *mmap_file_ = nullptr;
+  /** Used when memory-mapping is not possible. */
+  void *memory_ = nullptr;
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  OBJFileBuffer(const char *filepath)
+  {
+    file_ = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+    if (file_ == -1) {
+      return;
+    }
+    size_ = BLI_file_descriptor_size(file_);
+    if (size_ == size_t(-1) || size_ == 0) {
+      size_ = 0;
+      return;
+    }
+    mmap_file_ = BLI_mmap_open(file_);
+    if (mmap_file_) {
+      data_ = static_cast<const char *>(BLI_mmap_get_pointer(mmap_file_));
+      return;
+    }
+    memory_ = BLI_file_read_binary_as_mem(filepath, 0, &size_);
+    data_ = static_cast<const char *>(memory_);
+  }
+
+  ~OBJFileBuffer()
+  {
+    if (mmap_file_) {
+      BLI_mmap_free(mmap_file_);
+    }
+    if (memory_) {
+      MEM_freeN(memory_);
+    }
+    if (file_ != -1) {
+      close(file_);
+    }
+  }
+
+  bool is_valid() const
+  {
+    return file_ != -1;
+  }
+
+  StringRef contents() const
+  {
+    return data_ ? StringRef(data_, size_) : StringRef();
+  }
+};
+
+/**
+ * Uniform scale that makes all imported vertices fit into `clamp_size`, or 1 if they do already.
+ */
+static float calc_clamp_scale(const GlobalVertices &global_vertices, const float clamp_size)
+{
+  if (clamp_size == 0.0f || global_vertices.vertices.is_empty()) {
+    return 1.0f;
+  }
+  float min[3], max[3];
+  INIT_MINMAX(min, max);
+  for (const float3 &vert : global_vertices.vertices) {
+    minmax_v3v3_v3(min, max, vert);
+  }
+  float size[3];
+  sub_v3_v3v3(size, max, min);
+  const float max_dimension = max_fff(size[0], size[1], size[2]);
+  return max_dimension > clamp_size ? clamp_size / max_dimension : 1.0f;
+}
+
+static void transform_object(Object *object, const OBJImportParams &import_params, float scale)
+{
+  float axes_transform[3][3];
+  unit_m3(axes_transform);
+  /* +Y-forward and +Z-up are the default Blender axis settings. */
+  mat3_from_axis_conversion(import_params.forward_axis,
+                            import_params.up_axis,
+                            OBJ_AXIS_Y_FORWARD,
+                            OBJ_AXIS_Z_UP,
+                            axes_transform);
+  /* mat3_from_axis_conversion returns a transposed matrix! */
+  transpose_m3(axes_transform);
+  mul_m3_fl(axes_transform, scale);
+
+  float obmat[4][4];
+  copy_m4_m3(obmat, axes_transform);
+  BKE_object_apply_mat4(object, obmat, true, false);
+}
+
+/**
+ * Tag vertices that are used by faces or edges of any object, so that objects without faces
+ * and edges only get the vertices nobody else uses.
+ */
+static Array<bool> calc_used_vertices(Span<std::unique_ptr<Geometry>> all_geometries,
+                                      const int tot_verts)
+{
+  Array<bool> vertex_is_used(tot_verts, false);
+  for (const std::unique_ptr<Geometry> &geometry : all_geometries) {
+    for (const PolyCorner &corner : geometry->face_corners) {
+      if (corner.vert_index >= 0 && corner.vert_index < tot_verts) {
+        vertex_is_used[corner.vert_index] = true;
+      }
+    }
+    for (const int2 &edge : geometry->edges) {
+      for (const int vert : {edge[0], edge[1]}) {
+        if (vert >= 0 && vert < tot_verts) {
+          vertex_is_used[vert] = true;
+        }
+      }
+    }
+  }
+  return vertex_is_used;
+}
+
+void importer_main(bContext *C, const OBJImportParams &import_params)
+{
+  Main *bmain = CTX_data_main(C);
+  Scene *scene = CTX_data_scene(C);
+  ViewLayer *view_layer = CTX_data_view_layer(C);
+  importer_main(bmain, scene, view_layer, import_params);
+}
+
+void importer_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   const OBJImportParams &import_params)
+{
+  Vector<std::unique_ptr<Geometry>> all_geometries;
+  GlobalVertices global_vertices;
+  {
+    OBJFileBuffer file_buffer(import_params.filepath);
+    if (!file_buffer.is_valid()) {
+      std::cerr << "Cannot read from OBJ file: '" << import_params.filepath << "'" << std::endl;
+      return;
+    }
+    char default_name[FILE_MAXFILE];
+    BLI_strncpy(default_name, BLI_path_basename(import_params.filepath), sizeof(default_name));
+    BLI_path_extension_replace(default_name, sizeof(default_name), "");
+    OBJParser parser(default_name);
+    parser.parse(file_buffer.contents(), all_geometries, global_vertices);
+  }
+
+  Array<bool> vertex_is_used;
+  for (const std::unique_ptr<Geometry> &geometry : all_geometries) {
+    if (geometry->is_vertex_only()) {
+      vertex_is_used = calc_used_vertices(all_geometries, global_vertices.vertices.size());
+      break;
+    }
+  }
+
+  /* Building meshes does not touch #Main, so do it for all objects in parallel. */
+  Array<Mesh *> meshes(all_geometries.size(), nullptr);
+  threading::parallel_for(all_geometries.index_range(), 1, [&](IndexRange range) {
+    for (const int i : range) {
+      MeshFromGeometry mesh_ob_from_geometry{*all_geometries[i], global_vertices};
+      meshes[i] = mesh_ob_from_geometry.create_mesh(import_params, vertex_is_used);
+    }
+  });
+
+  const float scale = calc_clamp_scale(global_vertices, import_params.clamp_size);
+
+  /* Add objects to the scene. */
+  BKE_view_layer_base_deselect_all(view_layer);
+  LayerCollection *lc = BKE_layer_collection_get_active(view_layer);
+  for (const int i : all_geometries.index_range()) {
+    if (meshes[i] == nullptr) {
+      continue;
+    }
+    MeshFromGeometry mesh_ob_from_geometry{*all_geometries[i], global_vertices};
+    Object *obj = mesh_ob_from_geometry.create_object(bmain, meshes[i]);
+    transform_object(obj, import_params, scale);
+
+    BKE_collection_object_add(bmain, lc->collection, obj);
+    Base *base = BKE_view_layer_base_find(view_layer, obj);
+    BKE_view_layer_base_select_and_set_active(view_layer, base);
+
+    DEG_id_tag_update(&lc->collection->id, ID_RECALC_COPY_ON_WRITE);
+    DEG_id_tag_update_ex(bmain,
+                         &obj->id,
+                         ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY | ID_RECALC_ANIMATION |
+                             ID_RECALC_BASE_FLAGS);
+  }
+
+  DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
+  DEG_relations_tag_update(bmain);
+}
+
+}  // namespace blender::io::obj
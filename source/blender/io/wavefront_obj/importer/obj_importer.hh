@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup obj
+ */
+
+#pragma once
+
+#include "IO_wavefront_obj.h"
+
+struct Main;
+struct Scene;
+struct ViewLayer;
+
+namespace blender::io::obj {
+
+/**
+ * Import the OBJ file given in `import_params`, adding its objects to the active collection of
+ * the current view layer.
+ */
+void importer_main(bContext *C, const OBJImportParams &import_params);
+
+/**
+ * Version of #importer_main that does not need a context, so it can be used in tests and from
+ * other places that do not have one.
+ */
+void importer_main(Main *bmain,
+                   Scene *scene,
+                   ViewLayer *view_layer,
+                   const OBJImportParams &import_params);
+
+}  // namespace blender::io::obj
@@ -0,0 +1,324 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+
+#include <gtest/gtest.h>
+
+#include "testing/testing.h"
+#include "tests/blendfile_loading_base_test.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_lib_id.h"
+
+#include "obj_import_file_reader.hh"
+#include "obj_import_mesh.hh"
+#include "obj_import_string_utils.hh"
+
+namespace blender::io::obj {
+
+/* -------------------------------------------------------------------- */
+/** \name String Utilities
+ * \{ */
+
+TEST(obj_import_string_utils, read_next_line)
+{
+  StringRef buffer = "abc\nde \\\nfg\r\n\nh";
+  EXPECT_EQ(read_next_line(buffer), "abc");
+  EXPECT_EQ(read_next_line(buffer), "de \\\nfg\r");
+  EXPECT_EQ(read_next_line(buffer), "");
+  EXPECT_EQ(read_next_line(buffer), "h");
+  EXPECT_TRUE(buffer.is_empty());
+}
+
+TEST(obj_import_string_utils, parse_int)
+{
+  const StringRef str = " 123 -45 +6 x 7/8";
+  const char *p = str.begin();
+  const char *end = str.end();
+  int val;
+  p = parse_int(p, end, -1, val);
+  EXPECT_EQ(val, 123);
+  p = parse_int(p, end, -1, val);
+  EXPECT_EQ(val, -45);
+  p = parse_int(p, end, -1, val);
+  EXPECT_EQ(val, 6);
+  p = parse_int(p, end, -1, val);
+  EXPECT_EQ(val, -1);
+  p = drop_non_whitespace(p, end);
+  p = parse_int(p, end, -1, val);
+  EXPECT_EQ(val, 7);
+  EXPECT_EQ(*p, '/');
+}
+
+TEST(obj_import_string_utils, parse_float)
+{
+  const StringRef str = "1 -2.5 .25 1e3 -1.5E-2 0.000123456789 12345678901234567890 +7. abc";
+  const char *p = str.begin();
+  const char *end = str.end();
+  float val;
+  p = parse_float(p, end, -1.0f, val);
+  EXPECT_FLOAT_EQ(val, 1.0f);
+  p = parse_float(p, end, -1.0f, val);
+  EXPECT_FLOAT_EQ(val, -2.5f);
+  p = parse_float(p, end, -1.0f, val);
+  EXPECT_FLOAT_EQ(val, 0.25f);
+  p = parse_float(p, end, -1.0f, val);
+  EXPECT_FLOAT_EQ(val, 1000.0f);
+  p = parse_float(p, end, -1.0f, val);
+  EXPECT_FLOAT_EQ(val, -0.015f);
+  p = parse_float(p, end, -1.0f, val);
+  EXPECT_FLOAT_EQ(val, 0.000123456789f);
+  p = parse_float(p, end, -1.0f, val);
+  EXPECT_FLOAT_EQ(val, 12345678901234567890.0f);
+  p = parse_float(p, end, -1.0f, val);
+  EXPECT_FLOAT_EQ(val, 7.0f);
+  p = parse_float(p, end, -1.0f, val);
+  EXPECT_FLOAT_EQ(val, -1.0f);
+  EXPECT_EQ(*p, 'a');
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Parser
+ * \{ */
+
+struct ParseResult {
+  Vector<std::unique_ptr<Geometry>> geometries;
+  GlobalVertices global_vertices;
+};
+
+static ParseResult parse_text(StringRef text, size_t chunk_size = OBJParser::default_chunk_size)
+{
+  ParseResult result;
+  OBJParser parser("Default", chunk_size);
+  parser.parse(text, result.geometries, result.global_vertices);
+  return result;
+}
+
+static const char *cube_and_plane_obj =
+    "# Comment\n"
+    "mtllib cube.mtl\n"
+    "o Cube\n"
+    "v 1 1 -1\n"
+    "v 1 -1 -1\n"
+    "v 1 1 1\n"
+    "v 1 -1 1\n"
+    "v -1 1 -1\n"
+    "v -1 -1 -1\n"
+    "v -1 1 1\n"
+    "v -1 -1 1\n"
+    "vt 0.625 0.5\n"
+    "vt 0.875 0.5\n"
+    "vt 0.875 0.75\n"
+    "vt 0.625 0.75\n"
+    "vn 0 1 0\n"
+    "vn 0 0 1\n"
+    "usemtl Red\n"
+    "s off\n"
+    "f 1/1/1 5/2/1 7/3/1 3/4/1\n"
+    "f 4/1/2 3/2/2 7/3/2 8/4/2\n"
+    "usemtl Blue\n"
+    "s 1\n"
+    "f 8/1 7/2 5/3 6/4\n"
+    "f 6//1 2//1 4//1 8//1\n"
+    "f 2 1 3 \\\n 4\n"
+    "usemtl Red\n"
+    "f 6 5 1 2\n"
+    "l 1 2 8\n"
+    "o Plane\n"
+    "v -1 0 -1\n"
+    "v 1 0 -1\n"
+    "v -1 0 1\n"
+    "v 1 0 1\n"
+    "f -4 -3 -1 -2\n";
+
+TEST(obj_importer_parser, cube_and_plane)
+{
+  ParseResult result = parse_text(cube_and_plane_obj);
+  ASSERT_EQ(result.geometries.size(), 2);
+  EXPECT_EQ(result.global_vertices.vertices.size(), 12);
+  EXPECT_EQ(result.global_vertices.uv_vertices.size(), 4);
+  EXPECT_EQ(result.global_vertices.vertex_normals.size(), 2);
+  EXPECT_V3_NEAR(result.global_vertices.vertices[5], float3(-1, -1, -1), 1e-6f);
+
+  const Geometry &cube = *result.geometries[0];
+  EXPECT_EQ(cube.geometry_name, "Cube");
+  EXPECT_EQ(cube.vertex_start, 0);
+  EXPECT_EQ(cube.vertex_count, 8);
+  ASSERT_EQ(cube.face_elements.size(), 6);
+  EXPECT_EQ(cube.face_corners.size(), 24);
+  EXPECT_EQ(cube.edges.size(), 2);
+  EXPECT_TRUE(cube.has_uv);
+  EXPECT_TRUE(cube.has_vertex_normals);
+  ASSERT_EQ(cube.material_names.size(), 2);
+  EXPECT_EQ(cube.material_names[0], "Red");
+  EXPECT_EQ(cube.material_names[1], "Blue");
+
+  EXPECT_EQ(cube.face_elements[0].material_index, 0);
+  EXPECT_FALSE(cube.face_elements[0].shaded_smooth);
+  EXPECT_EQ(cube.face_elements[2].material_index, 1);
+  EXPECT_TRUE(cube.face_elements[2].shaded_smooth);
+  EXPECT_EQ(cube.face_elements[5].material_index, 0);
+  EXPECT_TRUE(cube.face_elements[5].shaded_smooth);
+
+  /* Continued line. */
+  const PolyElem &continued = cube.face_elements[4];
+  EXPECT_EQ(continued.corner_count, 4);
+  EXPECT_EQ(cube.face_corners[continued.start_index + 3].vert_index, 3);
+
+  const PolyCorner &corner = cube.face_corners[cube.face_elements[1].start_index];
+  EXPECT_EQ(corner.vert_index, 3);
+  EXPECT_EQ(corner.uv_vert_index, 0);
+  EXPECT_EQ(corner.vertex_normal_index, 1);
+  const PolyCorner &corner_no_uv = cube.face_corners[cube.face_elements[3].start_index];
+  EXPECT_EQ(corner_no_uv.uv_vert_index, -1);
+  EXPECT_EQ(corner_no_uv.vertex_normal_index, 0);
+
+  const Geometry &plane = *result.geometries[1];
+  EXPECT_EQ(plane.geometry_name, "Plane");
+  EXPECT_EQ(plane.vertex_start, 8);
+  EXPECT_EQ(plane.vertex_count, 4);
+  ASSERT_EQ(plane.face_elements.size(), 1);
+  EXPECT_FALSE(plane.has_uv);
+  /* Relative indices. */
+  EXPECT_EQ(plane.face_corners[0].vert_index, 8);
+  EXPECT_EQ(plane.face_corners[1].vert_index, 9);
+  EXPECT_EQ(plane.face_corners[2].vert_index, 11);
+  EXPECT_EQ(plane.face_corners[3].vert_index, 10);
+  /* State carries over to the next object. */
+  EXPECT_EQ(plane.material_names.size(), 1);
+  EXPECT_EQ(plane.material_names[0], "Red");
+}
+
+TEST(obj_importer_parser, chunk_size_does_not_change_result)
+{
+  const ParseResult expected = parse_text(cube_and_plane_obj);
+  for (const size_t chunk_size : {1, 2, 7, 30, 100}) {
+    const ParseResult result = parse_text(cube_and_plane_obj, chunk_size);
+    ASSERT_EQ(result.geometries.size(), expected.geometries.size());
+    EXPECT_EQ_ARRAY(result.global_vertices.vertices.data(),
+                    expected.global_vertices.vertices.data(),
+                    expected.global_vertices.vertices.size());
+    for (const int i : expected.geometries.index_range()) {
+      const Geometry &a = *result.geometries[i];
+      const Geometry &b = *expected.geometries[i];
+      EXPECT_EQ(a.geometry_name, b.geometry_name);
+      EXPECT_EQ(a.vertex_start, b.vertex_start);
+      EXPECT_EQ(a.vertex_count, b.vertex_count);
+      EXPECT_EQ(a.material_names.size(), b.material_names.size());
+      EXPECT_EQ(a.edges.size(), b.edges.size());
+      ASSERT_EQ(a.face_elements.size(), b.face_elements.size());
+      ASSERT_EQ(a.face_corners.size(), b.face_corners.size());
+      for (const int j : b.face_elements.index_range()) {
+        EXPECT_EQ(a.face_elements[j].start_index, b.face_elements[j].start_index);
+        EXPECT_EQ(a.face_elements[j].corner_count, b.face_elements[j].corner_count);
+        EXPECT_EQ(a.face_elements[j].material_index, b.face_elements[j].material_index);
+        EXPECT_EQ(a.face_elements[j].shaded_smooth, b.face_elements[j].shaded_smooth);
+      }
+      for (const int j : b.face_corners.index_range()) {
+        EXPECT_EQ(a.face_corners[j].vert_index, b.face_corners[j].vert_index);
+        EXPECT_EQ(a.face_corners[j].uv_vert_index, b.face_corners[j].uv_vert_index);
+        EXPECT_EQ(a.face_corners[j].vertex_normal_index, b.face_corners[j].vertex_normal_index);
+      }
+    }
+  }
+}
+
+TEST(obj_importer_parser, default_object_and_empty_objects)
+{
+  ParseResult result = parse_text(
+      "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\ng\no Empty\no Points\nv 5 5 5\nv 6 6 6\n");
+  ASSERT_EQ(result.geometries.size(), 2);
+  EXPECT_EQ(result.geometries[0]->geometry_name, "Default");
+  EXPECT_EQ(result.geometries[0]->face_elements.size(), 1);
+  EXPECT_EQ(result.geometries[1]->geometry_name, "Points");
+  EXPECT_TRUE(result.geometries[1]->is_vertex_only());
+  EXPECT_EQ(result.geometries[1]->vertex_start, 3);
+  EXPECT_EQ(result.geometries[1]->vertex_count, 2);
+}
+
+TEST(obj_importer_parser, keyword_at_line_end)
+{
+  /* A bare `s` turns smooth shading off. */
+  ParseResult result = parse_text(
+      "v 0 0 0\nv 1 0 0\nv 0 1 0\ns 1\nf 1 2 3\ns\nf 1 2 3\ns 1\nf 1 2 3\ns");
+  ASSERT_EQ(result.geometries.size(), 1);
+  const Geometry &geometry = *result.geometries[0];
+  ASSERT_EQ(geometry.face_elements.size(), 3);
+  EXPECT_TRUE(geometry.face_elements[0].shaded_smooth);
+  EXPECT_FALSE(geometry.face_elements[1].shaded_smooth);
+  EXPECT_TRUE(geometry.face_elements[2].shaded_smooth);
+  /* Keywords must be followed by white-space or the line end, also on the last line without a
+   * line break. */
+  result = parse_text("vx 1 2 3\nv 1 2 3\nv");
+  EXPECT_EQ(result.global_vertices.vertices.size(), 2);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Creation
+ * \{ */
+
+/* Only used for the initialization of Blender's kernel, no file is loaded. */
+class obj_importer_mesh_test : public BlendfileLoadingBaseTest {
+};
+
+TEST_F(obj_importer_mesh_test, cube_mesh)
+{
+  ParseResult result = parse_text(cube_and_plane_obj);
+  OBJImportParams params{};
+  params.validate_meshes = true;
+
+  MeshFromGeometry cube_from_geometry(*result.geometries[0], result.global_vertices);
+  Mesh *cube = cube_from_geometry.create_mesh(params, {});
+  ASSERT_NE(cube, nullptr);
+  EXPECT_EQ(cube->totvert, 8);
+  EXPECT_EQ(cube->totpoly, 6);
+  EXPECT_EQ(cube->totloop, 24);
+  /* The loose edge 1-2 is also a face edge, 2-8 is not. */
+  EXPECT_EQ(cube->totedge, 13);
+  EXPECT_EQ(cube->mpoly[2].mat_nr, 1);
+  EXPECT_TRUE(cube->mpoly[2].flag & ME_SMOOTH);
+  EXPECT_NE(CustomData_get_layer(&cube->ldata, CD_MLOOPUV), nullptr);
+  EXPECT_NE(CustomData_get_layer(&cube->ldata, CD_CUSTOMLOOPNORMAL), nullptr);
+  BKE_id_free(nullptr, cube);
+
+  MeshFromGeometry plane_from_geometry(*result.geometries[1], result.global_vertices);
+  Mesh *plane = plane_from_geometry.create_mesh(params, {});
+  ASSERT_NE(plane, nullptr);
+  EXPECT_EQ(plane->totvert, 4);
+  EXPECT_EQ(plane->totpoly, 1);
+  EXPECT_EQ(plane->totedge, 4);
+  EXPECT_EQ(plane->mloop[0].v, 0);
+  EXPECT_EQ(plane->mloop[2].v, 3);
+  EXPECT_EQ(CustomData_get_layer(&plane->ldata, CD_MLOOPUV), nullptr);
+  BKE_id_free(nullptr, plane);
+}
+
+TEST_F(obj_importer_mesh_test, invalid_faces_are_skipped)
+{
+  ParseResult result = parse_text(
+      "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\n"
+      "f 1 2 3\n"  /* Valid. */
+      "f 1 2\n"    /* Too few corners. */
+      "f 1 2 9\n"  /* Missing vertex. */
+      "f 1 2 2\n"  /* Degenerate edge. */
+      "f 0 1 2\n"  /* Invalid index. */
+      "f 2 4 3\n"  /* Valid. */
+  );
+  OBJImportParams params{};
+  MeshFromGeometry mesh_from_geometry(*result.geometries[0], result.global_vertices);
+  Mesh *mesh = mesh_from_geometry.create_mesh(params, {});
+  ASSERT_NE(mesh, nullptr);
+  EXPECT_EQ(mesh->totvert, 4);
+  EXPECT_EQ(mesh->totpoly, 2);
+  EXPECT_EQ(mesh->totloop, 6);
+  BKE_id_free(nullptr, mesh);
+}
+
+/** \} */
+
+}  // namespace blender::io::obj
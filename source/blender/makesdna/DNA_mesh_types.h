@@ -73,6 +73,9 @@ typedef struct Mesh_Runtime {
   /** Needed to ensure some thread-safety during render data pre-processing. */
   void *render_mutex;
 
+  /** Protects the lazily computed topology caches below. */
+  void *topology_mutex;
+
   /** Lazily initialized SoA data from the #edit_mesh field in #Mesh. */
   struct EditMeshData *edit_data;
 
@@ -134,7 +137,26 @@ typedef struct Mesh_Runtime {
   float (*vert_normals)[3];
   float (*poly_normals)[3];
 
-  void *_pad2;
+  /**
+   * Face corner topology used to calculate split normals, see #BKE_mesh_corner_topology_ensure.
+   * Cleared with the other geometry caches, #edge_to_loops being null means it isn't computed.
+   * Code changing the vertices or edges of face corners in place must clear it as well, see
+   * #BKE_mesh_runtime_clear_geometry. #BKE_mesh_calc_normals_split only fills it for evaluated
+   * meshes.
+   */
+  int (*edge_to_loops)[2];
+  int *loop_to_poly;
+
+  /**
+   * Lazily computed topology maps, see #BKE_mesh_runtime_vert_poly_map_ensure and similar.
+   * The `_mem` arrays store the indices the map elements point into.
+   */
+  struct MeshElemMap *vert_poly_map;
+  int *vert_poly_map_mem;
+  struct MeshElemMap *vert_edge_map;
+  int *vert_edge_map_mem;
+  struct MeshElemMap *edge_poly_map;
+  int *edge_poly_map_mem;
 } Mesh_Runtime;
 
 typedef struct Mesh {
@@ -2292,7 +2292,11 @@ typedef struct NodesModifierData {
    * This can be used to help the user to debug a node tree.
    */
   void *runtime_eval_log;
-  void *_pad1;
+  /**
+   * Output values of individual nodes from previous evaluations that can be reused when the
+   * modifier is evaluated again, see #NodeOutputCache. Only used on the original modifier.
+   */
+  void *runtime_output_cache;
 } NodesModifierData;
 
 typedef struct MeshToVolumeModifierData {
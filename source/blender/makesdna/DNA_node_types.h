@@ -858,7 +858,10 @@ typedef struct NodeVertexCol {
 
 /** Defocus blur node. */
 typedef struct NodeDefocus {
-  char bktype, _pad0, preview, gamco;
+  char bktype;
+  /** #CMPNodeBokehBlurAlgorithm. */
+  char algorithm;
+  char preview, gamco;
   short samples, no_zbuf;
   float fstop, maxblur, bthresh, scale;
   float rotation;
@@ -1864,6 +1867,14 @@ typedef enum CMPNodeSetAlphaMode {
   CMP_NODE_SETALPHA_MODE_REPLACE_ALPHA = 1,
 } CMPNodeSetAlphaMode;
 
+/* Defocus and Bokeh Blur Nodes. */
+
+/** #NodeDefocus.algorithm and #bNode.custom2 of the bokeh blur node. */
+typedef enum CMPNodeBokehBlurAlgorithm {
+  CMP_NODE_BOKEH_BLUR_ACCURATE = 0,
+  CMP_NODE_BOKEH_BLUR_FAST = 1,
+} CMPNodeBokehBlurAlgorithm;
+
 /* Denoise Node. */
 
 /** #NodeDenoise.prefilter */
@@ -7454,6 +7454,23 @@ static void def_cmp_map_uv(StructRNA *srna)
   RNA_def_property_update(prop, NC_NODE | NA_EDITED, "rna_Node_update");
 }
 
+static const EnumPropertyItem cmp_node_bokeh_blur_algorithm_items[] = {
+    {CMP_NODE_BOKEH_BLUR_ACCURATE,
+     "ACCURATE",
+     0,
+     "Accurate",
+     "Gather every pixel inside the bokeh shape, processing time grows with the square of the "
+     "blur radius"},
+    {CMP_NODE_BOKEH_BLUR_FAST,
+     "FAST",
+     0,
+     "Fast",
+     "Sum rows of the bokeh shape at once, processing time grows linearly with the blur radius. "
+     "Hollow or soft bokeh shapes are approximated and only the Full Frame execution mode is "
+     "supported"},
+    {0, NULL, 0, NULL, NULL},
+};
+
 static void def_cmp_defocus(StructRNA *srna)
 {
   PropertyRNA *prop;
@@ -7530,6 +7547,12 @@ static void def_cmp_defocus(StructRNA *srna)
   RNA_def_property_ui_text(prop, "Preview", "Enable low quality mode, useful for preview");
   RNA_def_property_update(prop, NC_NODE | NA_EDITED, "rna_Node_update");
 
+  prop = RNA_def_property(srna, "blur_algorithm", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_sdna(prop, NULL, "algorithm");
+  RNA_def_property_enum_items(prop, cmp_node_bokeh_blur_algorithm_items);
+  RNA_def_property_ui_text(prop, "Algorithm", "Algorithm used to blur the image");
+  RNA_def_property_update(prop, NC_NODE | NA_EDITED, "rna_Node_update");
+
   prop = RNA_def_property(srna, "use_zbuffer", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_negative_sdna(prop, NULL, "no_zbuf", 1);
   RNA_def_property_ui_text(prop,
@@ -8306,6 +8329,12 @@ static void def_cmp_bokehblur(StructRNA *srna)
       prop, "Extend Bounds", "Extend bounds of the input image to fully fit blurred image");
   RNA_def_property_update(prop, NC_NODE | NA_EDITED, "rna_Node_update");
 
+  prop = RNA_def_property(srna, "blur_algorithm", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_sdna(prop, NULL, "custom2");
+  RNA_def_property_enum_items(prop, cmp_node_bokeh_blur_algorithm_items);
+  RNA_def_property_ui_text(prop, "Algorithm", "Algorithm used to blur the image");
+  RNA_def_property_update(prop, NC_NODE | NA_EDITED, "rna_Node_update");
+
 #  if 0
   prop = RNA_def_property(srna, "f_stop", PROP_FLOAT, PROP_NONE);
   RNA_def_property_float_sdna(prop, NULL, "custom3");
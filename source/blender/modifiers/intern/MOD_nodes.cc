@@ -32,6 +32,7 @@
 #include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
 #include "DNA_space_types.h"
+#include "DNA_userdef_types.h"
 #include "DNA_windowmanager_types.h"
 
 #include "BKE_attribute_math.hh"
@@ -71,6 +72,7 @@
 #include "MOD_modifiertypes.h"
 #include "MOD_nodes.h"
 #include "MOD_nodes_evaluator.hh"
+#include "MOD_nodes_output_cache.hh"
 #include "MOD_ui_common.h"
 
 #include "ED_object.h"
@@ -111,6 +113,7 @@ using blender::fn::Field;
 using blender::fn::GField;
 using blender::fn::ValueOrField;
 using blender::fn::ValueOrFieldCPPType;
+using blender::modifiers::geometry_nodes::NodeOutputCache;
 using blender::nodes::FieldInferencingInterface;
 using blender::nodes::GeoNodeExecParams;
 using blender::nodes::InputSocketFieldType;
@@ -379,6 +382,22 @@ static bool logging_enabled(const ModifierEvalContext *ctx)
   return true;
 }
 
+/**
+ * Reusing node outputs from previous evaluations only pays off when the same modifier is
+ * evaluated over and over again with small changes, which is the case for the active depsgraph.
+ * Other depsgraphs (e.g. for final renders) would just keep memory alive.
+ */
+static bool output_cache_enabled(const ModifierEvalContext *ctx)
+{
+  if (!DEG_is_active(ctx->depsgraph)) {
+    return false;
+  }
+  if ((ctx->flag & MOD_APPLY_ORCO) != 0) {
+    return false;
+  }
+  return true;
+}
+
 static const std::string use_attribute_suffix = "_use_attribute";
 static const std::string attribute_name_suffix = "_attribute_name";
 
@@ -922,6 +941,28 @@ static void clear_runtime_data(NodesModifierData *nmd)
   }
 }
 
+static void free_output_cache(NodesModifierData *nmd)
+{
+  if (nmd->runtime_output_cache != nullptr) {
+    delete (NodeOutputCache *)nmd->runtime_output_cache;
+    nmd->runtime_output_cache = nullptr;
+  }
+}
+
+static NodeOutputCache *ensure_output_cache(NodesModifierData *nmd,
+                                            const ModifierEvalContext *ctx)
+{
+  NodesModifierData *nmd_orig = (NodesModifierData *)BKE_modifier_get_original(ctx->object,
+                                                                               &nmd->modifier);
+  if (nmd_orig == nullptr) {
+    return nullptr;
+  }
+  if (nmd_orig->runtime_output_cache == nullptr) {
+    nmd_orig->runtime_output_cache = new NodeOutputCache();
+  }
+  return static_cast<NodeOutputCache *>(nmd_orig->runtime_output_cache);
+}
+
 struct OutputAttributeInfo {
   GField field;
   StringRefNull name;
@@ -1138,6 +1179,9 @@ static GeometrySet compute_geometry(const DerivedNodeTree &tree,
   eval_params.depsgraph = ctx->depsgraph;
   eval_params.self_object = ctx->object;
   eval_params.geo_logger = geo_logger.has_value() ? &*geo_logger : nullptr;
+  if (output_cache_enabled(ctx)) {
+    eval_params.output_cache = ensure_output_cache(nmd, ctx);
+  }
   blender::modifiers::geometry_nodes::evaluate_geometry_nodes(eval_params);
 
   GeometrySet output_geometry_set = std::move(*eval_params.r_output_values[0].get<GeometrySet>());
@@ -1620,6 +1664,22 @@ static void panel_draw(const bContext *C, Panel *panel)
     });
   }
 
+  /* Draw output cache statistics. */
+  if ((U.flag & USER_DEVELOPER_UI) && nmd->runtime_output_cache != nullptr) {
+    const NodeOutputCache::Statistics statistics =
+        static_cast<const NodeOutputCache *>(nmd->runtime_output_cache)->statistics();
+    char info[256];
+    BLI_snprintf(info,
+                 sizeof(info),
+                 TIP_("Node Cache: %d%% hits (%lld of %lld), %lld entries, %.1f MiB"),
+                 int(statistics.hit_rate() * 100.0f + 0.5f),
+                 (long long)statistics.hits,
+                 (long long)statistics.lookups,
+                 (long long)statistics.entries,
+                 double(statistics.memory_bytes) / (1024.0 * 1024.0));
+    uiItemL(layout, info, ICON_INFO);
+  }
+
   modifier_panel_end(layout, ptr);
 }
 
@@ -1674,6 +1734,7 @@ static void blendRead(BlendDataReader *reader, ModifierData *md)
   BLO_read_data_address(reader, &nmd->settings.properties);
   IDP_BlendDataRead(reader, &nmd->settings.properties);
   nmd->runtime_eval_log = nullptr;
+  nmd->runtime_output_cache = nullptr;
 }
 
 static void copyData(const ModifierData *md, ModifierData *target, const int flag)
@@ -1684,6 +1745,7 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   BKE_modifier_copydata_generic(md, target, flag);
 
   tnmd->runtime_eval_log = nullptr;
+  tnmd->runtime_output_cache = nullptr;
 
   if (nmd->settings.properties != nullptr) {
     tnmd->settings.properties = IDP_CopyProperty_ex(nmd->settings.properties, flag);
@@ -1699,6 +1761,7 @@ static void freeData(ModifierData *md)
   }
 
   clear_runtime_data(nmd);
+  free_output_cache(nmd);
 }
 
 static void requiredDataMask(Object *UNUSED(ob),
@@ -5,6 +5,7 @@
 #include "BKE_type_conversions.hh"
 
 #include "NOD_geometry_exec.hh"
+#include "NOD_geometry_nodes_profile.hh"
 #include "NOD_socket_declarations.hh"
 
 #include "DEG_depsgraph_query.h"
@@ -17,11 +18,15 @@
 
 #include "BLI_enumerable_thread_specific.hh"
 #include "BLI_generic_value_map.hh"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_stack.hh"
 #include "BLI_task.h"
 #include "BLI_task.hh"
 #include "BLI_vector_set.hh"
 
+#include "MEM_guardedalloc.h"
+
 #include <chrono>
 
 namespace blender::modifiers::geometry_nodes {
@@ -247,6 +252,38 @@ struct NodeState {
    * not run twice at the same time accidentally.
    */
   NodeScheduleState schedule_state = NodeScheduleState::NotScheduled;
+
+  /**
+   * Identifies the node across evaluations in the #NodeOutputCache. Only set when an output cache
+   * is used.
+   */
+  uint64_t cache_key = 0;
+
+  /**
+   * Hash of everything the outputs of this node depend on. It is empty when the outputs depend
+   * on data that is not known to the evaluator (e.g. other objects or the scene time), in which
+   * case the outputs of this node and all nodes depending on it can't be reused.
+   */
+  std::optional<uint64_t> fingerprint;
+  bool fingerprint_computed = false;
+
+  /**
+   * True when the outputs of this node are looked up in and added to the output cache.
+   */
+  bool use_output_cache = false;
+
+  /**
+   * Copies of the values the node outputs, indexed by socket index. They are added to the output
+   * cache after the node has been executed.
+   */
+  Vector<GMutablePointer> outputs_to_cache;
+
+  /**
+   * Size of the values that the current execution of the node outputs. Only used when geometry
+   * nodes are profiled.
+   */
+  int64_t profile_output_memory_bytes = 0;
+  int64_t profile_output_elements_num = 0;
 };
 
 /**
@@ -400,6 +437,99 @@ static bool node_supports_laziness(const DNode node)
   return node->typeinfo()->geometry_node_execute_supports_laziness;
 }
 
+/**
+ * Only keep node outputs in the cache when computing them took longer than it would take to copy
+ * this many bytes per microsecond. Holding on to an output makes nodes further down copy geometry
+ * that they could modify in place otherwise, so cheap nodes are better recomputed.
+ */
+static constexpr int64_t output_cache_min_bytes_per_microsecond = 1000;
+
+static uint64_t hash_memory(const void *data, const size_t size, const uint64_t hash)
+{
+  return BLI_ghashutil_combine_hash(hash, BLI_hash_mm2((const uchar *)data, size, 0));
+}
+
+/**
+ * Key that identifies a node across evaluations, as long as neither the node nor the group nodes
+ * it is nested in are renamed.
+ */
+static uint64_t node_output_cache_key(const DNode node)
+{
+  uint64_t key = get_default_hash(node->name());
+  for (const DTreeContext *context = node.context(); !context->is_root();
+       context = context->parent_context()) {
+    key = BLI_ghashutil_combine_hash(key, get_default_hash(context->parent_node()->name()));
+  }
+  return key;
+}
+
+static std::optional<uint64_t> hash_node_settings(const bNode &bnode)
+{
+  if (bnode.id != nullptr) {
+    /* The referenced data-block can change without the node changing. */
+    return std::nullopt;
+  }
+  if (ELEM(bnode.type,
+           GEO_NODE_OBJECT_INFO,
+           GEO_NODE_COLLECTION_INFO,
+           GEO_NODE_IMAGE_TEXTURE,
+           GEO_NODE_INPUT_SCENE_TIME,
+           GEO_NODE_IS_VIEWPORT)) {
+    /* The output depends on data outside of the node tree. */
+    return std::nullopt;
+  }
+  if (ELEM(bnode.type, SH_NODE_CURVE_FLOAT, SH_NODE_CURVE_VEC, SH_NODE_CURVE_RGB)) {
+    /* The curve mapping in the storage is not hashed, because it references more data. */
+    return std::nullopt;
+  }
+  uint64_t hash = get_default_hash_4(bnode.typeinfo, bnode.custom1, bnode.custom2, bnode.custom3);
+  hash = get_default_hash_2(hash, bnode.custom4);
+  if (bnode.storage != nullptr) {
+    if (bnode.type == FN_NODE_INPUT_STRING) {
+      const NodeInputString &storage = *static_cast<const NodeInputString *>(bnode.storage);
+      hash = get_default_hash_2(hash, StringRef(storage.string ? storage.string : ""));
+    }
+    else {
+      hash = hash_memory(bnode.storage, MEM_allocN_len(bnode.storage), hash);
+    }
+  }
+  return hash;
+}
+
+static std::optional<uint64_t> hash_unlinked_socket_value(const bNodeSocket &socket)
+{
+  if (ELEM(socket.type, SOCK_OBJECT, SOCK_COLLECTION, SOCK_TEXTURE, SOCK_IMAGE, SOCK_MATERIAL)) {
+    /* The data-block can change without the socket value changing. */
+    return std::nullopt;
+  }
+  uint64_t hash = get_default_hash_2(socket.type, StringRef(socket.identifier));
+  if (socket.default_value != nullptr) {
+    hash = hash_memory(socket.default_value, MEM_allocN_len(socket.default_value), hash);
+  }
+  return hash;
+}
+
+static std::optional<uint64_t> hash_group_input_value(const GPointer value)
+{
+  const CPPType &type = *value.type();
+  if (type == CPPType::get<GeometrySet>()) {
+    return geometry_set_content_hash(*value.get<GeometrySet>());
+  }
+  if (const ValueOrFieldCPPType *value_or_field_type = dynamic_cast<const ValueOrFieldCPPType *>(
+          &type)) {
+    if (value_or_field_type->is_field(value.get())) {
+      /* Attribute inputs of the modifier, their field inputs hash the attribute name. */
+      return value_or_field_type->as_field(value.get()).hash();
+    }
+    const CPPType &base_type = value_or_field_type->base_type();
+    if (base_type.is_hashable()) {
+      return base_type.hash(value_or_field_type->get_value_ptr(value.get()));
+    }
+  }
+  /* Data-block pointers and types that can't be hashed. */
+  return std::nullopt;
+}
+
 struct NodeTaskRunState {
   /** The node that should be run on the same thread after the current node finished. */
   DNode next_node_to_run;
@@ -465,13 +595,17 @@ class GeometryNodesEvaluator {
   GeometryNodesEvaluationParams &params_;
   const blender::bke::DataTypeConversions &conversions_;
 
+  /** True when every node execution is recorded by the geometry nodes profiler. */
+  const bool use_profiler_;
+
   friend NodeParamsProvider;
 
  public:
   GeometryNodesEvaluator(GeometryNodesEvaluationParams &params)
       : outer_allocator_(params.allocator),
         params_(params),
-        conversions_(blender::bke::get_implicit_type_conversions())
+        conversions_(blender::bke::get_implicit_type_conversions()),
+        use_profiler_(nodes::geometry_nodes_profile::is_enabled())
   {
   }
 
@@ -480,6 +614,9 @@ class GeometryNodesEvaluator {
     task_pool_ = BLI_task_pool_create(this, TASK_PRIORITY_HIGH);
 
     this->create_states_for_reachable_nodes();
+    if (params_.output_cache != nullptr) {
+      this->compute_output_cache_fingerprints();
+    }
     this->forward_group_inputs();
     this->schedule_initial_nodes();
 
@@ -616,6 +753,141 @@ class GeometryNodesEvaluator {
     }
   }
 
+  /**
+   * Compute the fingerprints of all nodes that are used to find their outputs from previous
+   * evaluations in the output cache. The fingerprint of a node combines its settings with the
+   * fingerprints of its inputs, so origin nodes have to be handled first.
+   */
+  void compute_output_cache_fingerprints()
+  {
+    Map<DOutputSocket, std::optional<uint64_t>> group_input_hashes;
+    for (auto &&item : params_.input_values.items()) {
+      group_input_hashes.add_new(item.key, hash_group_input_value(item.value));
+    }
+
+    Stack<DNode> nodes_to_check;
+    for (const NodeWithState &item : node_states_) {
+      nodes_to_check.push(item.node);
+    }
+    while (!nodes_to_check.is_empty()) {
+      const DNode node = nodes_to_check.peek();
+      NodeState &node_state = this->get_node_state(node);
+      if (node_state.fingerprint_computed) {
+        nodes_to_check.pop();
+        continue;
+      }
+      bool all_origins_computed = true;
+      for (const InputSocketRef *input_ref : node->inputs()) {
+        const DInputSocket input{node.context(), input_ref};
+        input.foreach_origin_socket([&](const DSocket origin) {
+          if (origin->is_output() && !this->get_node_state(origin.node()).fingerprint_computed) {
+            nodes_to_check.push(origin.node());
+            all_origins_computed = false;
+          }
+        });
+      }
+      if (!all_origins_computed) {
+        continue;
+      }
+      nodes_to_check.pop();
+      this->compute_node_fingerprint(node, node_state, group_input_hashes);
+      node_state.fingerprint_computed = true;
+    }
+  }
+
+  void compute_node_fingerprint(
+      const DNode node,
+      NodeState &node_state,
+      const Map<DOutputSocket, std::optional<uint64_t>> &group_input_hashes)
+  {
+    if (node->is_group_input_node() || node->is_group_output_node()) {
+      return;
+    }
+    node_state.cache_key = node_output_cache_key(node);
+    const std::optional<uint64_t> settings_hash = hash_node_settings(*node->bnode());
+    if (!settings_hash) {
+      return;
+    }
+    uint64_t fingerprint = get_default_hash_2(node_state.cache_key, *settings_hash);
+    for (const InputSocketRef *input_ref : node->inputs()) {
+      if (!input_ref->is_available()) {
+        continue;
+      }
+      const std::optional<uint64_t> input_hash = this->input_fingerprint(
+          {node.context(), input_ref}, group_input_hashes);
+      if (!input_hash) {
+        return;
+      }
+      /* Combined in order, so that swapping the links of two inputs changes the fingerprint. */
+      fingerprint = BLI_ghashutil_combine_hash(fingerprint,
+                                               get_default_hash_2(input_ref->index(), *input_hash));
+    }
+    node_state.fingerprint = fingerprint;
+    node_state.use_output_cache = this->node_supports_output_cache(node, node_state);
+  }
+
+  std::optional<uint64_t> input_fingerprint(
+      const DInputSocket socket,
+      const Map<DOutputSocket, std::optional<uint64_t>> &group_input_hashes)
+  {
+    bool has_origin = false;
+    std::optional<uint64_t> fingerprint = socket->bsocket()->type;
+    socket.foreach_origin_socket([&](const DSocket origin) {
+      has_origin = true;
+      if (!fingerprint) {
+        return;
+      }
+      std::optional<uint64_t> origin_hash;
+      if (origin->is_input()) {
+        origin_hash = hash_unlinked_socket_value(*origin->bsocket());
+      }
+      else if (origin.node()->is_group_input_node()) {
+        origin_hash = group_input_hashes.lookup_default(DOutputSocket(origin), std::nullopt);
+      }
+      else {
+        const NodeState &origin_state = this->get_node_state(origin.node());
+        if (origin_state.fingerprint) {
+          origin_hash = get_default_hash_2(*origin_state.fingerprint, origin->index());
+        }
+      }
+      if (origin_hash) {
+        /* The order of the links of multi-input sockets matters, and linking the same socket
+         * twice must not cancel out. */
+        fingerprint = BLI_ghashutil_combine_hash(*fingerprint, *origin_hash);
+      }
+      else {
+        fingerprint.reset();
+      }
+    });
+    if (!has_origin) {
+      return hash_unlinked_socket_value(*socket->bsocket());
+    }
+    return fingerprint;
+  }
+
+  bool node_supports_output_cache(const DNode node, const NodeState &node_state)
+  {
+    /* Lazy nodes may execute more than once, which makes it hard to know when all outputs have
+     * been computed. */
+    if (node->typeinfo()->geometry_node_execute == nullptr || node_supports_laziness(node)) {
+      return false;
+    }
+    /* Inputs that have to be computed for logging would be skipped when the outputs are loaded
+     * from the cache. */
+    for (const InputState &input_state : node_state.inputs) {
+      if (input_state.force_compute) {
+        return false;
+      }
+    }
+    /* Other values are cheap to recompute, caching is only worth it for geometry. */
+    for (const OutputSocketRef *socket : node->outputs()) {
+      if (socket->is_available() && socket->bsocket()->type == SOCK_GEOMETRY) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   void destruct_node_states()
   {
     threading::parallel_for(
@@ -656,6 +928,7 @@ class GeometryNodesEvaluator {
 
     destruct_n(node_state.inputs.data(), node_state.inputs.size());
     destruct_n(node_state.outputs.data(), node_state.outputs.size());
+    free_outputs_to_cache(node_state);
 
     node_state.~NodeState();
   }
@@ -762,19 +1035,25 @@ class GeometryNodesEvaluator {
 
     NodeState &node_state = *node_states_.lookup_key_as(node).state;
 
-    const bool do_execute_node = this->node_task_preprocessing(node, node_state, run_state);
+    Vector<GMutablePointer> cached_outputs;
+    const bool do_execute_node = this->node_task_preprocessing(
+        node, node_state, cached_outputs, run_state);
 
     /* Only execute the node if all prerequisites are met. There has to be an output that is
      * required and all required inputs have to be provided already. */
     if (do_execute_node) {
       this->execute_node(node, node_state, run_state);
     }
+    else if (!cached_outputs.is_empty()) {
+      this->forward_cached_outputs(node, node_state, cached_outputs, run_state);
+    }
 
     this->node_task_postprocessing(node, node_state, do_execute_node, run_state);
   }
 
   bool node_task_preprocessing(const DNode node,
                                NodeState &node_state,
+                               Vector<GMutablePointer> &r_cached_outputs,
                                NodeTaskRunState *run_state)
   {
     bool do_execute_node = false;
@@ -790,6 +1069,13 @@ class GeometryNodesEvaluator {
       if (!this->prepare_node_outputs_for_execution(locked_node)) {
         return;
       }
+      /* Try to reuse the outputs from a previous evaluation before any input is requested. That
+       * way the nodes that would compute the inputs are not evaluated at all. */
+      if (node_state.use_output_cache && !node_state.non_lazy_inputs_handled) {
+        if (this->load_outputs_from_cache(locked_node, r_cached_outputs)) {
+          return;
+        }
+      }
       /* Initialize inputs that don't support laziness. This is done after at least one output is
        * required and before we check that all required inputs are provided. This reduces the
        * number of "round-trips" through the task pool by one for most nodes. */
@@ -806,6 +1092,47 @@ class GeometryNodesEvaluator {
     return do_execute_node;
   }
 
+  bool load_outputs_from_cache(LockedNode &locked_node, Vector<GMutablePointer> &r_values)
+  {
+    NodeState &node_state = locked_node.node_state;
+    Vector<int, 16> used_outputs;
+    for (const int i : node_state.outputs.index_range()) {
+      if (node_state.outputs[i].output_usage_for_execution != ValueUsage::Unused) {
+        used_outputs.append(i);
+      }
+    }
+    LinearAllocator<> &allocator = local_allocators_.local();
+    Vector<GMutablePointer> values(node_state.outputs.size());
+    const bool found = params_.output_cache->lookup(
+        node_state.cache_key,
+        *node_state.fingerprint,
+        used_outputs,
+        [&](const int output_index, const GPointer value) {
+          const CPPType &type = *value.type();
+          void *buffer = allocator.allocate(type.size(), type.alignment());
+          type.copy_construct(value.get(), buffer);
+          values[output_index] = {type, buffer};
+        });
+    if (found) {
+      r_values = std::move(values);
+    }
+    return found;
+  }
+
+  void forward_cached_outputs(const DNode node,
+                              NodeState &node_state,
+                              Span<GMutablePointer> values,
+                              NodeTaskRunState *run_state)
+  {
+    for (const int i : values.index_range()) {
+      if (values[i].get() == nullptr) {
+        continue;
+      }
+      this->forward_output(node.output(i), values[i], run_state);
+      node_state.outputs[i].has_been_computed = true;
+    }
+  }
+
   /* A node is finished when it has computed all outputs that may be used have been computed and
    * when no input is still forced to be computed. */
   bool finish_node_if_possible(LockedNode &locked_node)
@@ -982,6 +1309,11 @@ class GeometryNodesEvaluator {
 
     NodeParamsProvider params_provider{*this, node, node_state, run_state};
     GeoNodeExecParams params{params_provider};
+    if (node_state.use_output_cache) {
+      node_state.outputs_to_cache.resize(node->outputs().size());
+    }
+    node_state.profile_output_memory_bytes = 0;
+    node_state.profile_output_elements_num = 0;
     Clock::time_point begin = Clock::now();
     bnode.typeinfo->geometry_node_execute(params);
     Clock::time_point end = Clock::now();
@@ -990,6 +1322,95 @@ class GeometryNodesEvaluator {
     if (params_.geo_logger != nullptr) {
       params_.geo_logger->local().log_execution_time(node, duration);
     }
+    if (use_profiler_) {
+      this->record_node_profile_event(node, node_state, begin, end);
+    }
+    if (node_state.use_output_cache) {
+      this->add_outputs_to_cache(node_state, duration);
+    }
+  }
+
+  void record_node_profile_event(const DNode node,
+                                 const NodeState &node_state,
+                                 const nodes::geometry_nodes_profile::TimePoint start,
+                                 const nodes::geometry_nodes_profile::TimePoint end)
+  {
+    nodes::geometry_nodes_profile::ProfileEvent event;
+    /* Include the names of the group nodes, because the same group can be used many times. */
+    event.name = node->name();
+    for (const DTreeContext *context = node.context(); !context->is_root();
+         context = context->parent_context()) {
+      event.name = context->parent_node()->name() + " > " + event.name;
+    }
+    event.category = node->bnode()->idname;
+    event.object_name = params_.self_object->id.name + 2;
+    event.modifier_name = params_.modifier_->modifier.name;
+    event.frame = DEG_get_ctime(params_.depsgraph);
+    event.start = start;
+    event.end = end;
+    event.output_memory_bytes = node_state.profile_output_memory_bytes;
+    event.output_elements_num = node_state.profile_output_elements_num;
+    nodes::geometry_nodes_profile::record(std::move(event));
+  }
+
+  /** Accumulate the size of an output value of a node for the profiler. */
+  void add_output_to_profile(NodeState &node_state, const GPointer value)
+  {
+    if (!use_profiler_) {
+      return;
+    }
+    node_state.profile_output_memory_bytes += estimate_value_memory(value);
+    if (value.type()->is<GeometrySet>()) {
+      const GeometrySet &geometry_set = *static_cast<const GeometrySet *>(value.get());
+      for (const GeometryComponent *component : geometry_set.get_components_for_read()) {
+        const AttributeDomain domain = component->type() == GEO_COMPONENT_TYPE_INSTANCES ?
+                                           ATTR_DOMAIN_INSTANCE :
+                                           ATTR_DOMAIN_POINT;
+        node_state.profile_output_elements_num += component->attribute_domain_size(domain);
+      }
+    }
+  }
+
+  /** Keep a copy of an output value that is added to the output cache later on. */
+  void capture_output_for_cache(NodeState &node_state, const int index, const GPointer value)
+  {
+    if (!node_state.use_output_cache) {
+      return;
+    }
+    const CPPType &type = *value.type();
+    void *buffer = MEM_mallocN_aligned(type.size(), type.alignment(), __func__);
+    type.copy_construct(value.get(), buffer);
+    node_state.outputs_to_cache[index] = {type, buffer};
+  }
+
+  void add_outputs_to_cache(NodeState &node_state, const std::chrono::microseconds duration)
+  {
+    int64_t memory_bytes = 0;
+    for (const GMutablePointer value : node_state.outputs_to_cache) {
+      if (value.get() != nullptr) {
+        memory_bytes += estimate_value_memory(value);
+      }
+    }
+    if (duration.count() * output_cache_min_bytes_per_microsecond < memory_bytes) {
+      free_outputs_to_cache(node_state);
+      return;
+    }
+    params_.output_cache->add(node_state.cache_key,
+                              *node_state.fingerprint,
+                              std::move(node_state.outputs_to_cache),
+                              memory_bytes);
+    node_state.outputs_to_cache.clear();
+  }
+
+  static void free_outputs_to_cache(NodeState &node_state)
+  {
+    for (GMutablePointer value : node_state.outputs_to_cache) {
+      if (value.get() != nullptr) {
+        value.destruct();
+        MEM_freeN(value.get());
+      }
+    }
+    node_state.outputs_to_cache.clear();
   }
 
   void execute_multi_function_node(const DNode node,
@@ -1839,6 +2260,8 @@ void NodeParamsProvider::set_output(StringRef identifier, GMutablePointer value)
 
   OutputState &output_state = node_state_.outputs[socket->index()];
   BLI_assert(!output_state.has_been_computed);
+  evaluator_.capture_output_for_cache(node_state_, socket->index(), value);
+  evaluator_.add_output_to_profile(node_state_, value);
   evaluator_.forward_output(socket, value, run_state_);
   output_state.has_been_computed = true;
 }
@@ -1916,6 +2339,7 @@ void NodeParamsProvider::set_default_remaining_outputs()
     BLI_assert(type != nullptr);
     void *buffer = allocator.allocate(type->size(), type->alignment());
     type->copy_construct(type->default_value(), buffer);
+    evaluator_.capture_output_for_cache(node_state_, i, {type, buffer});
     evaluator_.forward_output(socket, {type, buffer}, run_state_);
     output_state.has_been_computed = true;
   }
@@ -1923,8 +2347,27 @@ void NodeParamsProvider::set_default_remaining_outputs()
 
 void evaluate_geometry_nodes(GeometryNodesEvaluationParams &params)
 {
+  namespace profile = nodes::geometry_nodes_profile;
+
+  const profile::TimePoint start = profile::Clock::now();
   GeometryNodesEvaluator evaluator{params};
   evaluator.execute();
+
+  if (profile::is_enabled()) {
+    /* The node events on the same thread are displayed as children of this event. */
+    profile::ProfileEvent event;
+    event.name = params.modifier_->modifier.name;
+    event.category = "modifier";
+    event.object_name = params.self_object->id.name + 2;
+    event.modifier_name = params.modifier_->modifier.name;
+    event.frame = DEG_get_ctime(params.depsgraph);
+    event.start = start;
+    event.end = profile::Clock::now();
+    for (const GMutablePointer &value : params.r_output_values) {
+      event.output_memory_bytes += estimate_value_memory(value);
+    }
+    profile::record(std::move(event));
+  }
 }
 
 }  // namespace blender::modifiers::geometry_nodes
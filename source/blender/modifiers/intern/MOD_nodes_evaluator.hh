@@ -13,6 +13,8 @@
 
 #include "FN_multi_function.hh"
 
+#include "MOD_nodes_output_cache.hh"
+
 namespace geo_log = blender::nodes::geometry_nodes_eval_log;
 
 namespace blender::modifiers::geometry_nodes {
@@ -35,6 +37,8 @@ struct GeometryNodesEvaluationParams {
   Depsgraph *depsgraph;
   Object *self_object;
   geo_log::GeoLogger *geo_logger;
+  /* Optional cache that outputs of expensive nodes are reused from and stored in. */
+  NodeOutputCache *output_cache = nullptr;
 
   Vector<GMutablePointer> r_output_values;
 };
@@ -0,0 +1,310 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "MOD_nodes_output_cache.hh"
+
+#include "BLI_ghash.h"
+#include "BLI_hash.hh"
+#include "BLI_hash_mm2a.h"
+
+#include "BKE_attribute_access.hh"
+#include "BKE_geometry_set.hh"
+
+#include "DNA_curves_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "MEM_guardedalloc.h"
+
+namespace blender::modifiers::geometry_nodes {
+
+using bke::AttributeIDRef;
+
+NodeOutputCache::NodeOutputCache(const int64_t memory_limit) : memory_limit_(memory_limit)
+{
+}
+
+NodeOutputCache::~NodeOutputCache()
+{
+  this->clear();
+}
+
+bool NodeOutputCache::lookup(const uint64_t node_key,
+                             const uint64_t fingerprint,
+                             Span<int> required_outputs,
+                             FunctionRef<void(int output_index, GPointer value)> fn)
+{
+  std::lock_guard lock{mutex_};
+  statistics_.lookups++;
+  Entry *entry = entries_.lookup_ptr(node_key);
+  if (entry == nullptr || entry->fingerprint != fingerprint) {
+    return false;
+  }
+  for (const int output_index : required_outputs) {
+    if (output_index >= entry->values.size() || entry->values[output_index].get() == nullptr) {
+      /* The output was not used when the node was cached. */
+      return false;
+    }
+  }
+  for (const int output_index : required_outputs) {
+    fn(output_index, entry->values[output_index]);
+  }
+  entry->last_use = ++use_clock_;
+  statistics_.hits++;
+  return true;
+}
+
+void NodeOutputCache::add(const uint64_t node_key,
+                          const uint64_t fingerprint,
+                          Vector<GMutablePointer> values,
+                          const int64_t memory_bytes)
+{
+  std::lock_guard lock{mutex_};
+  Entry *old_entry = entries_.lookup_ptr(node_key);
+  if (old_entry != nullptr) {
+    statistics_.memory_bytes -= old_entry->memory_bytes;
+    free_entry(*old_entry);
+    entries_.remove_contained(node_key);
+  }
+  if (memory_bytes > memory_limit_) {
+    Entry entry{fingerprint, std::move(values), memory_bytes, 0};
+    free_entry(entry);
+    return;
+  }
+  this->evict_until_fits(memory_bytes);
+  entries_.add_new(node_key, {fingerprint, std::move(values), memory_bytes, ++use_clock_});
+  statistics_.memory_bytes += memory_bytes;
+}
+
+void NodeOutputCache::evict_until_fits(const int64_t required_bytes)
+{
+  while (!entries_.is_empty() && statistics_.memory_bytes + required_bytes > memory_limit_) {
+    /* Linear search is fine, there is at most one entry per node. */
+    uint64_t oldest_key = 0;
+    uint64_t oldest_use = UINT64_MAX;
+    for (const auto item : entries_.items()) {
+      if (item.value.last_use < oldest_use) {
+        oldest_use = item.value.last_use;
+        oldest_key = item.key;
+      }
+    }
+    Entry entry = entries_.pop(oldest_key);
+    statistics_.memory_bytes -= entry.memory_bytes;
+    statistics_.evictions++;
+    free_entry(entry);
+  }
+}
+
+void NodeOutputCache::free_entry(Entry &entry)
+{
+  for (GMutablePointer value : entry.values) {
+    if (value.get() != nullptr) {
+      value.destruct();
+      MEM_freeN(value.get());
+    }
+  }
+  entry.values.clear();
+}
+
+void NodeOutputCache::clear()
+{
+  std::lock_guard lock{mutex_};
+  for (Entry &entry : entries_.values()) {
+    free_entry(entry);
+  }
+  entries_.clear();
+  statistics_.memory_bytes = 0;
+}
+
+NodeOutputCache::Statistics NodeOutputCache::statistics() const
+{
+  std::lock_guard lock{mutex_};
+  Statistics statistics = statistics_;
+  statistics.entries = entries_.size();
+  return statistics;
+}
+
+static int64_t estimate_attributes_memory(const GeometryComponent &component)
+{
+  int64_t memory = 0;
+  component.attribute_foreach(
+      [&](const AttributeIDRef &UNUSED(attribute_id), const AttributeMetaData &meta_data) {
+        const CPPType *type = bke::custom_data_type_to_cpp_type(meta_data.data_type);
+        if (type != nullptr) {
+          memory += int64_t(component.attribute_domain_size(meta_data.domain)) * type->size();
+        }
+        return true;
+      });
+  return memory;
+}
+
+static int64_t estimate_geometry_set_memory(const GeometrySet &geometry_set)
+{
+  int64_t memory = sizeof(GeometrySet);
+  for (const GeometryComponent *component : geometry_set.get_components_for_read()) {
+    memory += estimate_attributes_memory(*component);
+    switch (component->type()) {
+      case GEO_COMPONENT_TYPE_MESH: {
+        const Mesh *mesh = static_cast<const MeshComponent *>(component)->get_for_read();
+        if (mesh != nullptr) {
+          memory += int64_t(mesh->totedge) * sizeof(MEdge);
+          memory += int64_t(mesh->totloop) * sizeof(MLoop);
+          memory += int64_t(mesh->totpoly) * sizeof(MPoly);
+        }
+        break;
+      }
+      case GEO_COMPONENT_TYPE_CURVE: {
+        const Curves *curves = static_cast<const CurveComponent *>(component)->get_for_read();
+        if (curves != nullptr) {
+          memory += int64_t(curves->geometry.curve_size + 1) * sizeof(int);
+        }
+        break;
+      }
+      case GEO_COMPONENT_TYPE_INSTANCES: {
+        const InstancesComponent &instances = *static_cast<const InstancesComponent *>(component);
+        memory += int64_t(instances.instances_amount()) * (sizeof(float4x4) + sizeof(int));
+        for (const InstanceReference &reference : instances.references()) {
+          if (reference.type() == InstanceReference::Type::GeometrySet) {
+            memory += estimate_geometry_set_memory(reference.geometry_set());
+          }
+        }
+        break;
+      }
+      case GEO_COMPONENT_TYPE_POINT_CLOUD:
+      case GEO_COMPONENT_TYPE_VOLUME:
+        /* Point cloud data is stored in attributes. Volume grids are not accounted for. */
+        break;
+    }
+  }
+  return memory;
+}
+
+int64_t estimate_value_memory(const GPointer value)
+{
+  const CPPType &type = *value.type();
+  if (type == CPPType::get<GeometrySet>()) {
+    return estimate_geometry_set_memory(*static_cast<const GeometrySet *>(value.get()));
+  }
+  return type.size();
+}
+
+static uint64_t hash_bytes(const void *data, const int64_t size, const uint64_t hash)
+{
+  if (size == 0) {
+    return hash;
+  }
+  return BLI_ghashutil_combine_hash(hash, BLI_hash_mm2((const uchar *)data, size_t(size), 0));
+}
+
+static std::optional<uint64_t> attributes_content_hash(const GeometryComponent &component)
+{
+  uint64_t hash = 0;
+  bool is_hashable = true;
+  component.attribute_foreach([&](const AttributeIDRef &attribute_id,
+                                  const AttributeMetaData &meta_data) {
+    if (!attribute_id.is_named()) {
+      /* Anonymous attributes are recreated for every evaluation, so they can't be used as key. */
+      is_hashable = false;
+      return false;
+    }
+    const GVArray varray = component.attribute_try_get_for_read(attribute_id).varray;
+    if (!varray) {
+      return true;
+    }
+    const CPPType &type = varray.type();
+    hash = BLI_ghashutil_combine_hash(
+        hash, get_default_hash_2(attribute_id.name(), uint64_t(meta_data.domain)));
+    if (varray.is_span()) {
+      const GSpan span = varray.get_internal_span();
+      hash = hash_bytes(span.data(), span.size() * type.size(), hash);
+    }
+    else {
+      void *buffer = MEM_mallocN_aligned(type.size() * varray.size(), type.alignment(), __func__);
+      varray.materialize_to_uninitialized(buffer);
+      hash = hash_bytes(buffer, type.size() * varray.size(), hash);
+      type.destruct_n(buffer, varray.size());
+      MEM_freeN(buffer);
+    }
+    return true;
+  });
+  if (!is_hashable) {
+    return std::nullopt;
+  }
+  return hash;
+}
+
+std::optional<uint64_t> geometry_set_content_hash(const GeometrySet &geometry_set)
+{
+  uint64_t hash = 0;
+  for (const GeometryComponent *component : geometry_set.get_components_for_read()) {
+    hash = BLI_ghashutil_combine_hash(hash, uint64_t(component->type()));
+    switch (component->type()) {
+      case GEO_COMPONENT_TYPE_MESH: {
+        const Mesh *mesh = static_cast<const MeshComponent *>(component)->get_for_read();
+        if (mesh == nullptr) {
+          break;
+        }
+        hash = BLI_ghashutil_combine_hash(
+            hash, get_default_hash_3(mesh->totvert, mesh->totedge, mesh->totpoly));
+        hash = hash_bytes(mesh->medge, int64_t(mesh->totedge) * sizeof(MEdge), hash);
+        hash = hash_bytes(mesh->mloop, int64_t(mesh->totloop) * sizeof(MLoop), hash);
+        hash = hash_bytes(mesh->mpoly, int64_t(mesh->totpoly) * sizeof(MPoly), hash);
+        /* Materials are assigned by pointer, the same geometry with other materials differs. */
+        hash = hash_bytes(mesh->mat, int64_t(mesh->totcol) * sizeof(Material *), hash);
+        break;
+      }
+      case GEO_COMPONENT_TYPE_CURVE: {
+        const Curves *curves = static_cast<const CurveComponent *>(component)->get_for_read();
+        if (curves == nullptr) {
+          break;
+        }
+        const int curves_num = curves->geometry.curve_size;
+        hash = BLI_ghashutil_combine_hash(
+            hash, get_default_hash_2(curves->geometry.point_size, curves_num));
+        hash = hash_bytes(
+            curves->geometry.curve_offsets, int64_t(curves_num + 1) * sizeof(int), hash);
+        hash = hash_bytes(curves->mat, int64_t(curves->totcol) * sizeof(Material *), hash);
+        break;
+      }
+      case GEO_COMPONENT_TYPE_INSTANCES: {
+        const InstancesComponent &instances = *static_cast<const InstancesComponent *>(component);
+        const Span<float4x4> transforms = instances.instance_transforms();
+        const Span<int> handles = instances.instance_reference_handles();
+        hash = hash_bytes(transforms.data(), transforms.size_in_bytes(), hash);
+        hash = hash_bytes(handles.data(), handles.size_in_bytes(), hash);
+        for (const InstanceReference &reference : instances.references()) {
+          if (reference.type() != InstanceReference::Type::GeometrySet) {
+            /* Referenced objects and collections can change without the pointer changing. */
+            return std::nullopt;
+          }
+          const std::optional<uint64_t> reference_hash = geometry_set_content_hash(
+              reference.geometry_set());
+          if (!reference_hash) {
+            return std::nullopt;
+          }
+          hash = BLI_ghashutil_combine_hash(hash, *reference_hash);
+        }
+        break;
+      }
+      case GEO_COMPONENT_TYPE_POINT_CLOUD: {
+        const PointCloud *pointcloud =
+            static_cast<const PointCloudComponent *>(component)->get_for_read();
+        if (pointcloud == nullptr) {
+          break;
+        }
+        hash = hash_bytes(pointcloud->mat, int64_t(pointcloud->totcol) * sizeof(Material *), hash);
+        break;
+      }
+      case GEO_COMPONENT_TYPE_VOLUME:
+        return std::nullopt;
+    }
+    const std::optional<uint64_t> attributes_hash = attributes_content_hash(*component);
+    if (!attributes_hash) {
+      return std::nullopt;
+    }
+    hash = BLI_ghashutil_combine_hash(hash, *attributes_hash);
+  }
+  return hash;
+}
+
+}  // namespace blender::modifiers::geometry_nodes
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+#include <mutex>
+#include <optional>
+
+#include "BLI_function_ref.hh"
+#include "BLI_generic_pointer.hh"
+#include "BLI_map.hh"
+#include "BLI_vector.hh"
+
+struct GeometrySet;
+
+namespace blender::modifiers::geometry_nodes {
+
+/**
+ * Keeps the output values of individual nodes from previous evaluations of a geometry nodes
+ * modifier, so that sub-graphs whose inputs did not change don't have to be recomputed.
+ *
+ * Entries are identified by a key that is stable across evaluations (the node name and the names
+ * of the group nodes it is nested in) and are only reused when the fingerprint of the node still
+ * matches. The fingerprint is computed by the evaluator from the node settings, the unlinked input
+ * values and the fingerprints of all linked origin nodes, so it changes whenever anything
+ * upstream of the node changes.
+ *
+ * The cache is owned by the original modifier and accessed from multiple threads during
+ * evaluation, so all methods are thread-safe.
+ */
+class NodeOutputCache : NonCopyable, NonMovable {
+ public:
+  /** Upper bound for the memory used by cached values before old entries are evicted. */
+  static constexpr int64_t default_memory_limit = int64_t(1024) * 1024 * 1024;
+
+  struct Statistics {
+    int64_t lookups = 0;
+    int64_t hits = 0;
+    int64_t evictions = 0;
+    int64_t entries = 0;
+    int64_t memory_bytes = 0;
+
+    float hit_rate() const
+    {
+      return lookups == 0 ? 0.0f : float(hits) / float(lookups);
+    }
+  };
+
+ private:
+  struct Entry {
+    uint64_t fingerprint;
+    /* Owned values, indexed by output socket index. Outputs that were not computed are null. */
+    Vector<GMutablePointer> values;
+    int64_t memory_bytes;
+    /* Value of #use_clock_ when the entry was used the last time, used for LRU eviction. */
+    uint64_t last_use;
+  };
+
+  mutable std::mutex mutex_;
+  Map<uint64_t, Entry> entries_;
+  int64_t memory_limit_;
+  uint64_t use_clock_ = 0;
+  Statistics statistics_;
+
+ public:
+  NodeOutputCache(int64_t memory_limit = default_memory_limit);
+  ~NodeOutputCache();
+
+  /**
+   * Find the outputs of a node from a previous evaluation. The lookup only succeeds when the
+   * fingerprint matches and all outputs in \a required_outputs are available. In that case
+   * \a fn is called for every cached output that is required. It has to copy the value, because
+   * it is still owned by the cache.
+   */
+  bool lookup(uint64_t node_key,
+              uint64_t fingerprint,
+              Span<int> required_outputs,
+              FunctionRef<void(int output_index, GPointer value)> fn);
+
+  /**
+   * Store the outputs of a node, replacing the previously cached outputs of the same node.
+   * Takes ownership of the values, which have to be allocated with #MEM_mallocN_aligned.
+   * \param memory_bytes: Memory estimate of all values, see #estimate_value_memory.
+   */
+  void add(uint64_t node_key,
+           uint64_t fingerprint,
+           Vector<GMutablePointer> values,
+           int64_t memory_bytes);
+
+  void clear();
+
+  Statistics statistics() const;
+
+ private:
+  static void free_entry(Entry &entry);
+  void evict_until_fits(int64_t required_bytes);
+};
+
+/**
+ * Rough estimate of the memory that is kept alive by a value. This is used to decide when entries
+ * have to be evicted from the cache and whether storing an output is worth it at all.
+ */
+int64_t estimate_value_memory(GPointer value);
+
+/**
+ * Hash the contents of all components in the geometry set. Returns nothing when the geometry
+ * contains data whose content cannot be hashed cheaply or that references other data-blocks,
+ * which makes it unsuitable as cache key.
+ */
+std::optional<uint64_t> geometry_set_content_hash(const GeometrySet &geometry_set);
+
+}  // namespace blender::modifiers::geometry_nodes
@@ -26,6 +26,7 @@
 #include "BKE_lib_id.h"
 #include "BKE_lib_query.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_screen.h"
 
 #include "UI_interface.h"
@@ -325,6 +326,7 @@ static void normalEditModifier_do_radial(NormalEditModifierData *enmd,
           mloop, nos, &mesh->ldata, mpoly, BKE_mesh_poly_normals_for_write(mesh), num_polys)) {
     /* We need to recompute vertex normals! */
     BKE_mesh_normals_tag_dirty(mesh);
+    BKE_mesh_runtime_clear_geometry(mesh);
   }
 
   BKE_mesh_normals_loop_custom_set(mvert,
@@ -439,6 +441,7 @@ static void normalEditModifier_do_directional(NormalEditModifierData *enmd,
       polygons_check_flip(
           mloop, nos, &mesh->ldata, mpoly, BKE_mesh_poly_normals_for_write(mesh), num_polys)) {
     BKE_mesh_normals_tag_dirty(mesh);
+    BKE_mesh_runtime_clear_geometry(mesh);
   }
 
   BKE_mesh_normals_loop_custom_set(mvert,
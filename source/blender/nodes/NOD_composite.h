@@ -138,12 +138,17 @@ const char *node_cmp_rlayers_sock_to_pass(int sock_index);
 
 void register_node_type_cmp_custom_group(bNodeType *ntype);
 
+/**
+ * \param viewer_visible_area: Normalized part of the viewer image to calculate, null for all of
+ * it, see #COM_execute.
+ */
 void ntreeCompositExecTree(struct Scene *scene,
                            struct bNodeTree *ntree,
                            struct RenderData *rd,
                            int rendering,
                            int do_previews,
-                           const char *view_name);
+                           const char *view_name,
+                           const struct rctf *viewer_visible_area);
 
 /**
  * Called from render pipeline, to tag render input and output.
@@ -135,6 +135,12 @@ void register_node_type_geo_triangulate(void);
 void register_node_type_geo_viewer(void);
 void register_node_type_geo_volume_to_mesh(void);
 
+/**
+ * Record the execution times of all geometry nodes until Blender exits and write them to the
+ * given file then, see `--debug-geometry-nodes-profile`.
+ */
+void NOD_geometry_nodes_profile_enable(const char *filepath);
+
 #ifdef __cplusplus
 }
 #endif
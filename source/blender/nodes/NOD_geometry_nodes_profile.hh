@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/**
+ * Geometry nodes profiling records the execution of every geometry node and every geometry nodes
+ * modifier evaluation, so that hotspots can be found without the node editor (e.g. in render farm
+ * jobs). It is enabled with the `--debug-geometry-nodes-profile <file>` command line argument.
+ * The recorded events are written to the file in the Chrome trace event format when Blender
+ * exits. The file can be opened in `chrome://tracing`, Perfetto or Speedscope.
+ *
+ * Unlike the #GeoLogger, which only keeps the timings of the last evaluation for the node editor
+ * overlay, the profiler keeps all events of the entire session, e.g. a rendered frame range.
+ */
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+namespace blender::nodes::geometry_nodes_profile {
+
+using Clock = std::chrono::steady_clock;
+using TimePoint = Clock::time_point;
+
+/** A timed piece of work, e.g. the execution of a node. */
+struct ProfileEvent {
+  std::string name;
+  /** Used to group events, e.g. the idname of the node type. */
+  std::string category;
+  std::string object_name;
+  std::string modifier_name;
+  float frame = 0.0f;
+  TimePoint start;
+  TimePoint end;
+  /** Estimated memory used by the output values. */
+  int64_t output_memory_bytes = 0;
+  /** Number of points and instances in the output geometries. */
+  int64_t output_elements_num = 0;
+  /** Index of the thread that recorded the event. Set by #record. */
+  int thread_index = 0;
+};
+
+/** True when geometry nodes profiling has been enabled. This check is cheap. */
+bool is_enabled();
+
+/**
+ * Start recording events. They are written to the given file when Blender exits. Calling this
+ * again only changes the file path.
+ */
+void enable(std::string filepath);
+
+/** Add a new event. This is thread-safe. */
+void record(ProfileEvent event);
+
+/** Write all events that have been recorded so far in the Chrome trace event format. */
+void write_chrome_trace(std::ostream &stream);
+
+}  // namespace blender::nodes::geometry_nodes_profile
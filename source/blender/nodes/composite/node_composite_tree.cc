@@ -206,12 +206,13 @@ void ntreeCompositExecTree(Scene *scene,
                            RenderData *rd,
                            int rendering,
                            int do_preview,
-                           const char *view_name)
+                           const char *view_name,
+                           const rctf *viewer_visible_area)
 {
 #ifdef WITH_COMPOSITOR
-  COM_execute(rd, scene, ntree, rendering, view_name);
+  COM_execute(rd, scene, ntree, rendering, view_name, viewer_visible_area);
 #else
-  UNUSED_VARS(scene, ntree, rd, rendering, view_name);
+  UNUSED_VARS(scene, ntree, rd, rendering, view_name, viewer_visible_area);
 #endif
 
   UNUSED_VARS(do_preview);
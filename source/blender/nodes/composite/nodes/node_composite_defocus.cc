@@ -62,6 +62,7 @@ static void node_composit_buts_defocus(uiLayout *layout, bContext *C, PointerRNA
 
   col = uiLayoutColumn(layout, false);
   uiItemR(col, ptr, "use_preview", UI_ITEM_R_SPLIT_EMPTY_NAME, nullptr, ICON_NONE);
+  uiItemR(col, ptr, "blur_algorithm", UI_ITEM_R_SPLIT_EMPTY_NAME, nullptr, ICON_NONE);
 
   uiTemplateID(layout,
                C,
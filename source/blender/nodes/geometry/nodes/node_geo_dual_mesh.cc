@@ -7,6 +7,8 @@
 
 #include "BKE_attribute_math.hh"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
 
 #include "node_geometry_util.hh"
 
@@ -258,12 +260,13 @@ static void calc_boundaries(const Mesh &mesh,
 static void create_vertex_poly_map(const Mesh &mesh,
                                    MutableSpan<Vector<int>> r_vertex_poly_indices)
 {
-  for (const int i : IndexRange(mesh.totpoly)) {
-    const MPoly &poly = mesh.mpoly[i];
-    for (const MLoop &loop : Span<MLoop>(&mesh.mloop[poly.loopstart], poly.totloop)) {
-      r_vertex_poly_indices[loop.v].append(i);
+  const MeshElemMap *vert_poly_map = BKE_mesh_runtime_vert_poly_map_ensure(&mesh);
+  threading::parallel_for(r_vertex_poly_indices.index_range(), 1024, [&](IndexRange range) {
+    for (const int i : range) {
+      r_vertex_poly_indices[i].extend(
+          Span<int>(vert_poly_map[i].indices, vert_poly_map[i].count));
     }
-  }
+  });
 }
 
 /**
@@ -48,6 +48,7 @@ static void mesh_flip_faces(MeshComponent &component, const Field<bool> &selecti
       std::swap(loops[index1 - 1].e, loops[index2].e);
     }
   }
+  BKE_mesh_runtime_clear_geometry(mesh);
 
   component.attribute_foreach(
       [&](const bke::AttributeIDRef &attribute_id, const AttributeMetaData &meta_data) {
@@ -4,6 +4,8 @@
 #include "DNA_meshdata_types.h"
 
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
 
 #include "node_geometry_util.hh"
 
@@ -25,34 +27,6 @@ static void node_declare(NodeDeclarationBuilder &b)
           "angles are negative. Computing this value is slower than the unsigned angle");
 }
 
-struct EdgeMapEntry {
-  int face_count;
-  int face_index_1;
-  int face_index_2;
-};
-
-static Array<EdgeMapEntry> create_edge_map(const Span<MPoly> polys,
-                                           const Span<MLoop> loops,
-                                           const int total_edges)
-{
-  Array<EdgeMapEntry> edge_map(total_edges, {0, 0, 0});
-
-  for (const int i_poly : polys.index_range()) {
-    const MPoly &mpoly = polys[i_poly];
-    for (const MLoop &loop : loops.slice(mpoly.loopstart, mpoly.totloop)) {
-      EdgeMapEntry &entry = edge_map[loop.e];
-      if (entry.face_count == 0) {
-        entry.face_index_1 = i_poly;
-      }
-      else if (entry.face_count == 1) {
-        entry.face_index_2 = i_poly;
-      }
-      entry.face_count++;
-    }
-  }
-  return edge_map;
-}
-
 class AngleFieldInput final : public GeometryFieldInput {
  public:
   AngleFieldInput() : GeometryFieldInput(CPPType::get<float>(), "Unsigned Angle Field")
@@ -76,14 +50,14 @@ class AngleFieldInput final : public GeometryFieldInput {
 
     Span<MPoly> polys{mesh->mpoly, mesh->totpoly};
     Span<MLoop> loops{mesh->mloop, mesh->totloop};
-    Array<EdgeMapEntry> edge_map = create_edge_map(polys, loops, mesh->totedge);
+    const MeshElemMap *edge_map = BKE_mesh_runtime_edge_poly_map_ensure(mesh);
 
     auto angle_fn = [edge_map, polys, loops, mesh](const int i) -> float {
-      if (edge_map[i].face_count != 2) {
+      if (edge_map[i].count != 2) {
         return 0.0f;
       }
-      const MPoly &mpoly_1 = polys[edge_map[i].face_index_1];
-      const MPoly &mpoly_2 = polys[edge_map[i].face_index_2];
+      const MPoly &mpoly_1 = polys[edge_map[i].indices[0]];
+      const MPoly &mpoly_2 = polys[edge_map[i].indices[1]];
       float3 normal_1, normal_2;
       BKE_mesh_calc_poly_normal(&mpoly_1, &loops[mpoly_1.loopstart], mesh->mvert, normal_1);
       BKE_mesh_calc_poly_normal(&mpoly_2, &loops[mpoly_2.loopstart], mesh->mvert, normal_2);
@@ -130,14 +104,14 @@ class SignedAngleFieldInput final : public GeometryFieldInput {
 
     Span<MPoly> polys{mesh->mpoly, mesh->totpoly};
     Span<MLoop> loops{mesh->mloop, mesh->totloop};
-    Array<EdgeMapEntry> edge_map = create_edge_map(polys, loops, mesh->totedge);
+    const MeshElemMap *edge_map = BKE_mesh_runtime_edge_poly_map_ensure(mesh);
 
     auto angle_fn = [edge_map, polys, loops, mesh](const int i) -> float {
-      if (edge_map[i].face_count != 2) {
+      if (edge_map[i].count != 2) {
         return 0.0f;
       }
-      const MPoly &mpoly_1 = polys[edge_map[i].face_index_1];
-      const MPoly &mpoly_2 = polys[edge_map[i].face_index_2];
+      const MPoly &mpoly_1 = polys[edge_map[i].indices[0]];
+      const MPoly &mpoly_2 = polys[edge_map[i].indices[1]];
 
       /* Find the normals of the 2 polys. */
       float3 poly_1_normal, poly_2_normal;
@@ -4,6 +4,10 @@
 #include "DNA_meshdata_types.h"
 
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
+
+#include "BLI_task.hh"
 
 #include "node_geometry_util.hh"
 
@@ -29,11 +33,13 @@ static VArray<int> construct_vertex_count_gvarray(const MeshComponent &component
   }
 
   if (domain == ATTR_DOMAIN_POINT) {
-    Array<int> vertices(mesh->totvert, 0);
-    for (const int i : IndexRange(mesh->totedge)) {
-      vertices[mesh->medge[i].v1]++;
-      vertices[mesh->medge[i].v2]++;
-    }
+    const MeshElemMap *vert_edge_map = BKE_mesh_runtime_vert_edge_map_ensure(mesh);
+    Array<int> vertices(mesh->totvert);
+    threading::parallel_for(vertices.index_range(), 4096, [&](IndexRange range) {
+      for (const int i : range) {
+        vertices[i] = vert_edge_map[i].count;
+      }
+    });
     return VArray<int>::ForContainer(std::move(vertices));
   }
   return {};
@@ -78,11 +84,13 @@ static VArray<int> construct_face_count_gvarray(const MeshComponent &component,
   }
 
   if (domain == ATTR_DOMAIN_POINT) {
-    Array<int> vertices(mesh->totvert, 0);
-    for (const int i : IndexRange(mesh->totloop)) {
-      int vertex = mesh->mloop[i].v;
-      vertices[vertex]++;
-    }
+    const MeshElemMap *vert_poly_map = BKE_mesh_runtime_vert_poly_map_ensure(mesh);
+    Array<int> vertices(mesh->totvert);
+    threading::parallel_for(vertices.index_range(), 4096, [&](IndexRange range) {
+      for (const int i : range) {
+        vertices[i] = vert_poly_map[i].count;
+      }
+    });
     return VArray<int>::ForContainer(std::move(vertices));
   }
   return {};
@@ -1,5 +1,7 @@
 /* SPDX-License-Identifier: GPL-2.0-or-later */
 
+#include "BLI_task.hh"
+
 #include "DNA_mesh_types.h"
 
 #include "BKE_attribute_math.hh"
@@ -149,21 +151,33 @@ static void raycast_to_mesh(IndexMask mask,
   /* We shouldn't be rebuilding the BVH tree when calling this function in parallel. */
   BLI_assert(tree_data.cached);
 
-  for (const int i : mask) {
-    const float ray_length = ray_lengths[i];
-    const float3 ray_origin = ray_origins[i];
-    const float3 ray_direction = math::normalize(ray_directions[i]);
-
-    BVHTreeRayHit hit;
-    hit.index = -1;
-    hit.dist = ray_length;
-    if (BLI_bvhtree_ray_cast(tree_data.tree,
-                             ray_origin,
-                             ray_direction,
+  /* Gather the rays, so they can be cast together in packets. */
+  Array<float3> origins(mask.size());
+  Array<float3> directions(mask.size());
+  Array<BVHTreeRayHit> hits(mask.size());
+  threading::parallel_for(mask.index_range(), 1024, [&](IndexRange range) {
+    for (const int i : range) {
+      origins[i] = ray_origins[mask[i]];
+      directions[i] = math::normalize(ray_directions[mask[i]]);
+      hits[i].index = -1;
+      hits[i].dist = ray_lengths[mask[i]];
+    }
+  });
+
+  BLI_bvhtree_ray_cast_array(tree_data.tree,
+                             reinterpret_cast<const float(*)[3]>(origins.data()),
+                             reinterpret_cast<const float(*)[3]>(directions.data()),
+                             mask.size(),
                              0.0f,
-                             &hit,
+                             hits.data(),
                              tree_data.raycast_callback,
-                             &tree_data) != -1) {
+                             &tree_data,
+                             BVH_RAYCAST_DEFAULT);
+
+  for (const int64_t mask_i : mask.index_range()) {
+    const int i = mask[mask_i];
+    const BVHTreeRayHit &hit = hits[mask_i];
+    if (hit.index != -1) {
       hit_count++;
       if (!r_hit.is_empty()) {
         r_hit[i] = hit.index >= 0;
@@ -196,7 +210,7 @@ static void raycast_to_mesh(IndexMask mask,
         r_hit_normals[i] = float3(0.0f, 0.0f, 0.0f);
       }
       if (!r_hit_distances.is_empty()) {
-        r_hit_distances[i] = ray_length;
+        r_hit_distances[i] = ray_lengths[i];
       }
     }
   }
@@ -135,6 +135,53 @@ static void node_gather_link_searches(GatherLinkSearchOpParams &params)
   }
 }
 
+/**
+ * Find the nearest element in the tree for all positions at once, so that the lookups can reuse
+ * the result of spatially close positions.
+ */
+static void find_nearest_in_bvhtree(BVHTree *tree,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    const VArray<float3> &positions,
+                                    const IndexMask mask,
+                                    const MutableSpan<int> r_indices,
+                                    const MutableSpan<float> r_distances_sq,
+                                    const MutableSpan<float3> r_positions)
+{
+  Array<float3> mask_positions(mask.size());
+  Array<BVHTreeNearest> nearest(mask.size());
+  threading::parallel_for(mask.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      mask_positions[i] = positions[mask[i]];
+      nearest[i].index = -1;
+      nearest[i].dist_sq = FLT_MAX;
+    }
+  });
+
+  BLI_bvhtree_find_nearest_array(tree,
+                                 reinterpret_cast<const float(*)[3]>(mask_positions.data()),
+                                 mask.size(),
+                                 nearest.data(),
+                                 callback,
+                                 userdata,
+                                 0);
+
+  threading::parallel_for(mask.index_range(), 4096, [&](IndexRange range) {
+    for (const int i : range) {
+      const int index = mask[i];
+      if (!r_indices.is_empty()) {
+        r_indices[index] = nearest[i].index;
+      }
+      if (!r_distances_sq.is_empty()) {
+        r_distances_sq[index] = nearest[i].dist_sq;
+      }
+      if (!r_positions.is_empty()) {
+        r_positions[index] = nearest[i].co;
+      }
+    }
+  });
+}
+
 static void get_closest_in_bvhtree(BVHTreeFromMesh &tree_data,
                                    const VArray<float3> &positions,
                                    const IndexMask mask,
@@ -146,22 +193,14 @@ static void get_closest_in_bvhtree(BVHTreeFromMesh &tree_data,
   BLI_assert(positions.size() >= r_distances_sq.size());
   BLI_assert(positions.size() >= r_positions.size());
 
-  for (const int i : mask) {
-    BVHTreeNearest nearest;
-    nearest.dist_sq = FLT_MAX;
-    const float3 position = positions[i];
-    BLI_bvhtree_find_nearest(
-        tree_data.tree, position, &nearest, tree_data.nearest_callback, &tree_data);
-    if (!r_indices.is_empty()) {
-      r_indices[i] = nearest.index;
-    }
-    if (!r_distances_sq.is_empty()) {
-      r_distances_sq[i] = nearest.dist_sq;
-    }
-    if (!r_positions.is_empty()) {
-      r_positions[i] = nearest.co;
-    }
-  }
+  find_nearest_in_bvhtree(tree_data.tree,
+                          tree_data.nearest_callback,
+                          &tree_data,
+                          positions,
+                          mask,
+                          r_indices,
+                          r_distances_sq,
+                          r_positions);
 }
 
 static void get_closest_pointcloud_points(const PointCloud &pointcloud,
@@ -176,17 +215,14 @@ static void get_closest_pointcloud_points(const PointCloud &pointcloud,
   BVHTreeFromPointCloud tree_data;
   BKE_bvhtree_from_pointcloud_get(&tree_data, &pointcloud, 2);
 
-  for (const int i : mask) {
-    BVHTreeNearest nearest;
-    nearest.dist_sq = FLT_MAX;
-    const float3 position = positions[i];
-    BLI_bvhtree_find_nearest(
-        tree_data.tree, position, &nearest, tree_data.nearest_callback, &tree_data);
-    r_indices[i] = nearest.index;
-    if (!r_distances_sq.is_empty()) {
-      r_distances_sq[i] = nearest.dist_sq;
-    }
-  }
+  find_nearest_in_bvhtree(tree_data.tree,
+                          tree_data.nearest_callback,
+                          &tree_data,
+                          positions,
+                          mask,
+                          r_indices,
+                          r_distances_sq,
+                          {});
 
   free_bvhtree_from_pointcloud(&tree_data);
 }
@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+
+#include "BLI_enumerable_thread_specific.hh"
+#include "BLI_serialize.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_blender.h"
+
+#include "NOD_geometry.h"
+#include "NOD_geometry_nodes_profile.hh"
+
+namespace blender::nodes::geometry_nodes_profile {
+
+using namespace io::serialize;
+
+struct Profiler {
+  std::string filepath;
+  /** Timestamps in the written trace are relative to this time. */
+  TimePoint start_time;
+  threading::EnumerableThreadSpecific<Vector<ProfileEvent>> events_by_thread;
+};
+
+/** Only changed at startup and exit, when no geometry nodes are evaluated. */
+static Profiler *profiler = nullptr;
+
+bool is_enabled()
+{
+  return profiler != nullptr;
+}
+
+static void profile_atexit(void *UNUSED(user_data))
+{
+  std::ofstream os;
+  os.open(profiler->filepath, std::ios::out | std::ios::trunc);
+  if (os.is_open()) {
+    write_chrome_trace(os);
+    printf("Geometry nodes profile written to \"%s\"\n", profiler->filepath.c_str());
+  }
+  else {
+    fprintf(stderr,
+            "Geometry nodes profile could not be written to \"%s\"\n",
+            profiler->filepath.c_str());
+  }
+  delete profiler;
+  profiler = nullptr;
+}
+
+void enable(std::string filepath)
+{
+  if (profiler == nullptr) {
+    profiler = new Profiler();
+    profiler->start_time = Clock::now();
+    BKE_blender_atexit_register(profile_atexit, nullptr);
+  }
+  profiler->filepath = std::move(filepath);
+}
+
+/** Small and stable thread identifiers are easier to read in trace viewers than system ids. */
+static int current_thread_index()
+{
+  static std::atomic<int> threads_num = 0;
+  thread_local const int thread_index = threads_num.fetch_add(1);
+  return thread_index;
+}
+
+void record(ProfileEvent event)
+{
+  BLI_assert(is_enabled());
+  event.thread_index = current_thread_index();
+  profiler->events_by_thread.local().append(std::move(event));
+}
+
+static double microseconds_since_start(const TimePoint time)
+{
+  return std::chrono::duration<double, std::micro>(time - profiler->start_time).count();
+}
+
+static DictionaryValue *event_to_trace_value(const ProfileEvent &event)
+{
+  DictionaryValue *args = new DictionaryValue();
+  DictionaryValue::Items &args_items = args->elements();
+  args_items.append_as(std::pair("frame", new DoubleValue(event.frame)));
+  args_items.append_as(std::pair("object", new StringValue(event.object_name)));
+  args_items.append_as(std::pair("modifier", new StringValue(event.modifier_name)));
+  args_items.append_as(std::pair("output_memory_bytes", new IntValue(event.output_memory_bytes)));
+  args_items.append_as(std::pair("output_elements", new IntValue(event.output_elements_num)));
+
+  const double start = microseconds_since_start(event.start);
+  const double end = microseconds_since_start(event.end);
+
+  /* A "complete" event as described in the Chrome trace event format specification. Events on
+   * the same thread that are contained in each other are displayed as flame graph. */
+  DictionaryValue *value = new DictionaryValue();
+  DictionaryValue::Items &items = value->elements();
+  items.append_as(std::pair("name", new StringValue(event.name)));
+  items.append_as(std::pair("cat", new StringValue(event.category)));
+  items.append_as(std::pair("ph", new StringValue("X")));
+  items.append_as(std::pair("ts", new DoubleValue(start)));
+  items.append_as(std::pair("dur", new DoubleValue(end - start)));
+  items.append_as(std::pair("pid", new IntValue(1)));
+  items.append_as(std::pair("tid", new IntValue(event.thread_index)));
+  items.append_as(std::pair("args", args));
+  return value;
+}
+
+void write_chrome_trace(std::ostream &stream)
+{
+  Vector<const ProfileEvent *> events;
+  for (const Vector<ProfileEvent> &thread_events : profiler->events_by_thread) {
+    for (const ProfileEvent &event : thread_events) {
+      events.append(&event);
+    }
+  }
+  std::sort(events.begin(), events.end(), [](const ProfileEvent *a, const ProfileEvent *b) {
+    return a->start < b->start;
+  });
+
+  ArrayValue *trace_events = new ArrayValue();
+  ArrayValue::Items &trace_event_items = trace_events->elements();
+  for (const ProfileEvent *event : events) {
+    trace_event_items.append_as(event_to_trace_value(*event));
+  }
+
+  DictionaryValue root;
+  DictionaryValue::Items &root_items = root.elements();
+  root_items.append_as(std::pair("traceEvents", trace_events));
+  root_items.append_as(std::pair("displayTimeUnit", new StringValue("ms")));
+
+  JsonFormatter formatter;
+  formatter.serialize(stream, root);
+}
+
+}  // namespace blender::nodes::geometry_nodes_profile
+
+void NOD_geometry_nodes_profile_enable(const char *filepath)
+{
+  blender::nodes::geometry_nodes_profile::enable(filepath);
+}
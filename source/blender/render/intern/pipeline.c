@@ -1213,7 +1213,7 @@ static void do_render_compositor(Render *re)
         RenderView *rv;
         for (rv = re->result->views.first; rv; rv = rv->next) {
           ntreeCompositExecTree(
-              re->pipeline_scene_eval, ntree, &re->r, true, G.background == 0, rv->name);
+              re->pipeline_scene_eval, ntree, &re->r, true, G.background == 0, rv->name, NULL);
         }
 
         ntree->stats_draw = NULL;
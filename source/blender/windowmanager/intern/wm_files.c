@@ -1918,6 +1918,56 @@ static void wm_autosave_location(char *filepath)
   BLI_join_dirfile(filepath, FILE_MAX, BKE_tempdir_base(), path);
 }
 
+typedef struct AutosaveJob {
+  /** Undo memfile sharing the buffers of the active undo step, see #BLO_memfile_duplicate. */
+  MemFile *memfile;
+  char filepath[FILE_MAX];
+} AutosaveJob;
+
+static void wm_autosave_job_startjob(void *customdata,
+                                     /* Cannot be const, this function implements
+                                      * wm_jobs_start_callback.
+                                      * NOLINTNEXTLINE: readability-non-const-parameter. */
+                                     short *UNUSED(stop),
+                                     short *UNUSED(do_update),
+                                     float *UNUSED(progress))
+{
+  AutosaveJob *autosave_job = customdata;
+  /* Stopping halfway would leave a broken file behind, so the stop flag is ignored. Writing the
+   * memfile is just a copy to disk, so it finishes quickly when waited on. */
+  BLO_memfile_write_file(autosave_job->memfile, autosave_job->filepath);
+}
+
+static void wm_autosave_job_free(void *customdata)
+{
+  AutosaveJob *autosave_job = customdata;
+  BLO_memfile_free(autosave_job->memfile);
+  MEM_freeN(autosave_job->memfile);
+  MEM_freeN(autosave_job);
+}
+
+/**
+ * Write the undo memfile from a job, so the UI doesn't wait for the disk. The job uses its own
+ * memfile sharing the chunk buffers, since undo steps may be freed while the job runs.
+ */
+static void wm_autosave_write_memfile_job(wmWindowManager *wm,
+                                          wmWindow *win,
+                                          const MemFile *memfile,
+                                          const char *filepath)
+{
+  AutosaveJob *autosave_job = MEM_callocN(sizeof(*autosave_job), __func__);
+  autosave_job->memfile = BLO_memfile_duplicate(memfile);
+  BLI_strncpy(autosave_job->filepath, filepath, sizeof(autosave_job->filepath));
+
+  /* The window manager owns the job, there is only one auto-save at a time. Starting it again
+   * while the previous one still runs waits for it to finish before writing. */
+  wmJob *wm_job = WM_jobs_get(wm, win, wm, "Auto Save", 0, WM_JOB_TYPE_AUTOSAVE);
+  WM_jobs_customdata_set(wm_job, autosave_job, wm_autosave_job_free);
+  WM_jobs_timer(wm_job, 0.1, 0, 0);
+  WM_jobs_callbacks(wm_job, wm_autosave_job_startjob, NULL, NULL, NULL);
+  WM_jobs_start(wm, wm_job);
+}
+
 static void wm_autosave_write(Main *bmain, wmWindowManager *wm)
 {
   char filepath[FILE_MAX];
@@ -1928,7 +1978,14 @@ static void wm_autosave_write(Main *bmain, wmWindowManager *wm)
   const bool use_memfile = (U.uiflag & USER_GLOBALUNDO) != 0;
   MemFile *memfile = use_memfile ? ED_undosys_stack_memfile_get_active(wm->undo_stack) : NULL;
   if (memfile != NULL) {
-    BLO_memfile_write_file(memfile, filepath);
+    /* Jobs need a window, there may be no active one when no window has focus. */
+    wmWindow *win = (wm->winactive) ? wm->winactive : wm->windows.first;
+    if (G.background || win == NULL) {
+      BLO_memfile_write_file(memfile, filepath);
+    }
+    else {
+      wm_autosave_write_memfile_job(wm, win, memfile, filepath);
+    }
   }
   else {
     if (use_memfile) {
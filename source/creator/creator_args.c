@@ -70,6 +70,8 @@
 #  include "DEG_depsgraph_build.h"
 #  include "DEG_depsgraph_debug.h"
 
+#  include "NOD_geometry.h"
+
 #  include "WM_types.h"
 
 #  include "creator_intern.h" /* own include */
@@ -575,6 +577,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-time");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-pretty");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph-uuid");
+  BLI_args_print_arg_doc(ba, "--debug-geometry-nodes-profile");
   BLI_args_print_arg_doc(ba, "--debug-ghost");
   BLI_args_print_arg_doc(ba, "--debug-gpu");
   BLI_args_print_arg_doc(ba, "--debug-gpu-force-workarounds");
@@ -1080,6 +1083,25 @@ static int arg_handle_debug_value_set(int argc, const char **argv, void *UNUSED(
   return 0;
 }
 
+static const char arg_handle_debug_geometry_nodes_profile_set_doc[] =
+    "<filepath>\n"
+    "\tRecord the execution time of all geometry nodes and write them to <filepath> on exit.\n"
+    "\tThe file uses the Chrome trace event format.";
+static int arg_handle_debug_geometry_nodes_profile_set(int argc,
+                                                       const char **argv,
+                                                       void *UNUSED(data))
+{
+  if (argc > 1) {
+    char filepath[FILE_MAX];
+    BLI_strncpy(filepath, argv[1], sizeof(filepath));
+    BLI_path_abs_from_cwd(filepath, sizeof(filepath));
+    NOD_geometry_nodes_profile_enable(filepath);
+    return 1;
+  }
+  printf("\nError: you must specify a file path for the geometry nodes profile.\n");
+  return 0;
+}
+
 static const char arg_handle_debug_gpu_set_doc[] =
     "\n"
     "\tEnable GPU debug context and information for OpenGL 4.3+.";
@@ -2195,6 +2217,11 @@ void main_args_setup(bContext *C, bArgs *ba)
                "--debug-depsgraph-uuid",
                CB_EX(arg_handle_debug_mode_generic_set, depsgraph_uuid),
                (void *)G_DEBUG_DEPSGRAPH_UUID);
+  BLI_args_add(ba,
+               NULL,
+               "--debug-geometry-nodes-profile",
+               CB(arg_handle_debug_geometry_nodes_profile_set),
+               NULL);
   BLI_args_add(ba,
                NULL,
                "--debug-gpu-force-workarounds",
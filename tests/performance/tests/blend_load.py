@@ -3,12 +3,21 @@
 import api
 import os
 import pathlib
+import tempfile
 
 
-def _run(filepath):
+def _run(args):
     import bpy
     import time
 
+    filepath = args['filepath']
+
+    if args['compress']:
+        # Save a compressed copy, to measure decompression as part of loading.
+        bpy.ops.wm.open_mainfile(filepath=filepath)
+        filepath = os.path.join(args['tempdir'], os.path.basename(filepath))
+        bpy.ops.wm.save_as_mainfile(filepath=filepath, compress=True, copy=True)
+
     # Load once to ensure it's cached by OS
     bpy.ops.wm.open_mainfile(filepath=filepath)
     bpy.ops.wm.read_homefile()
@@ -23,20 +32,28 @@ def _run(filepath):
 
 
 class BlendLoadTest(api.Test):
-    def __init__(self, filepath):
+    def __init__(self, filepath, compress=False):
         self.filepath = filepath
+        self.compress = compress
 
     def name(self):
+        if self.compress:
+            return self.filepath.stem + "_compressed"
         return self.filepath.stem
 
     def category(self):
         return "blend_load"
 
     def run(self, env, device_id):
-        result, _ = env.run_in_blender(_run, str(self.filepath))
+        with tempfile.TemporaryDirectory() as tempdir:
+            args = {'filepath': str(self.filepath),
+                    'compress': self.compress,
+                    'tempdir': tempdir}
+            result, _ = env.run_in_blender(_run, args)
         return result
 
 
 def generate(env):
     filepaths = env.find_blend_files('*/*')
-    return [BlendLoadTest(filepath) for filepath in filepaths]
+    return ([BlendLoadTest(filepath) for filepath in filepaths] +
+            [BlendLoadTest(filepath, compress=True) for filepath in filepaths])
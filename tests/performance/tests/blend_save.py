@@ -0,0 +1,56 @@
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+import os
+import tempfile
+
+
+def _run(args):
+    import bpy
+    import time
+
+    bpy.ops.wm.open_mainfile(filepath=args['filepath'])
+    filepath = os.path.join(args['tempdir'], "save.blend")
+
+    # Save once to ensure the output file exists and is cached by OS.
+    bpy.ops.wm.save_as_mainfile(filepath=filepath, compress=args['compress'], copy=True)
+
+    # Measure saving the second time.
+    start_time = time.time()
+    bpy.ops.wm.save_as_mainfile(filepath=filepath, compress=args['compress'], copy=True)
+    elapsed_time = time.time() - start_time
+
+    # Throughput is measured on the uncompressed size, so it is comparable between both modes.
+    bpy.ops.wm.save_as_mainfile(filepath=filepath, compress=False, copy=True)
+    size = os.path.getsize(filepath)
+
+    result = {'time': elapsed_time, 'throughput_mb_per_sec': size / (1024 * 1024) / elapsed_time}
+    return result
+
+
+class BlendSaveTest(api.Test):
+    def __init__(self, filepath, compress):
+        self.filepath = filepath
+        self.compress = compress
+
+    def name(self):
+        if self.compress:
+            return self.filepath.stem + "_compressed"
+        return self.filepath.stem
+
+    def category(self):
+        return "blend_save"
+
+    def run(self, env, device_id):
+        with tempfile.TemporaryDirectory() as tempdir:
+            args = {'filepath': str(self.filepath),
+                    'compress': self.compress,
+                    'tempdir': tempdir}
+            result, _ = env.run_in_blender(_run, args)
+        return result
+
+
+def generate(env):
+    filepaths = env.find_blend_files('*/*')
+    return ([BlendSaveTest(filepath, compress=False) for filepath in filepaths] +
+            [BlendSaveTest(filepath, compress=True) for filepath in filepaths])
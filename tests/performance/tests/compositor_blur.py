@@ -0,0 +1,82 @@
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+
+def _run(args):
+    import bpy
+    import time
+
+    bpy.ops.wm.read_homefile(use_empty=True)
+    scene = bpy.context.scene
+    scene.render.resolution_x = args['width']
+    scene.render.resolution_y = args['height']
+    scene.render.resolution_percentage = 100
+    scene.use_nodes = True
+    tree = scene.node_tree
+    tree.execution_mode = 'FULL_FRAME'
+    tree.nodes.clear()
+
+    image = bpy.data.images.new("Input", args['width'], args['height'], float_buffer=True)
+    image.generated_type = 'COLOR_GRID'
+    image_node = tree.nodes.new("CompositorNodeImage")
+    image_node.image = image
+    composite_node = tree.nodes.new("CompositorNodeComposite")
+
+    radius = args['radius']
+    if args['node'] == 'DEFOCUS':
+        blur_node = tree.nodes.new("CompositorNodeDefocus")
+        blur_node.use_zbuffer = False
+        blur_node.z_scale = radius
+        blur_node.blur_max = radius
+        blur_node.inputs["Z"].default_value = 1.0
+    else:
+        blur_node = tree.nodes.new("CompositorNodeBokehBlur")
+        bokeh_node = tree.nodes.new("CompositorNodeBokehImage")
+        tree.links.new(bokeh_node.outputs["Image"], blur_node.inputs["Bokeh"])
+        # Size is a percentage of the largest image dimension.
+        blur_node.inputs["Size"].default_value = radius * 100.0 / max(args['width'],
+                                                                      args['height'])
+    blur_node.blur_algorithm = args['algorithm']
+    tree.links.new(image_node.outputs["Image"], blur_node.inputs["Image"])
+    tree.links.new(blur_node.outputs["Image"], composite_node.inputs["Image"])
+
+    # Warm up with the same tree. Renders don't use the compositor result cache, so the timed
+    # render still computes the blur.
+    bpy.ops.render.render()
+
+    start_time = time.time()
+    bpy.ops.render.render()
+    elapsed_time = time.time() - start_time
+
+    result = {'time': elapsed_time}
+    return result
+
+
+class CompositorBlurTest(api.Test):
+    def __init__(self, node, algorithm, radius):
+        self.node = node
+        self.algorithm = algorithm
+        self.radius = radius
+
+    def name(self):
+        return f"{self.node.lower()}_{self.algorithm.lower()}_radius_{self.radius}"
+
+    def category(self):
+        return "compositor_blur"
+
+    def run(self, env, device_id):
+        args = {'node': self.node,
+                'algorithm': self.algorithm,
+                'radius': self.radius,
+                'width': 960,
+                'height': 540}
+        result, _ = env.run_in_blender(_run, args)
+        return result
+
+
+def generate(env):
+    return [CompositorBlurTest(node, algorithm, radius)
+            for node in ('DEFOCUS', 'BOKEH_BLUR')
+            for algorithm in ('ACCURATE', 'FAST')
+            for radius in (4, 16, 64)]
@@ -0,0 +1,57 @@
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+import os
+import tempfile
+
+
+def _run(args):
+    import bpy
+    import time
+
+    # Build a scene with many subdivided objects, applied so export doesn't measure modifiers.
+    bpy.ops.wm.read_homefile(use_empty=True)
+    for i in range(args['num_objects']):
+        bpy.ops.mesh.primitive_grid_add(x_subdivisions=args['resolution'],
+                                        y_subdivisions=args['resolution'],
+                                        location=(i * 3.0, 0.0, 0.0))
+
+    filepath = os.path.join(args['tempdir'], "export.obj")
+
+    # Export once to warm up caches.
+    bpy.ops.wm.obj_export(filepath=filepath)
+
+    # Measure exporting the second time.
+    start_time = time.time()
+    bpy.ops.wm.obj_export(filepath=filepath)
+    elapsed_time = time.time() - start_time
+
+    result = {'time': elapsed_time}
+    return result
+
+
+class OBJExportTest(api.Test):
+    def __init__(self, resolution, num_objects):
+        self.resolution = resolution
+        self.num_objects = num_objects
+
+    def name(self):
+        num_verts = self.resolution * self.resolution * self.num_objects
+        return f"grid_{num_verts // 1000}k_verts_{self.num_objects}_objects"
+
+    def category(self):
+        return "obj_export"
+
+    def run(self, env, device_id):
+        with tempfile.TemporaryDirectory() as tempdir:
+            args = {'resolution': self.resolution,
+                    'num_objects': self.num_objects,
+                    'tempdir': tempdir}
+            result, _ = env.run_in_blender(_run, args)
+        return result
+
+
+def generate(env):
+    return [OBJExportTest(1000, 1),
+            OBJExportTest(3000, 1),
+            OBJExportTest(300, 100)]
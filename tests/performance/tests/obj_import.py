@@ -0,0 +1,76 @@
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+import pathlib
+import tempfile
+
+
+def _write_grid_obj(filepath, resolution, num_objects):
+    # Synthetic scan-like mesh: a grid of quads with UVs and normals per object.
+    with open(filepath, 'w') as f:
+        vert_offset = 0
+        for ob in range(num_objects):
+            f.write(f"o Grid.{ob:03d}\n")
+            step = 1.0 / (resolution - 1)
+            for y in range(resolution):
+                for x in range(resolution):
+                    f.write(f"v {x * step:.6f} {y * step:.6f} {ob + (x * y) % 7 * 0.001:.6f}\n")
+            for y in range(resolution):
+                for x in range(resolution):
+                    f.write(f"vt {x * step:.6f} {y * step:.6f}\n")
+            f.write("vn 0.0000 0.0000 1.0000\n")
+            f.write("s 1\n")
+            for y in range(resolution - 1):
+                for x in range(resolution - 1):
+                    a = vert_offset + y * resolution + x + 1
+                    b = a + 1
+                    c = a + resolution + 1
+                    d = a + resolution
+                    f.write(f"f {a}/{a}/{ob + 1} {b}/{b}/{ob + 1} "
+                            f"{c}/{c}/{ob + 1} {d}/{d}/{ob + 1}\n")
+            vert_offset += resolution * resolution
+
+
+def _run(args):
+    import bpy
+    import time
+
+    filepath = args['filepath']
+
+    # Import once to ensure it's cached by OS.
+    bpy.ops.wm.obj_import(filepath=filepath)
+    bpy.ops.wm.read_homefile()
+
+    # Measure importing the second time.
+    start_time = time.time()
+    bpy.ops.wm.obj_import(filepath=filepath)
+    elapsed_time = time.time() - start_time
+
+    result = {'time': elapsed_time}
+    return result
+
+
+class OBJImportTest(api.Test):
+    def __init__(self, resolution, num_objects):
+        self.resolution = resolution
+        self.num_objects = num_objects
+
+    def name(self):
+        num_verts = self.resolution * self.resolution * self.num_objects
+        return f"grid_{num_verts // 1000}k_verts_{self.num_objects}_objects"
+
+    def category(self):
+        return "obj_import"
+
+    def run(self, env, device_id):
+        with tempfile.TemporaryDirectory() as tempdir:
+            filepath = pathlib.Path(tempdir) / (self.name() + ".obj")
+            _write_grid_obj(filepath, self.resolution, self.num_objects)
+            result, _ = env.run_in_blender(_run, {'filepath': str(filepath)})
+        return result
+
+
+def generate(env):
+    return [OBJImportTest(1000, 1),
+            OBJImportTest(3000, 1),
+            OBJImportTest(300, 100)]
@@ -0,0 +1,64 @@
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+
+def _rss_bytes():
+    # Resident memory of the current process, Linux only.
+    import os
+    with open("/proc/self/statm") as f:
+        return int(f.read().split()[1]) * os.sysconf("SC_PAGE_SIZE")
+
+
+def _run(args):
+    import bpy
+    import time
+
+    bpy.ops.wm.read_homefile(use_empty=True)
+    bpy.ops.mesh.primitive_grid_add(x_subdivisions=args['resolution'],
+                                    y_subdivisions=args['resolution'])
+    mesh = bpy.context.active_object.data
+    bpy.ops.ed.undo_push(message="Initial")
+
+    memory_before = _rss_bytes()
+    start_time = time.time()
+    for i in range(args['num_steps']):
+        if args['append']:
+            # Adding vertices shifts the data of the mesh in the undo memfile.
+            mesh.vertices.add(1)
+        else:
+            mesh.vertices[i].co.z += 0.1
+        mesh.update()
+        bpy.ops.ed.undo_push(message=f"Step {i}")
+    elapsed_time = time.time() - start_time
+    memory_after = _rss_bytes()
+
+    result = {'time': elapsed_time, 'undo_memory': memory_after - memory_before}
+    return result
+
+
+class UndoMemoryTest(api.Test):
+    def __init__(self, resolution, num_steps, append):
+        self.resolution = resolution
+        self.num_steps = num_steps
+        self.append = append
+
+    def name(self):
+        num_polys = (self.resolution - 1) * (self.resolution - 1)
+        mode = "append" if self.append else "edit"
+        return f"grid_{num_polys // 1000000}m_polys_{self.num_steps}_{mode}_steps"
+
+    def category(self):
+        return "undo_memory"
+
+    def run(self, env, device_id):
+        args = {'resolution': self.resolution,
+                'num_steps': self.num_steps,
+                'append': self.append}
+        result, _ = env.run_in_blender(_run, args)
+        return result
+
+
+def generate(env):
+    return [UndoMemoryTest(3163, 10, append=False),
+            UndoMemoryTest(3163, 10, append=True)]